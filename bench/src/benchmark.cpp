@@ -0,0 +1,52 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "benchmark.h"
+
+#include <iomanip>
+
+namespace chessgame::bench {
+
+auto BenchmarkRunner::run(const Workload &workload, const std::function<void()> &body) -> void {
+    if (workload.name.find(m_settings.filter) == std::string::npos) {
+        return;
+    }
+    body();
+
+    BenchmarkResult result{.workload = workload};
+    const auto allocations_before = allocation_count();
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    result.allocations = allocation_count() - allocations_before;
+    result.iterations = 1;
+    auto elapsed = std::chrono::duration<double>{std::chrono::steady_clock::now() - start};
+    while (elapsed < m_settings.min_time || result.iterations < m_settings.min_iterations) {
+        body();
+        ++result.iterations;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    result.seconds = elapsed.count() / static_cast<double>(result.iterations);
+    m_results.push_back(result);
+}
+
+auto BenchmarkRunner::report(std::ostream &out_stream) const -> void {
+    out_stream << std::left << std::setw(36) << "benchmark" << std::right << std::setw(12) << "iterations" << std::setw(16) << "items/s"
+               << std::setw(8) << "unit" << std::setw(12) << "games/s" << std::setw(10) << "MB/s" << std::setw(14) << "allocs/game" << '\n';
+    out_stream << std::fixed;
+    for (const auto &result : m_results) {
+        const auto games_per_second = static_cast<double>(result.workload.games) / result.seconds;
+        out_stream << std::left << std::setw(36) << result.workload.name << std::right << std::setw(12) << result.iterations << std::setw(16)
+                   << std::setprecision(0) << result.items_per_second() << std::setw(8) << result.workload.unit << std::setw(12) << games_per_second
+                   << std::setw(10) << std::setprecision(1);
+        if (result.workload.bytes == 0) {
+            out_stream << "-";
+        } else {
+            out_stream << result.megabytes_per_second();
+        }
+        out_stream << std::setw(14) << result.allocations_per_game() << '\n';
+    }
+}
+
+} // namespace chessgame::bench
@@ -0,0 +1,104 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_BENCH_BENCHMARK_H
+#define CHESSGAME_BENCH_BENCHMARK_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "allocation_counter.h"
+
+namespace chessgame::bench {
+
+using support::allocation_count;
+
+/**
+ * \brief Settings for running benchmarks.
+ */
+struct BenchmarkSettings {
+    std::chrono::duration<double> min_time{0.5}; ///< Minimum measured time of every benchmark.
+    size_t min_iterations{3};                    ///< Minimum number of measured iterations of every benchmark.
+    std::string filter;                          ///< Only run benchmarks, whose name contains the filter.
+};
+
+/**
+ * \brief The work done by one iteration of a benchmark.
+ */
+struct Workload {
+    std::string name; ///< Name of the benchmark.
+    std::string unit; ///< Unit of the items, e.g. games or moves.
+    size_t items{0};  ///< Number of items processed by one iteration.
+    size_t games{0};  ///< Number of games processed by one iteration.
+    size_t bytes{0};  ///< Number of PGN bytes processed by one iteration.
+};
+
+/**
+ * \brief The measurements of a benchmark.
+ */
+struct BenchmarkResult {
+    Workload workload;       ///< The work done by one iteration.
+    size_t iterations{0};    ///< Number of measured iterations.
+    double seconds{0.0};     ///< Mean time of one iteration.
+    uint64_t allocations{0}; ///< Number of allocations of one iteration.
+
+    [[nodiscard]] auto items_per_second() const -> double { return static_cast<double>(workload.items) / seconds; }
+    [[nodiscard]] auto megabytes_per_second() const -> double { return static_cast<double>(workload.bytes) / (1024.0 * 1024.0) / seconds; }
+    [[nodiscard]] auto allocations_per_game() const -> double { return workload.games == 0 ? 0.0 : static_cast<double>(allocations) / static_cast<double>(workload.games); }
+};
+
+/**
+ * \brief Runs benchmarks and collects their results.
+ */
+class BenchmarkRunner {
+public:
+    explicit BenchmarkRunner(BenchmarkSettings settings) : m_settings{std::move(settings)} {}
+
+    /**
+     * \brief Run a benchmark.
+     *
+     * The body is run once to warm up, then repeatedly until the minimum time
+     * and number of iterations are reached. The allocations are counted in
+     * the first measured iteration.
+     * \param workload The work done by one run of the body.
+     * \param body The benchmark body.
+     */
+    auto run(const Workload &workload, const std::function<void()> &body) -> void;
+
+    /**
+     * \brief Write the results as a table.
+     *
+     * \param out_stream The output stream.
+     */
+    auto report(std::ostream &out_stream) const -> void;
+private:
+    BenchmarkSettings m_settings;
+    std::vector<BenchmarkResult> m_results;
+};
+
+/**
+ * \brief Prevent the compiler from optimizing away a computed value.
+ *
+ * \param value The value.
+ */
+template<typename T>
+auto do_not_optimize(const T &value) -> void {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void *sink{nullptr};
+    sink = &value;
+#endif
+}
+
+} // namespace chessgame::bench
+
+#endif
@@ -0,0 +1,218 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark.h"
+#include "corpus.h"
+
+#include "chessgame/export.h"
+#include "chessgame/filter.h"
+#include "chessgame/game.h"
+#include "chessgame/mainline.h"
+#include "chessgame/pgn.h"
+#include "chessgame/position_index.h"
+#include "chessgame/san.h"
+
+using namespace chessgame;
+using namespace chessgame::bench;
+
+namespace {
+
+struct SANSample {
+    std::string san;
+    chesscore::Color side_to_move;
+    SANMove san_move;
+    chesscore::Move move;
+    chesscore::MoveList legal_moves;
+};
+
+auto read_games(const Corpus &corpus) -> std::vector<Game> {
+    std::vector<Game> games;
+    PGNParser parser{std::string_view{corpus.pgn}};
+    while (auto game = parser.read_game()) {
+        games.push_back(std::move(*game));
+    }
+    return games;
+}
+
+auto collect_san_samples(const std::vector<Game> &games) -> std::vector<SANSample> {
+    std::vector<SANSample> samples;
+    for (const auto &game : games) {
+        auto cursor = game.cursor();
+        for (auto child = cursor.child(0); child.has_value(); child = cursor.child(0)) {
+            const auto &position = cursor.position();
+            auto legal_moves = position.all_legal_moves();
+            const auto &move = child->move();
+            auto san = generate_san_move(move, legal_moves).value().san_string;
+            auto san_move = parse_san(san, position.side_to_move()).value();
+            samples.push_back(SANSample{
+                .san = std::move(san), .side_to_move = position.side_to_move(), .san_move = std::move(san_move), .move = move, .legal_moves = std::move(legal_moves)
+            });
+            cursor = *child;
+        }
+    }
+    return samples;
+}
+
+auto run_corpus_benchmarks(BenchmarkRunner &runner, const Corpus &corpus) -> void {
+    const auto games = read_games(corpus);
+    const auto samples = collect_san_samples(games);
+    std::vector<MainlineGame> mainline_games;
+    std::ranges::transform(games, std::back_inserter(mainline_games), &MainlineGame::from_game);
+    const std::string_view data{corpus.pgn};
+    const auto pgn_workload = [&](std::string_view benchmark) {
+        return Workload{.name = std::string{benchmark} + "/" + corpus.name, .unit = "games", .items = games.size(), .games = games.size(), .bytes = data.size()};
+    };
+    const auto san_workload = [&](std::string_view benchmark) {
+        return Workload{.name = std::string{benchmark} + "/" + corpus.name, .unit = "moves", .items = samples.size(), .games = games.size()};
+    };
+
+    runner.run(pgn_workload("PGNLexer::next_token"), [&] {
+        PGNLexer lexer{data};
+        size_t tokens{0};
+        while (lexer.next_token().type != PGNLexer::TokenType::EndOfInput) {
+            ++tokens;
+        }
+        do_not_optimize(tokens);
+    });
+    runner.run(pgn_workload("PGNParser::read_game"), [&] {
+        PGNParser parser{data};
+        while (const auto game = parser.read_game()) {
+            do_not_optimize(*game);
+        }
+    });
+    runner.run(pgn_workload("PGNParser::read_game (monotonic buffer)"), [&] {
+        std::pmr::monotonic_buffer_resource batch{};
+        PGNParser parser{data, &batch};
+        while (const auto game = parser.read_game()) {
+            do_not_optimize(*game);
+        }
+    });
+    runner.run(pgn_workload("StrictMainlinePGNParser::read_game"), [&] {
+        StrictMainlinePGNParser parser{data};
+        while (const auto game = parser.read_game()) {
+            do_not_optimize(*game);
+        }
+    });
+    runner.run(pgn_workload("PGNParser::read_mainline_game"), [&] {
+        PGNParser parser{data};
+        while (const auto game = parser.read_mainline_game()) {
+            do_not_optimize(*game);
+        }
+    });
+    runner.run(pgn_workload("PGNParser::read_game_into"), [&] {
+        PGNParser parser{data};
+        Game game{};
+        while (parser.read_game_into(game)) {
+            do_not_optimize(game);
+        }
+    });
+    runner.run(pgn_workload("PGNParser::read_game (lazy)"), [&] {
+        PGNParser parser{data};
+        parser.set_lazy_movetext(true);
+        while (const auto game = parser.read_game()) {
+            do_not_optimize(*game);
+        }
+    });
+    runner.run(pgn_workload("filter_games (tags)"), [&] {
+        std::ostringstream out_stream;
+        GameFilter filter{};
+        filter.require_tag("Result", "1-0");
+        do_not_optimize(filter_games(data, filter, out_stream));
+    });
+    runner.run(pgn_workload("filter_games (position)"), [&] {
+        std::ostringstream out_stream;
+        auto board = Board::starting_position();
+        board.make_move(chesscore::Move{.from = chesscore::Square::E2, .to = chesscore::Square::E4, .piece = chesscore::Piece::WhitePawn});
+        GameFilter filter{};
+        filter.require_position(board.key()).set_max_ply(20);
+        do_not_optimize(filter_games(data, filter, out_stream));
+    });
+    runner.run(pgn_workload("build_position_index"), [&] { do_not_optimize(build_position_index(data)); });
+    const auto position_index = build_position_index(data);
+    runner.run(pgn_workload("PositionIndex::find_games (material)"), [&] {
+        do_not_optimize(position_index.find_games(PositionQuery{.material = material_signature(Board::from_fen("4k3/8/8/8/8/8/8/4K3 w - - 0 1").value())}));
+    });
+    runner.run(pgn_workload("PGNWriter::write_game"), [&] {
+        std::ostringstream out_stream;
+        PGNWriter writer{out_stream};
+        for (const auto &game : games) {
+            writer.write_game(game);
+        }
+        do_not_optimize(out_stream);
+    });
+    runner.run(pgn_workload("PGNWriter::write_game (main line)"), [&] {
+        std::ostringstream out_stream;
+        PGNWriter writer{out_stream};
+        for (const auto &game : mainline_games) {
+            writer.write_game(game);
+        }
+        do_not_optimize(out_stream);
+    });
+    runner.run(pgn_workload("export_games"), [&] {
+        std::ostringstream out_stream;
+        export_games(games, out_stream);
+        do_not_optimize(out_stream);
+    });
+    runner.run(san_workload("parse_san"), [&] {
+        for (const auto &sample : samples) {
+            const auto san_move = parse_san(sample.san, sample.side_to_move);
+            do_not_optimize(san_move);
+        }
+    });
+    runner.run(san_workload("match_move"), [&] {
+        for (const auto &sample : samples) {
+            const auto matches = match_move(sample.san_move, sample.legal_moves);
+            do_not_optimize(matches);
+        }
+    });
+    runner.run(san_workload("generate_san_move"), [&] {
+        for (const auto &sample : samples) {
+            const auto san_move = generate_san_move(sample.move, sample.legal_moves);
+            do_not_optimize(san_move);
+        }
+    });
+}
+
+auto print_usage(std::string_view program) -> void {
+    std::cout << "Usage: " << program << " [--filter=<text>] [--min-time=<seconds>]\n"
+              << "  --filter=<text>       Only run benchmarks whose name contains the text.\n"
+              << "  --min-time=<seconds>  Minimum measured time of every benchmark (default 0.5).\n";
+}
+
+} // namespace
+
+auto main(int argc, char *argv[]) -> int {
+    BenchmarkSettings settings;
+    const std::vector<std::string_view> args(argv + 1, argv + argc);
+    for (const auto arg : args) {
+        if (arg.starts_with("--filter=")) {
+            settings.filter = arg.substr(9);
+        } else if (arg.starts_with("--min-time=")) {
+            settings.min_time = std::chrono::duration<double>{std::stod(std::string{arg.substr(11)})};
+        } else {
+            print_usage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    BenchmarkRunner runner{settings};
+    for (const auto &spec : standard_corpora()) {
+        const auto corpus = generate_corpus(spec);
+        std::cout << "corpus " << corpus.name << ": " << corpus.game_count << " games, " << corpus.pgn.size() / 1024 << " KiB\n";
+        run_corpus_benchmarks(runner, corpus);
+    }
+    std::cout << '\n';
+    runner.report(std::cout);
+    return 0;
+}
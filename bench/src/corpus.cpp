@@ -0,0 +1,126 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "corpus.h"
+
+#include <array>
+#include <random>
+#include <sstream>
+#include <string_view>
+
+#include "chessgame/game.h"
+#include "chessgame/pgn.h"
+
+namespace chessgame::bench {
+
+namespace {
+
+constexpr std::array<std::string_view, 5> start_fens{
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 0 4",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+};
+
+constexpr std::array<std::string_view, 4> comments{
+    "A natural move.",
+    "The alternative keeps more tension in the centre, but after the exchange the position is equal.",
+    "Threatening the pawn.",
+    "Black has to be careful now, the king is still in the centre and the rooks are not connected.",
+};
+
+constexpr size_t variation_plies{6};
+
+/*
+ * std::uniform_int_distribution is implemented differently by the standard
+ * libraries. Taking the random number modulo the range keeps the corpus equal
+ * on all platforms.
+ */
+class MoveSelector {
+public:
+    explicit MoveSelector(uint64_t seed) : m_engine{seed} {}
+
+    auto index(size_t count) -> size_t { return static_cast<size_t>(m_engine() % count); }
+private:
+    std::mt19937_64 m_engine;
+};
+
+class GameGenerator {
+public:
+    explicit GameGenerator(MoveSelector &selector) : m_selector{&selector} {}
+
+    auto play_line(Cursor cursor, size_t plies, size_t depth) -> void {
+        for (size_t ply = 0; ply < plies; ++ply) {
+            const auto moves = cursor.position().all_legal_moves();
+            if (moves.empty()) {
+                return;
+            }
+            const auto move_index = m_selector->index(moves.size());
+            auto next = cursor.play_move(moves[move_index]);
+            if (depth > 0) {
+                annotate(next, ply);
+                if (ply % 5 == 2 && moves.size() > 1) {
+                    const auto alternative = (move_index + 1 + m_selector->index(moves.size() - 1)) % moves.size();
+                    if (auto variation = next.add_variation(moves[alternative]); variation.has_value()) {
+                        play_line(*variation, variation_plies, depth - 1);
+                    }
+                }
+            }
+            cursor = next;
+        }
+    }
+private:
+    MoveSelector *m_selector;
+
+    auto annotate(Cursor &cursor, size_t ply) -> void {
+        if (ply % 3 == 0) {
+            cursor.set_comment(std::string{comments[m_selector->index(comments.size())]});
+        }
+        if (ply % 4 == 1) {
+            cursor.add_nag(static_cast<int>(1 + m_selector->index(6)));
+        }
+    }
+};
+
+} // namespace
+
+auto generate_corpus(const CorpusSpec &spec) -> Corpus {
+    MoveSelector selector{spec.seed};
+    GameGenerator generator{selector};
+    std::ostringstream pgn;
+    PGNWriter writer{pgn};
+    for (size_t index = 0; index < spec.game_count; ++index) {
+        GameMetadata metadata;
+        const auto number = std::to_string(index + 1);
+        metadata.add("Event", spec.name);
+        metadata.add("Site", "Benchmark");
+        metadata.add("Date", "2024.01.01");
+        metadata.add("Round", number);
+        metadata.add("White", "White " + number);
+        metadata.add("Black", "Black " + number);
+        metadata.add("Result", "*");
+        if (spec.fen_start) {
+            metadata.add("SetUp", "1");
+            metadata.add("FEN", start_fens[index % start_fens.size()]);
+        }
+        Game game{metadata};
+        generator.play_line(game.edit(), spec.plies, spec.variation_depth);
+        writer.write_game(game);
+        pgn << '\n';
+    }
+    return Corpus{.name = spec.name, .game_count = spec.game_count, .pgn = pgn.str()};
+}
+
+auto standard_corpora() -> std::vector<CorpusSpec> {
+    return {
+        CorpusSpec{.name = "short", .game_count = 1000, .plies = 40},
+        CorpusSpec{.name = "long", .game_count = 200, .plies = 200},
+        CorpusSpec{.name = "annotated", .game_count = 200, .plies = 80, .variation_depth = 3},
+        CorpusSpec{.name = "fen", .game_count = 500, .plies = 60, .fen_start = true},
+    };
+}
+
+} // namespace chessgame::bench
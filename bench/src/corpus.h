@@ -0,0 +1,60 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_BENCH_CORPUS_H
+#define CHESSGAME_BENCH_CORPUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace chessgame::bench {
+
+/**
+ * \brief Description of a generated benchmark corpus.
+ *
+ * The games are played with pseudo-random legal moves. The generator only
+ * depends on the seed, so that every run benchmarks the same PGN data.
+ */
+struct CorpusSpec {
+    std::string name;            ///< Name of the corpus in the reports.
+    size_t game_count{0};        ///< Number of games.
+    size_t plies{0};             ///< Maximum number of plies on the main line of every game.
+    size_t variation_depth{0};   ///< Maximum nesting of variations. 0 generates no variations and annotations.
+    bool fen_start{false};       ///< Start the games from FEN positions instead of the starting position.
+    uint64_t seed{0x42656E6368}; ///< Seed of the move selection.
+};
+
+/**
+ * \brief A generated benchmark corpus.
+ */
+struct Corpus {
+    std::string name;     ///< Name of the corpus in the reports.
+    size_t game_count{0}; ///< Number of games.
+    std::string pgn;      ///< The games as PGN data.
+};
+
+/**
+ * \brief Generate a corpus.
+ *
+ * \param spec Description of the corpus.
+ * \return The corpus.
+ */
+auto generate_corpus(const CorpusSpec &spec) -> Corpus;
+
+/**
+ * \brief The corpora used by the benchmarks.
+ *
+ * Short games, long games of 200 plies, heavily annotated games with nested
+ * variations and games starting from FEN positions.
+ * \return The corpus descriptions.
+ */
+auto standard_corpora() -> std::vector<CorpusSpec>;
+
+} // namespace chessgame::bench
+
+#endif
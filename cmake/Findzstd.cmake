@@ -0,0 +1,19 @@
+# Find the Zstandard library.
+#
+# Defines the imported target zstd::zstd and the variables zstd_FOUND,
+# zstd_INCLUDE_DIR and zstd_LIBRARY.
+
+find_path(zstd_INCLUDE_DIR zstd.h)
+find_library(zstd_LIBRARY NAMES zstd zstd_static)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(zstd REQUIRED_VARS zstd_LIBRARY zstd_INCLUDE_DIR)
+mark_as_advanced(zstd_INCLUDE_DIR zstd_LIBRARY)
+
+if(zstd_FOUND AND NOT TARGET zstd::zstd)
+    add_library(zstd::zstd UNKNOWN IMPORTED)
+    set_target_properties(zstd::zstd PROPERTIES
+        IMPORTED_LOCATION "${zstd_LIBRARY}"
+        INTERFACE_INCLUDE_DIRECTORIES "${zstd_INCLUDE_DIR}"
+    )
+endif()
@@ -22,6 +22,8 @@ class ChessGameConan(ConanFile):
         "src/*",
         "include/*",
         "test/*",
+        "bench/*",
+        "support/*",
         "LICENSE",
     )
 
@@ -30,6 +32,8 @@ class ChessGameConan(ConanFile):
 
     def requirements(self):
         self.requires("chesscore/1.0.0", transitive_headers=True)
+        self.requires("zlib/[>=1.2.11 <2]")
+        self.requires("zstd/[>=1.5 <2]")
         self.test_requires("catch2/3.7.1")
 
     def config_options(self):
@@ -45,6 +49,7 @@ class ChessGameConan(ConanFile):
 
     def generate(self):
         deps = CMakeDeps(self)
+        deps.set_property("zstd", "cmake_target_name", "zstd::zstd")
         deps.generate()
         tc = CMakeToolchain(self)
         tc.generate()
@@ -61,3 +66,5 @@ class ChessGameConan(ConanFile):
     def package_info(self):
         self.cpp_info.libs = ["ChessGame"]
         self.cpp_info.set_property("cmake_target_name", "ChessGame::ChessGame")
+        if self.settings.os in ["Linux", "FreeBSD"]:
+            self.cpp_info.system_libs = ["pthread"]
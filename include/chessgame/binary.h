@@ -0,0 +1,200 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_BINARY_H
+#define CHESSGAME_BINARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "chessgame/game.h"
+
+#include "chesscore/move.h"
+
+namespace chessgame {
+
+/**
+ * \brief Version of the binary game format written by BinaryGameWriter.
+ *
+ * Version 2 added move indices, version 3 stores them in the canonical order
+ * of sort_legal_moves(). Move indices of version 2 are read in the order of
+ * the move generator of chesscore.
+ */
+constexpr uint32_t binary_format_version{3};
+
+/**
+ * \brief Maximum size of the record of a single game in the binary game format.
+ *
+ * Readers reject larger records as corrupted, before allocating memory for
+ * them, and writers refuse to write them.
+ */
+constexpr size_t max_binary_record_size{size_t{64} * 1024 * 1024};
+
+/**
+ * \brief Encode a move in the lower 23 bits of an integer.
+ *
+ * This is the move encoding of the binary game format.
+ * \param move The move.
+ * \return The code of the move.
+ */
+auto encode_move(const chesscore::Move &move) -> uint32_t;
+
+/**
+ * \brief Decode a move encoded by encode_move().
+ *
+ * Bits above the move code are ignored. Throws a ChessGameError, if the code
+ * does not describe a move.
+ * \param code The code of the move.
+ * \return The move.
+ */
+auto decode_move(uint32_t code) -> chesscore::Move;
+
+/**
+ * \brief Sort legal moves into the canonical order of move indices.
+ *
+ * The moves are sorted by their codes (see encode_move()), so that the order
+ * does not depend on the move generator. The order is part of the binary game
+ * format and must not change.
+ * \param legal_moves The legal moves of a position.
+ */
+auto sort_legal_moves(chesscore::MoveList &legal_moves) -> void;
+
+/**
+ * \brief Encode a move as its index in the legal moves of its position.
+ *
+ * A position never has more than 256 legal moves, so the index fits into a
+ * single byte. It can only be decoded with the same list of legal moves, so
+ * the list should be sorted with sort_legal_moves().
+ * \param move The move.
+ * \param legal_moves The legal moves of the position before the move.
+ * \return The index or nullopt, if the move is not in the list.
+ */
+auto encode_move_index(const chesscore::Move &move, const chesscore::MoveList &legal_moves) -> std::optional<uint8_t>;
+
+/**
+ * \brief Decode a move encoded by encode_move_index().
+ *
+ * \param index The index of the move.
+ * \param legal_moves The legal moves of the position before the move.
+ * \return The move or nullopt, if the index is out of range.
+ */
+auto decode_move_index(uint8_t index, const chesscore::MoveList &legal_moves) -> std::optional<chesscore::Move>;
+
+/**
+ * \brief Options of the binary game format.
+ */
+struct BinaryGameOptions {
+    /**
+     * \brief Store the moves as indices into the legal moves of their positions.
+     *
+     * Every move takes a single byte instead of four, but the legal moves of
+     * every position with children have to be generated for writing and
+     * reading the games. The reader caches the SAN strings of the moves (see
+     * GameNode::san()), as it generates the legal moves anyway.
+     */
+    bool move_indices{false};
+};
+
+/**
+ * \brief Writer for the binary game format.
+ *
+ * The binary format stores games compactly, so that they can be loaded again
+ * without parsing any SAN moves. A stream starts with a header containing
+ * the options, followed by one record per game. A record contains the
+ * metadata (including the FEN tag describing the start position) and the game
+ * tree in pre-order. Every move is stored in four bytes: from and to square
+ * and promotion, the moved and the captured piece, and the shape of the tree
+ * at the node. With BinaryGameOptions::move_indices, every move is stored in
+ * one byte for the index of the move and one byte for the shape of the tree.
+ */
+class BinaryGameWriter {
+public:
+    /**
+     * \brief Create a writer and write the stream header.
+     *
+     * \param out_stream The output stream.
+     * \param options Options of the format.
+     */
+    explicit BinaryGameWriter(std::ostream &out_stream, const BinaryGameOptions &options = {});
+
+    /**
+     * \brief Append a game to the stream.
+     *
+     * With BinaryGameOptions::move_indices, throws a ChessGameError, if a move
+     * of the game is not legal. Also throws a ChessGameError, if the record of
+     * the game would exceed max_binary_record_size.
+     * \param game The game.
+     */
+    auto write_game(const Game &game) -> void;
+private:
+    std::ostream *m_out_stream;  ///< The output stream.
+    BinaryGameOptions m_options; ///< Options of the format.
+    std::string m_record;        ///< Buffer for the record of the current game.
+};
+
+/**
+ * \brief Reader for the binary game format.
+ *
+ * Reads games written by a BinaryGameWriter. Throws a ChessGameError, if the
+ * data is not in the binary game format or is corrupted.
+ */
+class BinaryGameReader {
+public:
+    /**
+     * \brief Create a reader for a stream and read the stream header.
+     *
+     * \param in_stream The input stream.
+     */
+    explicit BinaryGameReader(std::istream &in_stream);
+
+    /**
+     * \brief Create a reader for data in memory and read the header.
+     *
+     * The data is not copied and has to outlive the reader.
+     * \param data The input data.
+     */
+    explicit BinaryGameReader(std::string_view data);
+
+    /**
+     * \brief The format version of the input.
+     *
+     * \return Version from the stream header.
+     */
+    [[nodiscard]] auto version() const -> uint32_t { return m_version; }
+
+    /**
+     * \brief The options of the format of the input.
+     *
+     * \return Options from the stream header.
+     */
+    [[nodiscard]] auto options() const -> const BinaryGameOptions & { return m_options; }
+
+    /**
+     * \brief Read the next game.
+     *
+     * \return The game or nullopt at the end of the input.
+     */
+    auto read_game() -> std::optional<Game>;
+private:
+    std::istream *m_in_stream{nullptr}; ///< The input stream, if the input is not in memory.
+    std::string_view m_data;            ///< The remaining input, if the input is in memory.
+    std::string m_record;               ///< Buffer for the record of the current game from a stream.
+    uint32_t m_version{0};              ///< Format version of the input.
+    BinaryGameOptions m_options;        ///< Options of the format of the input.
+
+    auto read_header() -> void;
+    auto read_bytes(size_t count) -> std::optional<std::string_view>;
+    auto read_record_size() -> std::optional<size_t>;
+};
+
+} // namespace chessgame
+
+#endif
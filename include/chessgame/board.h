@@ -0,0 +1,250 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_BOARD_H
+#define CHESSGAME_BOARD_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "chessgame/san.h"
+
+#include "chesscore/move.h"
+#include "chesscore/piece.h"
+#include "chesscore/square.h"
+
+namespace chessgame {
+
+/**
+ * \brief Index of a square.
+ *
+ * Squares are numbered from 0 (a1) to 63 (h8), rank by rank.
+ * \param square The square.
+ * \return Index of the square.
+ */
+inline auto square_index(const chesscore::Square &square) -> int {
+    return (square.file().name() - 'a') + 8 * (square.rank().rank - 1);
+}
+
+/**
+ * \brief The square with an index.
+ *
+ * \param index Index of the square, see square_index().
+ * \return The square.
+ */
+inline auto index_square(int index) -> chesscore::Square {
+    return chesscore::Square{chesscore::File{static_cast<char>('a' + index % 8)}, chesscore::Rank{index / 8 + 1}};
+}
+
+/**
+ * \brief A lightweight piece placement board.
+ *
+ * Stores the pieces on the squares, the side to move, the castling rights and
+ * the en passant square, and applies moves to them. In contrast to
+ * chesscore::Position, the contents of single squares can be queried cheaply.
+ * This allows resolving SAN moves and computing position keys without
+ * generating all legal moves of a position.
+ *
+ * The board maintains a 64-bit Zobrist key of the position, that is updated
+ * incrementally with every move. Equal positions have equal keys, independent
+ * of the moves that lead to them.
+ */
+class Board {
+public:
+    static constexpr uint8_t white_kingside{1};  ///< White may castle kingside.
+    static constexpr uint8_t white_queenside{2}; ///< White may castle queenside.
+    static constexpr uint8_t black_kingside{4};  ///< Black may castle kingside.
+    static constexpr uint8_t black_queenside{8}; ///< Black may castle queenside.
+
+    /**
+     * \brief Create a board from a FEN string.
+     *
+     * Only the piece placement, the side to move, the castling rights and the
+     * en passant square are used.
+     * \param fen The FEN string.
+     * \return The board or nullopt, if the FEN string cannot be parsed.
+     */
+    static auto from_fen(std::string_view fen) -> std::optional<Board>;
+
+    /**
+     * \brief The board of the standard starting position.
+     *
+     * \return The board.
+     */
+    static auto starting_position() -> Board;
+
+    /**
+     * \brief The FEN string of the board.
+     *
+     * The board does not track the move counters, so the halfmove clock is
+     * always 0 and the fullmove number is always 1.
+     * \return The FEN string.
+     */
+    [[nodiscard]] auto fen() const -> std::string;
+
+    /**
+     * \brief The piece on a square.
+     *
+     * \param square The square.
+     * \return The piece or nullopt, if the square is empty.
+     */
+    [[nodiscard]] auto piece_at(const chesscore::Square &square) const -> std::optional<chesscore::Piece> { return piece_at(square_index(square)); }
+
+    /**
+     * \brief The piece on a square.
+     *
+     * \param index Index of the square.
+     * \return The piece or nullopt, if the square is empty.
+     */
+    [[nodiscard]] auto piece_at(int index) const -> std::optional<chesscore::Piece>;
+
+    /**
+     * \brief The side to move.
+     *
+     * \return Color of the side to move.
+     */
+    [[nodiscard]] auto side_to_move() const -> chesscore::Color { return m_side_to_move; }
+
+    /**
+     * \brief The castling rights.
+     *
+     * \return Combination of the castling flags.
+     */
+    [[nodiscard]] auto castling_rights() const -> uint8_t { return m_castling_rights; }
+
+    /**
+     * \brief The en passant target square.
+     *
+     * \return Index of the square, that a pawn skipped with its last move, or -1.
+     */
+    [[nodiscard]] auto en_passant_index() const -> int { return m_en_passant; }
+
+    /**
+     * \brief The Zobrist key of the position.
+     *
+     * The key covers the piece placement, the side to move, the castling
+     * rights and the en passant square. The en passant square is only taken
+     * into account, if a pawn of the side to move can capture en passant.
+     * The key is never 0, so that 0 can mark an unknown key.
+     * \return The key.
+     */
+    [[nodiscard]] auto key() const -> uint64_t;
+
+    /**
+     * \brief Apply a move.
+     *
+     * The move is not checked for legality.
+     * \param move The move.
+     */
+    auto make_move(const chesscore::Move &move) -> void;
+
+    /**
+     * \brief Check, if a square is attacked.
+     *
+     * \param index Index of the square.
+     * \param by Color of the attacking side.
+     * \return If any piece of the attacking side attacks the square.
+     */
+    [[nodiscard]] auto is_attacked(int index, chesscore::Color by) const -> bool;
+
+    /**
+     * \brief Check, if the king of a side is in check.
+     *
+     * \param color Color of the king.
+     * \return If the king is attacked.
+     */
+    [[nodiscard]] auto in_check(chesscore::Color color) const -> bool;
+
+    /**
+     * \brief Check, if a move leaves the own king in check.
+     *
+     * \param move The move of the side to move.
+     * \return If the move is legal with respect to the own king.
+     */
+    [[nodiscard]] auto keeps_king_safe(const chesscore::Move &move) const -> bool;
+
+    auto operator==(const Board &other) const -> bool = default;
+private:
+    std::array<uint8_t, 64> m_squares{};                      ///< Piece codes of the squares, 0 for empty squares.
+    chesscore::Color m_side_to_move{chesscore::Color::White}; ///< The side to move.
+    uint8_t m_castling_rights{0};                             ///< Combination of the castling flags.
+    int8_t m_en_passant{-1};                                  ///< Index of the en passant square or -1.
+    uint64_t m_key{0};                                        ///< Zobrist key without the en passant square.
+
+    auto set_square(int index, uint8_t code) -> void;
+    auto set_castling_rights(uint8_t rights) -> void;
+    auto compute_key() -> void;
+    [[nodiscard]] auto king_index(chesscore::Color color) const -> int;
+    [[nodiscard]] auto has_piece(int file, int rank, uint8_t code) const -> bool;
+    [[nodiscard]] auto slider_attacks(int file, int rank, int file_step, int rank_step, uint8_t code, uint8_t queen_code) const -> bool;
+};
+
+/**
+ * \brief Find the move described by a SAN move on a board.
+ *
+ * Only the pieces of the moving piece type that can reach the target square
+ * are considered, and only these are checked for legality. All legal moves
+ * do not have to be generated.
+ * \param san_move The SAN move.
+ * \param board The board before the move.
+ * \return The move or nullopt, if no or more than one legal move matches.
+ */
+auto resolve_san_move(const SANMove &san_move, const Board &board) -> std::optional<chesscore::Move>;
+
+/**
+ * \brief Find the move described by a SAN move and format its SAN string.
+ *
+ * Like resolve_san_move(), but also appends the SAN string of the found move
+ * to a buffer, as append_san_move() would format it. This can differ from
+ * the given SAN move, e.g. if it contains an unnecessary disambiguation.
+ * \param san_move The SAN move.
+ * \param board The board before the move.
+ * \param san The buffer. Nothing is appended, if no move is found.
+ * \return The move or nullopt, if no or more than one legal move matches.
+ */
+auto resolve_san_move(const SANMove &san_move, const Board &board, std::string &san) -> std::optional<chesscore::Move>;
+
+/**
+ * \brief Check, if the side to move is checkmated.
+ *
+ * Only the moves that can get the king out of check are tried, so that all
+ * legal moves do not have to be generated.
+ * \param board The board.
+ * \return If the side to move is in check and has no legal move.
+ */
+auto is_checkmate(const Board &board) -> bool;
+
+/**
+ * \brief Generate all legal moves on a board.
+ *
+ * Uses the same move resolution as resolve_san_move(). The moves are the same
+ * as the ones of chesscore::Position::all_legal_moves(), but their order may
+ * differ. This is mostly useful for checking the board against chesscore.
+ * \param board The board.
+ * \return The legal moves of the side to move.
+ */
+auto legal_moves(const Board &board) -> chesscore::MoveList;
+
+/**
+ * \brief Append the SAN string of a move on a board to a buffer.
+ *
+ * Produces the same string as append_san_move() with the list of all legal
+ * moves, but only the pieces that can reach the target square are checked,
+ * like in resolve_san_move(). The check or checkmate suffix is not appended.
+ * Nothing is appended, if the move is not legal on the board.
+ * \param out The buffer.
+ * \param move The move to be converted.
+ * \param board The board before the move.
+ * \return If the move could be converted.
+ */
+auto append_san_move(std::string &out, const chesscore::Move &move, const Board &board) -> bool;
+
+} // namespace chessgame
+
+#endif
@@ -8,8 +8,16 @@
 #define CHESSGAME_CURSOR_H
 
 #include <cstddef>
+#include <memory_resource>
 #include <optional>
-
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "chessgame/board.h"
+#include "chessgame/traversal.h"
 #include "chessgame/tree.h"
 
 namespace chessgame {
@@ -28,15 +36,12 @@ public:
     /**
      * \brief Create a cursor for a game and a specific node.
      *
-     * Neither the game nor the node may be null pointers.
+     * The game may not be a null pointer and the node has to exist in the
+     * game.
      * \param game The game.
-     * \param node The node.
+     * \param node The id of the node.
      */
-    BaseCursor(GameType *game, const std::shared_ptr<NodeType> &node) : m_game(game), m_node{node} {
-        if ((m_game == nullptr) || !node) {
-            throw ChessGameError("Invalid game or node provided to Cursor constructor.");
-        }
-    }
+    BaseCursor(GameType *game, NodeId node) : BaseCursor{game, node, std::nullopt, std::nullopt} {}
 
     /**
      * \brief Implicit conversion operator.
@@ -44,7 +49,7 @@ public:
      * Allows implicit conversion from Cursor to ConstCursor.
      * \return A ConstCursor.
      */
-    operator BaseCursor<const Game, const GameNode>() const { return BaseCursor<const Game, const GameNode>{m_game, m_node}; }
+    operator BaseCursor<const Game, const GameNode>() const { return BaseCursor<const Game, const GameNode>{m_game, m_node, m_position, m_board}; }
 
     /**
      * \brief Get the parent of the current node.
@@ -52,9 +57,9 @@ public:
      * \return Cursor to the parent node, if it exists.
      */
     [[nodiscard]] auto parent() const -> std::optional<BaseCursor> {
-        const auto parent_node = m_node.lock()->parent();
-        if (parent_node) {
-            return BaseCursor{m_game, parent_node};
+        const auto parent_node = tree_node().parent();
+        if (parent_node != NodeId::Invalid) {
+            return BaseCursor{m_game, parent_node, stored_position(parent_node), std::nullopt};
         }
         return {};
     }
@@ -67,14 +72,17 @@ public:
      * variations.
      * \return Number of children.
      */
-    [[nodiscard]] auto child_count() const -> size_t { return m_node.lock()->child_count(); }
+    [[nodiscard]] auto child_count() const -> size_t { return m_game->tree().child_count(m_node); }
 
     /**
      * \brief Check if the current node has variations.
      *
      * \return If the current node has variations.
      */
-    [[nodiscard]] auto has_variations() const -> bool { return child_count() > 1; }
+    [[nodiscard]] auto has_variations() const -> bool {
+        const auto first_child = tree_node().first_child();
+        return first_child != NodeId::Invalid && m_game->tree().node(first_child).next_sibling() != NodeId::Invalid;
+    }
 
     /**
      * \brief Check if the current node is the start of a variation.
@@ -84,8 +92,8 @@ public:
      * \return If the current node is the start of a variation.
      */
     [[nodiscard]] auto starts_variation() const -> bool {
-        const auto parent_node = m_node.lock()->parent();
-        return parent_node && (m_node.lock() != parent_node->get_child(0));
+        const auto parent_node = tree_node().parent();
+        return parent_node != NodeId::Invalid && m_game->tree().node(parent_node).first_child() != m_node;
     }
 
     /**
@@ -95,10 +103,7 @@ public:
      * that this node starts the i-th variation in its parent.
      * \return The number of the variation.
      */
-    [[nodiscard]] auto variation_number() const -> int {
-        const auto parent_node = m_node.lock()->parent();
-        return parent_node ? parent_node->get_child_number(m_node.lock()) : 0;
-    }
+    [[nodiscard]] auto variation_number() const -> int { return m_game->tree().child_number(m_node); }
 
     /**
      * \brief Get a child node of the current node.
@@ -107,9 +112,22 @@ public:
      * \return Cursor to the child node, if it exists.
      */
     [[nodiscard]] auto child(size_t index) const -> std::optional<BaseCursor> {
-        const auto child_node = m_node.lock()->get_child(index);
-        if (child_node) {
-            return BaseCursor{m_game, child_node};
+        const auto child_node = m_game->tree().child(m_node, index);
+        if (child_node != NodeId::Invalid) {
+            const auto &child_move = m_game->tree().node(child_node).move();
+            auto next_board = m_board;
+            if (next_board.has_value()) {
+                next_board->make_move(child_move);
+            }
+            if (const auto *child_position = m_game->tree().position(child_node); child_position != nullptr) {
+                return BaseCursor{m_game, child_node, *child_position, std::move(next_board)};
+            }
+            if (!m_position.has_value()) {
+                return BaseCursor{m_game, child_node, std::nullopt, std::move(next_board)};
+            }
+            auto next_position = *m_position;
+            next_position.make_move(child_move);
+            return BaseCursor{m_game, child_node, std::move(next_position), std::move(next_board)};
         }
         return {};
     }
@@ -119,7 +137,22 @@ public:
      *
      * \return Id of the referenced node.
      */
-    [[nodiscard]] auto node_id() const -> NodeId { return m_node.lock()->id(); }
+    [[nodiscard]] auto node_id() const -> NodeId { return m_node; }
+
+    /**
+     * \brief Get a lightweight read-only view of the referenced node.
+     *
+     * The view navigates the tree without tracking positions, see NodeView.
+     * \return View of the node.
+     */
+    [[nodiscard]] auto view() const -> NodeView { return {&std::as_const(*m_game).tree(), m_node}; }
+
+    /**
+     * \brief Get the distance of the node from the root of the game tree.
+     *
+     * \return Number of moves from the root to this node.
+     */
+    [[nodiscard]] auto ply() const -> size_t { return tree_node().ply(); }
 
     /**
      * \brief Get the position object represented by this game node.
@@ -128,22 +161,112 @@ public:
      * stored in the node already, in which case it is simply returned.
      * Otherwise, the position is calculated by following the moves from an
      * ancestor that stores a position.
+     *
+     * The cursor remembers the position. Cursors obtained from this cursor via
+     * child() derive their position from it by applying a single move.
+     * Cursors obtained via play_move() only do so, if the board is not known.
      * \return The position of this game node.
      */
-    [[nodiscard]] auto position() const -> chesscore::Position { return m_node.lock()->calculate_position(); }
+    [[nodiscard]] auto position() const -> const chesscore::Position & {
+        if (!m_position.has_value()) {
+            m_position = m_game->tree().calculate_position(m_node);
+        }
+        return *m_position;
+    }
+
+    /**
+     * \brief Check, if the game tree stores the position of the node.
+     *
+     * Whether positions are stored is decided by the position cache policy of
+     * the game.
+     * \return If the position is stored in the game tree.
+     */
+    [[nodiscard]] auto has_stored_position() const -> bool { return m_game->tree().position(m_node) != nullptr; }
+
+    /**
+     * \brief Get the board of this game node.
+     *
+     * Like the position, the board is calculated once and remembered by the
+     * cursor. Cursors obtained via child() or play_move() derive their board
+     * from it.
+     * \return The board or nullptr, if the start position of the game could not be read.
+     */
+    [[nodiscard]] auto board() const -> const Board * {
+        if (!m_board.has_value()) {
+            m_board = m_game->board(m_node);
+        }
+        return m_board.has_value() ? &*m_board : nullptr;
+    }
+
+    /**
+     * \brief Get the key of the position of this game node.
+     *
+     * \return The key or 0, if it is not known.
+     */
+    [[nodiscard]] auto position_key() const -> uint64_t { return tree_node().key(); }
+
+    /**
+     * \brief Get the cached SAN string of the move that lead to this position.
+     *
+     * \return The SAN string or an empty string, if it is not cached.
+     */
+    [[nodiscard]] auto san() const -> std::string_view { return tree_node().san(); }
 
     /**
      * \brief Play a move at the current cursor position.
      *
-     * Appends the given move to the current position of the game.
+     * Appends the given move to the current position of the game. If the
+     * board of the position is known, the SAN string of the move is cached in
+     * the new node, see GameNode::san(). The position of the new node is only
+     * calculated, if the position cache policy of the game stores it, or if
+     * the board is not known.
      * \param move The move to apply.
      * \return A cursor pointing to the new position.
      */
     [[nodiscard]] auto play_move(const chesscore::Move &move) -> BaseCursor
     requires(!std::is_const_v<GameType>)
     {
-        const auto node_ptr = m_game->add_node(m_node.lock(), move);
-        return {m_game, node_ptr};
+        std::string san;
+        if (const auto *current_board = board(); current_board != nullptr) {
+            append_san_move(san, move, *current_board);
+        }
+        return play_move(move, san);
+    }
+
+    /**
+     * \brief Play a move with a known SAN string at the current cursor position.
+     *
+     * Like play_move(const chesscore::Move &), but the SAN string of the move
+     * is not formatted again. The string has to be formatted like
+     * append_san_move() does it.
+     * \param move The move to apply.
+     * \param san The SAN string of the move without check or checkmate suffix. Nothing is cached, if it is empty.
+     * \return A cursor pointing to the new position.
+     */
+    [[nodiscard]] auto play_move(const chesscore::Move &move, std::string_view san) -> BaseCursor
+    requires(!std::is_const_v<GameType>)
+    {
+        std::optional<Board> next_board;
+        std::optional<chesscore::Position> next_position;
+        if (const auto *current_board = board(); current_board != nullptr) {
+            next_board = *current_board;
+            next_board->make_move(move);
+        } else {
+            // Without a board, the position is the only state to derive the next node from.
+            next_position = position();
+            next_position->make_move(move);
+        }
+        const auto node_id = m_game->add_node(m_node, move, next_position, next_board);
+        if (!san.empty() && next_board.has_value()) {
+            if (next_board->in_check(next_board->side_to_move())) {
+                std::string checking_san{san};
+                checking_san.push_back(is_checkmate(*next_board) ? '#' : '+');
+                m_game->tree().set_san(node_id, checking_san);
+            } else {
+                m_game->tree().set_san(node_id, san);
+            }
+        }
+        return {m_game, node_id, std::move(next_position), std::move(next_board)};
     }
 
     /**
@@ -158,11 +281,10 @@ public:
     [[nodiscard]] auto add_variation(const chesscore::Move &move) -> std::optional<BaseCursor>
     requires(!std::is_const_v<GameType>)
     {
-        const auto parent_cursor = parent();
-        if (parent_cursor) {
-            const auto parent_node = parent_cursor->m_node;
-            const auto node_ptr = m_game->add_node(parent_node.lock(), move);
-            return BaseCursor{m_game, node_ptr};
+        const auto parent_node = tree_node().parent();
+        if (parent_node != NodeId::Invalid) {
+            const auto node_id = m_game->add_node(parent_node, move);
+            return BaseCursor{m_game, node_id};
         }
         return {};
     }
@@ -172,24 +294,24 @@ public:
      *
      * \return The comment.
      */
-    auto comment() const -> std::string { return m_node.lock()->comment(); }
+    auto comment() const -> const std::pmr::string & { return m_game->tree().comment(m_node); }
 
     /**
      * \brief Get the pre-move comment for the current node.
      *
      * \return The pre-move comment.
      */
-    auto premove_comment() const -> std::string { return m_node.lock()->premove_comment(); }
+    auto premove_comment() const -> const std::pmr::string & { return m_game->tree().premove_comment(m_node); }
 
     /**
      * \brief Sets the comment for the current node.
      *
      * \param comment The comment.
      */
-    auto set_comment(const std::string &comment) -> void
+    auto set_comment(std::string_view comment) -> void
     requires(!std::is_const_v<GameType>)
     {
-        m_node.lock()->set_comment(comment);
+        m_game->tree().set_comment(m_node, comment);
     }
 
     /**
@@ -197,10 +319,10 @@ public:
      *
      * \param comment The comment.
      */
-    auto append_comment(const std::string &comment) -> void
+    auto append_comment(std::string_view comment) -> void
     requires(!std::is_const_v<GameType>)
     {
-        m_node.lock()->append_comment(comment);
+        m_game->tree().append_comment(m_node, comment);
     }
 
     /**
@@ -208,10 +330,10 @@ public:
      *
      * \param comment The comment.
      */
-    auto set_premove_comment(const std::string &comment) -> void
+    auto set_premove_comment(std::string_view comment) -> void
     requires(!std::is_const_v<GameType>)
     {
-        m_node.lock()->set_premove_comment(comment);
+        m_game->tree().set_premove_comment(m_node, comment);
     }
 
     /**
@@ -219,29 +341,27 @@ public:
      *
      * \param comment The comment.
      */
-    auto append_premove_comment(const std::string &comment) -> void
+    auto append_premove_comment(std::string_view comment) -> void
     requires(!std::is_const_v<GameType>)
     {
-        m_node.lock()->append_premove_comment(comment);
+        m_game->tree().append_premove_comment(m_node, comment);
     }
 
     /**
      * \brief Access the GameNode references by this cursor.
      *
-     * Get access to the GameNode referenced by this cursor.
+     * Get access to the GameNode referenced by this cursor. The reference is
+     * invalidated, when nodes are added to the game.
      */
-    auto node() -> std::shared_ptr<NodeType>
-    requires(!std::is_const_v<GameType>)
-    {
-        return m_node.lock();
-    }
+    auto node() const -> const GameNode * { return &tree_node(); }
 
     /**
-     * \brief Access the GameNode references by this cursor.
+     * \brief Returns the lit of NAGs for this node.
      *
-     * Get access to the GameNode referenced by this cursor.
+     * The list of Numeric Annotation Glyphs (NAG) for this node are returned.
+     * \return List of NAGs.
      */
-    auto node() const -> std::shared_ptr<const NodeType> { return m_node.lock(); }
+    auto nags() const -> const std::pmr::vector<int> & { return std::as_const(m_game->tree()).nags(m_node); }
 
     /**
      * \brief Returns the lit of NAGs for this node.
@@ -249,19 +369,33 @@ public:
      * The list of Numeric Annotation Glyphs (NAG) for this node are returned.
      * \return List of NAGs.
      */
-    auto nags() const -> const std::vector<int> & { return m_node.lock()->nags(); }
+
+    auto nags() -> std::pmr::vector<int> &
+    requires(!std::is_const_v<GameType>)
+    {
+        return m_game->tree().nags(m_node);
+    }
 
     /**
-     * \brief Returns the lit of NAGs for this node.
+     * \brief Appends a NAG to this node.
      *
-     * The list of Numeric Annotation Glyphs (NAG) for this node are returned.
-     * \return List of NAGs.
+     * \param nag The Numeric Annotation Glyph.
      */
+    auto add_nag(int nag) -> void
+    requires(!std::is_const_v<GameType>)
+    {
+        m_game->tree().add_nag(m_node, nag);
+    }
 
-    auto nags() -> std::vector<int> &
+    /**
+     * \brief Replaces the NAGs of this node.
+     *
+     * \param nags List of Numeric Annotation Glyphs.
+     */
+    auto set_nags(std::span<const int> nags) -> void
     requires(!std::is_const_v<GameType>)
     {
-        return m_node.lock()->nags();
+        m_game->tree().set_nags(m_node, nags);
     }
 
     /**
@@ -271,7 +405,7 @@ public:
      * The move that lead to this position is returned.
      * \return Move that lead to this position.
      */
-    auto move() const -> const chesscore::Move & { return m_node.lock()->move(); }
+    auto move() const -> const chesscore::Move & { return tree_node().move(); }
 
     /**
      * \brief The player that is to move in this position.
@@ -299,10 +433,29 @@ public:
      * \param other The other cursor.
      * \return If the cursors are equal or not.
      */
-    auto operator==(const BaseCursor &other) const -> bool { return m_game == other.m_game && m_node.lock() == other.m_node.lock(); }
+    auto operator==(const BaseCursor &other) const -> bool { return m_game == other.m_game && m_node == other.m_node; }
 private:
     GameType *m_game{};
-    std::weak_ptr<NodeType> m_node;
+    NodeId m_node;
+    mutable std::optional<chesscore::Position> m_position; ///< The position of the node, once it is known.
+    mutable std::optional<Board> m_board;                  ///< The board of the node, once it is known.
+
+    template<typename OtherGameType, typename OtherNodeType>
+    friend class BaseCursor;
+
+    BaseCursor(GameType *game, NodeId node, std::optional<chesscore::Position> position, std::optional<Board> board)
+        : m_game(game), m_node{node}, m_position{std::move(position)}, m_board{std::move(board)} {
+        if ((m_game == nullptr) || !m_game->tree().contains(m_node)) {
+            throw ChessGameError("Invalid game or node provided to Cursor constructor.");
+        }
+    }
+
+    [[nodiscard]] auto tree_node() const -> const GameNode & { return m_game->tree().node(m_node); }
+
+    [[nodiscard]] auto stored_position(NodeId node) const -> std::optional<chesscore::Position> {
+        const auto *node_position = m_game->tree().position(node);
+        return node_position != nullptr ? std::optional<chesscore::Position>{*node_position} : std::nullopt;
+    }
 };
 
 /**
@@ -0,0 +1,209 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_DATABASE_H
+#define CHESSGAME_DATABASE_H
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "chessgame/game.h"
+#include "chessgame/pgn.h"
+
+namespace chessgame {
+
+/**
+ * \brief A read-only memory mapping of a file.
+ *
+ * The whole file is mapped into memory as long as the object exists.
+ */
+class MappedFile {
+public:
+    /**
+     * \brief Map a file into memory.
+     *
+     * Throws a ChessGameError, if the file cannot be mapped.
+     * \param path Path of the file.
+     */
+    explicit MappedFile(const std::filesystem::path &path);
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    auto operator=(const MappedFile &) -> MappedFile & = delete;
+    auto operator=(MappedFile &&other) noexcept -> MappedFile &;
+    ~MappedFile();
+
+    /**
+     * \brief The contents of the file.
+     *
+     * \return View of the mapped file contents.
+     */
+    [[nodiscard]] auto data() const -> std::string_view { return {m_data, m_size}; }
+private:
+    const char *m_data{nullptr}; ///< Start of the mapping.
+    size_t m_size{0};            ///< Size of the mapping.
+
+    auto unmap() -> void;
+};
+
+/**
+ * \brief Find the start offsets of all games in PGN data.
+ *
+ * Scans the data for game boundaries without parsing the games. A game starts
+ * with its tag section.
+ * \param data The PGN data.
+ * \return Byte offsets of the starts of the games.
+ */
+auto scan_game_offsets(std::string_view data) -> std::vector<size_t>;
+
+/**
+ * \brief How a PGNDatabase uses the index file of a PGN file.
+ */
+enum class IndexFileMode {
+    Ignore,    ///< Always scan the PGN file, do not read or write an index file.
+    Read,      ///< Use a matching index file, but never write one.
+    ReadWrite, ///< Use a matching index file, write a new one, if it is missing or stale.
+};
+
+/**
+ * \brief Random access to the games in a PGN file.
+ *
+ * The PGN file is memory-mapped and scanned once for game boundaries. The
+ * offsets of the games can be stored in an index file next to the PGN file,
+ * so that the scan is not necessary when the file is opened again. Each game
+ * can then be parsed by its number without reading the preceding games.
+ *
+ * The index file records the size, the modification time and a hash of the
+ * first and last block of the PGN file. An index file, that does not match the
+ * PGN file, was written on a machine with a different byte order, or contains
+ * offsets that are not strictly increasing, is ignored.
+ */
+class PGNDatabase {
+public:
+    /**
+     * \brief Open a PGN file using the default index file.
+     *
+     * By default, an existing index file is used, but no index file is
+     * written.
+     * \param path Path of the PGN file.
+     * \param mode How the index file is used.
+     */
+    explicit PGNDatabase(const std::filesystem::path &path, IndexFileMode mode = IndexFileMode::Read);
+
+    /**
+     * \brief Open a PGN file using the given index file.
+     *
+     * If the index file does not exist or does not match the PGN file, the
+     * PGN file is scanned. With IndexFileMode::ReadWrite, the index file is
+     * then written. A database is also usable, if the index file cannot be
+     * written.
+     * \param path Path of the PGN file.
+     * \param index_path Path of the index file.
+     * \param mode How the index file is used.
+     */
+    PGNDatabase(const std::filesystem::path &path, const std::filesystem::path &index_path, IndexFileMode mode = IndexFileMode::Read);
+
+    /**
+     * \brief The default path of the index file for a PGN file.
+     *
+     * \param path Path of the PGN file.
+     * \return Path of the index file.
+     */
+    static auto default_index_path(const std::filesystem::path &path) -> std::filesystem::path;
+
+    /**
+     * \brief The number of games in the database.
+     *
+     * \return Number of games.
+     */
+    [[nodiscard]] auto size() const -> size_t { return m_offsets.size(); }
+
+    /**
+     * \brief Check, if the database contains no games.
+     *
+     * \return If the database is empty.
+     */
+    [[nodiscard]] auto empty() const -> bool { return m_offsets.empty(); }
+
+    /**
+     * \brief The contents of the PGN file.
+     *
+     * \return View of the whole PGN file.
+     */
+    [[nodiscard]] auto data() const -> std::string_view { return m_file.data(); }
+
+    /**
+     * \brief The start offsets of all games.
+     *
+     * \return Byte offsets of the starts of the games.
+     */
+    [[nodiscard]] auto offsets() const -> const std::vector<size_t> & { return m_offsets; }
+
+    /**
+     * \brief The PGN data of a single game.
+     *
+     * \param index Number of the game, starting at 0.
+     * \return View of the PGN data of the game.
+     */
+    [[nodiscard]] auto game_data(size_t index) const -> std::string_view;
+
+    /**
+     * \brief Create a parser for a single game.
+     *
+     * The parser can be used to read the game and inspect the warnings.
+     * \param index Number of the game, starting at 0.
+     * \return Parser for the PGN data of the game.
+     */
+    [[nodiscard]] auto parser(size_t index) const -> PGNParser;
+
+    /**
+     * \brief The pool for the tag names and values of the games.
+     *
+     * All games read from the database share this pool.
+     * \return The pool.
+     */
+    [[nodiscard]] auto tag_pool() const -> const std::shared_ptr<TagPool> & { return m_tag_pool; }
+
+    /**
+     * \brief Parse a single game.
+     *
+     * \param index Number of the game, starting at 0.
+     * \return The game or nullopt, if the game is no standard chess game.
+     */
+    [[nodiscard]] auto read_game(size_t index) const -> std::optional<Game>;
+
+    /**
+     * \brief Read only the tags of a single game.
+     *
+     * The movetext of the game is not parsed.
+     * \param index Number of the game, starting at 0.
+     * \return The header of the game.
+     */
+    [[nodiscard]] auto read_header(size_t index) const -> GameHeader;
+
+    /**
+     * \brief Write the game offsets to an index file.
+     *
+     * \param index_path Path of the index file.
+     * \return If the index file was written.
+     */
+    auto save_index(const std::filesystem::path &index_path) const -> bool;
+private:
+    std::filesystem::path m_path;                                     ///< Path of the PGN file.
+    MappedFile m_file;                                                ///< The mapped PGN file.
+    std::vector<size_t> m_offsets;                                    ///< Start offsets of the games.
+    std::shared_ptr<TagPool> m_tag_pool{std::make_shared<TagPool>()}; ///< Pool for the tags of the games.
+
+    auto load_index(const std::filesystem::path &index_path) -> bool;
+};
+
+} // namespace chessgame
+
+#endif
@@ -0,0 +1,72 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_EXPORT_H
+#define CHESSGAME_EXPORT_H
+
+#include <cstddef>
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#include "chessgame/game.h"
+#include "chessgame/import.h"
+
+namespace chessgame {
+
+/**
+ * \brief Options for writing many games in parallel.
+ */
+struct ExportOptions {
+    unsigned int thread_count{0};   ///< Number of worker threads. 0 uses one thread per hardware thread.
+    size_t batch_size{16};          ///< Number of consecutive games a worker writes into one buffer.
+    size_t max_pending_batches{16}; ///< Maximum number of written batches, that wait for being copied to the output.
+};
+
+/**
+ * \brief Write games as PGN in parallel.
+ *
+ * The games are split into batches of consecutive games. Every worker thread
+ * writes the batches it takes with its own PGNWriter into a buffer, and the
+ * calling thread copies the buffers to the output in input order. The output
+ * is the same as from writing the games one after the other with a single
+ * PGNWriter. At most ExportOptions::max_pending_batches buffers are kept,
+ * so that the memory does not grow with the number of games.
+ *
+ * An exception thrown while writing a game, e.g. for an illegal move, stops
+ * the export and is rethrown. The output then ends with the batches before
+ * the failing one.
+ * \param games The games.
+ * \param out_stream The output stream.
+ * \param options Export options.
+ */
+auto export_games(std::span<const Game> games, std::ostream &out_stream, const ExportOptions &options = {}) -> void;
+
+/**
+ * \brief Write imported games as PGN in parallel.
+ *
+ * Games that could not be imported are skipped.
+ * \param games The imported games.
+ * \param out_stream The output stream.
+ * \param options Export options.
+ */
+auto export_games(const std::vector<ImportedGame> &games, std::ostream &out_stream, const ExportOptions &options = {}) -> void;
+
+/**
+ * \brief Write games as PGN into a file in parallel.
+ *
+ * The file is replaced. Throws a ChessGameError, if the file cannot be
+ * written.
+ * \param games The games.
+ * \param path Path of the file.
+ * \param options Export options.
+ */
+auto export_games(std::span<const Game> games, const std::filesystem::path &path, const ExportOptions &options = {}) -> void;
+
+} // namespace chessgame
+
+#endif
@@ -0,0 +1,182 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_FILTER_H
+#define CHESSGAME_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "chessgame/board.h"
+#include "chessgame/database.h"
+#include "chessgame/metadata.h"
+#include "chessgame/pgn.h"
+
+#include "chesscore/move.h"
+
+namespace chessgame {
+
+/**
+ * \brief Counters of a filter run.
+ */
+struct FilterStats {
+    size_t games{0};          ///< Number of games that were checked.
+    size_t matches{0};        ///< Number of matching games.
+    size_t movetext_games{0}; ///< Number of games, whose movetext had to be read.
+    size_t plies{0};          ///< Number of moves that were played to check the games.
+    size_t errors{0};         ///< Number of games, that could not be read. They do not match.
+    size_t skipped{0};        ///< Number of games of other variants, whose movetext was not checked. They do not match.
+};
+
+/**
+ * \brief Selects games from PGN data by their tags, positions and moves.
+ *
+ * A game matches, if every tag predicate accepts its tags, every position
+ * predicate accepts at least one position of its main line (including the
+ * start position), and every move predicate accepts at least one move of its
+ * main line. Variations are not checked.
+ *
+ * The tag predicates are checked first, on the tag section alone. The
+ * movetext is only read, if all tag predicates accept the game and there are
+ * position or move predicates. The moves are then played on a Board without
+ * building a game tree, and reading stops as soon as all position and move
+ * predicates are satisfied or the maximum ply is reached. Only games of
+ * standard chess can match position or move predicates.
+ */
+class GameFilter {
+public:
+    using TagPredicate = std::function<bool(const GameMetadata &)>;                     ///< Predicate on the tags of a game.
+    using PositionPredicate = std::function<bool(const Board &)>;                       ///< Predicate on a position of a game.
+    using MovePredicate = std::function<bool(const Board &, const chesscore::Move &)>; ///< Predicate on a move and the board before the move.
+
+    /**
+     * \brief Add a predicate on the tags of a game.
+     *
+     * \param predicate The predicate.
+     * \return Reference to this filter.
+     */
+    auto add_tag_predicate(TagPredicate predicate) -> GameFilter &;
+
+    /**
+     * \brief Require a tag to have a value.
+     *
+     * \param name Name of the tag.
+     * \param value The required value.
+     * \return Reference to this filter.
+     */
+    auto require_tag(std::string_view name, std::string_view value) -> GameFilter &;
+
+    /**
+     * \brief Add a predicate, that a position of the main line has to satisfy.
+     *
+     * \param predicate The predicate.
+     * \return Reference to this filter.
+     */
+    auto add_position_predicate(PositionPredicate predicate) -> GameFilter &;
+
+    /**
+     * \brief Require the main line to reach a position.
+     *
+     * \param key Key of the position, see Board::key().
+     * \return Reference to this filter.
+     */
+    auto require_position(uint64_t key) -> GameFilter &;
+
+    /**
+     * \brief Add a predicate, that a move of the main line has to satisfy.
+     *
+     * \param predicate The predicate.
+     * \return Reference to this filter.
+     */
+    auto add_move_predicate(MovePredicate predicate) -> GameFilter &;
+
+    /**
+     * \brief Only check the first moves of the main line.
+     *
+     * \param max_ply Number of plies that are checked.
+     * \return Reference to this filter.
+     */
+    auto set_max_ply(size_t max_ply) -> GameFilter &;
+
+    /**
+     * \brief Check, if the filter has to read the movetext of games.
+     *
+     * \return If there are position or move predicates.
+     */
+    [[nodiscard]] auto needs_movetext() const -> bool { return !m_position_predicates.empty() || !m_move_predicates.empty(); }
+
+    /**
+     * \brief Check, if a single game matches.
+     *
+     * \param game_data The PGN data of the game.
+     * \return If the game matches. Games that cannot be read do not match.
+     */
+    [[nodiscard]] auto matches(std::string_view game_data) const -> bool;
+
+    /**
+     * \brief Check, if a single game matches, and count the work.
+     *
+     * \param game_data The PGN data of the game.
+     * \param stats The counters, that are updated.
+     * \return If the game matches.
+     */
+    auto matches(std::string_view game_data, FilterStats &stats) const -> bool;
+private:
+    std::vector<TagPredicate> m_tag_predicates;
+    std::vector<PositionPredicate> m_position_predicates;
+    std::vector<MovePredicate> m_move_predicates;
+    std::optional<size_t> m_max_ply;
+
+    auto matches(PGNParser &parser, std::string_view game_data, FilterStats &stats) const -> bool;
+    auto matches_movetext(std::string_view movetext, Board board, FilterStats &stats) const -> std::optional<bool>;
+    auto matches_game(const Game &game, Board board, FilterStats &stats) const -> bool;
+
+    friend auto filter_games(std::string_view data, const std::vector<size_t> &offsets, const GameFilter &filter, std::ostream &out_stream) -> FilterStats;
+};
+
+/**
+ * \brief Copy the matching games of PGN data to a stream.
+ *
+ * The games are split by scanning for game boundaries. The data of matching
+ * games is copied unchanged, including the whitespace up to the next game.
+ * \param data The PGN data.
+ * \param filter The filter.
+ * \param out_stream The output stream.
+ * \return Counters of the run.
+ */
+auto filter_games(std::string_view data, const GameFilter &filter, std::ostream &out_stream) -> FilterStats;
+
+/**
+ * \brief Copy the matching games of a PGN database to a stream.
+ *
+ * Uses the game offsets of the database instead of scanning the data.
+ * \param database The PGN database.
+ * \param filter The filter.
+ * \param out_stream The output stream.
+ * \return Counters of the run.
+ */
+auto filter_games(const PGNDatabase &database, const GameFilter &filter, std::ostream &out_stream) -> FilterStats;
+
+/**
+ * \brief Copy the matching games at the given offsets to a stream.
+ *
+ * \param data The PGN data.
+ * \param offsets Start offsets of the games in the data, in ascending order.
+ * \param filter The filter.
+ * \param out_stream The output stream.
+ * \return Counters of the run.
+ */
+auto filter_games(std::string_view data, const std::vector<size_t> &offsets, const GameFilter &filter, std::ostream &out_stream) -> FilterStats;
+
+} // namespace chessgame
+
+#endif
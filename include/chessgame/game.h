@@ -7,7 +7,16 @@
 #ifndef CHESSGAME_GAME_H
 #define CHESSGAME_GAME_H
 
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "chessgame/board.h"
 #include "chessgame/cursor.h"
+#include "chessgame/memory.h"
 #include "chessgame/metadata.h"
 #include "chessgame/tree.h"
 
@@ -15,6 +24,85 @@
 
 namespace chessgame {
 
+/**
+ * \brief Strategy for storing positions in the nodes of a game tree.
+ *
+ * A position stored in a node does not have to be replayed from the root of
+ * the game. Storing more positions trades memory for the time needed to
+ * calculate positions.
+ */
+struct PositionCachePolicy {
+    /**
+     * \brief Which nodes store their position.
+     */
+    enum class Mode {
+        RootOnly,     ///< Only the root node stores its position.
+        Always,       ///< Every node stores its position.
+        EveryNPlies,  ///< Every node with a ply that is a multiple of the interval stores its position.
+        WhileParsing, ///< Every node stores its position while the game is built. The positions are dropped afterwards.
+    };
+
+    Mode mode{Mode::RootOnly}; ///< Which nodes store their position.
+    size_t interval{1};        ///< Distance between stored positions for Mode::EveryNPlies.
+
+    /**
+     * \brief Only store the position of the root node.
+     *
+     * \return The policy.
+     */
+    static constexpr auto root_only() -> PositionCachePolicy { return {.mode = Mode::RootOnly}; }
+
+    /**
+     * \brief Store the positions of all nodes.
+     *
+     * \return The policy.
+     */
+    static constexpr auto always() -> PositionCachePolicy { return {.mode = Mode::Always}; }
+
+    /**
+     * \brief Store the position of every n-th ply.
+     *
+     * \param plies Distance between stored positions.
+     * \return The policy.
+     */
+    static constexpr auto every_n_plies(size_t plies) -> PositionCachePolicy { return {.mode = Mode::EveryNPlies, .interval = plies == 0 ? 1 : plies}; }
+
+    /**
+     * \brief Store all positions while a game is being built.
+     *
+     * \return The policy.
+     */
+    static constexpr auto while_parsing() -> PositionCachePolicy { return {.mode = Mode::WhileParsing}; }
+
+    /**
+     * \brief Check, if a node at the given ply should store its position.
+     *
+     * \param ply The ply of the node.
+     * \return If the position should be stored.
+     */
+    [[nodiscard]] constexpr auto caches(size_t ply) const -> bool {
+        switch (mode) {
+        case Mode::RootOnly:
+            return ply == 0;
+        case Mode::EveryNPlies:
+            return ply % interval == 0;
+        case Mode::Always:
+        case Mode::WhileParsing:
+            return true;
+        }
+        return false;
+    }
+};
+
+/**
+ * \brief The board of the start position of a game.
+ *
+ * \param metadata The metadata of the game.
+ * \return The board of the FEN tag, the standard starting position if there
+ *   is no FEN tag, or nullopt, if the FEN tag cannot be read.
+ */
+auto start_board(const GameMetadata &metadata) -> std::optional<Board>;
+
 /**
  * \brief A game of chess.
  *
@@ -22,6 +110,14 @@ namespace chessgame {
  * names of the players, the event, etc.
  * Manages the list of moves of the game. Moves can be annotated and the class
  * can also store variations of the game (alternative sequences of moves).
+ *
+ * A game owns its tree. Games can be moved cheaply; copying a game copies the
+ * whole tree and has to be requested explicitly with clone(). A moved-from
+ * game is an empty game with the default starting position.
+ *
+ * The tree and the metadata can be allocated from a memory resource, e.g. a
+ * std::pmr::monotonic_buffer_resource, that is released after a batch of
+ * games has been processed.
  */
 class Game {
 public:
@@ -34,6 +130,57 @@ public:
 
     Game(const GameMetadata &metadata);
 
+    /**
+     * \brief Create a new Game using a memory resource.
+     *
+     * The tree and the copy of the metadata allocate their memory from the
+     * resource. Also the trees created by reset() and by parsing pending
+     * movetext use the resource.
+     * \param metadata The metadata of the game.
+     * \param resource The memory resource. Has to outlive the game.
+     */
+    Game(const GameMetadata &metadata, std::pmr::memory_resource *resource);
+
+    Game(Game &&other) noexcept;
+    auto operator=(const Game &) -> Game & = delete;
+
+    /**
+     * \brief Move another game into this game.
+     *
+     * The game takes over the tree and the memory resource of the other game.
+     * If the memory resources differ, the metadata is copied into the
+     * previous resource of this game, which therefore still has to outlive it.
+     * \param other The moved game.
+     * \return This game.
+     */
+    auto operator=(Game &&other) -> Game &;
+    ~Game() = default;
+
+    /**
+     * \brief Create an independent copy of the game.
+     *
+     * The copy has its own tree, changes to the copy do not affect this game.
+     * Pending movetext is copied without parsing it. The copy uses the default
+     * memory resource. Only the TagPool of the metadata is shared. It keeps the
+     * memory resource, that it was created with, as the metadata never creates
+     * a pool itself.
+     * \return The copy.
+     */
+    [[nodiscard]] auto clone() const -> Game { return Game{*this}; }
+
+    /**
+     * \brief Start the game anew.
+     *
+     * The game gets the given metadata and a tree, that only consists of the
+     * start position, as if newly constructed. The memory of the tree and the
+     * metadata is reused. Cursors into the game are invalidated.
+     *
+     * If the FEN tag of the metadata cannot be read, an exception is thrown
+     * and the game is left unchanged.
+     * \param metadata The metadata of the new game.
+     */
+    auto reset(const GameMetadata &metadata) -> void;
+
     /**
      * \brief Read-only access to the meta data of the game.
      *
@@ -48,24 +195,139 @@ public:
      */
     auto metadata() -> GameMetadata & { return m_metadata; }
 
+    /**
+     * \brief Read-only access to the tree of moves of the game.
+     *
+     * \return The game tree.
+     */
+    [[nodiscard]] auto tree() const -> const GameTree & {
+        materialize_movetext();
+        return m_tree != nullptr ? *m_tree : empty_tree();
+    }
+
+    /**
+     * \brief Access to the tree of moves of the game.
+     *
+     * \return The game tree.
+     */
+    auto tree() -> GameTree &;
+
+    /**
+     * \brief Defer building the game tree until it is accessed.
+     *
+     * The movetext is parsed by a PGNParser, when the tree of the game is
+     * accessed for the first time. Until then, the game only consists of its
+     * metadata. Parsing the movetext may throw a PGNError with the line
+     * number in the original PGN data. The tree is built on the first access
+     * also through a const game. This is thread-safe: concurrent readers wait
+     * until the tree is built once.
+     * \param movetext The movetext of the game.
+     * \param first_line Line number of the start of the movetext in the PGN data.
+     */
+    auto set_pending_movetext(std::string movetext, int first_line = 1) -> void;
+
+    /**
+     * \brief Check, if the movetext of the game has not been parsed yet.
+     *
+     * \return If the game has pending movetext.
+     */
+    [[nodiscard]] auto has_pending_movetext() const -> bool { return m_pending_movetext != nullptr && !m_pending_movetext->parsed.load(std::memory_order_acquire); }
+
+    /**
+     * \brief The memory resource of the game.
+     *
+     * \return The memory resource for the tree and the metadata.
+     */
+    [[nodiscard]] auto memory_resource() const -> std::pmr::memory_resource * { return m_resource; }
+
+    /**
+     * \brief The memory used by the game.
+     *
+     * Pending movetext is not parsed, it is reported as
+     * MemoryUsage::movetext_bytes instead.
+     * \return Number of nodes and stored positions and the allocated bytes.
+     */
+    [[nodiscard]] auto memory_usage() const -> MemoryUsage;
+
     /**
      * \brief Add a new node to the game tree.
      *
      * The node is appended as a new child to the given parent node. If the
      * parent node already conatins a child with the given move, no new node is
      * added and that child is returned.
+     *
+     * Depending on the position cache policy, the position of the new node is
+     * stored in the node. A caller that already knows the position can pass
+     * it along, so that it does not have to be calculated.
+     *
+     * The new node is indexed by the key of its position. The key is taken
+     * from the board after the move, if it is passed. Otherwise, the board is
+     * derived from the board of the parent node. Every 16th ply, the board of
+     * the new node is stored in the tree, so that boards never have to be
+     * calculated from far away.
      * \param parent The parent node of the new node.
      * \param move The move that leads from the parent to the new node.
-     * \return The new node.
+     * \param position The position after the move, if known.
+     * \param board The board after the move, if known.
+     * \return The id of the new node.
+     */
+    auto add_node(NodeId parent, const chesscore::Move &move, const std::optional<chesscore::Position> &position = std::nullopt,
+                  const std::optional<Board> &board = std::nullopt) -> NodeId;
+
+    /**
+     * \brief Calculate the board of a node.
+     *
+     * The board is calculated by replaying the moves from the nearest
+     * ancestor, that stores its board, or from the root node. At most 15
+     * moves are replayed for nodes added by add_node().
+     * \param node_id The node id.
+     * \return The board or nullopt, if the start position of the game could not be read.
+     */
+    [[nodiscard]] auto board(NodeId node_id) const -> std::optional<Board>;
+
+    /**
+     * \brief Find a position in the game.
+     *
+     * \param key The key of the position, see Board::key().
+     * \return Cursor to the first node with the position, if the position occurs in the game.
+     */
+    auto find_position(uint64_t key) -> std::optional<Cursor>;
+
+    /**
+     * \brief Find a position in the game.
+     *
+     * \param key The key of the position, see Board::key().
+     * \return Cursor to the first node with the position, if the position occurs in the game.
+     */
+    [[nodiscard]] auto find_position(uint64_t key) const -> std::optional<ConstCursor>;
+
+    /**
+     * \brief The policy for storing positions in the game nodes.
+     *
+     * \return The position cache policy.
      */
-    auto add_node(const std::shared_ptr<GameNode> &parent, const chesscore::Move &move) -> std::shared_ptr<GameNode>;
+    [[nodiscard]] auto position_cache_policy() const -> const PositionCachePolicy & { return m_position_cache_policy; }
+
+    /**
+     * \brief Change the policy for storing positions in the game nodes.
+     *
+     * Stored positions that are not covered by the new policy are dropped.
+     * Missing positions are not calculated for the existing nodes.
+     * \param policy The new position cache policy.
+     */
+    auto set_position_cache_policy(const PositionCachePolicy &policy) -> void;
+
+    /**
+     * \brief Drop all stored positions except the one of the root node.
+     */
+    auto drop_cached_positions() -> void;
 
     /**
      * \brief Get a cursor to the beginning of the game.
      *
      * \return Cursor to the beginning of the game.
      */
-    auto edit() -> Cursor { return {this, m_root}; }
+    auto edit() -> Cursor { return {this, GameTree::root_id}; }
 
     /**
      * \brief Get a const cursor to the beginning of the game.
@@ -80,7 +342,7 @@ public:
      *
      * \return Read-only cursor to the beginning of the game.
      */
-    [[nodiscard]] auto cursor() const -> ConstCursor { return {this, m_root}; }
+    [[nodiscard]] auto cursor() const -> ConstCursor { return {this, GameTree::root_id}; }
 
     /**
      * \brief Get a read-only cursor to the beginning of the game.
@@ -88,7 +350,14 @@ public:
      * \return Read-only cursor to the beginning of the game.
      */
 
-    [[nodiscard]] auto const_cursor() const -> ConstCursor { return {this, m_root}; }
+    [[nodiscard]] auto const_cursor() const -> ConstCursor { return {this, GameTree::root_id}; }
+
+    /**
+     * \brief Get a lightweight read-only view of the start of the game.
+     *
+     * \return View of the root node, see NodeView.
+     */
+    [[nodiscard]] auto view() const -> NodeView { return {&tree(), GameTree::root_id}; }
 
     /**
      * \brief Get a cursor to the current position on the main line.
@@ -106,9 +375,42 @@ public:
      */
     auto current_mainline() const -> ConstCursor { return follow_mainline<ConstCursor>(const_cursor()); }
 private:
-    GameMetadata m_metadata{};        ///< Meta data for the game.
-    std::shared_ptr<GameNode> m_root; ///< Root node of the game tree.
-    NodeId m_next_id{2U};             ///< Next available node id.
+    /**
+     * \brief Movetext, that has not been parsed yet.
+     *
+     * Stored on the heap, so that the game stays movable.
+     */
+    struct PendingMovetext {
+        std::string movetext;                        ///< The movetext.
+        int first_line{1};                           ///< Line number of the start of the movetext.
+        PositionCachePolicy position_cache_policy{}; ///< Position cache policy for parsing the movetext.
+        std::once_flag parse_once;                   ///< Guards parsing the movetext.
+        std::mutex tree_mutex;                       ///< Guards replacing the tree by the parsed tree.
+        std::atomic<bool> parsed{false};             ///< If the tree has been built from the movetext.
+    };
+
+    std::pmr::memory_resource *m_resource;              ///< Memory resource for the tree and the metadata.
+    GameMetadata m_metadata;                            ///< Meta data for the game.
+    mutable std::unique_ptr<GameTree> m_tree;           ///< The game tree.
+    std::optional<Board> m_root_board;                  ///< Board of the start position.
+    PositionCachePolicy m_position_cache_policy;        ///< Which nodes store their position.
+    std::unique_ptr<PendingMovetext> m_pending_movetext; ///< Movetext, that is parsed on the first access to the tree.
+
+    Game(const Game &other);
+
+    /**
+     * \brief The tree of a moved-from game.
+     *
+     * \return A tree, that only consists of the starting position.
+     */
+    static auto empty_tree() -> const GameTree &;
+
+    auto materialize_movetext() const -> void {
+        if (has_pending_movetext()) {
+            build_pending_tree();
+        }
+    }
+    auto build_pending_tree() const -> void;
 
     template<typename T>
     static auto follow_mainline(T cursor) -> T {
@@ -0,0 +1,122 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_IMPORT_H
+#define CHESSGAME_IMPORT_H
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "chessgame/database.h"
+#include "chessgame/game.h"
+#include "chessgame/input.h"
+#include "chessgame/pgn.h"
+
+namespace chessgame {
+
+/**
+ * \brief Options for importing many games in parallel.
+ */
+struct ImportOptions {
+    unsigned int thread_count{0}; ///< Number of worker threads. 0 uses one thread per hardware thread.
+    size_t batch_size{64};        ///< Number of consecutive games a worker takes at once.
+    PositionCachePolicy position_cache_policy{PositionCachePolicy::root_only()}; ///< Position cache policy for the parsed games.
+    bool intern_tags{false};                                                         ///< Intern the tags of the games of every worker in a TagPool of the worker.
+    size_t tag_pool_limit{size_t{16} * 1024 * 1024};                                 ///< Maximum size of the pool of every worker, see TagPool.
+    size_t block_size{PGNLexer::default_block_size}; ///< Number of bytes read from an input stream at once.
+    size_t max_pending_batches{16};                  ///< Maximum number of batches read from an input stream, that are not yet consumed.
+};
+
+/**
+ * \brief The result of importing a single game.
+ */
+struct ImportedGame {
+    size_t offset{0};                 ///< Byte offset of the game in the input.
+    std::optional<Game> game;         ///< The game. Empty, if the game could not be parsed or is no standard chess game.
+    std::vector<PGNWarning> warnings; ///< Warnings that occured while parsing the game.
+    std::optional<PGNError> error;    ///< The error that prevented parsing the game.
+    size_t error_offset{0};           ///< Byte offset of the error in the input, if there is an error.
+};
+
+/**
+ * \brief Receives the games of a streaming import.
+ */
+using ImportConsumer = std::function<void(ImportedGame &&game)>;
+
+/**
+ * \brief Parse all games in PGN data in parallel.
+ *
+ * The data is split into games by scanning for game boundaries. The games are
+ * then parsed by a pool of worker threads, each with its own PGNParser. An
+ * error in one game does not affect the other games. Errors are reported
+ * without throwing exceptions (see PGNParser::try_read_game()).
+ * \param data The PGN data.
+ * \param options Import options.
+ * \return The imported games in input order.
+ */
+auto import_games(std::string_view data, const ImportOptions &options = {}) -> std::vector<ImportedGame>;
+
+/**
+ * \brief Parse all games of a PGN database in parallel.
+ *
+ * Uses the game offsets of the database instead of scanning the data.
+ * \param database The PGN database.
+ * \param options Import options.
+ * \return The imported games in database order.
+ */
+auto import_games(const PGNDatabase &database, const ImportOptions &options = {}) -> std::vector<ImportedGame>;
+
+/**
+ * \brief Parse the games at the given offsets in parallel.
+ *
+ * \param data The PGN data.
+ * \param offsets Start offsets of the games in the data, in ascending order.
+ * \param options Import options.
+ * \return The imported games in the order of the offsets.
+ */
+auto import_games(std::string_view data, const std::vector<size_t> &offsets, const ImportOptions &options = {}) -> std::vector<ImportedGame>;
+
+/**
+ * \brief Parse all games from a stream in a pipeline.
+ *
+ * The import runs in stages, that work concurrently: A reader thread reads
+ * blocks of the stream ahead, a splitter thread cuts the blocks into batches
+ * of complete games, and the worker threads parse the batches. The games are
+ * passed to the consumer on the calling thread in input order, while the
+ * following games are read and parsed. At most
+ * ImportOptions::max_pending_batches batches are read but not yet consumed,
+ * so that a slow consumer stalls the reading instead of buffering the whole
+ * input.
+ *
+ * Errors in games are reported like in the other import functions. An
+ * exception thrown while reading the stream or by the consumer stops the
+ * import and is rethrown.
+ * \param in_stream The PGN input.
+ * \param consumer Receives the imported games.
+ * \param options Import options.
+ * \return The number of games passed to the consumer.
+ */
+auto import_games(std::istream &in_stream, const ImportConsumer &consumer, const ImportOptions &options = {}) -> size_t;
+
+/**
+ * \brief Parse all games from an input source in a pipeline.
+ *
+ * Like the import from a stream, e.g. for compressed input from open_input().
+ * \param input The PGN input.
+ * \param consumer Receives the imported games.
+ * \param options Import options.
+ * \return The number of games passed to the consumer.
+ */
+auto import_games(InputSource &input, const ImportConsumer &consumer, const ImportOptions &options = {}) -> size_t;
+
+} // namespace chessgame
+
+#endif
@@ -0,0 +1,182 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_INPUT_H
+#define CHESSGAME_INPUT_H
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace chessgame {
+
+/**
+ * \brief A source of input data, that is read in blocks.
+ *
+ * The PGNLexer reads its input from a source in large blocks directly into
+ * its buffer. Sources can decompress the data on the fly, so that every
+ * decompressed block is analysed in place.
+ */
+class InputSource {
+public:
+    InputSource() = default;
+    InputSource(const InputSource &) = delete;
+    InputSource(InputSource &&) = delete;
+    auto operator=(const InputSource &) -> InputSource & = delete;
+    auto operator=(InputSource &&) -> InputSource & = delete;
+    virtual ~InputSource() = default;
+
+    /**
+     * \brief Read the next block of data.
+     *
+     * Fewer bytes than requested are only returned at the end of the input.
+     * \param buffer Receives the data.
+     * \param size Maximum number of bytes to read.
+     * \return Number of bytes read, 0 at the end of the input, or nullopt, if
+     *         the input cannot be read.
+     */
+    [[nodiscard]] virtual auto read(char *buffer, size_t size) -> std::optional<size_t> = 0;
+};
+
+/**
+ * \brief Input from a stream.
+ */
+class StreamInput final : public InputSource {
+public:
+    /**
+     * \brief Create a source for a stream.
+     *
+     * The stream is not owned and has to outlive the source.
+     * \param in_stream The input stream.
+     * \param prefix Data, that is returned before the data of the stream.
+     */
+    explicit StreamInput(std::istream &in_stream, std::string prefix = {}) : m_in_stream{&in_stream}, m_prefix{std::move(prefix)} {}
+
+    [[nodiscard]] auto read(char *buffer, size_t size) -> std::optional<size_t> override;
+private:
+    std::istream *m_in_stream; ///< The input stream.
+    std::string m_prefix;      ///< Data, that is returned first.
+    size_t m_prefix_pos{0};    ///< Position of the next byte of the prefix.
+};
+
+/**
+ * \brief Input from data in memory.
+ *
+ * Used to decompress data in memory, e.g. of a MappedFile. Uncompressed data
+ * in memory should be given to the PGNLexer directly.
+ */
+class MemoryInput final : public InputSource {
+public:
+    /**
+     * \brief Create a source for data in memory.
+     *
+     * The data is not copied and has to outlive the source.
+     * \param data The data.
+     */
+    explicit MemoryInput(std::string_view data) : m_data{data} {}
+
+    [[nodiscard]] auto read(char *buffer, size_t size) -> std::optional<size_t> override;
+private:
+    std::string_view m_data; ///< The remaining data.
+};
+
+/**
+ * \brief Compression formats of input data.
+ */
+enum class Compression {
+    None, ///< Uncompressed data.
+    Gzip, ///< gzip or zlib compressed data.
+    Zstd, ///< Zstandard compressed data.
+};
+
+/**
+ * \brief Check, if a compression format can be decompressed.
+ *
+ * Decompression depends on optional libraries (zlib and libzstd), that are
+ * detected when building the library.
+ * \param compression The compression format.
+ * \return If input in the format can be read.
+ */
+auto compression_supported(Compression compression) -> bool;
+
+/**
+ * \brief Detect the compression format from the first bytes of the data.
+ *
+ * \param prefix The first bytes of the data. Four bytes are sufficient.
+ * \return The compression format.
+ */
+auto detect_compression(std::string_view prefix) -> Compression;
+
+/**
+ * \brief Input decompressed from gzip or zlib compressed data.
+ *
+ * Concatenated gzip members are decompressed one after the other, like by
+ * gunzip.
+ */
+class GzipInput final : public InputSource {
+public:
+    /**
+     * \brief Create a source, that decompresses another source.
+     *
+     * Throws a ChessGameError, if gzip support is not available.
+     * \param compressed The compressed data.
+     */
+    explicit GzipInput(std::unique_ptr<InputSource> compressed);
+    ~GzipInput() override;
+
+    [[nodiscard]] auto read(char *buffer, size_t size) -> std::optional<size_t> override;
+private:
+    struct State;
+    std::unique_ptr<State> m_state; ///< The state of the decompressor.
+};
+
+/**
+ * \brief Input decompressed from Zstandard compressed data.
+ *
+ * Concatenated frames are decompressed one after the other.
+ */
+class ZstdInput final : public InputSource {
+public:
+    /**
+     * \brief Create a source, that decompresses another source.
+     *
+     * Throws a ChessGameError, if Zstandard support is not available.
+     * \param compressed The compressed data.
+     */
+    explicit ZstdInput(std::unique_ptr<InputSource> compressed);
+    ~ZstdInput() override;
+
+    [[nodiscard]] auto read(char *buffer, size_t size) -> std::optional<size_t> override;
+private:
+    struct State;
+    std::unique_ptr<State> m_state; ///< The state of the decompressor.
+};
+
+/**
+ * \brief Create a source for a possibly compressed stream.
+ *
+ * The compression format is detected from the first bytes of the stream.
+ * Throws a ChessGameError, if the format is not supported.
+ * \param in_stream The input stream. Has to outlive the source.
+ * \return The source, that returns the decompressed data.
+ */
+auto open_input(std::istream &in_stream) -> std::unique_ptr<InputSource>;
+
+/**
+ * \brief Create a source for possibly compressed data in memory.
+ *
+ * \param data The data. Has to outlive the source.
+ * \return The source, that returns the decompressed data.
+ */
+auto open_input(std::string_view data) -> std::unique_ptr<InputSource>;
+
+} // namespace chessgame
+
+#endif
@@ -0,0 +1,150 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_MAINLINE_H
+#define CHESSGAME_MAINLINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "chessgame/board.h"
+#include "chessgame/game.h"
+#include "chessgame/metadata.h"
+
+#include "chesscore/move.h"
+
+namespace chessgame {
+
+/**
+ * \brief Encode a move in 16 bits.
+ *
+ * Only the from and to square and the promotion piece type are stored. The
+ * moved and the captured piece are taken from the board when decoding.
+ * \param move The move.
+ * \return The code of the move.
+ */
+auto encode_compact_move(const chesscore::Move &move) -> uint16_t;
+
+/**
+ * \brief Decode a move encoded by encode_compact_move().
+ *
+ * The move is not checked for legality.
+ * \param code The code of the move.
+ * \param board The board before the move.
+ * \return The move or nullopt, if there is no piece of the side to move on
+ *         the from square.
+ */
+auto decode_compact_move(uint16_t code, const Board &board) -> std::optional<chesscore::Move>;
+
+/**
+ * \brief A game, that consists only of its main line.
+ *
+ * Stores the metadata and the moves of the main line in a contiguous array of
+ * 16-bit codes (see encode_compact_move()), i.e., two bytes per ply. There
+ * are no variations, comments or NAGs. This is the compact form for storing
+ * many games in memory.
+ *
+ * The start position is given by the FEN tag, like for Game. The positions
+ * of the game are computed by replaying the moves on a Board.
+ */
+class MainlineGame {
+public:
+    /**
+     * \brief Create a game without tags and moves.
+     */
+    MainlineGame() = default;
+
+    /**
+     * \brief Create a game without moves.
+     *
+     * \param metadata The tags of the game.
+     */
+    explicit MainlineGame(GameMetadata metadata) : m_metadata{std::move(metadata)} {}
+
+    /**
+     * \brief Create a game from the main line of a game.
+     *
+     * Variations, comments and NAGs are dropped.
+     * \param game The game.
+     * \return The main line game.
+     */
+    static auto from_game(const Game &game) -> MainlineGame;
+
+    /**
+     * \brief Create a game with a tree from the main line.
+     *
+     * Throws a ChessGameError, if the start position is invalid or a move
+     * cannot be decoded.
+     * \return The game.
+     */
+    [[nodiscard]] auto to_game() const -> Game;
+
+    /**
+     * \brief Read-only access to the tags of the game.
+     *
+     * \return The tags.
+     */
+    [[nodiscard]] auto metadata() const -> const GameMetadata & { return m_metadata; }
+
+    /**
+     * \brief Access to the tags of the game.
+     *
+     * \return The tags.
+     */
+    auto metadata() -> GameMetadata & { return m_metadata; }
+
+    /**
+     * \brief The board of the start position.
+     *
+     * \return The board or nullopt, if the FEN tag cannot be read.
+     */
+    [[nodiscard]] auto start_board() const -> std::optional<Board>;
+
+    /**
+     * \brief The number of plies of the game.
+     *
+     * \return Number of moves in the main line.
+     */
+    [[nodiscard]] auto ply_count() const -> size_t { return m_moves.size(); }
+
+    /**
+     * \brief The codes of the moves.
+     *
+     * \return The codes in the order of the moves.
+     */
+    [[nodiscard]] auto move_codes() const -> std::span<const uint16_t> { return m_moves; }
+
+    /**
+     * \brief Append a move to the main line.
+     *
+     * \param move The move.
+     */
+    auto append_move(const chesscore::Move &move) -> void { m_moves.push_back(encode_compact_move(move)); }
+
+    /**
+     * \brief The moves of the main line.
+     *
+     * Throws a ChessGameError, if the start position is invalid or a move
+     * cannot be decoded.
+     * \return The moves.
+     */
+    [[nodiscard]] auto moves() const -> std::vector<chesscore::Move>;
+
+    /**
+     * \brief Release unused capacity of the move array.
+     */
+    auto shrink_to_fit() -> void { m_moves.shrink_to_fit(); }
+private:
+    GameMetadata m_metadata;       ///< The tags of the game.
+    std::vector<uint16_t> m_moves; ///< Codes of the moves of the main line.
+};
+
+} // namespace chessgame
+
+#endif
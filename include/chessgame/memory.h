@@ -0,0 +1,128 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_MEMORY_H
+#define CHESSGAME_MEMORY_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace chessgame {
+
+/**
+ * \brief The memory used by a game, a tree or a single node.
+ *
+ * The byte counts are estimates of the memory allocated for the objects,
+ * split by category. They include the entries and buckets of the hash tables,
+ * but not the bookkeeping of the allocator. Strings, that are short enough to
+ * be stored inside the string object, do not need any additional memory.
+ *
+ * The tag pool of metadata is usually shared by many games, e.g. by all games
+ * of a database. Its size is reported separately, so that it can be counted
+ * once when the usage of several games is summed up.
+ */
+struct MemoryUsage {
+    size_t nodes{0};          ///< Number of nodes.
+    size_t positions{0};      ///< Number of stored positions.
+    size_t node_bytes{0};     ///< Bytes of the nodes, including the cached SAN strings.
+    size_t comment_bytes{0};  ///< Bytes of the comments and pre-move comments.
+    size_t nag_bytes{0};      ///< Bytes of the NAGs.
+    size_t position_bytes{0}; ///< Bytes of the stored positions and boards.
+    size_t index_bytes{0};    ///< Bytes of the index of the nodes by position key.
+    size_t metadata_bytes{0}; ///< Bytes of the list of tags of the metadata.
+    size_t tag_pool_bytes{0}; ///< Bytes of the pool storing the names and values of the tags.
+    size_t movetext_bytes{0}; ///< Bytes of movetext, that has not been parsed yet.
+
+    /**
+     * \brief The total number of bytes.
+     *
+     * \return Sum of all categories.
+     */
+    [[nodiscard]] auto total() const -> size_t {
+        return node_bytes + comment_bytes + nag_bytes + position_bytes + index_bytes + metadata_bytes + tag_pool_bytes + movetext_bytes;
+    }
+
+    /**
+     * \brief Add the usage of other objects.
+     *
+     * \param other The usage of the other objects.
+     * \return This usage.
+     */
+    auto operator+=(const MemoryUsage &other) -> MemoryUsage & {
+        nodes += other.nodes;
+        positions += other.positions;
+        node_bytes += other.node_bytes;
+        comment_bytes += other.comment_bytes;
+        nag_bytes += other.nag_bytes;
+        position_bytes += other.position_bytes;
+        index_bytes += other.index_bytes;
+        metadata_bytes += other.metadata_bytes;
+        tag_pool_bytes += other.tag_pool_bytes;
+        movetext_bytes += other.movetext_bytes;
+        return *this;
+    }
+
+    auto operator==(const MemoryUsage &) const -> bool = default;
+};
+
+/**
+ * \brief The memory allocated by a string.
+ *
+ * \param str The string.
+ * \return Number of bytes, 0 if the characters are stored inside the string object.
+ */
+template<typename CharT, typename Traits, typename Allocator>
+auto heap_bytes(const std::basic_string<CharT, Traits, Allocator> &str) -> size_t {
+    const auto *object = reinterpret_cast<const char *>(&str);
+    const auto *data = reinterpret_cast<const char *>(str.data());
+    const std::less<const char *> less{};
+    if (!less(data, object) && less(data, object + sizeof(str))) {
+        return 0;
+    }
+    return (str.capacity() + 1) * sizeof(CharT);
+}
+
+/**
+ * \brief The memory allocated by a vector.
+ *
+ * \param vector The vector.
+ * \return Number of bytes of the capacity of the vector.
+ */
+template<typename T, typename Allocator>
+auto heap_bytes(const std::vector<T, Allocator> &vector) -> size_t {
+    return vector.capacity() * sizeof(T);
+}
+
+/**
+ * \brief The estimated memory of a single entry of a hash table.
+ *
+ * Every entry is stored in its own node with a link to the next node and the
+ * cached hash of the key.
+ * \return Number of bytes of an entry.
+ */
+template<typename Table>
+constexpr auto table_entry_bytes() -> size_t {
+    return sizeof(void *) + sizeof(typename Table::value_type) + sizeof(size_t);
+}
+
+/**
+ * \brief The estimated memory allocated by a hash table.
+ *
+ * Only counts the entries and buckets of the table, not memory allocated by
+ * the keys and values.
+ * \param table The table.
+ * \return Number of bytes.
+ */
+template<typename Table>
+auto table_bytes(const Table &table) -> size_t {
+    return table.size() * table_entry_bytes<Table>() + table.bucket_count() * sizeof(void *);
+}
+
+} // namespace chessgame
+
+#endif
@@ -8,57 +8,251 @@
 #define CHESSGAME_GAME_METADATA_H
 
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "chessgame/memory.h"
+
 namespace chessgame {
 
+/**
+ * \brief A pool of interned tag names and values.
+ *
+ * Every distinct string is stored only once. The pool can be shared by the
+ * metadata of many games, e.g. of all games of a database, so that repeated
+ * player names, events and sites do not need additional memory.
+ *
+ * Strings are never removed from the pool and views to them stay valid for
+ * the lifetime of the pool. The pool can be limited to a number of bytes, so
+ * that it does not grow without bounds. Once the limit is reached, new
+ * strings are not interned anymore and the metadata stores them itself.
+ *
+ * Interning is thread-safe. The strings are distributed over independently
+ * locked shards, so that threads interning different strings rarely wait
+ * for each other. Still, an import with many threads should give every
+ * worker its own pool, see ImportOptions::intern_tags.
+ */
+class TagPool {
+public:
+    static constexpr size_t unlimited{std::numeric_limits<size_t>::max()}; ///< No limit for the size of the pool.
+
+    /**
+     * \brief Create an empty pool using the default memory resource.
+     */
+    TagPool() : TagPool{unlimited} {}
+
+    /**
+     * \brief Create an empty pool.
+     *
+     * \param resource The memory resource for the strings. Has to outlive the pool.
+     */
+    explicit TagPool(std::pmr::memory_resource *resource) : TagPool{unlimited, resource} {}
+
+    /**
+     * \brief Create an empty pool with a limited size.
+     *
+     * \param max_bytes Maximum number of characters of all strings in the pool.
+     * \param resource The memory resource for the strings. Has to outlive the pool.
+     */
+    explicit TagPool(size_t max_bytes, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_max_bytes{max_bytes}, m_shards{make_shards(resource, std::make_index_sequence<shard_count>{})} {}
+
+    /**
+     * \brief Intern a string.
+     *
+     * \param str The string.
+     * \return View to the copy of the string in the pool, nullopt if the string
+     *   is not in the pool and the pool is full.
+     */
+    auto intern(std::string_view str) -> std::optional<std::string_view>;
+
+    /**
+     * \brief The number of distinct strings in the pool.
+     *
+     * \return Number of strings.
+     */
+    [[nodiscard]] auto size() const -> size_t;
+
+    /**
+     * \brief The memory used by the pool.
+     *
+     * \return Estimated number of bytes allocated for the strings.
+     */
+    [[nodiscard]] auto memory_usage() const -> size_t;
+private:
+    static constexpr size_t shard_count{16};
+
+    struct string_hash {
+        using is_transparent = void;
+        auto operator()(std::string_view str) const -> size_t { return std::hash<std::string_view>{}(str); }
+    };
+    using string_set = std::pmr::unordered_set<std::pmr::string, string_hash, std::equal_to<>>;
+
+    struct Shard {
+        explicit Shard(std::pmr::memory_resource *resource) : strings{resource} {}
+
+        mutable std::mutex mutex; ///< Guards the strings.
+        string_set strings;       ///< The interned strings of the shard.
+    };
+
+    size_t m_max_bytes;                      ///< Maximum number of characters in the pool.
+    std::atomic<size_t> m_bytes{0};          ///< Number of characters in the pool.
+    std::array<Shard, shard_count> m_shards; ///< The strings, distributed by their hash.
+
+    template<size_t... Index>
+    static auto make_shards(std::pmr::memory_resource *resource, std::index_sequence<Index...> /*indices*/) -> std::array<Shard, shard_count> {
+        return {((void)Index, Shard{resource})...};
+    }
+};
+
 /**
  * \brief A metadata tag.
  *
  * A metadata tag is a key-value pair and describes meta data of a chess game.
+ * The strings are stored in the GameMetadata or in its TagPool.
  */
 struct metadata_tag {
-    std::string name;  ///< Name of the metadata tag.
-    std::string value; ///< Value of the metadata tag.
+    std::string_view name;  ///< Name of the metadata tag.
+    std::string_view value; ///< Value of the metadata tag.
 };
 
 /**
  * \brief A collection of metadata tags.
+ *
+ * The tags are kept in the order they were added. The tags of the seven tag
+ * roster are additionally referenced from fixed slots, so that they can be
+ * found without searching.
+ *
+ * Names and values are stored in buffers owned by the metadata. The buffers
+ * are kept, when the metadata is reset, so that metadata reused for many
+ * games does not allocate memory once the buffers are large enough.
+ * Optionally, the strings are interned in a TagPool shared with other
+ * metadata. Views returned by the metadata stay valid until it is reset,
+ * assigned or destroyed.
+ *
+ * The tags and buffers are allocated from a memory resource. Like for the
+ * standard containers, a copy uses the default memory resource and assigning
+ * metadata keeps the memory resource of the target. A copy shares the pool
+ * of the other metadata and copies all strings not stored in the pool into
+ * its own buffers.
  */
 class GameMetadata {
 public:
-    using iterator = std::vector<metadata_tag>::iterator;
-    using const_iterator = std::vector<metadata_tag>::const_iterator;
+    using iterator = std::pmr::vector<metadata_tag>::const_iterator;
+    using const_iterator = std::pmr::vector<metadata_tag>::const_iterator;
+
+    /**
+     * \brief Create empty metadata.
+     */
+    GameMetadata() = default;
+
+    /**
+     * \brief Create empty metadata storing its strings in a shared pool.
+     *
+     * \param pool The pool.
+     */
+    explicit GameMetadata(std::shared_ptr<TagPool> pool) : m_pool{std::move(pool)} {}
+
+    /**
+     * \brief Create empty metadata using a memory resource.
+     *
+     * \param resource The memory resource. Has to outlive the metadata.
+     */
+    explicit GameMetadata(std::pmr::memory_resource *resource) : m_tags{resource}, m_buffers{resource} {}
+
+    /**
+     * \brief Copy metadata into a memory resource.
+     *
+     * \param other The metadata to copy.
+     * \param resource The memory resource. Has to outlive the metadata.
+     */
+    GameMetadata(const GameMetadata &other, std::pmr::memory_resource *resource);
+
+    GameMetadata(const GameMetadata &other) : GameMetadata{other, std::pmr::get_default_resource()} {}
+    GameMetadata(GameMetadata &&other) noexcept;
+    auto operator=(const GameMetadata &other) -> GameMetadata &;
+    auto operator=(GameMetadata &&other) -> GameMetadata &;
+    ~GameMetadata() = default;
 
-    iterator begin() { return m_tags.begin(); }
-    iterator end() { return m_tags.end(); }
     const_iterator begin() const { return m_tags.begin(); }
     const_iterator end() const { return m_tags.end(); }
 
-    static const std::array<std::string, 7> str_tags;
+    static constexpr std::array<std::string_view, 7> str_tags{"Event", "Site", "Date", "Round", "White", "Black", "Result"};
 
     /**
      * \brief Retrieve the value of a tag pair.
      *
      * Returns the value of a tag pair with the given name, if it exists.
-     * Returns nullopt otherwise.
+     * Returns nullopt otherwise. If there are multiple tags with the name,
+     * the first one is returned.
      * \param name Name of the tag pair.
      * \return Value of the tag pair, if it exists.
      */
-    auto get(const std::string &name) const -> std::optional<std::string>;
+    [[nodiscard]] auto get(std::string_view name) const -> std::optional<std::string_view>;
 
     /**
      * \brief Add a tag pair.
      *
+     * The name and value are copied into the pool or the own buffers.
      * \param name Name of the tag.
      * \param value Value of the tag.
      */
-    template<typename NameT, typename ValueT>
-    auto add(NameT &&name, ValueT &&value) -> void {
-        m_tags.emplace_back(std::forward<NameT>(name), std::forward<ValueT>(value));
-    }
+    auto add(std::string_view name, std::string_view value) -> void;
+
+    /**
+     * \brief Set the value of a tag pair.
+     *
+     * Changes the value of the first tag pair with the given name. Adds a tag
+     * pair, if there is none.
+     * \param name Name of the tag.
+     * \param value New value of the tag.
+     */
+    auto set(std::string_view name, std::string_view value) -> void;
+
+    /**
+     * \brief Remove all tags.
+     *
+     * The memory allocated for the tags and the own buffers is kept, so that
+     * the metadata can be reused for another game.
+     * \param pool The pool for the tags added afterwards. nullptr stores them
+     *   in the own buffers.
+     */
+    auto reset(std::shared_ptr<TagPool> pool) -> void;
+
+    /**
+     * \brief The pool storing the names and values.
+     *
+     * \return The pool, nullptr if the strings are stored in the own buffers.
+     */
+    [[nodiscard]] auto pool() const -> const std::shared_ptr<TagPool> & { return m_pool; }
+
+    /**
+     * \brief The memory resource of the metadata.
+     *
+     * \return The memory resource for the tags and the own buffers.
+     */
+    [[nodiscard]] auto memory_resource() const -> std::pmr::memory_resource * { return m_tags.get_allocator().resource(); }
+
+    /**
+     * \brief The memory used by the metadata.
+     *
+     * The own buffers are reported as MemoryUsage::metadata_bytes. The whole
+     * pool is reported as MemoryUsage::tag_pool_bytes, also if it is shared
+     * with other metadata.
+     * \return The allocated bytes of the tags, the buffers and the pool.
+     */
+    [[nodiscard]] auto memory_usage() const -> MemoryUsage;
 
     /**
      * \brief Determine, if the tag belongs to the seven tag roster (STR).
@@ -67,7 +261,7 @@ public:
      * \param name Name of the tag.
      * \return If the tag belongs to the STR.
      */
-    static auto is_str_tag(const std::string &name) -> bool;
+    static auto is_str_tag(std::string_view name) -> bool { return str_tag_index(name).has_value(); }
 
     /**
      * \brief Determine, if the tag belongs to the seven tag roster (STR).
@@ -76,9 +270,23 @@ public:
      * \param tag The tag.
      * \return If the tag belongs to the STR.
      */
-    static auto is_str_tag(const metadata_tag &tag) -> bool;
+    static auto is_str_tag(const metadata_tag &tag) -> bool { return is_str_tag(tag.name); }
+
+    /**
+     * \brief Determine the index of a tag in the seven tag roster (STR).
+     *
+     * \param name Name of the tag.
+     * \return Index of the tag in str_tags or nullopt, if it does not belong to the STR.
+     */
+    static auto str_tag_index(std::string_view name) -> std::optional<size_t>;
 private:
-    std::vector<metadata_tag> m_tags{}; ///< Collection of metadata tags.
+    std::shared_ptr<TagPool> m_pool;              ///< Optional shared storage for the names and values.
+    std::pmr::vector<metadata_tag> m_tags;        ///< Collection of metadata tags.
+    std::pmr::vector<std::pmr::string> m_buffers; ///< Own storage for the names and values. A buffer never grows beyond its capacity.
+    size_t m_buffer_index{0};                     ///< Index of the first buffer with free space.
+    std::array<uint32_t, 7> m_str_slots{};        ///< Index + 1 in m_tags of the STR tags, 0 if the tag is missing.
+
+    auto store(std::string_view str) -> std::string_view;
 };
 
 } // namespace chessgame
@@ -0,0 +1,214 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_OPENING_H
+#define CHESSGAME_OPENING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "chessgame/game.h"
+#include "chessgame/import.h"
+
+#include "chesscore/move.h"
+
+namespace chessgame {
+
+/**
+ * \brief Version of the snapshot format written by OpeningTree::write().
+ */
+constexpr uint32_t opening_tree_format_version{1};
+
+/**
+ * \brief Statistics of the games that reached a position or played a move.
+ *
+ * Every game is counted at most once, even if it reaches a position several
+ * times. The ratings are the ratings of the player to move in the position,
+ * i.e., of the player choosing the next move.
+ */
+struct OpeningStats {
+    uint64_t games{0};       ///< Number of games.
+    uint64_t white_wins{0};  ///< Number of games won by white.
+    uint64_t draws{0};       ///< Number of drawn games.
+    uint64_t black_wins{0};  ///< Number of games won by black.
+    uint64_t rating_sum{0};  ///< Sum of the ratings of the player to move over all rated games.
+    uint64_t rated_games{0}; ///< Number of games with a rating of the player to move.
+
+    /**
+     * \brief The score of white in the games with a known result.
+     *
+     * \return Score between 0 and 1 or nullopt, if no game has a known result.
+     */
+    [[nodiscard]] auto white_score() const -> std::optional<double>;
+
+    /**
+     * \brief The average rating of the player to move.
+     *
+     * \return The average rating or nullopt, if no game has a rating.
+     */
+    [[nodiscard]] auto average_rating() const -> std::optional<double>;
+
+    /**
+     * \brief Add the statistics of other games.
+     *
+     * \param other The other statistics.
+     * \return Reference to this object.
+     */
+    auto operator+=(const OpeningStats &other) -> OpeningStats &;
+
+    auto operator==(const OpeningStats &other) const -> bool = default;
+};
+
+/**
+ * \brief A move played in a position of an opening tree.
+ */
+struct OpeningMove {
+    chesscore::Move move; ///< The move.
+    uint64_t key{0};      ///< Key of the position after the move.
+    OpeningStats stats;   ///< Statistics of the games that played the move.
+};
+
+/**
+ * \brief Options for building an opening tree.
+ */
+struct OpeningTreeOptions {
+    bool include_variations{false}; ///< Also merge the moves of variations, not only the main line.
+    size_t max_ply{0};              ///< Maximum number of plies taken from each game. 0 takes all moves.
+};
+
+/**
+ * \brief Move statistics by position over many games.
+ *
+ * The opening tree merges the moves of many games into one graph of
+ * positions. Positions are identified by their key (see Board::key()), so
+ * transpositions lead to the same position. Every edge of the graph is a move
+ * and counts the games that played the move, their results, and the ratings
+ * from the WhiteElo and BlackElo tags.
+ *
+ * Games can be added concurrently from multiple threads. The positions are
+ * distributed over independently locked shards, so that threads adding
+ * different games rarely wait for each other.
+ *
+ * A snapshot of the tree can be written to a stream and read again.
+ */
+class OpeningTree {
+public:
+    /**
+     * \brief Create an empty opening tree.
+     *
+     * \param options Options for adding games.
+     */
+    explicit OpeningTree(const OpeningTreeOptions &options = {});
+
+    /**
+     * \brief The options for adding games.
+     *
+     * \return The options.
+     */
+    [[nodiscard]] auto options() const -> const OpeningTreeOptions & { return m_options; }
+
+    /**
+     * \brief Add the moves of a game.
+     *
+     * The result is taken from the Result tag of the game. Games without
+     * position keys, e.g. with an unreadable start position, are ignored.
+     * \param game The game.
+     */
+    auto add_game(const Game &game) -> void;
+
+    /**
+     * \brief Add all games of an import.
+     *
+     * Games that could not be imported are skipped.
+     * \param games The imported games.
+     */
+    auto add_games(const std::vector<ImportedGame> &games) -> void;
+
+    /**
+     * \brief The number of games added to the tree.
+     *
+     * \return Number of games.
+     */
+    [[nodiscard]] auto game_count() const -> uint64_t { return m_storage->game_count.load(); }
+
+    /**
+     * \brief The number of distinct positions in the tree.
+     *
+     * \return Number of positions.
+     */
+    [[nodiscard]] auto position_count() const -> size_t;
+
+    /**
+     * \brief The statistics of the games that reached a position.
+     *
+     * \param key Key of the position.
+     * \return The statistics or nullopt, if no game reached the position.
+     */
+    [[nodiscard]] auto stats(uint64_t key) const -> std::optional<OpeningStats>;
+
+    /**
+     * \brief The moves played in a position.
+     *
+     * \param key Key of the position.
+     * \return The moves, ordered by the number of games, most played first.
+     */
+    [[nodiscard]] auto moves(uint64_t key) const -> std::vector<OpeningMove>;
+
+    /**
+     * \brief Write a snapshot of the tree.
+     *
+     * The snapshot stores the positions ordered by their keys, so that equal
+     * trees give equal snapshots. Must not be called while games are added.
+     * \param out_stream The output stream.
+     */
+    auto write(std::ostream &out_stream) const -> void;
+
+    /**
+     * \brief Read a snapshot of a tree.
+     *
+     * Throws a ChessGameError, if the data is no opening tree snapshot or is
+     * corrupted.
+     * \param in_stream The input stream.
+     * \param options Options for adding further games.
+     * \return The tree.
+     */
+    static auto read(std::istream &in_stream, const OpeningTreeOptions &options = {}) -> OpeningTree;
+private:
+    static constexpr size_t shard_count{64};
+
+    struct Position {
+        OpeningStats stats;
+        std::vector<OpeningMove> moves;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, Position> positions;
+    };
+
+    struct Storage {
+        std::array<Shard, shard_count> shards;
+        std::atomic<uint64_t> game_count{0};
+    };
+
+    OpeningTreeOptions m_options;                                    ///< Options for adding games.
+    std::unique_ptr<Storage> m_storage{std::make_unique<Storage>()}; ///< The positions, distributed over the shards.
+
+    [[nodiscard]] auto shard(uint64_t key) const -> Shard &;
+};
+
+} // namespace chessgame
+
+#endif
@@ -7,14 +7,29 @@
 #ifndef CHESSGAME_GAME_PGN_H
 #define CHESSGAME_GAME_PGN_H
 
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
 #include <iosfwd>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <ostream>
 #include <stack>
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "chessgame/board.h"
 #include "chessgame/cursor.h"
 #include "chessgame/game.h"
+#include "chessgame/input.h"
+#include "chessgame/mainline.h"
 #include "chessgame/san.h"
 #include "chessgame/types.h"
 
@@ -35,6 +50,8 @@ enum class PGNErrorType {
     InvalidGameResult, ///< Invalid game result.
     CannotStartRav,    ///< Cannot start a RAV in this position.
     NoPenRav,          ///< There is currently no RAV active.
+    InvalidGame,       ///< The game could not be created.
+    InvalidFen,        ///< The FEN tag of the game cannot be read.
     EndOfInput         ///< End of input.
 };
 
@@ -83,10 +100,164 @@ struct PGNWarning {
     std::string description; ///< A description of the warning.
 };
 
+/**
+ * \brief Number of PGN warning types.
+ */
+constexpr size_t pgn_warning_type_count{3};
+
+/**
+ * \brief Stages of reading and writing PGN data.
+ */
+enum class PGNStage {
+    Lexing,         ///< Reading tokens from the input.
+    SANParsing,     ///< Parsing SAN moves.
+    MoveResolution, ///< Finding the legal moves described by SAN moves.
+    TreeBuilding,   ///< Adding nodes to the game tree, including the positions after the moves.
+    PositionReplay, ///< Applying moves to positions while writing.
+    SANGeneration,  ///< Generating SAN moves while writing.
+};
+
+/**
+ * \brief Number of PGN stages.
+ */
+constexpr size_t pgn_stage_count{6};
+
+auto to_string(PGNStage stage) -> std::string;
+
+/**
+ * \brief Counters collected by PGNInstrumentation.
+ *
+ * A parser counts the games, tokens and bytes it reads, a writer the games
+ * and bytes it writes. The bytes written are only counted for output streams
+ * that report their position.
+ */
+struct PGNCounters {
+    uint64_t games{0};                                                   ///< Number of games read or written.
+    uint64_t tokens{0};                                                  ///< Number of tokens read.
+    uint64_t bytes{0};                                                   ///< Number of bytes consumed from the input or written to the output.
+    uint64_t san_parses{0};                                              ///< Number of parsed SAN moves.
+    uint64_t san_generations{0};                                         ///< Number of generated SAN moves.
+    uint64_t legal_move_generations{0};                                  ///< Number of generated lists of all legal moves.
+    uint64_t positions_replayed{0};                                      ///< Number of moves applied to positions.
+    uint64_t nodes_allocated{0};                                         ///< Number of nodes added to game trees.
+    std::array<uint64_t, pgn_warning_type_count> warnings{};             ///< Number of warnings per warning type.
+    std::array<std::chrono::nanoseconds, pgn_stage_count> stage_times{}; ///< Accumulated time per stage.
+
+    /**
+     * \brief The number of warnings of a type.
+     *
+     * \param type The warning type.
+     * \return Number of warnings.
+     */
+    [[nodiscard]] auto warning_count(PGNWarningType type) const -> uint64_t { return warnings[static_cast<size_t>(type)]; }
+
+    /**
+     * \brief The accumulated time of a stage.
+     *
+     * \param stage The stage.
+     * \return The time spent in the stage.
+     */
+    [[nodiscard]] auto stage_time(PGNStage stage) const -> std::chrono::nanoseconds { return stage_times[static_cast<size_t>(stage)]; }
+};
+
+/**
+ * \brief Instrumentation policy, that collects nothing.
+ *
+ * This is the default policy of BasicPGNParser and BasicPGNWriter. All
+ * instrumentation hooks are removed at compile time.
+ */
+struct NoInstrumentation {
+    static constexpr bool enabled{false}; ///< Instrumentation is disabled.
+
+    struct StageTimer {};
+
+    static auto time(PGNStage /*stage*/) -> StageTimer { return {}; }
+};
+
+/**
+ * \brief Instrumentation policy, that collects PGNCounters.
+ *
+ * The counters accumulate over all games read or written, until they are
+ * reset.
+ */
+class PGNInstrumentation {
+public:
+    static constexpr bool enabled{true}; ///< Instrumentation is enabled.
+
+    /**
+     * \brief Adds the time of its lifetime to a stage.
+     */
+    class StageTimer {
+    public:
+        StageTimer(PGNCounters &counters, PGNStage stage)
+            : m_time{&counters.stage_times[static_cast<size_t>(stage)]}, m_start{std::chrono::steady_clock::now()} {}
+        StageTimer(const StageTimer &) = delete;
+        StageTimer(StageTimer &&) = delete;
+        auto operator=(const StageTimer &) -> StageTimer & = delete;
+        auto operator=(StageTimer &&) -> StageTimer & = delete;
+        ~StageTimer() { *m_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start); }
+    private:
+        std::chrono::nanoseconds *m_time;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    /**
+     * \brief Measure the time of a stage.
+     *
+     * \param stage The stage.
+     * \return Timer, that adds the time until its destruction to the stage.
+     */
+    auto time(PGNStage stage) -> StageTimer { return StageTimer{m_counters, stage}; }
+
+    /**
+     * \brief The collected counters.
+     *
+     * \return The counters.
+     */
+    [[nodiscard]] auto counters() const -> const PGNCounters & { return m_counters; }
+
+    /**
+     * \brief Access to the collected counters.
+     *
+     * \return The counters.
+     */
+    auto counters() -> PGNCounters & { return m_counters; }
+
+    /**
+     * \brief Reset all counters to zero.
+     */
+    auto reset() -> void { m_counters = PGNCounters{}; }
+
+    /**
+     * \brief Count the input consumed up to an offset.
+     *
+     * Bytes are counted only once, even if the input is read again after
+     * stepping back.
+     * \param offset The offset in the input.
+     */
+    auto consumed_input(size_t offset) -> void {
+        if (offset > m_input_offset) {
+            m_counters.bytes += offset - m_input_offset;
+            m_input_offset = offset;
+        }
+    }
+
+    /**
+     * \brief Start counting the consumed bytes of a new input.
+     */
+    auto new_input() -> void { m_input_offset = 0; }
+private:
+    PGNCounters m_counters;
+    size_t m_input_offset{0};
+};
+
 /**
  * \brief Lexical analysis of PGN data.
  *
- * Extracts tokens from PGN data.
+ * Extracts tokens from PGN data. The lexer works on contiguous memory. Input
+ * given as a string view (e.g., a memory-mapped file) is analysed in place.
+ * Input from a stream or an InputSource is read in large blocks into an
+ * internal buffer.
  */
 class PGNLexer {
 public:
@@ -112,20 +283,49 @@ public:
     /**
      * \brief A token of PGN data.
      *
-     * Describes a lexical unit in the PGN data stream.
+     * Describes a lexical unit in the PGN data stream. The value refers to
+     * memory owned by the input or by the lexer. For input from a string view,
+     * it stays valid as long as the input. For input from a stream, it is only
+     * valid until the next token is requested.
      */
     struct Token {
         TokenType type{TokenType::Invalid}; ///< The type of the token.
         int line{0};                        ///< The line number of the token.
-        std::string value;                  ///< The value of the token.
+        std::string_view value;             ///< The value of the token.
+        size_t offset{0};                   ///< Byte offset of the start of the token in the input.
     };
 
+    /**
+     * \brief Default size of the blocks that are read from an input stream.
+     */
+    static constexpr size_t default_block_size{64UL * 1024UL};
+
     /**
      * \brief Create a PGNLexer for a given input stream.
      *
+     * The buffer grows beyond the block size, if a single token does not fit.
      * \param in_stream The PGN input.
+     * \param block_size Number of bytes to read from the stream at once.
+     */
+    explicit PGNLexer(std::istream *in_stream, size_t block_size = default_block_size);
+
+    /**
+     * \brief Create a PGNLexer for PGN data from an input source.
+     *
+     * The blocks are read from the source directly into the buffer. Use
+     * open_input() for compressed input.
+     * \param source The PGN input.
+     * \param block_size Number of bytes to read from the source at once.
+     */
+    explicit PGNLexer(std::unique_ptr<InputSource> source, size_t block_size = default_block_size);
+
+    /**
+     * \brief Create a PGNLexer for PGN data in memory.
+     *
+     * The data is not copied and has to outlive the lexer and its tokens.
+     * \param input The PGN input.
      */
-    explicit PGNLexer(std::istream *in_stream) : m_in_stream{in_stream} {}
+    explicit PGNLexer(std::string_view input);
 
     /**
      * \brief Retrieve the next token from the input stream.
@@ -143,80 +343,437 @@ public:
      */
     [[nodiscard]] auto line_number() const -> int { return m_line_number; }
 
+    /**
+     * \brief The offset of the lexer in the whole input.
+     *
+     * \return Byte offset of the next character to analyse.
+     */
+    [[nodiscard]] auto offset() const -> size_t { return m_begin_offset + static_cast<size_t>(m_pos - m_begin); }
+
     auto skip_back() -> void;
+
+    /**
+     * \brief Skip the input up to the next tag section.
+     *
+     * Skips all characters up to the next opening bracket, that is not part of
+     * a comment or a string, without creating any tokens. The opening bracket
+     * is returned by the next call to next_token().
+     */
+    auto skip_to_tag_section() -> void;
+
+    /**
+     * \brief Copy the input up to the next tag section.
+     *
+     * Skips the input like skip_to_tag_section(), starting after the last
+     * token. The input from the start of the last token up to the next tag
+     * section is appended to a string.
+     * \param out The string.
+     */
+    auto copy_to_tag_section(std::string &out) -> void;
 private:
-    std::istream *m_in_stream; ///< The input stream
-    int m_line_number{1};      ///< Current line number
+    static constexpr int end_of_input{-1};
+
+    std::unique_ptr<InputSource> m_source; ///< The input source, if the input is not in memory.
+    std::vector<char> m_buffer;         ///< Block buffer for input from a stream.
+    const char *m_begin{nullptr};       ///< Start of the available input.
+    size_t m_begin_offset{0};           ///< Offset of m_begin in the whole input.
+    const char *m_pos{nullptr};         ///< Next character to analyse.
+    const char *m_end{nullptr};         ///< End of the available input.
+    const char *m_token_start{nullptr}; ///< Start of the current token. Kept in the buffer, when it is refilled.
+    std::string m_comment;              ///< Comment with normalized whitespace.
+    int m_line_number{1};               ///< Current line number
+    std::string *m_capture{nullptr};    ///< Receives the skipped input in copy_to_tag_section().
+    const char *m_capture_start{};      ///< Start of the input, that is not yet appended to m_capture.
+
+    auto fill_buffer() -> bool;
+    auto peek() -> int { return (m_pos != m_end || fill_buffer()) ? static_cast<unsigned char>(*m_pos) : end_of_input; }
+    auto get() -> int {
+        const auto character = peek();
+        if (character != end_of_input) {
+            ++m_pos;
+        }
+        return character;
+    }
+    [[nodiscard]] auto make_token(TokenType type, std::string_view value) const -> Token;
+    [[nodiscard]] auto token_value(size_t prefix_length, size_t suffix_length = 0) const -> std::string_view;
 
     [[nodiscard]] static auto is_whitespace(char character) -> bool;
-    auto skip_whitespace(int character) -> void;
+    auto skip_whitespace() -> void;
     auto read_string() -> Token;
-    auto read_token_starting_with_number(char first_c) -> Token;
-    [[nodiscard]] static auto is_symbol_character(char character) -> bool;
-    auto read_symbol(char first_c) -> Token;
+    auto read_token_starting_with_number() -> Token;
+    auto read_symbol() -> Token;
     auto read_comment() -> Token;
     auto read_nag() -> Token;
+    auto scan_to_delimiter(char delimiter, bool &irregular_whitespace) -> bool;
+    auto skip_until(char delimiter) -> void;
 };
 
 auto to_string(PGNLexer::TokenType type) -> std::string;
 
+/**
+ * \brief The tag section of a game.
+ *
+ * Result of reading only the header of a game, without its movetext.
+ */
+struct GameHeader {
+    size_t offset{0};          ///< Byte offset of the start of the game in the input.
+    size_t movetext_offset{0}; ///< Byte offset of the start of the movetext in the input.
+    GameMetadata metadata;     ///< The tags of the game.
+};
+
+/**
+ * \brief An error in a single game.
+ *
+ * Result of reading a game, that could not be parsed, without throwing.
+ */
+struct PGNGameError {
+    PGNError error;        ///< The error, including the line number.
+    size_t game_offset{0}; ///< Byte offset of the start of the game in the input.
+    size_t offset{0};      ///< Byte offset of the token, where the error was detected.
+};
+
+/**
+ * \brief Parser policy, that accepts deviations from the standard and keeps everything.
+ *
+ * This is the default policy of BasicPGNParser. A parser policy decides at
+ * compile time, which features of the parser are used. The code of disabled
+ * features is removed.
+ */
+struct LenientPGNPolicy {
+    static constexpr bool lenient{true};          ///< Accept moves without piece type or capture mark and stray characters in the movetext, with a warning.
+    static constexpr bool keep_comments{true};    ///< Store the comments in the games.
+    static constexpr bool keep_variations{true};  ///< Parse the variations and store them in the games.
+    static constexpr bool keep_nags{true};        ///< Store the NAGs and suffix annotations in the games.
+    static constexpr bool collect_warnings{true}; ///< Collect warnings, see BasicPGNParser::warnings().
+};
+
+/**
+ * \brief Parser policy for strictly valid input, that keeps only the main line.
+ *
+ * Comments, NAGs and suffix annotations are skipped, variations are skipped
+ * without checking their moves. Every move has to be standard SAN. This is
+ * the fast path for machine-generated input, e.g. engine games.
+ */
+struct StrictMainlinePGNPolicy {
+    static constexpr bool lenient{false};          ///< Reject all deviations from the standard.
+    static constexpr bool keep_comments{false};    ///< Skip the comments.
+    static constexpr bool keep_variations{false};  ///< Skip the variations.
+    static constexpr bool keep_nags{false};        ///< Skip the NAGs and suffix annotations.
+    static constexpr bool collect_warnings{false}; ///< Do not collect warnings.
+};
+
 /**
  * \brief Parser for PGN data.
  *
  * Performs syntactical analysis of PGN data and extracts games.
+ *
+ * The instrumentation policy decides, which counters and timings are
+ * collected while parsing. With NoInstrumentation, the default, nothing is
+ * collected. PGNInstrumentation collects PGNCounters.
+ *
+ * The parser policy decides, which deviations from the standard are accepted
+ * and which parts of the movetext are kept, see LenientPGNPolicy (the
+ * default) and StrictMainlinePGNPolicy. Only these policies are instantiated
+ * in the library.
  */
-class PGNParser {
+template<typename Instrumentation = NoInstrumentation, typename Policy = LenientPGNPolicy>
+class BasicPGNParser {
 public:
-    explicit PGNParser(std::istream &in_stream) : m_lexer{&in_stream} {}
+    /**
+     * \brief Create a parser for PGN data from a stream.
+     *
+     * \param in_stream The PGN input.
+     * \param resource The memory resource for the games returned by read_game().
+     */
+    explicit BasicPGNParser(std::istream &in_stream, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_lexer{&in_stream}, m_metadata{resource}, m_game{GameMetadata{resource}, resource} {}
+
+    /**
+     * \brief Create a parser for PGN data from an input source.
+     *
+     * \param input The PGN input, e.g. from open_input().
+     * \param resource The memory resource for the games returned by read_game().
+     */
+    explicit BasicPGNParser(std::unique_ptr<InputSource> input, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_lexer{std::move(input)}, m_metadata{resource}, m_game{GameMetadata{resource}, resource} {}
 
+    /**
+     * \brief Create a parser for PGN data in memory.
+     *
+     * The data is not copied and has to outlive the parser.
+     * \param input The PGN input.
+     * \param resource The memory resource for the games returned by read_game().
+     */
+    explicit BasicPGNParser(std::string_view input, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_lexer{input}, m_metadata{resource}, m_game{GameMetadata{resource}, resource} {}
+
+    /**
+     * \brief Continue parsing with new PGN data in memory.
+     *
+     * The parser forgets the previous input and starts reading games from the
+     * given data. The data is not copied and has to outlive the parser.
+     * \param input The PGN input.
+     */
+    auto set_input(std::string_view input) -> void;
+
+    /**
+     * \brief Read the next game.
+     *
+     * Games of other variants than standard chess are skipped. Throws a
+     * PGNError, if the game cannot be parsed. The parser is then left inside
+     * the game, see skip_to_next_game().
+     * \return The game or nullopt at the end of the input.
+     */
     auto read_game() -> std::optional<Game>;
 
+    /**
+     * \brief Read the next game, reporting errors instead of throwing them.
+     *
+     * Behaves like read_game(), but returns the error of a game that cannot
+     * be parsed. The parser then skips to the tag section of the following
+     * game, so that calling try_read_game() again continues with that game.
+     * Errors of the input stream itself are still thrown.
+     * \return The game, nullopt at the end of the input, or the error.
+     */
+    auto try_read_game() -> std::expected<std::optional<Game>, PGNGameError>;
+
+    /**
+     * \brief Read the next game into an existing game.
+     *
+     * Behaves like read_game(), but stores the game in the given object (see
+     * Game::reset()). The memory of the game is reused, so that reading many
+     * games into the same object does not allocate new trees and tag lists.
+     * Comments, NAGs, stored positions other than the root and stored boards
+     * are still allocated for every game.
+     * \param game The game, that is overwritten with the next game.
+     * \return If a game was read, false at the end of the input.
+     */
+    auto read_game_into(Game &game) -> bool;
+
+    /**
+     * \brief Read the next game into an existing game, reporting errors.
+     *
+     * Combines read_game_into() and try_read_game(). After an error, the game
+     * contains the part read before the error.
+     * \param game The game, that is overwritten with the next game.
+     * \return If a game was read, false at the end of the input, or the error.
+     */
+    auto try_read_game_into(Game &game) -> std::expected<bool, PGNGameError>;
+
+    /**
+     * \brief Parse a game, that consists only of movetext.
+     *
+     * The input is the movetext of a single game without a tag section, as
+     * recorded for games read with lazy movetext.
+     * \param metadata The tags of the game.
+     * \return The game.
+     */
+    auto read_game_movetext(const GameMetadata &metadata) -> Game;
+
+    /**
+     * \brief Read only the main line of the next game.
+     *
+     * Behaves like read_game(), but no game tree is built. The moves are
+     * resolved on a Board and stored in a MainlineGame, variations are
+     * skipped, and comments and NAGs are dropped. Throws a PGNError, if the
+     * game cannot be parsed.
+     * \return The game or nullopt at the end of the input.
+     */
+    auto read_mainline_game() -> std::optional<MainlineGame>;
+
     auto warnings() const -> const std::vector<PGNWarning> & { return m_warnings; }
 
     auto skip_to_next_game() -> void;
+
+    /**
+     * \brief Skip over the next game without parsing it.
+     *
+     * Skips the tag section and the movetext of the next game. The movetext is
+     * skipped like in skip_to_next_game(), i.e., the game ends where the tag
+     * section of the following game starts.
+     * \return Byte offset of the start of the skipped game or nullopt at the
+     *   end of the input.
+     */
+    auto skip_game() -> std::optional<size_t>;
+
+    /**
+     * \brief Read only the tag section of the next game.
+     *
+     * The tags are parsed, the movetext is skipped without analysing moves,
+     * so no Game and no positions are created. In contrast to read_game(),
+     * games of all variants are returned.
+     *
+     * Without skipping the movetext, reading stops at the start of the
+     * movetext, e.g. for checking the tags of a single game before deciding
+     * to read its movetext. The parser then has to get new input (see
+     * set_input()) before reading further games.
+     * \param skip_movetext If the movetext is skipped, so that the next game can be read.
+     * \return The header of the game or nullopt at the end of the input.
+     */
+    auto read_header(bool skip_movetext = true) -> std::optional<GameHeader>;
+
+    /**
+     * \brief The policy for storing positions in the parsed games.
+     *
+     * By default, only the position of the root node is stored. The parser
+     * resolves the moves on a Board, so it does not need stored positions.
+     * \return The position cache policy.
+     */
+    [[nodiscard]] auto position_cache_policy() const -> const PositionCachePolicy & { return m_position_cache_policy; }
+
+    /**
+     * \brief Set the policy for storing positions in the parsed games.
+     *
+     * \param policy The position cache policy.
+     */
+    auto set_position_cache_policy(const PositionCachePolicy &policy) -> void { m_position_cache_policy = policy; }
+
+    /**
+     * \brief Set the pool for the tag names and values of the parsed games.
+     *
+     * Sharing a pool between the games of a database stores repeated names
+     * and values only once. Without a pool, every game stores its tags
+     * itself.
+     * \param pool The pool.
+     */
+    auto set_tag_pool(std::shared_ptr<TagPool> pool) -> void { m_tag_pool = std::move(pool); }
+
+    /**
+     * \brief The memory resource for the parsed games.
+     *
+     * The games returned by read_game() and read_game_movetext() allocate
+     * their trees and metadata from the resource. Without a shared pool, also
+     * the pools of the games are allocated from the resource. Games passed to
+     * read_game_into() keep their own memory resource.
+     * \return The memory resource given to the constructor.
+     */
+    [[nodiscard]] auto memory_resource() const -> std::pmr::memory_resource * { return m_game.memory_resource(); }
+
+    /**
+     * \brief Check, if the movetext of games is parsed lazily.
+     *
+     * \return If the movetext is parsed lazily.
+     */
+    [[nodiscard]] auto lazy_movetext() const -> bool { return m_lazy_movetext; }
+
+    /**
+     * \brief Parse the movetext of games lazily.
+     *
+     * In lazy mode, read_game() only parses the tags of a game and records
+     * its movetext. The moves are parsed and the game tree is built the first
+     * time the tree of the game is accessed, e.g. by Game::cursor() or
+     * Game::edit(). Errors in the movetext are then reported by that access.
+     * Warnings are not collected for lazily parsed movetext.
+     * \param lazy If the movetext should be parsed lazily.
+     */
+    auto set_lazy_movetext(bool lazy) -> void { m_lazy_movetext = lazy; }
+
+    /**
+     * \brief The instrumentation of the parser.
+     *
+     * \return The instrumentation.
+     */
+    [[nodiscard]] auto instrumentation() const -> const Instrumentation & { return m_instrumentation; }
+
+    /**
+     * \brief Access to the instrumentation of the parser.
+     *
+     * \return The instrumentation.
+     */
+    auto instrumentation() -> Instrumentation & { return m_instrumentation; }
 private:
     PGNLexer m_lexer;
     PGNLexer::Token m_token;
     GameMetadata m_metadata;
-    Game m_game;
+    Game m_game;                   ///< The game returned by read_game().
+    Game *m_current_game{nullptr}; ///< The game, that is currently being parsed.
+    PositionCachePolicy m_position_cache_policy{PositionCachePolicy::root_only()};
+    std::shared_ptr<TagPool> m_tag_pool;
     std::string m_overall_game_comment;
+    bool m_lazy_movetext{false};
+    size_t m_game_offset{0}; ///< Byte offset of the start of the current game.
+    std::string m_san;       ///< SAN string of the last resolved move, see GameNode::san().
 
     struct rav_descriptor {
         bool has_moves{false};
         std::string comment;
     };
-    std::stack<rav_descriptor> m_rav_stack;
+    std::stack<rav_descriptor, std::vector<rav_descriptor>> m_rav_stack;
 
     mutable std::vector<PGNWarning> m_warnings;
+    [[no_unique_address]] mutable Instrumentation m_instrumentation;
+
+    struct game_line {
+        Cursor cursor;                ///< Cursor at the last move of the line.
+        std::optional<Cursor> parent; ///< Cursor before the last move of the line, keeping its position and board.
+    };
+    std::stack<game_line, std::vector<game_line>> m_cursors;
 
-    std::stack<Cursor> m_cursors;
+    using Status = std::expected<void, PGNError>;
+
+    auto parse_game(Game &game) -> std::expected<bool, PGNError>;
     auto reset() -> void;
-    auto setup_game() -> void;
+    auto reset_game(Game &game) -> Status;
+    auto setup_game(Game &game) -> Status;
+    auto finish_game() -> void;
     auto clear_cursor_stack() -> void;
-    auto current_game_line() -> Cursor & { return m_cursors.top(); }
-    [[nodiscard]] auto current_game_line() const -> const Cursor & { return m_cursors.top(); }
+    auto current_game_line() -> Cursor & { return m_cursors.top().cursor; }
+    [[nodiscard]] auto current_game_line() const -> const Cursor & { return m_cursors.top().cursor; }
 
     auto next_token() -> void;
-    auto read_metadata() -> void;
-    auto read_movetext() -> void;
-    auto read_move() -> void;
-    auto read_tag() -> void;
+    auto read_metadata() -> Status;
+    auto read_game_comment() -> void;
+    auto read_movetext() -> Status;
+    auto read_move() -> Status;
+    auto read_tag() -> Status;
     auto annotate_move() -> void;
     auto process_game_result() -> void;
     auto process_move_comment() -> void;
-    auto start_rav() -> void;
-    auto finish_rav() -> void;
+    auto start_rav() -> Status;
+    auto finish_rav() -> Status;
     auto read_move_number_indication() -> void;
 
-    auto process_move() -> void;
-    [[nodiscard]] auto parse_san_move(const std::string &san_str) const -> SANMove;
-    [[nodiscard]] auto find_legal_move(const SANMove &san_move) const -> chesscore::Move;
+    auto process_move() -> Status;
+    [[nodiscard]] auto parse_san_move(std::string_view san_str, chesscore::Color side_to_move) const -> std::expected<SANMove, PGNError>;
+    auto find_legal_move(const SANMove &san_move) -> std::expected<chesscore::Move, PGNError>;
+    auto match_legal_move(const SANMove &san_move, const chesscore::Position &position) -> std::expected<chesscore::Move, PGNError>;
+    auto read_mainline_movetext(MainlineGame &game, Board &board) -> Status;
+    auto read_mainline_move(MainlineGame &game, Board &board) -> Status;
 
-    auto check_token_type(PGNLexer::TokenType expected_type, const std::string &error_message) const -> void;
-    auto expect_token(PGNLexer::TokenType expected_type, const std::string &error_message) -> void;
+    [[nodiscard]] auto check_token_type(PGNLexer::TokenType expected_type, std::string_view error_message) const -> Status;
+    auto expect_token(PGNLexer::TokenType expected_type, std::string_view error_message) -> Status;
     auto skip_tokens(PGNLexer::TokenType type) -> void;
+    auto skip_rav() -> Status;
+    auto add_warning(PGNWarningType type, int line, std::string description) const -> void;
+};
+
+extern template class BasicPGNParser<NoInstrumentation>;
+extern template class BasicPGNParser<PGNInstrumentation>;
+extern template class BasicPGNParser<NoInstrumentation, StrictMainlinePGNPolicy>;
+extern template class BasicPGNParser<PGNInstrumentation, StrictMainlinePGNPolicy>;
+
+/**
+ * \brief Parser for PGN data without instrumentation.
+ *
+ * A class instead of an alias, so that it can be forward declared.
+ */
+class PGNParser : public BasicPGNParser<> {
+public:
+    using BasicPGNParser::BasicPGNParser;
 };
 
+/**
+ * \brief Parser for strictly valid PGN data, that keeps only the main line.
+ */
+using StrictMainlinePGNParser = BasicPGNParser<NoInstrumentation, StrictMainlinePGNPolicy>;
+
+/**
+ * \brief Formatting of PGN tokens.
+ *
+ * Writes tokens to a stream, separating them by whitespace where necessary
+ * and wrapping lines. Tokens are formatted into a buffer that is reused for
+ * all tokens, so that writing a token does not allocate memory.
+ */
 class PGNTokenOutput {
 public:
     explicit PGNTokenOutput(std::ostream *ostream) : m_ostream{ostream} {}
@@ -226,37 +783,41 @@ public:
     template<typename... Args>
     auto write(OutToken type, Args &&...args) -> void {
         static_assert(sizeof...(args) > 0, "No data to write");
-        std::string token = (... + to_string(std::forward<Args>(args)));
-        write_token(type, token);
+        m_token.clear();
+        (append(m_token, std::forward<Args>(args)), ...);
+        write_token(type, m_token);
     }
 
-    auto write_comment(const std::string &comment) -> void;
+    auto write_comment(std::string_view comment) -> void;
 
     auto newline() -> void;
 
     auto end_metadata_section() -> void { newline(); }
+
+    /**
+     * \brief The output stream.
+     *
+     * \return The stream, that the tokens are written to.
+     */
+    [[nodiscard]] auto stream() const -> std::ostream * { return m_ostream; }
 private:
     std::ostream *m_ostream;
     OutToken m_last_out_token{OutToken::None};
     const size_t m_max_line_length{79};
     size_t m_current_line_length{};
+    std::string m_token; ///< Buffer for formatting a token.
 
-    template<size_t N>
-    std::string to_string(const char (&val)[N]) {
-        return std::string(val);
-    }
-
-    std::string to_string(const std::string &val) { return val; }
-    std::string to_string(const std::string_view val) { return std::string{val}; }
+    static auto append(std::string &out, std::string_view value) -> void { out.append(value); }
+    static auto append(std::string &out, char value) -> void { out.push_back(value); }
 
-    std::string to_string(char val) { return std::string(1, val); }
-
-    template<typename T>
-    std::string to_string(const T &val) {
-        return std::to_string(val);
+    template<std::integral T>
+    static auto append(std::string &out, T value) -> void {
+        std::array<char, std::numeric_limits<T>::digits10 + 2> digits{};
+        const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), value);
+        out.append(digits.data(), result.ptr);
     }
 
-    auto write_token(OutToken type, const std::string &token) -> void;
+    auto write_token(OutToken type, std::string_view token) -> void;
 
     auto needs_whitespace(OutToken type) const -> bool;
 };
@@ -265,29 +826,116 @@ private:
  * \brief Writer for PGN data.
  *
  * Provides functionality to write a chess game as PGN data to a stream.
+ *
+ * Like BasicPGNParser, the writer takes an instrumentation policy.
  */
-class PGNWriter {
+template<typename Instrumentation = NoInstrumentation>
+class BasicPGNWriter {
 public:
-    explicit PGNWriter(std::ostream &ostream) : m_output{&ostream} {}
+    explicit BasicPGNWriter(std::ostream &ostream) : m_output{&ostream} {}
 
     auto write_game(const Game &game) -> void;
 
+    /**
+     * \brief Write a game, that consists only of its main line.
+     *
+     * The output is the same as for the game returned by
+     * MainlineGame::to_game(), but no game tree and no positions are created.
+     * The SAN strings of the moves are generated on a Board.
+     * \param game The game.
+     */
+    auto write_game(const MainlineGame &game) -> void;
+
     auto write_metadata(const GameMetadata &metadata) -> void;
     auto write_game_lines(const ConstCursor &node) -> void;
+
+    /**
+     * \brief Write the game lines that start at a node.
+     *
+     * The position is carried along the lines, so that every position is
+     * calculated only once.
+     * \param node The node where the lines start.
+     * \param position The position of the node.
+     */
+    auto write_game_lines(const ConstCursor &node, chesscore::Position position) -> void;
+
+    /**
+     * \brief Write the game lines that start at a node of a tree.
+     *
+     * Like write_game_lines(const ConstCursor &, chesscore::Position), but the
+     * tree is navigated without cursors.
+     * \param node The node where the lines start.
+     * \param position The position of the node.
+     */
+    auto write_game_lines(NodeView node, chesscore::Position position) -> void;
     auto write_game_termination(const Game &game) -> void;
+    auto write_game_termination(const GameMetadata &metadata) -> void;
 
     auto write_str_tags(const GameMetadata &metadata) -> void;
     auto write_non_str_tags(const GameMetadata &metadata) -> void;
-    auto write_tag_pair(const std::string &name, const std::string &value) -> void;
+    auto write_tag_pair(std::string_view name, std::string_view value) -> void;
     auto write_tag_pair(const metadata_tag &tag) -> void;
-    auto write_move(const GameNode &node) -> void;
+    auto write_move(const ConstCursor &node) -> void;
+
+    /**
+     * \brief Write the move that leads to a node.
+     *
+     * The cached SAN string of the node is used, if there is one. Otherwise,
+     * the SAN string is generated from the legal moves of the position.
+     * \param node The node.
+     * \param position The position before the move.
+     * \param next_position The position after the move.
+     */
+    auto write_move(const ConstCursor &node, const chesscore::Position &position, const chesscore::Position &next_position) -> void;
+    auto write_move(NodeView node, const chesscore::Position &position, const chesscore::Position &next_position) -> void;
     auto write_rav(const ConstCursor &node) -> void;
 
+    /**
+     * \brief Write a variation that starts with the move that leads to a node.
+     *
+     * \param node The first node of the variation.
+     * \param position The position before the first move of the variation.
+     */
+    auto write_rav(const ConstCursor &node, const chesscore::Position &position) -> void;
+    auto write_rav(NodeView node, const chesscore::Position &position) -> void;
+
     static auto has_overall_game_comment(const Game &game) -> bool;
     auto write_overall_game_comment(const Game &game) -> void;
+
+    /**
+     * \brief The instrumentation of the writer.
+     *
+     * \return The instrumentation.
+     */
+    [[nodiscard]] auto instrumentation() const -> const Instrumentation & { return m_instrumentation; }
+
+    /**
+     * \brief Access to the instrumentation of the writer.
+     *
+     * \return The instrumentation.
+     */
+    auto instrumentation() -> Instrumentation & { return m_instrumentation; }
 private:
     PGNTokenOutput m_output;
     bool m_write_black_move_number{false};
+    std::string m_san; ///< Buffer for formatting a SAN move.
+    [[no_unique_address]] Instrumentation m_instrumentation;
+
+    auto replay_move(chesscore::Position &position, const chesscore::Move &move) -> void;
+    auto generate_san(const chesscore::Move &move, const chesscore::Position &position, const chesscore::Position &next_position) -> void;
+};
+
+extern template class BasicPGNWriter<NoInstrumentation>;
+extern template class BasicPGNWriter<PGNInstrumentation>;
+
+/**
+ * \brief Writer for PGN data without instrumentation.
+ *
+ * A class instead of an alias, so that it can be forward declared.
+ */
+class PGNWriter : public BasicPGNWriter<> {
+public:
+    using BasicPGNWriter::BasicPGNWriter;
 };
 
 } // namespace chessgame
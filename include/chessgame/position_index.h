@@ -0,0 +1,208 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_POSITION_INDEX_H
+#define CHESSGAME_POSITION_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "chessgame/board.h"
+#include "chessgame/database.h"
+#include "chessgame/game.h"
+#include "chessgame/mainline.h"
+
+#include "chesscore/piece.h"
+
+namespace chessgame {
+
+/**
+ * \brief The material of a position.
+ *
+ * Packs the number of pawns (4 bits) and of knights, bishops, rooks and
+ * queens (3 bits each, saturating at 7) of both sides into 32 bits. White
+ * uses the lower 16 bits, black the upper 16 bits. Positions with the same
+ * material have the same signature.
+ * \param board The board of the position.
+ * \return The material signature.
+ */
+auto material_signature(const Board &board) -> uint32_t;
+
+/**
+ * \brief The squares of the pawns of one side.
+ *
+ * \param board The board of the position.
+ * \param color The side.
+ * \return Set of squares with a pawn of the side, bit n is the square with index n (see square_index()).
+ */
+auto pawn_squares(const Board &board, chesscore::Color color) -> uint64_t;
+
+/**
+ * \brief Conditions on the positions searched in a PositionIndex.
+ *
+ * A position matches, if it fulfils all given conditions. An empty query
+ * matches every position.
+ */
+struct PositionQuery {
+    std::optional<uint64_t> key{};      ///< Key of the position (see Board::key()).
+    std::optional<uint32_t> material{}; ///< Material signature of the position (see material_signature()).
+    uint64_t white_pawns{0};            ///< Squares, that have to be occupied by white pawns.
+    uint64_t black_pawns{0};            ///< Squares, that have to be occupied by black pawns.
+    uint64_t no_white_pawns{0};         ///< Squares, that may not be occupied by white pawns.
+    uint64_t no_black_pawns{0};         ///< Squares, that may not be occupied by black pawns.
+};
+
+/**
+ * \brief A position of a game, that matches a query.
+ */
+struct PositionMatch {
+    size_t game_offset{0}; ///< Byte offset of the game in the PGN data.
+    size_t ply{0};         ///< Number of moves into the main line, 0 for the start position.
+
+    auto operator==(const PositionMatch &other) const -> bool = default;
+};
+
+/**
+ * \brief Index of the positions on the main lines of games.
+ *
+ * Records a compact signature for every position on the main line of every
+ * game: the key, the material signature and the pawn squares of both sides.
+ * The signatures are stored column by column, so that queries scan each
+ * column sequentially (with SSE2, where available) without parsing any PGN
+ * data. Games are identified by their byte offset in the PGN data.
+ *
+ * The index can be saved to and loaded from a side file next to the PGN
+ * file, like the game offsets of a PGNDatabase. The file records the size and
+ * a hash of all of the PGN data, so that it is not used for other or changed
+ * data. Loading therefore reads the whole data once.
+ */
+class PositionIndex {
+public:
+    /**
+     * \brief Add the positions of the main line of a game.
+     *
+     * The game is added without positions, if its start position is invalid.
+     * \param game_offset Byte offset of the game in the PGN data.
+     * \param game The game.
+     */
+    auto add_game(size_t game_offset, const MainlineGame &game) -> void;
+
+    /**
+     * \brief Add the positions of the main line of a game.
+     *
+     * Can be used while importing games, see import_games().
+     * \param game_offset Byte offset of the game in the PGN data.
+     * \param game The game.
+     */
+    auto add_game(size_t game_offset, const Game &game) -> void;
+
+    /**
+     * \brief The number of indexed games.
+     *
+     * \return Number of games.
+     */
+    [[nodiscard]] auto game_count() const -> size_t { return m_game_offsets.size(); }
+
+    /**
+     * \brief The number of indexed positions.
+     *
+     * \return Number of positions of all games.
+     */
+    [[nodiscard]] auto position_count() const -> size_t { return m_keys.size(); }
+
+    /**
+     * \brief The byte offsets of the indexed games.
+     *
+     * \return Offsets in the order, in which the games were added.
+     */
+    [[nodiscard]] auto game_offsets() const -> std::span<const size_t> { return m_game_offsets; }
+
+    /**
+     * \brief Find the positions, that match a query.
+     *
+     * \param query The query.
+     * \param max_matches Maximum number of matches to return.
+     * \return The matches in the order of the games and plies.
+     */
+    [[nodiscard]] auto find(const PositionQuery &query, size_t max_matches = std::numeric_limits<size_t>::max()) const -> std::vector<PositionMatch>;
+
+    /**
+     * \brief Find the games, that reach a position matching a query.
+     *
+     * \param query The query.
+     * \return The first matching position of every game with a match.
+     */
+    [[nodiscard]] auto find_games(const PositionQuery &query) const -> std::vector<PositionMatch>;
+
+    /**
+     * \brief Save the index to a file.
+     *
+     * \param path Path of the file.
+     * \param data The indexed PGN data.
+     * \return If the index was written.
+     */
+    auto save(const std::filesystem::path &path, std::string_view data) const -> bool;
+
+    /**
+     * \brief Load an index from a file written by save().
+     *
+     * \param path Path of the file.
+     * \param data The indexed PGN data.
+     * \return The index or nullopt, if the file cannot be read, is no valid index or belongs to other data.
+     */
+    static auto load(const std::filesystem::path &path, std::string_view data) -> std::optional<PositionIndex>;
+private:
+    std::vector<uint64_t> m_keys;         ///< Keys of the positions.
+    std::vector<uint32_t> m_material;     ///< Material signatures of the positions.
+    std::vector<uint64_t> m_white_pawns;  ///< Squares of the white pawns of the positions.
+    std::vector<uint64_t> m_black_pawns;  ///< Squares of the black pawns of the positions.
+    std::vector<size_t> m_game_offsets;   ///< Byte offsets of the games.
+    std::vector<size_t> m_game_positions; ///< Index of the first position of every game.
+
+    template<typename NextMove>
+    auto add_positions(Board board, NextMove next_move) -> void;
+
+    template<typename Visitor>
+    auto scan(const PositionQuery &query, Visitor visitor) const -> void;
+};
+
+/**
+ * \brief Build the position index of PGN data.
+ *
+ * Only the main lines of the games are parsed (see
+ * PGNParser::read_mainline_game()). Games, that cannot be parsed, and games of
+ * other variants are not indexed.
+ * \param data The PGN data.
+ * \param offsets Byte offsets of the starts of the games.
+ * \return The index.
+ */
+auto build_position_index(std::string_view data, const std::vector<size_t> &offsets) -> PositionIndex;
+
+/**
+ * \brief Build the position index of PGN data.
+ *
+ * \param data The PGN data.
+ * \return The index.
+ */
+auto build_position_index(std::string_view data) -> PositionIndex;
+
+/**
+ * \brief Build the position index of the games of a database.
+ *
+ * \param database The database.
+ * \return The index.
+ */
+auto build_position_index(const PGNDatabase &database) -> PositionIndex;
+
+} // namespace chessgame
+
+#endif
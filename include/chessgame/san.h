@@ -9,7 +9,9 @@
 
 #include <expected>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 
 #include "chesscore/move.h"
 #include "chesscore/piece.h"
@@ -95,7 +97,7 @@ struct SANParserError {
  * \param side_to_move The side to move.
  * \return The parsed SANMove.
  */
-auto parse_san(const std::string &san, chesscore::Color side_to_move) -> std::expected<SANMove, SANParserError>;
+auto parse_san(std::string_view san, chesscore::Color side_to_move) -> std::expected<SANMove, SANParserError>;
 
 /**
  * \brief Check, if a SAN move matches a move.
@@ -139,6 +141,32 @@ auto match_san_move_wildcard_piece_type(const SANMove &san_move, const chesscore
  */
 auto generate_san_move(const chesscore::Move &move, const chesscore::MoveList &moves) -> std::optional<SANMove>;
 
+/**
+ * \brief Append the SAN string of a move to a buffer.
+ *
+ * Formats the move like generate_san_move(), but writes only the SAN string
+ * and does not create a SANMove. Nothing is appended, if the move is not in
+ * the list of moves.
+ * \param out The buffer.
+ * \param move The move to be converted.
+ * \param moves A list of possible moves (where move should be included).
+ * \return If the move could be converted.
+ */
+auto append_san_move(std::string &out, const chesscore::Move &move, const chesscore::MoveList &moves) -> bool;
+
+/**
+ * \brief Append the SAN string of a move to a buffer.
+ *
+ * Formats the move like append_san_move() with a list of moves, but takes
+ * only the origin squares of the moves that are relevant for the
+ * disambiguation. The move is not checked for legality.
+ * \param out The buffer.
+ * \param move The move to be converted.
+ * \param origins Origin squares of all legal moves of the same piece to the
+ *                target square of the move, including the move itself.
+ */
+auto append_san_move(std::string &out, const chesscore::Move &move, std::span<const chesscore::Square> origins) -> void;
+
 } // namespace chessgame
 
 #endif
@@ -0,0 +1,339 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_TRAVERSAL_H
+#define CHESSGAME_TRAVERSAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string_view>
+
+#include "chessgame/tree.h"
+
+#include "chesscore/move.h"
+
+namespace chessgame {
+
+/**
+ * \brief Orders, in which nodes of a game tree can be traversed.
+ */
+enum class TraversalOrder {
+    Mainline,   ///< Follow the first children.
+    Siblings,   ///< Follow the next siblings.
+    DepthFirst, ///< Visit the nodes of a subtree in pre-order.
+};
+
+template<TraversalOrder Order>
+class NodeRange;
+
+/**
+ * \brief A lightweight read-only reference to a node of a game tree.
+ *
+ * In contrast to a ConstCursor, a view only consists of a pointer to the tree
+ * and the id of the node. It does not track the position or the board of the
+ * node, so that navigating the tree does not copy or update any positions.
+ * Views stay valid, when nodes are added to the tree, but not when the tree
+ * is destroyed or cleared.
+ *
+ * A default constructed view, and the views returned for non-existent
+ * relatives of a node, reference no node (see valid()).
+ */
+class NodeView {
+public:
+    /**
+     * \brief Create a view, that references no node.
+     */
+    NodeView() = default;
+
+    /**
+     * \brief Create a view for a node of a tree.
+     *
+     * \param tree The tree.
+     * \param node_id The id of the node, or NodeId::Invalid.
+     */
+    NodeView(const GameTree *tree, NodeId node_id) : m_tree{tree}, m_node{node_id} {}
+
+    /**
+     * \brief Check, if the view references a node.
+     *
+     * \return If the view references a node.
+     */
+    [[nodiscard]] auto valid() const -> bool { return m_tree != nullptr && m_node != NodeId::Invalid; }
+
+    /**
+     * \brief Check, if the view references a node.
+     *
+     * \return If the view references a node.
+     */
+    explicit operator bool() const { return valid(); }
+
+    /**
+     * \brief The id of the referenced node.
+     *
+     * \return The node id.
+     */
+    [[nodiscard]] auto id() const -> NodeId { return m_node; }
+
+    /**
+     * \brief The tree of the referenced node.
+     *
+     * \return The tree.
+     */
+    [[nodiscard]] auto tree() const -> const GameTree * { return m_tree; }
+
+    /**
+     * \brief The referenced node.
+     *
+     * \return The node.
+     */
+    [[nodiscard]] auto node() const -> const GameNode & { return m_tree->node(m_node); }
+
+    /**
+     * \brief The move that lead to the node.
+     *
+     * \return The move.
+     */
+    [[nodiscard]] auto move() const -> const chesscore::Move & { return node().move(); }
+
+    /**
+     * \brief The distance of the node from the root.
+     *
+     * \return The number of moves from the root.
+     */
+    [[nodiscard]] auto ply() const -> size_t { return node().ply(); }
+
+    /**
+     * \brief The key of the position of the node.
+     *
+     * \return The key or 0, if it is not known.
+     */
+    [[nodiscard]] auto position_key() const -> uint64_t { return node().key(); }
+
+    /**
+     * \brief The cached SAN string of the move.
+     *
+     * \return The SAN string or an empty string, if it is not cached.
+     */
+    [[nodiscard]] auto san() const -> std::string_view { return node().san(); }
+
+    /**
+     * \brief The comment of the node.
+     *
+     * \return The comment.
+     */
+    [[nodiscard]] auto comment() const -> std::string_view { return m_tree->comment(m_node); }
+
+    /**
+     * \brief The pre-move comment of the node.
+     *
+     * \return The pre-move comment.
+     */
+    [[nodiscard]] auto premove_comment() const -> std::string_view { return m_tree->premove_comment(m_node); }
+
+    /**
+     * \brief The Numeric Annotation Glyphs of the node.
+     *
+     * \return The NAGs.
+     */
+    [[nodiscard]] auto nags() const -> std::span<const int> { return m_tree->nags(m_node); }
+
+    /**
+     * \brief The parent of the node.
+     *
+     * \return View of the parent, invalid for the root.
+     */
+    [[nodiscard]] auto parent() const -> NodeView { return {m_tree, node().parent()}; }
+
+    /**
+     * \brief The first child of the node, i.e., the continuation of the line.
+     *
+     * \return View of the first child, invalid if there is none.
+     */
+    [[nodiscard]] auto first_child() const -> NodeView { return {m_tree, node().first_child()}; }
+
+    /**
+     * \brief The next child of the parent of the node, i.e., the next variation.
+     *
+     * \return View of the next sibling, invalid if there is none.
+     */
+    [[nodiscard]] auto next_sibling() const -> NodeView { return {m_tree, node().next_sibling()}; }
+
+    /**
+     * \brief A child of the node.
+     *
+     * \param index Index of the child, 0 for the main line.
+     * \return View of the child, invalid if it does not exist.
+     */
+    [[nodiscard]] auto child(size_t index) const -> NodeView { return {m_tree, m_tree->child(m_node, index)}; }
+
+    /**
+     * \brief The number of children of the node.
+     *
+     * \return Number of children.
+     */
+    [[nodiscard]] auto child_count() const -> size_t { return m_tree->child_count(m_node); }
+
+    /**
+     * \brief Check, if the node has children.
+     *
+     * \return If the node has children.
+     */
+    [[nodiscard]] auto has_children() const -> bool { return node().has_children(); }
+
+    /**
+     * \brief Check, if the node has variations.
+     *
+     * \return If the node has more than one child.
+     */
+    [[nodiscard]] auto has_variations() const -> bool { return has_children() && first_child().next_sibling().valid(); }
+
+    /**
+     * \brief Check, if the node starts a variation.
+     *
+     * \return If the node is a child other than the first of its parent.
+     */
+    [[nodiscard]] auto starts_variation() const -> bool {
+        const auto parent_view = parent();
+        return parent_view.valid() && parent_view.node().first_child() != m_node;
+    }
+
+    /**
+     * \brief The nodes of the main line, that follows the node.
+     *
+     * The range starts with the first child and follows the first children,
+     * so the node itself is not part of the range.
+     * \return Range of the nodes.
+     */
+    [[nodiscard]] auto mainline() const -> NodeRange<TraversalOrder::Mainline>;
+
+    /**
+     * \brief The children of the node.
+     *
+     * \return Range of the children, starting with the main line.
+     */
+    [[nodiscard]] auto children() const -> NodeRange<TraversalOrder::Siblings>;
+
+    /**
+     * \brief The nodes of the subtree of the node in pre-order.
+     *
+     * The range starts with the node itself. Every node is followed by the
+     * subtree of its first child and then by the subtrees of its further
+     * children. The traversal needs no additional memory.
+     * \return Range of the nodes.
+     */
+    [[nodiscard]] auto depth_first() const -> NodeRange<TraversalOrder::DepthFirst>;
+
+    /**
+     * \brief Equality comparison of views.
+     *
+     * \param other The other view.
+     * \return If both views reference the same node of the same tree.
+     */
+    auto operator==(const NodeView &other) const -> bool { return m_tree == other.m_tree && m_node == other.m_node; }
+private:
+    const GameTree *m_tree{nullptr};
+    NodeId m_node{NodeId::Invalid};
+};
+
+/**
+ * \brief Iterator over nodes of a game tree.
+ *
+ * \tparam Order The order of the traversal.
+ */
+template<TraversalOrder Order>
+class NodeIterator {
+public:
+    using value_type = NodeView;          ///< Type of the elements.
+    using difference_type = std::ptrdiff_t; ///< Type of distances between iterators.
+
+    NodeIterator() = default;
+
+    /**
+     * \brief Create an iterator.
+     *
+     * \param node The current node.
+     * \param root The root of the traversal, where a depth-first traversal ends.
+     */
+    NodeIterator(NodeView node, NodeId root) : m_node{node}, m_root{root} {}
+
+    auto operator*() const -> NodeView { return m_node; }
+
+    auto operator++() -> NodeIterator & {
+        if constexpr (Order == TraversalOrder::Mainline) {
+            m_node = m_node.first_child();
+        } else if constexpr (Order == TraversalOrder::Siblings) {
+            m_node = m_node.next_sibling();
+        } else {
+            if (m_node.has_children()) {
+                m_node = m_node.first_child();
+                return *this;
+            }
+            while (m_node.valid() && m_node.id() != m_root) {
+                if (const auto sibling = m_node.next_sibling(); sibling.valid()) {
+                    m_node = sibling;
+                    return *this;
+                }
+                m_node = m_node.parent();
+            }
+            m_node = NodeView{};
+        }
+        return *this;
+    }
+
+    auto operator++(int) -> NodeIterator {
+        auto previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    auto operator==(const NodeIterator &other) const -> bool { return m_node == other.m_node; }
+
+    auto operator==(std::default_sentinel_t /*sentinel*/) const -> bool { return !m_node.valid(); }
+private:
+    NodeView m_node;
+    NodeId m_root{NodeId::Invalid};
+};
+
+/**
+ * \brief Range of nodes of a game tree.
+ *
+ * \tparam Order The order of the traversal.
+ */
+template<TraversalOrder Order>
+class NodeRange {
+public:
+    /**
+     * \brief Create a range.
+     *
+     * \param first The first node of the range, may be invalid for an empty range.
+     * \param root The root of the traversal.
+     */
+    NodeRange(NodeView first, NodeId root) : m_first{first}, m_root{root} {}
+
+    [[nodiscard]] auto begin() const -> NodeIterator<Order> { return {m_first, m_root}; }
+    [[nodiscard]] auto end() const -> std::default_sentinel_t { return std::default_sentinel; }
+private:
+    NodeView m_first;
+    NodeId m_root;
+};
+
+inline auto NodeView::mainline() const -> NodeRange<TraversalOrder::Mainline> {
+    return {first_child(), m_node};
+}
+
+inline auto NodeView::children() const -> NodeRange<TraversalOrder::Siblings> {
+    return {first_child(), m_node};
+}
+
+inline auto NodeView::depth_first() const -> NodeRange<TraversalOrder::DepthFirst> {
+    return {*this, m_node};
+}
+
+} // namespace chessgame
+
+#endif
@@ -7,12 +7,24 @@
 #ifndef CHESSGAME_MOVETREE_H
 #define CHESSGAME_MOVETREE_H
 
-#include <memory>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "chessgame/board.h"
+#include "chessgame/memory.h"
 #include "chessgame/types.h"
 
 #include "chesscore/move.h"
+#include "chesscore/position.h"
 
 namespace chessgame {
 
@@ -64,27 +76,26 @@ struct NodeId {
  * game tree is stored. A GameNode represents a position in the game tree after
  * a move has been made. Multiple children represent continuations of the game
  * with alternative moves.
+ *
+ * The node only stores the move, the key of its position and the links to its
+ * relatives in the game tree. Comments, NAGs and positions are stored by the
+ * GameTree.
  */
 class GameNode {
 public:
+    static constexpr size_t max_san_length{7}; ///< Maximum length of a cached SAN string, e.g. "Qa1xb2+".
+
     /**
      * \brief Construct a new GameNode object
      *
-     * If a prent node is given, the move should also be valid. It is
+     * If a parent node is given, the move should also be valid. It is
      * interpreted as the move that lead from the parent node to this node.
      *
-     * \param node_id The id of the game node.
      * \param move The move that led to this node.
-     * \param parent The parent node.
+     * \param parent The id of the parent node.
+     * \param ply The distance of the node from the root node.
      */
-    explicit GameNode(NodeId node_id, chesscore::Move move = {}, const std::shared_ptr<GameNode> &parent = nullptr) : m_id(node_id), m_move(move), m_parent(parent) {}
-
-    /**
-     * \brief Get the id of the node.
-     *
-     * \return Id of the node.
-     */
-    [[nodiscard]] auto id() const -> const NodeId & { return m_id; }
+    explicit GameNode(chesscore::Move move = {}, NodeId parent = NodeId::Invalid, uint32_t ply = 0) : m_move{move}, m_parent{parent}, m_ply{ply} {}
 
     /**
      * \brief Get the move.
@@ -97,20 +108,49 @@ public:
     /**
      * \brief Get the parent node.
      *
-     * If the parent no longer exists, nullptr is returned.
-     * \return The parent node.
+     * \return Id of the parent node or NodeId::Invalid for the root node.
      */
-    [[nodiscard]] auto parent() const -> std::shared_ptr<GameNode> { return m_parent.lock(); }
+    [[nodiscard]] auto parent() const -> NodeId { return m_parent; }
 
     /**
-     * \brief The number of children.
+     * \brief Get the first child node.
      *
-     * Returns the number of children of this node. If this is not a leaf-node,
-     * at least 1 should be returned, for the child node representing the main
-     * line of the game.
-     * \return Number of child nodes.
+     * The first child represents the main line.
+     * \return Id of the first child node or NodeId::Invalid for a leaf node.
+     */
+    [[nodiscard]] auto first_child() const -> NodeId { return m_first_child; }
+
+    /**
+     * \brief Get the next sibling node.
+     *
+     * The next sibling is the next child of the parent node.
+     * \return Id of the next sibling node or NodeId::Invalid for the last child.
+     */
+    [[nodiscard]] auto next_sibling() const -> NodeId { return m_next_sibling; }
+
+    /**
+     * \brief Get the distance of the node from the root of the game tree.
+     *
+     * The root node has ply 0, its children have ply 1, etc.
+     * \return Number of moves from the root to this node.
+     */
+    [[nodiscard]] auto ply() const -> size_t { return m_ply; }
+
+    /**
+     * \brief Get the key of the position represented by the node.
+     *
+     * Nodes with equal keys represent the same position, see Board::key().
+     * \return The key or 0, if the key is not known.
      */
-    [[nodiscard]] auto child_count() const -> size_t { return m_children.size(); }
+    [[nodiscard]] auto key() const -> uint64_t { return m_key; }
+
+    /**
+     * \brief Get the cached SAN string of the move.
+     *
+     * The SAN string includes the check or checkmate suffix.
+     * \return The SAN string or an empty string, if it is not cached.
+     */
+    [[nodiscard]] auto san() const -> std::string_view { return {m_san.data(), m_san_length}; }
 
     /**
      * \brief Check if the node has children.
@@ -118,136 +158,443 @@ public:
      * Returns true if the node has children, false otherwhise.
      * \return If the node has children.
      */
-    [[nodiscard]] auto has_children() const -> bool { return child_count() > 0; }
+    [[nodiscard]] auto has_children() const -> bool { return m_first_child != NodeId::Invalid; }
+private:
+    uint64_t m_key{0};                        ///< Key of the position, 0 if unknown.
+    chesscore::Move m_move;                   ///< The move that led to this node (from the parent node).
+    NodeId m_parent;                          ///< Id of the parent node.
+    NodeId m_first_child{NodeId::Invalid};    ///< Id of the first child node, the "main line".
+    NodeId m_next_sibling{NodeId::Invalid};   ///< Id of the next child of the parent node.
+    uint32_t m_ply;                           ///< Distance from the root node.
+    std::array<char, max_san_length> m_san{}; ///< Cached SAN string of the move.
+    uint8_t m_san_length{0};                  ///< Length of the cached SAN string, 0 if it is not cached.
+
+    friend class GameTree;
+};
+
+/**
+ * \brief The tree of moves of a game.
+ *
+ * The nodes are stored in a contiguous array and are addressed by their
+ * NodeId. The root node has the id GameTree::root_id. Nodes are linked to
+ * their parent, their first child and their next sibling, so that a node
+ * without variations does not need any additional memory.
+ *
+ * Comments, NAGs and positions are only present at a few nodes. They are
+ * stored in separate tables, indexed by the node id.
+ *
+ * The tree also indexes the nodes by their position keys. This allows
+ * finding all nodes with a given position, e.g. to detect transpositions.
+ * The index is a sorted array, that is built on the first search after keys
+ * have changed. Searching is thread-safe.
+ *
+ * Nodes are never removed from the tree. References to nodes are invalidated,
+ * when new nodes are added; node ids stay valid.
+ *
+ * The nodes, the tables and the index are allocated from a memory resource,
+ * e.g. a std::pmr::monotonic_buffer_resource for the games of a batch. This
+ * includes the characters of the comments and the lists of NAGs. A copy of a
+ * tree uses the default memory resource, unless another resource is given.
+ */
+class GameTree {
+public:
+    static constexpr NodeId root_id{1}; ///< Id of the root node.
 
     /**
-     * \brief Get the child node.
+     * \brief Create a tree that only consists of the root node.
      *
-     * Returns the child node at the given index. Index 0 represents the main
-     * line. If the index is too big, nullptr is returned.
-     * \param index Index of the child.
-     * \return The child with the given index.
+     * \param root_position The position of the root node.
+     * \param resource The memory resource for the tree. Has to outlive the tree.
      */
-    auto get_child(size_t index) -> std::shared_ptr<GameNode> { return index >= m_children.size() ? nullptr : m_children[index]; }
+    explicit GameTree(const chesscore::Position &root_position, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
     /**
-     * \brief Get the child node.
+     * \brief Copy a tree into a memory resource.
      *
-     * Returns the child node at the given index. Index 0 represents the main
-     * line. If the index is too big, nullptr is returned.
+     * \param other The tree to copy.
+     * \param resource The memory resource for the copy. Has to outlive the copy.
+     */
+    GameTree(const GameTree &other, std::pmr::memory_resource *resource);
+
+    GameTree(const GameTree &other) : GameTree{other, std::pmr::get_default_resource()} {}
+    GameTree(GameTree &&) = default;
+    auto operator=(const GameTree &) -> GameTree & = default;
+    auto operator=(GameTree &&) -> GameTree & = default;
+    ~GameTree() = default;
+
+    /**
+     * \brief The memory resource of the tree.
+     *
+     * \return The memory resource, from which the tree allocates its memory.
+     */
+    [[nodiscard]] auto memory_resource() const -> std::pmr::memory_resource * { return m_nodes.get_allocator().resource(); }
+
+    /**
+     * \brief The memory used by the tree.
+     *
+     * \return Number of nodes and stored positions and the allocated bytes.
+     */
+    [[nodiscard]] auto memory_usage() const -> MemoryUsage;
+
+    /**
+     * \brief The memory used by a single node.
+     *
+     * Includes the node itself and its entries in the tables of comments,
+     * NAGs and positions and in the index, but no share of the buckets of the
+     * tables.
+     * \param node_id The node id.
+     * \return The allocated bytes of the node.
+     */
+    [[nodiscard]] auto memory_usage(NodeId node_id) const -> MemoryUsage;
+
+    /**
+     * \brief The number of nodes in the tree.
+     *
+     * \return Number of nodes, including the root node.
+     */
+    [[nodiscard]] auto size() const -> size_t { return m_nodes.size(); }
+
+    /**
+     * \brief Reserve memory for a number of nodes.
+     *
+     * \param count Number of nodes.
+     */
+    auto reserve(size_t count) -> void { m_nodes.reserve(count); }
+
+    /**
+     * \brief Remove all nodes except a new root node.
+     *
+     * The memory allocated for the nodes is kept, so that the tree can be
+     * reused for another game.
+     * \param root_position The position of the new root node.
+     */
+    auto clear(const chesscore::Position &root_position) -> void;
+
+    /**
+     * \brief Check, if a node id refers to a node of this tree.
+     *
+     * \param node_id The node id.
+     * \return If the node exists.
+     */
+    [[nodiscard]] auto contains(NodeId node_id) const -> bool { return node_id != NodeId::Invalid && node_id.value <= m_nodes.size(); }
+
+    /**
+     * \brief Access a node.
+     *
+     * The node id has to refer to a node of this tree.
+     * \param node_id The node id.
+     * \return The node.
+     */
+    [[nodiscard]] auto node(NodeId node_id) const -> const GameNode & { return m_nodes[node_id.value - 1]; }
+
+    /**
+     * \brief The number of children of a node.
+     *
+     * \param node_id The node id.
+     * \return Number of child nodes.
+     */
+    [[nodiscard]] auto child_count(NodeId node_id) const -> size_t;
+
+    /**
+     * \brief Get a child of a node.
+     *
+     * Index 0 represents the main line.
+     * \param node_id The node id.
      * \param index Index of the child.
-     * \return The child with the given index.
+     * \return Id of the child or NodeId::Invalid, if the index is too big.
      */
-    [[nodiscard]] auto get_child(size_t index) const -> std::shared_ptr<const GameNode> { return index >= m_children.size() ? nullptr : m_children[index]; }
+    [[nodiscard]] auto child(NodeId node_id, size_t index) const -> NodeId;
 
     /**
-     * \brief Get the position of the fiven child node.
+     * \brief Get the index of a node in the list of children of its parent.
      *
-     * Returns the position, i.e., the index, of the given child node in this
-     * node's list of children. A result of -1 is returned, when the fiven node
-     * is not a child of this node.
-     * \param child The child node.
-     * \return Index of the child node in this node's list of children or -1.
+     * \param node_id The node id.
+     * \return Index of the node or 0 for the root node.
      */
-    [[nodiscard]] auto get_child_number(const std::shared_ptr<GameNode> &child) const -> int;
+    [[nodiscard]] auto child_number(NodeId node_id) const -> int;
 
     /**
      * \brief Append a new child node.
      *
-     * The given node is appended to the list of child nodes. Checks, if a
-     * child with the same move is already present. In that case, the child is
-     * not added, but the existing child is returned.
-     * \param child The child node.
-     * \returns The given child node, if it was added, or the previously added
-     *   child node with the same move.
+     * Checks, if a child with the same move is already present. In that case,
+     * no node is added.
+     * \param parent The id of the parent node.
+     * \param move The move that leads from the parent to the child.
+     * \return Id of the child and if the child was added.
      */
-    auto append_child(const std::shared_ptr<GameNode> &child) -> std::shared_ptr<GameNode>;
+    auto add_child(NodeId parent, const chesscore::Move &move) -> std::pair<NodeId, bool>;
 
     /**
-     * \brief Return the comment of the game node.
+     * \brief Return the comment of a node.
      *
      * This is a comment of the game position or the move that lead to it.
+     * \param node_id The node id.
      * \return The comment.
      */
-    [[nodiscard]] auto comment() const -> const std::string & { return m_comment; }
+    [[nodiscard]] auto comment(NodeId node_id) const -> const std::pmr::string & { return lookup(m_comments, node_id); }
 
     /**
-     * \brief Return the pre-move comment of the game node.
+     * \brief Return the pre-move comment of a node.
      *
-     * This is a comment of the game position or the move that lead to it.
+     * This is a comment on this game line, given before the move.
+     * \param node_id The node id.
      * \return The comment.
      */
-    [[nodiscard]] auto premove_comment() const -> const std::string & { return m_premove_comment; }
+    [[nodiscard]] auto premove_comment(NodeId node_id) const -> const std::pmr::string & { return lookup(m_premove_comments, node_id); }
 
     /**
-     * \brief Set the comment of the game node.
+     * \brief Set the comment of a node.
      *
-     * This is a comment of the game position or the move that lead to it.
+     * \param node_id The node id.
      * \param comment The comment.
      */
-    auto set_comment(const std::string &comment) -> void { m_comment = comment; }
+    auto set_comment(NodeId node_id, std::string_view comment) -> void { store(m_comments, node_id, comment); }
 
     /**
-     * \brief Append to the comment of the game node.
+     * \brief Append to the comment of a node.
      *
-     * This is a comment of the game position or the move that lead to it.
+     * \param node_id The node id.
      * \param comment The comment.
      */
-    auto append_comment(const std::string &comment) -> void { m_comment += comment; }
+    auto append_comment(NodeId node_id, std::string_view comment) -> void { m_comments[node_id.value] += comment; }
 
     /**
-     * \brief Set the pre-move comment of the game node.
+     * \brief Set the pre-move comment of a node.
      *
-     * This is a comment of the game position.
+     * \param node_id The node id.
      * \param comment The comment.
      */
-    auto set_premove_comment(const std::string &comment) -> void { m_premove_comment = comment; }
+    auto set_premove_comment(NodeId node_id, std::string_view comment) -> void { store(m_premove_comments, node_id, comment); }
 
     /**
-     * \brief Append to the pre-move comment of the game node.
+     * \brief Append to the pre-move comment of a node.
      *
-     * This is a comment of the game position.
+     * \param node_id The node id.
      * \param comment The comment.
      */
-    auto append_premove_comment(const std::string &comment) -> void { m_premove_comment += comment; }
+    auto append_premove_comment(NodeId node_id, std::string_view comment) -> void { m_premove_comments[node_id.value] += comment; }
+
+    /**
+     * \brief The NAGs of a node.
+     *
+     * \param node_id The node id.
+     * \return List of NAGs.
+     */
+    [[nodiscard]] auto nags(NodeId node_id) const -> const std::pmr::vector<int> & { return lookup(m_nags, node_id); }
 
     /**
-     * \brief Get the position of the game node.
+     * \brief The NAGs of a node.
      *
-     * \return The position.
+     * \param node_id The node id.
+     * \return List of NAGs.
      */
-    [[nodiscard]] auto position() const -> const std::optional<chesscore::Position> & { return m_position; }
+    auto nags(NodeId node_id) -> std::pmr::vector<int> & { return m_nags[node_id.value]; }
 
     /**
-     * \brief Set the position of the game node.
+     * \brief Append a NAG to a node.
      *
+     * \param node_id The node id.
+     * \param nag The NAG.
+     */
+    auto add_nag(NodeId node_id, int nag) -> void { m_nags[node_id.value].push_back(nag); }
+
+    /**
+     * \brief Replace the NAGs of a node.
+     *
+     * \param node_id The node id.
+     * \param nags List of NAGs.
+     */
+    auto set_nags(NodeId node_id, std::span<const int> nags) -> void { store(m_nags, node_id, nags); }
+
+    /**
+     * \brief Get the stored position of a node.
+     *
+     * \param node_id The node id.
+     * \return The position or nullptr, if the node does not store its position.
+     */
+    [[nodiscard]] auto position(NodeId node_id) const -> const chesscore::Position *;
+
+    /**
+     * \brief Store the position of a node.
+     *
+     * \param node_id The node id.
      * \param position The position.
      */
-    auto set_position(const chesscore::Position &position) -> void { m_position = position; }
+    auto set_position(NodeId node_id, const chesscore::Position &position) -> void { m_positions.insert_or_assign(node_id.value, position); }
+
+    /**
+     * \brief Remove the stored position of a node.
+     *
+     * The position can still be calculated from an ancestor node.
+     * \param node_id The node id.
+     */
+    auto clear_position(NodeId node_id) -> void { m_positions.erase(node_id.value); }
 
     /**
-     * \brief Calculate the position of this game node.
+     * \brief Get the stored board of a node.
+     *
+     * Boards are stored at a few nodes, so that the board of any node can be
+     * calculated from a near ancestor, see Game::board().
+     * \param node_id The node id.
+     * \return The board or nullptr, if the node does not store its board.
+     */
+    [[nodiscard]] auto board(NodeId node_id) const -> const Board *;
+
+    /**
+     * \brief Store the board of a node.
+     *
+     * \param node_id The node id.
+     * \param board The board.
+     */
+    auto set_board(NodeId node_id, const Board &board) -> void { m_boards.insert_or_assign(node_id.value, board); }
+
+    /**
+     * \brief Calculate the position of a node.
      *
      * The position is calculated from an ancestor node that has a position and
      * the sequence of moves that lead to this node from that ancestor. The
-     * computed position is not stored in the node. Use setPosition to do that.
-     * \return The position represented by this node.
+     * computed position is not stored.
+     * \param node_id The node id.
+     * \return The position represented by the node.
      */
-    [[nodiscard]] auto calculate_position() const -> chesscore::Position;
+    [[nodiscard]] auto calculate_position(NodeId node_id) const -> chesscore::Position;
 
-    auto nags() const -> const std::vector<int> & { return m_nags; }
-    auto nags() -> std::vector<int> & { return m_nags; }
+    /**
+     * \brief Remove stored positions.
+     *
+     * The position of the root node is kept.
+     * \param keep Predicate on the ply of a node, if its position is kept.
+     */
+    template<typename Predicate>
+    auto prune_positions(Predicate keep) -> void {
+        std::erase_if(m_positions, [&](const auto &entry) { return NodeId{entry.first} != root_id && !keep(node(NodeId{entry.first}).ply()); });
+    }
+
+    /**
+     * \brief Set the key of the position of a node.
+     *
+     * The node is indexed by the key, replacing an earlier key. Board::key()
+     * is never 0, so 0 marks an unknown key.
+     * \param node_id The node id.
+     * \param key The key, 0 if the key is not known.
+     */
+    auto set_position_key(NodeId node_id, uint64_t key) -> void;
 
-    auto add_nag(int num) -> void { m_nags.push_back(num); }
+    /**
+     * \brief Cache the SAN string of the move of a node.
+     *
+     * Moves of nodes are never changed and the legal moves of a position do
+     * not depend on the rest of the tree, so the cached string stays valid.
+     * Strings longer than GameNode::max_san_length are not cached.
+     * \param node_id The node id.
+     * \param san The SAN string including the check or checkmate suffix.
+     */
+    auto set_san(NodeId node_id, std::string_view san) -> void;
+
+    /**
+     * \brief Find a node with a position.
+     *
+     * \param key The key of the position.
+     * \return Id of the first node with the position or NodeId::Invalid, if no node has the position.
+     */
+    [[nodiscard]] auto find_position(uint64_t key) const -> NodeId;
+
+    /**
+     * \brief Find all nodes with a position.
+     *
+     * More than one node with the same position means, that the position is
+     * reached by different sequences of moves, or repeated in a line.
+     * \param key The key of the position.
+     * \return Ids of the nodes with the position in ascending order.
+     */
+    [[nodiscard]] auto find_positions(uint64_t key) const -> std::vector<NodeId>;
 private:
-    NodeId m_id;                                       ///< The id of this node.
-    chesscore::Move m_move;                            ///< The move that led to this node (from the parent node).
-    std::weak_ptr<GameNode> m_parent;                  ///< Pointer to the parent node.
-    std::vector<std::shared_ptr<GameNode>> m_children; ///< List of child nodes. The first entry represetns the "main line".
-    std::string m_comment;                             ///< A comment of the position or move.
-    std::string m_premove_comment;                     ///< A comment on this game line, given before the move.
-    std::vector<int> m_nags;                           ///< Numeric annotation glyphs describing the move or position.
-    std::optional<chesscore::Position> m_position;     ///< The position described by this node.
+    /**
+     * \brief Node ids sorted by the keys of their positions.
+     *
+     * The index is built from the keys of the nodes on the first search after
+     * it was invalidated. Searches lock the index, so that they can run in
+     * parallel on a const tree. A copy starts without an index.
+     */
+    class KeyIndex {
+    public:
+        struct Entry {
+            uint64_t key;  ///< Key of the position.
+            uint32_t node; ///< Id of the node.
+        };
+
+        explicit KeyIndex(std::pmr::memory_resource *resource) noexcept : m_entries{resource} {}
+        KeyIndex(const KeyIndex & /*other*/, std::pmr::memory_resource *resource) noexcept : KeyIndex{resource} {}
+        KeyIndex(const KeyIndex &) = delete;
+        KeyIndex(KeyIndex &&other) noexcept : KeyIndex{other.m_entries.get_allocator().resource()} {}
+        auto operator=(const KeyIndex & /*other*/) -> KeyIndex & {
+            invalidate();
+            return *this;
+        }
+        auto operator=(KeyIndex && /*other*/) noexcept -> KeyIndex & {
+            invalidate();
+            return *this;
+        }
+        ~KeyIndex() = default;
+
+        /**
+         * \brief Mark the index as outdated.
+         *
+         * Only called by modifying operations of the tree, which must not run
+         * in parallel with searches anyway.
+         */
+        auto invalidate() -> void { m_valid = false; }
+
+        /**
+         * \brief The entries with a key.
+         *
+         * \param nodes The nodes of the tree, for building the index.
+         * \param key The key.
+         * \return The entries with the key, in ascending order of the node ids.
+         */
+        [[nodiscard]] auto find(const std::pmr::vector<GameNode> &nodes, uint64_t key) const -> std::span<const Entry>;
+
+        /**
+         * \brief The memory used by the index.
+         *
+         * An outdated index is not built, its current entries are reported.
+         * \return Number of bytes of the entries.
+         */
+        [[nodiscard]] auto memory_usage() const -> size_t;
+    private:
+        mutable std::mutex m_mutex;                ///< Guards building the index.
+        mutable std::pmr::vector<Entry> m_entries; ///< The entries, sorted by key and node id.
+        mutable bool m_valid{false};               ///< If the entries match the keys of the nodes.
+
+        auto build(const std::pmr::vector<GameNode> &nodes) const -> void;
+    };
+
+    std::pmr::vector<GameNode> m_nodes;                                     ///< The nodes. The node with id n is stored at index n - 1.
+    std::pmr::unordered_map<uint32_t, std::pmr::string> m_comments;         ///< Comments of the nodes.
+    std::pmr::unordered_map<uint32_t, std::pmr::string> m_premove_comments; ///< Pre-move comments of the nodes.
+    std::pmr::unordered_map<uint32_t, std::pmr::vector<int>> m_nags;        ///< Numeric annotation glyphs describing the move or position.
+    std::pmr::unordered_map<uint32_t, chesscore::Position> m_positions;     ///< Stored positions of the nodes.
+    std::pmr::unordered_map<uint32_t, Board> m_boards;                      ///< Stored boards of the nodes.
+    KeyIndex m_key_index;                                                   ///< Node ids by position key.
+
+    auto mutable_node(NodeId node_id) -> GameNode & { return m_nodes[node_id.value - 1]; }
+
+    template<typename T>
+    static auto lookup(const std::pmr::unordered_map<uint32_t, T> &table, NodeId node_id) -> const T & {
+        static const T empty{};
+        const auto entry = table.find(node_id.value);
+        return entry == table.end() ? empty : entry->second;
+    }
+
+    /// The values are copied into the memory resource of the table.
+    template<typename T, typename Values>
+    static auto store(std::pmr::unordered_map<uint32_t, T> &table, NodeId node_id, const Values &values) -> void {
+        if (values.empty()) {
+            table.erase(node_id.value);
+        } else {
+            table[node_id.value].assign(values.begin(), values.end());
+        }
+    }
 };
 
 } // namespace chessgame
@@ -0,0 +1,465 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "chessgame/binary.h"
+#include "chessgame/san.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace chessgame {
+
+using serialization::append_string;
+using serialization::append_u32;
+using serialization::append_varint;
+
+namespace {
+
+constexpr std::string_view binary_magic{"CGBG"};
+constexpr std::string_view piece_chars{"PRNBQK"};
+
+constexpr uint32_t promoted_shift{12};
+constexpr uint32_t piece_shift{15};
+constexpr uint32_t black_piece_bit{1U << 18U};
+constexpr uint32_t captured_shift{19};
+constexpr uint32_t en_passant_bit{1U << 22U};
+constexpr uint32_t comment_bit{1U << 23U};
+constexpr uint32_t premove_comment_bit{1U << 24U};
+constexpr uint32_t nags_bit{1U << 25U};
+constexpr uint32_t child_count_shift{26};
+constexpr uint32_t many_children{3};
+constexpr uint32_t annotation_shift{23};
+constexpr uint32_t move_indices_flag{1};
+constexpr size_t stream_chunk_size{size_t{64} * 1024};
+
+constexpr std::string_view corrupted_message{"Corrupted binary game data"};
+
+[[noreturn]] auto corrupted_data() -> void {
+    throw ChessGameError{std::string{corrupted_message}};
+}
+
+auto square_code(const chesscore::Square &square) -> uint32_t {
+    return static_cast<uint32_t>(square.file().name() - 'a') + 8U * static_cast<uint32_t>(square.rank().rank - 1);
+}
+
+auto code_square(uint32_t code) -> chesscore::Square {
+    return chesscore::Square{chesscore::File{static_cast<char>('a' + code % 8U)}, chesscore::Rank{static_cast<int>(code / 8U) + 1}};
+}
+
+auto piece_type_code(chesscore::PieceType type) -> uint32_t {
+    return static_cast<uint32_t>(piece_chars.find(chesscore::Piece{.type = type, .color = chesscore::Color::White}.piece_char_colorless()));
+}
+
+auto code_piece_type(uint32_t code) -> chesscore::PieceType {
+    if (code >= piece_chars.size()) {
+        corrupted_data();
+    }
+    return chesscore::piece_type_from_char(piece_chars[code]);
+}
+
+} // namespace
+
+auto encode_move(const chesscore::Move &move) -> uint32_t {
+    uint32_t code = square_code(move.from) | (square_code(move.to) << 6U) | (piece_type_code(move.piece.type) << piece_shift);
+    if (move.promoted.has_value()) {
+        code |= (piece_type_code(move.promoted->type) + 1) << promoted_shift;
+    }
+    if (move.piece.color == chesscore::Color::Black) {
+        code |= black_piece_bit;
+    }
+    if (move.captured.has_value()) {
+        code |= (piece_type_code(move.captured->type) + 1) << captured_shift;
+    }
+    if (move.capturing_en_passant) {
+        code |= en_passant_bit;
+    }
+    return code;
+}
+
+auto decode_move(uint32_t code) -> chesscore::Move {
+    const auto color = (code & black_piece_bit) != 0 ? chesscore::Color::Black : chesscore::Color::White;
+    chesscore::Move move{
+        .from = code_square(code & 0x3FU),
+        .to = code_square((code >> 6U) & 0x3FU),
+        .piece = chesscore::Piece{.type = code_piece_type((code >> piece_shift) & 0x7U), .color = color},
+    };
+    if (const auto promoted = (code >> promoted_shift) & 0x7U; promoted != 0) {
+        move.promoted = chesscore::Piece{.type = code_piece_type(promoted - 1), .color = color};
+    }
+    if (const auto captured = (code >> captured_shift) & 0x7U; captured != 0) {
+        move.captured = chesscore::Piece{.type = code_piece_type(captured - 1), .color = chesscore::other_color(color)};
+    }
+    move.capturing_en_passant = (code & en_passant_bit) != 0;
+    return move;
+}
+
+auto sort_legal_moves(chesscore::MoveList &legal_moves) -> void {
+    std::ranges::sort(legal_moves, {}, [](const chesscore::Move &move) { return encode_move(move); });
+}
+
+auto encode_move_index(const chesscore::Move &move, const chesscore::MoveList &legal_moves) -> std::optional<uint8_t> {
+    const auto entry = std::ranges::find_if(legal_moves, [&move](const chesscore::Move &legal_move) { return chesscore::FullMoveCompare{}(legal_move, move); });
+    const auto index = std::distance(legal_moves.begin(), entry);
+    if (entry == legal_moves.end() || index > 0xFF) {
+        return std::nullopt;
+    }
+    return static_cast<uint8_t>(index);
+}
+
+auto decode_move_index(uint8_t index, const chesscore::MoveList &legal_moves) -> std::optional<chesscore::Move> {
+    if (index >= legal_moves.size()) {
+        return std::nullopt;
+    }
+    return legal_moves[index];
+}
+
+namespace {
+
+auto annotation_code(const GameTree &tree, NodeId node_id) -> uint32_t {
+    uint32_t code{0};
+    code |= tree.comment(node_id).empty() ? 0 : comment_bit;
+    code |= tree.premove_comment(node_id).empty() ? 0 : premove_comment_bit;
+    code |= tree.nags(node_id).empty() ? 0 : nags_bit;
+    code |= static_cast<uint32_t>(std::min<size_t>(tree.child_count(node_id), many_children)) << child_count_shift;
+    return code;
+}
+
+auto append_annotations(std::string &out, const GameTree &tree, NodeId node_id) -> void {
+    const auto &comment = tree.comment(node_id);
+    const auto &premove_comment = tree.premove_comment(node_id);
+    const auto &nags = tree.nags(node_id);
+    const auto child_count = tree.child_count(node_id);
+    if (child_count >= many_children) {
+        append_varint(out, child_count - many_children);
+    }
+    if (!comment.empty()) {
+        append_string(out, comment);
+    }
+    if (!premove_comment.empty()) {
+        append_string(out, premove_comment);
+    }
+    if (!nags.empty()) {
+        append_varint(out, nags.size());
+        for (const auto nag : nags) {
+            append_varint(out, static_cast<uint32_t>(nag));
+        }
+    }
+}
+
+auto append_tree(std::string &out, const GameTree &tree) -> void {
+    std::vector<NodeId> pending{GameTree::root_id};
+    std::vector<NodeId> children;
+    while (!pending.empty()) {
+        const auto node_id = pending.back();
+        pending.pop_back();
+        const auto move_code = node_id == GameTree::root_id ? 0 : encode_move(tree.node(node_id).move());
+        append_u32(out, move_code | annotation_code(tree, node_id));
+        append_annotations(out, tree, node_id);
+        children.clear();
+        for (auto child = tree.node(node_id).first_child(); child != NodeId::Invalid; child = tree.node(child).next_sibling()) {
+            children.push_back(child);
+        }
+        pending.insert(pending.end(), children.rbegin(), children.rend());
+    }
+}
+
+auto append_indexed_tree(std::string &out, const GameTree &tree) -> void {
+    struct PendingNode {
+        NodeId node_id;
+        uint8_t index;
+        chesscore::Position position;
+    };
+    std::vector<PendingNode> pending;
+    pending.emplace_back(GameTree::root_id, 0, tree.calculate_position(GameTree::root_id));
+    std::vector<PendingNode> children;
+    while (!pending.empty()) {
+        auto node = std::move(pending.back());
+        pending.pop_back();
+        out.push_back(static_cast<char>(annotation_code(tree, node.node_id) >> annotation_shift));
+        if (node.node_id != GameTree::root_id) {
+            out.push_back(static_cast<char>(node.index));
+        }
+        append_annotations(out, tree, node.node_id);
+        if (!tree.node(node.node_id).has_children()) {
+            continue;
+        }
+        auto legal_moves = node.position.all_legal_moves();
+        sort_legal_moves(legal_moves);
+        children.clear();
+        for (auto child = tree.node(node.node_id).first_child(); child != NodeId::Invalid; child = tree.node(child).next_sibling()) {
+            const auto &move = tree.node(child).move();
+            const auto index = encode_move_index(move, legal_moves);
+            if (!index.has_value()) {
+                throw ChessGameError{"Cannot encode an illegal move as a move index"};
+            }
+            auto child_position = node.position;
+            child_position.make_move(move);
+            children.emplace_back(child, index.value(), std::move(child_position));
+        }
+        pending.insert(pending.end(), std::make_move_iterator(children.rbegin()), std::make_move_iterator(children.rend()));
+    }
+}
+
+/**
+ * \brief Decoder for the header and the records of the binary format.
+ */
+class RecordDecoder : public serialization::ByteDecoder {
+public:
+    explicit RecordDecoder(std::string_view data) : ByteDecoder{data, corrupted_message} {}
+};
+
+auto apply_annotations(RecordDecoder &decoder, GameTree &tree, NodeId node_id, uint32_t code) -> size_t {
+    size_t child_count = (code >> child_count_shift) & 0x3U;
+    if (child_count == many_children) {
+        child_count += decoder.read_size();
+    }
+    if ((code & comment_bit) != 0) {
+        tree.set_comment(node_id, decoder.read_string());
+    }
+    if ((code & premove_comment_bit) != 0) {
+        tree.set_premove_comment(node_id, decoder.read_string());
+    }
+    if ((code & nags_bit) != 0) {
+        auto &nags = tree.nags(node_id);
+        nags.resize(decoder.read_size());
+        for (auto &nag : nags) {
+            nag = static_cast<int>(decoder.read_varint());
+        }
+    }
+    return child_count;
+}
+
+auto decode_tree(RecordDecoder &decoder, Game &game) -> void {
+    struct PendingChildren {
+        NodeId parent;
+        size_t remaining;
+        std::optional<Board> board;
+    };
+    std::vector<PendingChildren> pending;
+    if (const auto root_children = apply_annotations(decoder, game.tree(), GameTree::root_id, decoder.read_u32()); root_children > 0) {
+        pending.emplace_back(GameTree::root_id, root_children, game.board(GameTree::root_id));
+    }
+    while (!pending.empty()) {
+        auto &top = pending.back();
+        if (top.remaining == 0) {
+            pending.pop_back();
+            continue;
+        }
+        --top.remaining;
+        const auto code = decoder.read_u32();
+        const auto move = decode_move(code);
+        auto board = top.board;
+        if (board.has_value()) {
+            board->make_move(move);
+        }
+        const auto node_id = game.add_node(top.parent, move, std::nullopt, board);
+        if (const auto children = apply_annotations(decoder, game.tree(), node_id, code); children > 0) {
+            pending.emplace_back(node_id, children, std::move(board));
+        }
+    }
+}
+
+// Version 2 stored the move indices in the order of the move generator.
+auto decode_indexed_tree(RecordDecoder &decoder, Game &game, bool canonical_order) -> void {
+    const auto legal_moves_of = [canonical_order](const chesscore::Position &position) {
+        auto legal_moves = position.all_legal_moves();
+        if (canonical_order) {
+            sort_legal_moves(legal_moves);
+        }
+        return legal_moves;
+    };
+    struct PendingChildren {
+        NodeId parent;
+        size_t remaining;
+        chesscore::Position position;
+        chesscore::MoveList legal_moves;
+        std::optional<Board> board;
+    };
+    std::vector<PendingChildren> pending;
+    const auto root_code = static_cast<uint32_t>(decoder.read_u8()) << annotation_shift;
+    if (const auto root_children = apply_annotations(decoder, game.tree(), GameTree::root_id, root_code); root_children > 0) {
+        auto position = game.tree().calculate_position(GameTree::root_id);
+        auto legal_moves = legal_moves_of(position);
+        pending.emplace_back(GameTree::root_id, root_children, std::move(position), std::move(legal_moves), game.board(GameTree::root_id));
+    }
+    std::string san;
+    while (!pending.empty()) {
+        auto &top = pending.back();
+        if (top.remaining == 0) {
+            pending.pop_back();
+            continue;
+        }
+        --top.remaining;
+        const auto code = static_cast<uint32_t>(decoder.read_u8()) << annotation_shift;
+        const auto move = decode_move_index(decoder.read_u8(), top.legal_moves);
+        if (!move.has_value()) {
+            corrupted_data();
+        }
+        auto position = top.position;
+        position.make_move(move.value());
+        auto board = top.board;
+        san.clear();
+        append_san_move(san, move.value(), top.legal_moves);
+        if (board.has_value()) {
+            board->make_move(move.value());
+            if (board->in_check(board->side_to_move())) {
+                san.push_back(is_checkmate(board.value()) ? '#' : '+');
+            }
+        }
+        const auto node_id = game.add_node(top.parent, move.value(), position, board);
+        if (board.has_value()) {
+            game.tree().set_san(node_id, san);
+        }
+        if (const auto children = apply_annotations(decoder, game.tree(), node_id, code); children > 0) {
+            auto legal_moves = legal_moves_of(position);
+            pending.emplace_back(node_id, children, std::move(position), std::move(legal_moves), std::move(board));
+        }
+    }
+}
+
+auto decode_game(std::string_view record, const BinaryGameOptions &options, uint32_t version) -> Game {
+    RecordDecoder decoder{record};
+    GameMetadata metadata;
+    const auto tag_count = decoder.read_size();
+    for (size_t index = 0; index < tag_count; ++index) {
+        const auto name = decoder.read_string();
+        metadata.add(name, decoder.read_string());
+    }
+
+    Game game{metadata};
+    const auto node_count = decoder.read_size();
+    game.tree().reserve(node_count + 1);
+    if (options.move_indices) {
+        decode_indexed_tree(decoder, game, version >= 3);
+    } else {
+        decode_tree(decoder, game);
+    }
+    if (!decoder.at_end() || game.tree().size() != node_count + 1) {
+        corrupted_data();
+    }
+    return game;
+}
+
+} // namespace
+
+BinaryGameWriter::BinaryGameWriter(std::ostream &out_stream, const BinaryGameOptions &options) : m_out_stream{&out_stream}, m_options{options} {
+    std::string header{binary_magic};
+    append_u32(header, binary_format_version);
+    append_u32(header, m_options.move_indices ? move_indices_flag : 0);
+    m_out_stream->write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+auto BinaryGameWriter::write_game(const Game &game) -> void {
+    m_record.clear();
+    const auto &metadata = game.metadata();
+    append_varint(m_record, static_cast<size_t>(std::distance(metadata.begin(), metadata.end())));
+    for (const auto &tag : metadata) {
+        append_string(m_record, tag.name);
+        append_string(m_record, tag.value);
+    }
+
+    const auto &tree = game.tree();
+    append_varint(m_record, tree.size() - 1);
+    if (m_options.move_indices) {
+        append_indexed_tree(m_record, tree);
+    } else {
+        append_tree(m_record, tree);
+    }
+
+    if (m_record.size() > max_binary_record_size) {
+        throw ChessGameError{"Game too large for the binary game format"};
+    }
+    std::string size_prefix;
+    append_varint(size_prefix, m_record.size());
+    m_out_stream->write(size_prefix.data(), static_cast<std::streamsize>(size_prefix.size()));
+    m_out_stream->write(m_record.data(), static_cast<std::streamsize>(m_record.size()));
+}
+
+BinaryGameReader::BinaryGameReader(std::istream &in_stream) : m_in_stream{&in_stream} {
+    read_header();
+}
+
+BinaryGameReader::BinaryGameReader(std::string_view data) : m_data{data} {
+    read_header();
+}
+
+auto BinaryGameReader::read_header() -> void {
+    const auto header = read_bytes(binary_magic.size() + 4);
+    if (!header.has_value() || !header->starts_with(binary_magic)) {
+        throw ChessGameError{"Not a binary game stream"};
+    }
+    m_version = RecordDecoder{header->substr(binary_magic.size())}.read_u32();
+    if (m_version == 0 || m_version > binary_format_version) {
+        throw ChessGameError{"Unsupported binary game format version " + std::to_string(m_version)};
+    }
+    if (m_version >= 2) {
+        const auto flags = read_bytes(4);
+        if (!flags.has_value()) {
+            throw ChessGameError{"Not a binary game stream"};
+        }
+        m_options.move_indices = (RecordDecoder{*flags}.read_u32() & move_indices_flag) != 0;
+    }
+}
+
+auto BinaryGameReader::read_bytes(size_t count) -> std::optional<std::string_view> {
+    if (m_in_stream == nullptr) {
+        if (count > m_data.size()) {
+            return std::nullopt;
+        }
+        const auto bytes = m_data.substr(0, count);
+        m_data.remove_prefix(count);
+        return bytes;
+    }
+    // The count may come from corrupted data, so the buffer only grows with the data actually read.
+    m_record.clear();
+    while (m_record.size() < count) {
+        const auto offset = m_record.size();
+        const auto chunk = std::min(count - offset, stream_chunk_size);
+        m_record.resize(offset + chunk);
+        m_in_stream->read(m_record.data() + offset, static_cast<std::streamsize>(chunk));
+        if (static_cast<size_t>(m_in_stream->gcount()) != chunk) {
+            return std::nullopt;
+        }
+    }
+    return std::string_view{m_record};
+}
+
+auto BinaryGameReader::read_record_size() -> std::optional<size_t> {
+    uint64_t value{0};
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        const auto byte = read_bytes(1);
+        if (!byte.has_value()) {
+            if (shift == 0) {
+                return std::nullopt;
+            }
+            corrupted_data();
+        }
+        const auto bits = static_cast<unsigned char>((*byte)[0]);
+        value |= static_cast<uint64_t>(bits & 0x7FU) << shift;
+        if ((bits & 0x80U) == 0) {
+            return static_cast<size_t>(value);
+        }
+    }
+    corrupted_data();
+}
+
+auto BinaryGameReader::read_game() -> std::optional<Game> {
+    const auto record_size = read_record_size();
+    if (!record_size.has_value()) {
+        return std::nullopt;
+    }
+    if (*record_size > max_binary_record_size) {
+        corrupted_data();
+    }
+    const auto record = read_bytes(*record_size);
+    if (!record.has_value()) {
+        corrupted_data();
+    }
+    return decode_game(*record, m_options, m_version);
+}
+
+} // namespace chessgame
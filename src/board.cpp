@@ -0,0 +1,719 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "chessgame/board.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <span>
+#include <utility>
+
+namespace chessgame {
+
+namespace {
+
+constexpr std::string_view piece_chars{"PRNBQK"};
+constexpr std::string_view starting_fen{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"};
+constexpr uint8_t black_code{8};
+
+struct Offset {
+    int file;
+    int rank;
+};
+
+constexpr std::array<Offset, 8> knight_offsets{{{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}}};
+constexpr std::array<Offset, 8> king_offsets{{{0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}}};
+constexpr std::array<Offset, 4> rook_directions{{{0, 1}, {1, 0}, {0, -1}, {-1, 0}}};
+constexpr std::array<Offset, 4> bishop_directions{{{1, 1}, {1, -1}, {-1, -1}, {-1, 1}}};
+
+struct ZobristKeys {
+    std::array<uint64_t, 16 * 64> pieces{};     ///< Keys of the piece codes on the squares, 0 for empty squares.
+    std::array<uint64_t, 16> castling_rights{}; ///< Keys of all combinations of castling rights.
+    std::array<uint64_t, 8> en_passant_files{}; ///< Keys of the files of the en passant square.
+    uint64_t black_to_move{0};                  ///< Key of black being the side to move.
+};
+
+constexpr auto splitmix64(uint64_t &state) -> uint64_t {
+    state += 0x9E3779B97F4A7C15ULL;
+    uint64_t value = state;
+    value = (value ^ (value >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27U)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31U);
+}
+
+constexpr auto make_zobrist_keys() -> ZobristKeys {
+    ZobristKeys keys;
+    uint64_t state{0x43686573734B6579ULL};
+    for (size_t code = 1; code < 16; ++code) {
+        if (code == 7 || code == 8) {
+            continue;
+        }
+        for (size_t square = 0; square < 64; ++square) {
+            keys.pieces[code * 64 + square] = splitmix64(state);
+        }
+    }
+    std::array<uint64_t, 4> castling_flags{};
+    for (auto &flag : castling_flags) {
+        flag = splitmix64(state);
+    }
+    for (size_t rights = 0; rights < keys.castling_rights.size(); ++rights) {
+        for (size_t flag = 0; flag < castling_flags.size(); ++flag) {
+            if ((rights & (size_t{1} << flag)) != 0) {
+                keys.castling_rights[rights] ^= castling_flags[flag];
+            }
+        }
+    }
+    for (auto &file : keys.en_passant_files) {
+        file = splitmix64(state);
+    }
+    keys.black_to_move = splitmix64(state);
+    return keys;
+}
+
+constexpr ZobristKeys zobrist_keys = make_zobrist_keys();
+
+auto piece_key(uint8_t code, int index) -> uint64_t {
+    return zobrist_keys.pieces[static_cast<size_t>(code) * 64 + static_cast<size_t>(index)];
+}
+
+auto on_board(int file, int rank) -> bool {
+    return file >= 0 && file < 8 && rank >= 0 && rank < 8;
+}
+
+auto piece_code(chesscore::PieceType type, chesscore::Color color) -> uint8_t {
+    const auto type_index = piece_chars.find(chesscore::Piece{.type = type, .color = chesscore::Color::White}.piece_char_colorless());
+    return static_cast<uint8_t>(type_index + 1 + (color == chesscore::Color::Black ? black_code : 0U));
+}
+
+auto piece_code(const chesscore::Piece &piece) -> uint8_t {
+    return piece_code(piece.type, piece.color);
+}
+
+auto code_piece(uint8_t code) -> chesscore::Piece {
+    const auto color = (code & black_code) != 0 ? chesscore::Color::Black : chesscore::Color::White;
+    return chesscore::Piece{.type = chesscore::piece_type_from_char(piece_chars[(code & 7U) - 1U]), .color = color};
+}
+
+auto pawn_direction(chesscore::Color color) -> int {
+    return color == chesscore::Color::White ? 1 : -1;
+}
+
+auto castling_flags(chesscore::Color color) -> uint8_t {
+    return color == chesscore::Color::White ? Board::white_kingside | Board::white_queenside : Board::black_kingside | Board::black_queenside;
+}
+
+auto corner_castling_flag(int index) -> uint8_t {
+    switch (index) {
+    case 0:
+        return Board::white_queenside;
+    case 7:
+        return Board::white_kingside;
+    case 56:
+        return Board::black_queenside;
+    case 63:
+        return Board::black_kingside;
+    default:
+        return 0;
+    }
+}
+
+auto read_placement(std::string_view placement, std::array<uint8_t, 64> &squares) -> bool {
+    int rank{7};
+    int file{0};
+    for (const char c : placement) {
+        if (c == '/') {
+            if (file != 8 || rank == 0) {
+                return false;
+            }
+            --rank;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            if (file > 8) {
+                return false;
+            }
+        } else {
+            const auto type_index = piece_chars.find(c >= 'a' ? static_cast<char>(c - 'a' + 'A') : c);
+            if (type_index == std::string_view::npos || file >= 8) {
+                return false;
+            }
+            squares[static_cast<size_t>(file + 8 * rank)] = static_cast<uint8_t>(type_index + 1 + (c >= 'a' ? black_code : 0U));
+            ++file;
+        }
+    }
+    return rank == 0 && file == 8;
+}
+
+auto next_field(std::string_view &fen) -> std::string_view {
+    const auto start = fen.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+        fen = {};
+        return {};
+    }
+    fen.remove_prefix(start);
+    const auto end = std::min(fen.find(' '), fen.size());
+    const auto field = fen.substr(0, end);
+    fen.remove_prefix(end);
+    return field;
+}
+
+} // namespace
+
+auto Board::from_fen(std::string_view fen) -> std::optional<Board> {
+    Board board;
+    if (!read_placement(next_field(fen), board.m_squares)) {
+        return std::nullopt;
+    }
+    const auto side = next_field(fen);
+    if (side == "w") {
+        board.m_side_to_move = chesscore::Color::White;
+    } else if (side == "b") {
+        board.m_side_to_move = chesscore::Color::Black;
+    } else {
+        return std::nullopt;
+    }
+    const auto castling = next_field(fen);
+    if (castling != "-") {
+        for (const char c : castling) {
+            switch (c) {
+            case 'K':
+                board.m_castling_rights |= white_kingside;
+                break;
+            case 'Q':
+                board.m_castling_rights |= white_queenside;
+                break;
+            case 'k':
+                board.m_castling_rights |= black_kingside;
+                break;
+            case 'q':
+                board.m_castling_rights |= black_queenside;
+                break;
+            default:
+                return std::nullopt;
+            }
+        }
+    }
+    const auto en_passant = next_field(fen);
+    if (!en_passant.empty() && en_passant != "-") {
+        if (en_passant.size() != 2 || !on_board(en_passant[0] - 'a', en_passant[1] - '1')) {
+            return std::nullopt;
+        }
+        board.m_en_passant = static_cast<int8_t>((en_passant[0] - 'a') + 8 * (en_passant[1] - '1'));
+    }
+    board.compute_key();
+    return board;
+}
+
+auto Board::starting_position() -> Board {
+    static const Board board = from_fen(starting_fen).value();
+    return board;
+}
+
+auto Board::fen() const -> std::string {
+    std::string result;
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty{0};
+        for (int file = 0; file < 8; ++file) {
+            const auto code = m_squares[static_cast<size_t>(file + 8 * rank)];
+            if (code == 0) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) {
+                result.push_back(static_cast<char>('0' + empty));
+                empty = 0;
+            }
+            const auto piece_char = piece_chars[(code & 7U) - 1U];
+            result.push_back((code & black_code) != 0 ? static_cast<char>(piece_char - 'A' + 'a') : piece_char);
+        }
+        if (empty > 0) {
+            result.push_back(static_cast<char>('0' + empty));
+        }
+        if (rank > 0) {
+            result.push_back('/');
+        }
+    }
+    result += m_side_to_move == chesscore::Color::White ? " w " : " b ";
+    if (m_castling_rights == 0) {
+        result.push_back('-');
+    }
+    for (const auto &[flag, flag_char] : {std::pair{white_kingside, 'K'}, std::pair{white_queenside, 'Q'}, std::pair{black_kingside, 'k'}, std::pair{black_queenside, 'q'}}) {
+        if ((m_castling_rights & flag) != 0) {
+            result.push_back(flag_char);
+        }
+    }
+    if (m_en_passant < 0) {
+        result += " -";
+    } else {
+        result.push_back(' ');
+        result.push_back(static_cast<char>('a' + m_en_passant % 8));
+        result.push_back(static_cast<char>('1' + m_en_passant / 8));
+    }
+    result += " 0 1";
+    return result;
+}
+
+auto Board::piece_at(int index) const -> std::optional<chesscore::Piece> {
+    const auto code = m_squares[static_cast<size_t>(index)];
+    if (code == 0) {
+        return std::nullopt;
+    }
+    return code_piece(code);
+}
+
+auto Board::key() const -> uint64_t {
+    auto key = m_key;
+    if (m_en_passant >= 0) {
+        const int file = m_en_passant % 8;
+        const int pawn_rank = m_en_passant / 8 - pawn_direction(m_side_to_move);
+        const auto pawn = piece_code(chesscore::PieceType::Pawn, m_side_to_move);
+        if (has_piece(file - 1, pawn_rank, pawn) || has_piece(file + 1, pawn_rank, pawn)) {
+            key ^= zobrist_keys.en_passant_files[static_cast<size_t>(file)];
+        }
+    }
+    // 0 marks an unknown key in the game tree.
+    return key == 0 ? 1 : key;
+}
+
+auto Board::make_move(const chesscore::Move &move) -> void {
+    const auto from = square_index(move.from);
+    const auto to = square_index(move.to);
+    set_square(from, 0);
+    if (move.capturing_en_passant) {
+        set_square(to - 8 * pawn_direction(move.piece.color), 0);
+    }
+    auto rights = m_castling_rights;
+    if (move.piece.type == chesscore::PieceType::King) {
+        rights &= static_cast<uint8_t>(~castling_flags(move.piece.color));
+        if (to - from == 2) {
+            set_square(to - 1, m_squares[static_cast<size_t>(to + 1)]);
+            set_square(to + 1, 0);
+        } else if (from - to == 2) {
+            set_square(to + 1, m_squares[static_cast<size_t>(to - 2)]);
+            set_square(to - 2, 0);
+        }
+    }
+    rights &= static_cast<uint8_t>(~(corner_castling_flag(from) | corner_castling_flag(to)));
+    set_castling_rights(rights);
+    set_square(to, piece_code(move.promoted.value_or(move.piece)));
+    m_en_passant = -1;
+    if (move.piece.type == chesscore::PieceType::Pawn && std::abs(to - from) == 16) {
+        m_en_passant = static_cast<int8_t>((from + to) / 2);
+    }
+    m_side_to_move = chesscore::other_color(m_side_to_move);
+    m_key ^= zobrist_keys.black_to_move;
+}
+
+auto Board::set_square(int index, uint8_t code) -> void {
+    auto &square = m_squares[static_cast<size_t>(index)];
+    m_key ^= piece_key(square, index) ^ piece_key(code, index);
+    square = code;
+}
+
+auto Board::set_castling_rights(uint8_t rights) -> void {
+    m_key ^= zobrist_keys.castling_rights[m_castling_rights] ^ zobrist_keys.castling_rights[rights];
+    m_castling_rights = rights;
+}
+
+auto Board::compute_key() -> void {
+    m_key = zobrist_keys.castling_rights[m_castling_rights];
+    for (size_t index = 0; index < m_squares.size(); ++index) {
+        m_key ^= piece_key(m_squares[index], static_cast<int>(index));
+    }
+    if (m_side_to_move == chesscore::Color::Black) {
+        m_key ^= zobrist_keys.black_to_move;
+    }
+}
+
+auto Board::has_piece(int file, int rank, uint8_t code) const -> bool {
+    return on_board(file, rank) && m_squares[static_cast<size_t>(file + 8 * rank)] == code;
+}
+
+auto Board::slider_attacks(int file, int rank, int file_step, int rank_step, uint8_t code, uint8_t queen_code) const -> bool {
+    for (file += file_step, rank += rank_step; on_board(file, rank); file += file_step, rank += rank_step) {
+        const auto occupant = m_squares[static_cast<size_t>(file + 8 * rank)];
+        if (occupant != 0) {
+            return occupant == code || occupant == queen_code;
+        }
+    }
+    return false;
+}
+
+auto Board::is_attacked(int index, chesscore::Color by) const -> bool {
+    const int file = index % 8;
+    const int rank = index / 8;
+    const auto pawn_rank = rank - pawn_direction(by);
+    const auto pawn = piece_code(chesscore::PieceType::Pawn, by);
+    if (has_piece(file - 1, pawn_rank, pawn) || has_piece(file + 1, pawn_rank, pawn)) {
+        return true;
+    }
+    const auto knight = piece_code(chesscore::PieceType::Knight, by);
+    for (const auto &offset : knight_offsets) {
+        if (has_piece(file + offset.file, rank + offset.rank, knight)) {
+            return true;
+        }
+    }
+    const auto king = piece_code(chesscore::PieceType::King, by);
+    for (const auto &offset : king_offsets) {
+        if (has_piece(file + offset.file, rank + offset.rank, king)) {
+            return true;
+        }
+    }
+    const auto queen = piece_code(chesscore::PieceType::Queen, by);
+    const auto rook = piece_code(chesscore::PieceType::Rook, by);
+    for (const auto &direction : rook_directions) {
+        if (slider_attacks(file, rank, direction.file, direction.rank, rook, queen)) {
+            return true;
+        }
+    }
+    const auto bishop = piece_code(chesscore::PieceType::Bishop, by);
+    for (const auto &direction : bishop_directions) {
+        if (slider_attacks(file, rank, direction.file, direction.rank, bishop, queen)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto Board::king_index(chesscore::Color color) const -> int {
+    const auto king = piece_code(chesscore::PieceType::King, color);
+    for (size_t index = 0; index < m_squares.size(); ++index) {
+        if (m_squares[index] == king) {
+            return static_cast<int>(index);
+        }
+    }
+    return -1;
+}
+
+auto Board::in_check(chesscore::Color color) const -> bool {
+    const auto king = king_index(color);
+    return king >= 0 && is_attacked(king, chesscore::other_color(color));
+}
+
+auto Board::keeps_king_safe(const chesscore::Move &move) const -> bool {
+    auto board = *this;
+    board.make_move(move);
+    return !board.in_check(move.piece.color);
+}
+
+namespace {
+
+class SANResolver {
+public:
+    SANResolver(const SANMove &san_move, const Board &board)
+        : m_san_move{san_move}, m_board{board}, m_us{board.side_to_move()}, m_target{square_index(san_move.target_square)} {}
+
+    auto resolve() -> std::optional<chesscore::Move> {
+        if (m_san_move.moving_piece.color != m_us) {
+            return std::nullopt;
+        }
+        if (m_san_move.san_string.starts_with("O-O")) {
+            return resolve_castling();
+        }
+        find_candidates();
+        if (m_matches != 1) {
+            return std::nullopt;
+        }
+        return m_match;
+    }
+
+    auto append_san(std::string &out, const chesscore::Move &move) const -> void {
+        std::array<chesscore::Square, 8> origins{};
+        const auto legal_candidates = candidates();
+        std::ranges::transform(legal_candidates, origins.begin(), &chesscore::Move::from);
+        append_san_move(out, move, std::span{origins}.first(legal_candidates.size()));
+    }
+
+    auto find_candidates() -> void {
+        const auto occupant = m_board.piece_at(m_target);
+        if (occupant.has_value() && occupant->color == m_us) {
+            return;
+        }
+        const int file = m_target % 8;
+        const int rank = m_target / 8;
+        switch (m_san_move.moving_piece.type) {
+        case chesscore::PieceType::Pawn:
+            add_pawn_candidates(file, rank, occupant);
+            break;
+        case chesscore::PieceType::Knight:
+            add_step_candidates(file, rank, knight_offsets, occupant);
+            break;
+        case chesscore::PieceType::King:
+            add_step_candidates(file, rank, king_offsets, occupant);
+            break;
+        case chesscore::PieceType::Rook:
+            add_slider_candidates(file, rank, rook_directions, occupant);
+            break;
+        case chesscore::PieceType::Bishop:
+            add_slider_candidates(file, rank, bishop_directions, occupant);
+            break;
+        case chesscore::PieceType::Queen:
+            add_slider_candidates(file, rank, rook_directions, occupant);
+            add_slider_candidates(file, rank, bishop_directions, occupant);
+            break;
+        }
+    }
+
+    [[nodiscard]] auto candidates() const -> std::span<const chesscore::Move> { return std::span{m_candidates}.first(std::min(m_candidate_count, m_candidates.size())); }
+private:
+    const SANMove &m_san_move;
+    const Board &m_board;
+    chesscore::Color m_us;
+    int m_target;
+    size_t m_matches{0};
+    chesscore::Move m_match;
+    size_t m_candidate_count{0};
+    std::array<chesscore::Move, 8> m_candidates{}; ///< Legal moves to the target square regardless of the disambiguation, at most one per direction.
+
+    [[nodiscard]] auto is_own(int file, int rank, chesscore::PieceType type) const -> bool {
+        return on_board(file, rank) && m_board.piece_at(file + 8 * rank) == chesscore::Piece{.type = type, .color = m_us};
+    }
+
+    auto add_candidate(int from, const std::optional<chesscore::Piece> &captured, bool en_passant = false) -> void {
+        if (m_san_move.capturing != captured.has_value()) {
+            return;
+        }
+        const auto from_square = index_square(from);
+        const chesscore::Move move{
+            .from = from_square,
+            .to = m_san_move.target_square,
+            .piece = m_san_move.moving_piece,
+            .captured = captured,
+            .promoted = m_san_move.promotion,
+            .capturing_en_passant = en_passant,
+        };
+        if (!m_board.keeps_king_safe(move)) {
+            return;
+        }
+        if (m_candidate_count < m_candidates.size()) {
+            m_candidates[m_candidate_count] = move;
+        }
+        ++m_candidate_count;
+        if ((m_san_move.disambiguation_file.has_value() && m_san_move.disambiguation_file.value() != from_square.file()) ||
+            (m_san_move.disambiguation_rank.has_value() && m_san_move.disambiguation_rank.value() != from_square.rank())) {
+            return;
+        }
+        ++m_matches;
+        m_match = move;
+    }
+
+    auto add_pawn_candidates(int file, int rank, const std::optional<chesscore::Piece> &occupant) -> void {
+        const int direction = pawn_direction(m_us);
+        const int last_rank = m_us == chesscore::Color::White ? 7 : 0;
+        if (m_san_move.promotion.has_value() != (rank == last_rank)) {
+            return;
+        }
+        if (m_san_move.promotion.has_value() &&
+            (m_san_move.promotion->color != m_us || m_san_move.promotion->type == chesscore::PieceType::Pawn || m_san_move.promotion->type == chesscore::PieceType::King)) {
+            return;
+        }
+        const int from_rank = rank - direction;
+        if (occupant.has_value() || m_target == m_board.en_passant_index()) {
+            const auto captured = occupant.has_value() ? occupant : chesscore::Piece{.type = chesscore::PieceType::Pawn, .color = chesscore::other_color(m_us)};
+            for (const int from_file : {file - 1, file + 1}) {
+                if (is_own(from_file, from_rank, chesscore::PieceType::Pawn)) {
+                    add_candidate(from_file + 8 * from_rank, captured, !occupant.has_value());
+                }
+            }
+            return;
+        }
+        if (is_own(file, from_rank, chesscore::PieceType::Pawn)) {
+            add_candidate(file + 8 * from_rank, std::nullopt);
+        } else if (rank == (m_us == chesscore::Color::White ? 3 : 4) && !m_board.piece_at(file + 8 * from_rank).has_value() &&
+                   is_own(file, from_rank - direction, chesscore::PieceType::Pawn)) {
+            add_candidate(file + 8 * (from_rank - direction), std::nullopt);
+        }
+    }
+
+    template<size_t N>
+    auto add_step_candidates(int file, int rank, const std::array<Offset, N> &offsets, const std::optional<chesscore::Piece> &occupant) -> void {
+        for (const auto &offset : offsets) {
+            if (is_own(file + offset.file, rank + offset.rank, m_san_move.moving_piece.type)) {
+                add_candidate(file + offset.file + 8 * (rank + offset.rank), occupant);
+            }
+        }
+    }
+
+    template<size_t N>
+    auto add_slider_candidates(int file, int rank, const std::array<Offset, N> &directions, const std::optional<chesscore::Piece> &occupant) -> void {
+        for (const auto &direction : directions) {
+            int from_file = file + direction.file;
+            int from_rank = rank + direction.rank;
+            while (on_board(from_file, from_rank) && !m_board.piece_at(from_file + 8 * from_rank).has_value()) {
+                from_file += direction.file;
+                from_rank += direction.rank;
+            }
+            if (is_own(from_file, from_rank, m_san_move.moving_piece.type)) {
+                add_candidate(from_file + 8 * from_rank, occupant);
+            }
+        }
+    }
+
+    auto resolve_castling() -> std::optional<chesscore::Move> {
+        const bool kingside = !m_san_move.san_string.starts_with("O-O-O");
+        const int base = m_us == chesscore::Color::White ? 0 : 56;
+        const uint8_t flag = m_us == chesscore::Color::White ? (kingside ? Board::white_kingside : Board::white_queenside)
+                                                             : (kingside ? Board::black_kingside : Board::black_queenside);
+        const int king_from = base + 4;
+        const int king_to = base + (kingside ? 6 : 2);
+        const int rook_from = base + (kingside ? 7 : 0);
+        const chesscore::Piece king{.type = chesscore::PieceType::King, .color = m_us};
+        const chesscore::Piece rook{.type = chesscore::PieceType::Rook, .color = m_us};
+        if ((m_board.castling_rights() & flag) == 0 || m_board.piece_at(king_from) != king || m_board.piece_at(rook_from) != rook) {
+            return std::nullopt;
+        }
+        for (int index = std::min(king_from, rook_from) + 1; index < std::max(king_from, rook_from); ++index) {
+            if (m_board.piece_at(index).has_value()) {
+                return std::nullopt;
+            }
+        }
+        const auto them = chesscore::other_color(m_us);
+        const int pass_through = (king_from + king_to) / 2;
+        if (m_board.is_attacked(king_from, them) || m_board.is_attacked(pass_through, them) || m_board.is_attacked(king_to, them)) {
+            return std::nullopt;
+        }
+        return chesscore::Move{.from = index_square(king_from), .to = index_square(king_to), .piece = king};
+    }
+};
+
+} // namespace
+
+auto resolve_san_move(const SANMove &san_move, const Board &board) -> std::optional<chesscore::Move> {
+    return SANResolver{san_move, board}.resolve();
+}
+
+auto resolve_san_move(const SANMove &san_move, const Board &board, std::string &san) -> std::optional<chesscore::Move> {
+    SANResolver resolver{san_move, board};
+    const auto move = resolver.resolve();
+    if (move.has_value()) {
+        resolver.append_san(san, move.value());
+    }
+    return move;
+}
+
+auto is_checkmate(const Board &board) -> bool {
+    const auto us = board.side_to_move();
+    if (!board.in_check(us)) {
+        return false;
+    }
+    const chesscore::Piece king{.type = chesscore::PieceType::King, .color = us};
+    int king_square{0};
+    while (board.piece_at(king_square) != king) {
+        ++king_square;
+    }
+    for (const auto &offset : king_offsets) {
+        const int file = king_square % 8 + offset.file;
+        const int rank = king_square / 8 + offset.rank;
+        if (!on_board(file, rank)) {
+            continue;
+        }
+        const auto occupant = board.piece_at(file + 8 * rank);
+        if (occupant.has_value() && occupant->color == us) {
+            continue;
+        }
+        if (board.keeps_king_safe(chesscore::Move{.from = index_square(king_square), .to = index_square(file + 8 * rank), .piece = king, .captured = occupant})) {
+            return false;
+        }
+    }
+    // The king cannot escape, so another piece has to capture or block the checking piece.
+    const int last_rank = us == chesscore::Color::White ? 7 : 0;
+    for (int target = 0; target < 64; ++target) {
+        const auto occupant = board.piece_at(target);
+        if (occupant.has_value() && occupant->color == us) {
+            continue;
+        }
+        for (const auto type : {chesscore::PieceType::Pawn, chesscore::PieceType::Knight, chesscore::PieceType::Bishop, chesscore::PieceType::Rook, chesscore::PieceType::Queen}) {
+            const bool pawn = type == chesscore::PieceType::Pawn;
+            const SANMove san_move{
+                .san_string = {},
+                .moving_piece = chesscore::Piece{.type = type, .color = us},
+                .target_square = index_square(target),
+                .capturing = occupant.has_value() || (pawn && target == board.en_passant_index()),
+                .promotion = pawn && target / 8 == last_rank ? std::optional{chesscore::Piece{.type = chesscore::PieceType::Queen, .color = us}} : std::nullopt,
+            };
+            SANResolver resolver{san_move, board};
+            resolver.find_candidates();
+            if (!resolver.candidates().empty()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+auto legal_moves(const Board &board) -> chesscore::MoveList {
+    const auto us = board.side_to_move();
+    const int last_rank = us == chesscore::Color::White ? 7 : 0;
+    const std::array<std::optional<chesscore::Piece>, 1> no_promotion{};
+    const std::array<std::optional<chesscore::Piece>, 4> promotions{
+        chesscore::Piece{.type = chesscore::PieceType::Queen, .color = us}, chesscore::Piece{.type = chesscore::PieceType::Rook, .color = us},
+        chesscore::Piece{.type = chesscore::PieceType::Bishop, .color = us}, chesscore::Piece{.type = chesscore::PieceType::Knight, .color = us}};
+    chesscore::MoveList moves;
+    for (int target = 0; target < 64; ++target) {
+        const auto occupant = board.piece_at(target);
+        if (occupant.has_value() && occupant->color == us) {
+            continue;
+        }
+        for (const auto type : {chesscore::PieceType::Pawn, chesscore::PieceType::Knight, chesscore::PieceType::Bishop, chesscore::PieceType::Rook, chesscore::PieceType::Queen,
+                                chesscore::PieceType::King}) {
+            const bool pawn = type == chesscore::PieceType::Pawn;
+            std::span<const std::optional<chesscore::Piece>> choices{no_promotion};
+            if (pawn && target / 8 == last_rank) {
+                choices = promotions;
+            }
+            for (const auto &promotion : choices) {
+                const SANMove san_move{
+                    .san_string = {},
+                    .moving_piece = chesscore::Piece{.type = type, .color = us},
+                    .target_square = index_square(target),
+                    .capturing = occupant.has_value() || (pawn && target == board.en_passant_index()),
+                    .promotion = promotion,
+                };
+                SANResolver resolver{san_move, board};
+                resolver.find_candidates();
+                std::ranges::copy(resolver.candidates(), std::back_inserter(moves));
+            }
+        }
+    }
+    for (const auto *castling : {"O-O", "O-O-O"}) {
+        const SANMove san_move{.san_string = castling, .moving_piece = chesscore::Piece{.type = chesscore::PieceType::King, .color = us}, .target_square = index_square(0)};
+        if (const auto move = SANResolver{san_move, board}.resolve(); move.has_value()) {
+            moves.push_back(move.value());
+        }
+    }
+    return moves;
+}
+
+auto append_san_move(std::string &out, const chesscore::Move &move, const Board &board) -> bool {
+    const SANMove san_move{
+        .san_string = move.is_castling() ? ((move.to.file() == chesscore::File{'c'}) ? "O-O-O" : "O-O") : "",
+        .moving_piece = move.piece,
+        .target_square = move.to,
+        .capturing = move.captured.has_value(),
+        .promotion = move.promoted,
+    };
+    SANResolver resolver{san_move, board};
+    if (move.is_castling()) {
+        const auto castling = resolver.resolve();
+        if (!castling.has_value() || !chesscore::FullMoveCompare{}(castling.value(), move)) {
+            return false;
+        }
+        resolver.append_san(out, move);
+        return true;
+    }
+    if (move.piece.color != board.side_to_move()) {
+        return false;
+    }
+    resolver.find_candidates();
+    const auto candidates = resolver.candidates();
+    if (std::ranges::none_of(candidates, [&move](const chesscore::Move &candidate) { return chesscore::FullMoveCompare{}(candidate, move); })) {
+        return false;
+    }
+    resolver.append_san(out, move);
+    return true;
+}
+
+} // namespace chessgame
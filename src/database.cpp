@@ -0,0 +1,250 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "chessgame/database.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace chessgame {
+
+namespace {
+
+constexpr std::array<char, 4> index_magic{'C', 'G', 'I', 'X'};
+constexpr std::uint32_t index_version{2};
+constexpr std::uint32_t byte_order_mark{0x01020304U}; ///< Reads differently on a machine with another byte order.
+
+struct IndexHeader {
+    std::array<char, 4> magic{index_magic};
+    std::uint32_t version{index_version};
+    std::uint32_t byte_order{byte_order_mark};
+    std::uint32_t reserved{0};
+    std::uint64_t data_size{0};
+    std::int64_t modification_time{0};
+    std::uint64_t data_hash{0};
+    std::uint64_t game_count{0};
+};
+
+auto modification_time(const std::filesystem::path &path) -> std::int64_t {
+    std::error_code error;
+    const auto time = std::filesystem::last_write_time(path, error);
+    return error ? 0 : static_cast<std::int64_t>(time.time_since_epoch().count());
+}
+
+template<typename T>
+auto write_value(std::ostream &out, const T &value) -> void {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+template<typename T>
+auto read_value(std::istream &in, T &value) -> bool {
+    in.read(reinterpret_cast<char *>(&value), sizeof(T)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    return static_cast<bool>(in);
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw ChessGameError{"Cannot open file " + path.string()};
+    }
+    LARGE_INTEGER file_size{};
+    if (GetFileSizeEx(file, &file_size) == 0) {
+        CloseHandle(file);
+        throw ChessGameError{"Cannot determine size of file " + path.string()};
+    }
+    m_size = static_cast<size_t>(file_size.QuadPart);
+    if (m_size > 0) {
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            m_data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mapping);
+        }
+        if (m_data == nullptr) {
+            CloseHandle(file);
+            throw ChessGameError{"Cannot map file " + path.string()};
+        }
+    }
+    CloseHandle(file);
+}
+
+auto MappedFile::unmap() -> void {
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+    const int file = ::open(path.c_str(), O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg)
+    if (file < 0) {
+        throw ChessGameError{"Cannot open file " + path.string()};
+    }
+    struct stat file_status{};
+    if (::fstat(file, &file_status) != 0) {
+        ::close(file);
+        throw ChessGameError{"Cannot determine size of file " + path.string()};
+    }
+    m_size = static_cast<size_t>(file_status.st_size);
+    if (m_size > 0) {
+        void *mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+            ::close(file);
+            throw ChessGameError{"Cannot map file " + path.string()};
+        }
+        m_data = static_cast<const char *>(mapping);
+    }
+    ::close(file);
+}
+
+auto MappedFile::unmap() -> void {
+    if (m_data != nullptr) {
+        ::munmap(const_cast<char *>(m_data), m_size); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+MappedFile::MappedFile(MappedFile &&other) noexcept : m_data{std::exchange(other.m_data, nullptr)}, m_size{std::exchange(other.m_size, 0)} {}
+
+auto MappedFile::operator=(MappedFile &&other) noexcept -> MappedFile & {
+    if (this != &other) {
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+auto scan_game_offsets(std::string_view data) -> std::vector<size_t> {
+    std::vector<size_t> offsets;
+    PGNParser parser{data};
+    auto offset = parser.skip_game();
+    while (offset.has_value()) {
+        offsets.push_back(*offset);
+        offset = parser.skip_game();
+    }
+    return offsets;
+}
+
+PGNDatabase::PGNDatabase(const std::filesystem::path &path, IndexFileMode mode) : PGNDatabase{path, default_index_path(path), mode} {}
+
+PGNDatabase::PGNDatabase(const std::filesystem::path &path, const std::filesystem::path &index_path, IndexFileMode mode) : m_path{path}, m_file{path} {
+    if (mode != IndexFileMode::Ignore && load_index(index_path)) {
+        return;
+    }
+    m_offsets = scan_game_offsets(data());
+    if (mode == IndexFileMode::ReadWrite) {
+        save_index(index_path);
+    }
+}
+
+auto PGNDatabase::default_index_path(const std::filesystem::path &path) -> std::filesystem::path {
+    auto index_path = path;
+    index_path += ".idx";
+    return index_path;
+}
+
+auto PGNDatabase::game_data(size_t index) const -> std::string_view {
+    const auto begin = m_offsets.at(index);
+    const auto end = index + 1 < m_offsets.size() ? m_offsets[index + 1] : data().size();
+    return data().substr(begin, end - begin);
+}
+
+auto PGNDatabase::parser(size_t index) const -> PGNParser {
+    PGNParser game_parser{game_data(index)};
+    game_parser.set_tag_pool(m_tag_pool);
+    return game_parser;
+}
+
+auto PGNDatabase::read_game(size_t index) const -> std::optional<Game> {
+    auto game_parser = parser(index);
+    return game_parser.read_game();
+}
+
+auto PGNDatabase::read_header(size_t index) const -> GameHeader {
+    auto game_parser = parser(index);
+    auto header = game_parser.read_header().value_or(GameHeader{});
+    header.offset = m_offsets[index];
+    header.movetext_offset += m_offsets[index];
+    return header;
+}
+
+auto PGNDatabase::save_index(const std::filesystem::path &index_path) const -> bool {
+    std::ofstream out{index_path, std::ios::binary | std::ios::trunc};
+    if (!out) {
+        return false;
+    }
+    const IndexHeader header{
+        .data_size = data().size(),
+        .modification_time = modification_time(m_path),
+        .data_hash = serialization::hash_data(data()),
+        .game_count = m_offsets.size(),
+    };
+    write_value(out, header);
+    for (const auto offset : m_offsets) {
+        write_value(out, static_cast<std::uint64_t>(offset));
+    }
+    return static_cast<bool>(out);
+}
+
+auto PGNDatabase::load_index(const std::filesystem::path &index_path) -> bool {
+    std::ifstream in{index_path, std::ios::binary};
+    if (!in) {
+        return false;
+    }
+    IndexHeader header{};
+    if (!read_value(in, header) || header.magic != index_magic || header.version != index_version || header.byte_order != byte_order_mark) {
+        return false;
+    }
+    if (header.data_size != data().size() || header.modification_time != modification_time(m_path) || header.data_hash != serialization::hash_data(data())) {
+        return false;
+    }
+    if (header.game_count > data().size()) {
+        return false;
+    }
+    std::vector<size_t> offsets(header.game_count);
+    for (size_t index = 0; index < offsets.size(); ++index) {
+        std::uint64_t value{};
+        if (!read_value(in, value) || value >= data().size() || (index > 0 && value <= offsets[index - 1])) {
+            return false;
+        }
+        offsets[index] = static_cast<size_t>(value);
+    }
+    m_offsets = std::move(offsets);
+    return true;
+}
+
+} // namespace chessgame
@@ -0,0 +1,176 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "chessgame/export.h"
+#include "chessgame/pgn.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace chessgame {
+
+namespace {
+
+/**
+ * \brief Access to the game at an index. nullptr skips the index.
+ */
+using GameAccess = std::function<const Game *(size_t index)>;
+
+/**
+ * \brief Writes batches of games concurrently and copies them in order.
+ *
+ * The workers take the batches in ascending order. A worker only starts a
+ * batch, if there is a free buffer for it, i.e. if fewer than
+ * ExportOptions::max_pending_batches batches before it are not yet copied to
+ * the output.
+ */
+class ExportPipeline {
+public:
+    ExportPipeline(size_t game_count, GameAccess game, const ExportOptions &options)
+        : m_game_count{game_count}, m_game{std::move(game)}, m_batch_size{std::max<size_t>(options.batch_size, 1)},
+          m_batch_count{(game_count + m_batch_size - 1) / m_batch_size}, m_buffers(std::max<size_t>(options.max_pending_batches, 1)) {}
+
+    ExportPipeline(const ExportPipeline &) = delete;
+    ExportPipeline(ExportPipeline &&) = delete;
+    auto operator=(const ExportPipeline &) -> ExportPipeline & = delete;
+    auto operator=(ExportPipeline &&) -> ExportPipeline & = delete;
+
+    ~ExportPipeline() { stop(); }
+
+    auto run(std::ostream &out_stream, unsigned int workers) -> void {
+        for (unsigned int index = 0; index < workers; ++index) {
+            m_threads.emplace_back([this] { write_batches(); });
+        }
+        for (size_t batch = 0; batch < m_batch_count; ++batch) {
+            const auto data = take_buffer(batch);
+            out_stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+    }
+private:
+    size_t m_game_count;
+    GameAccess m_game;
+    size_t m_batch_size;
+    size_t m_batch_count;
+    std::mutex m_mutex;
+    std::condition_variable m_buffer_written;
+    std::condition_variable m_buffer_taken;
+    std::vector<std::optional<std::string>> m_buffers; ///< Ring of the buffers of the pending batches.
+    size_t m_next_batch{0};                            ///< The next batch to write.
+    size_t m_next_output{0};                           ///< The next batch to copy to the output.
+    std::exception_ptr m_error;                        ///< The first error of a worker.
+    size_t m_error_batch{0};                           ///< The batch, that caused the error.
+    bool m_stopped{false};
+    std::vector<std::jthread> m_threads; ///< Declared last, so that the threads are joined before the other members are destroyed.
+
+    auto stop() -> void {
+        const std::lock_guard lock{m_mutex};
+        m_stopped = true;
+        m_buffer_taken.notify_all();
+    }
+
+    auto next_batch() -> std::optional<size_t> {
+        std::unique_lock lock{m_mutex};
+        m_buffer_taken.wait(lock, [this] { return m_stopped || m_next_batch >= m_batch_count || m_next_batch < m_next_output + m_buffers.size(); });
+        if (m_stopped || m_next_batch >= m_batch_count) {
+            return std::nullopt;
+        }
+        return m_next_batch++;
+    }
+
+    auto write_batches() -> void {
+        std::ostringstream buffer;
+        while (const auto batch = next_batch()) {
+            try {
+                PGNWriter writer{buffer};
+                const auto last = std::min((*batch + 1) * m_batch_size, m_game_count);
+                for (auto index = *batch * m_batch_size; index < last; ++index) {
+                    if (const auto *game = m_game(index); game != nullptr) {
+                        writer.write_game(*game);
+                    }
+                }
+            } catch (...) {
+                const std::lock_guard lock{m_mutex};
+                if (!m_error || *batch < m_error_batch) {
+                    m_error = std::current_exception();
+                    m_error_batch = *batch;
+                }
+                m_stopped = true;
+                m_buffer_written.notify_all();
+                m_buffer_taken.notify_all();
+                return;
+            }
+            auto data = std::move(buffer).str();
+            buffer.str(std::string{});
+            const std::lock_guard lock{m_mutex};
+            m_buffers[*batch % m_buffers.size()] = std::move(data);
+            m_buffer_written.notify_all();
+        }
+    }
+
+    auto take_buffer(size_t batch) -> std::string {
+        std::unique_lock lock{m_mutex};
+        auto &buffer = m_buffers[batch % m_buffers.size()];
+        m_buffer_written.wait(lock, [&] { return buffer.has_value() || (m_error && m_error_batch == batch); });
+        if (!buffer.has_value()) {
+            std::rethrow_exception(m_error);
+        }
+        auto data = std::move(*buffer);
+        buffer.reset();
+        ++m_next_output;
+        m_buffer_taken.notify_all();
+        return data;
+    }
+};
+
+auto export_games(size_t game_count, const GameAccess &game, std::ostream &out_stream, const ExportOptions &options) -> void {
+    const auto batch_count = (game_count + std::max<size_t>(options.batch_size, 1) - 1) / std::max<size_t>(options.batch_size, 1);
+    const unsigned int requested = options.thread_count != 0 ? options.thread_count : std::max(std::thread::hardware_concurrency(), 1U);
+    const auto workers = static_cast<unsigned int>(std::min<size_t>(requested, batch_count));
+    if (workers <= 1) {
+        PGNWriter writer{out_stream};
+        for (size_t index = 0; index < game_count; ++index) {
+            if (const auto *current = game(index); current != nullptr) {
+                writer.write_game(*current);
+            }
+        }
+        return;
+    }
+    ExportPipeline pipeline{game_count, game, options};
+    pipeline.run(out_stream, workers);
+}
+
+} // namespace
+
+auto export_games(std::span<const Game> games, std::ostream &out_stream, const ExportOptions &options) -> void {
+    export_games(games.size(), [games](size_t index) { return &games[index]; }, out_stream, options);
+}
+
+auto export_games(const std::vector<ImportedGame> &games, std::ostream &out_stream, const ExportOptions &options) -> void {
+    export_games(
+        games.size(), [&games](size_t index) { return games[index].game.has_value() ? &*games[index].game : nullptr; }, out_stream, options
+    );
+}
+
+auto export_games(std::span<const Game> games, const std::filesystem::path &path, const ExportOptions &options) -> void {
+    std::ofstream out_stream{path, std::ios::binary | std::ios::trunc};
+    if (!out_stream) {
+        throw ChessGameError{"Cannot open " + path.string() + " for writing"};
+    }
+    export_games(games, out_stream, options);
+    out_stream.close();
+    if (!out_stream) {
+        throw ChessGameError{"Cannot write " + path.string()};
+    }
+}
+
+} // namespace chessgame
@@ -0,0 +1,247 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "chessgame/filter.h"
+
+#include "chessgame/san.h"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+namespace chessgame {
+
+namespace {
+
+auto is_chess960(const GameMetadata &metadata) -> bool {
+    const auto variant = metadata.get("Variant").value_or("");
+    return std::ranges::equal(variant, std::string_view{"chess960"}, [](char lhs, char rhs) {
+        return std::tolower(static_cast<unsigned char>(lhs)) == rhs;
+    });
+}
+
+/**
+ * \brief Tracks, which position and move predicates are satisfied by a game.
+ */
+class Satisfaction {
+public:
+    Satisfaction(size_t position_count, size_t move_count) : m_positions(position_count, false), m_moves(move_count, false), m_open{position_count + move_count} {}
+
+    template<typename Predicates, typename... Args>
+    auto check_positions(const Predicates &predicates, const Args &...args) -> void { check(m_positions, predicates, args...); }
+
+    template<typename Predicates, typename... Args>
+    auto check_moves(const Predicates &predicates, const Args &...args) -> void { check(m_moves, predicates, args...); }
+
+    [[nodiscard]] auto done() const -> bool { return m_open == 0; }
+private:
+    std::vector<bool> m_positions;
+    std::vector<bool> m_moves;
+    size_t m_open;
+
+    template<typename Predicates, typename... Args>
+    auto check(std::vector<bool> &satisfied, const Predicates &predicates, const Args &...args) -> void {
+        for (size_t index = 0; index < predicates.size(); ++index) {
+            if (!satisfied[index] && predicates[index](args...)) {
+                satisfied[index] = true;
+                --m_open;
+            }
+        }
+    }
+};
+
+} // namespace
+
+auto GameFilter::add_tag_predicate(TagPredicate predicate) -> GameFilter & {
+    m_tag_predicates.push_back(std::move(predicate));
+    return *this;
+}
+
+auto GameFilter::require_tag(std::string_view name, std::string_view value) -> GameFilter & {
+    return add_tag_predicate([name = std::string{name}, value = std::string{value}](const GameMetadata &metadata) {
+        return metadata.get(name) == value;
+    });
+}
+
+auto GameFilter::add_position_predicate(PositionPredicate predicate) -> GameFilter & {
+    m_position_predicates.push_back(std::move(predicate));
+    return *this;
+}
+
+auto GameFilter::require_position(uint64_t key) -> GameFilter & {
+    return add_position_predicate([key](const Board &board) { return board.key() == key; });
+}
+
+auto GameFilter::add_move_predicate(MovePredicate predicate) -> GameFilter & {
+    m_move_predicates.push_back(std::move(predicate));
+    return *this;
+}
+
+auto GameFilter::set_max_ply(size_t max_ply) -> GameFilter & {
+    m_max_ply = max_ply;
+    return *this;
+}
+
+auto GameFilter::matches(std::string_view game_data) const -> bool {
+    FilterStats stats{};
+    return matches(game_data, stats);
+}
+
+auto GameFilter::matches(std::string_view game_data, FilterStats &stats) const -> bool {
+    PGNParser parser{std::string_view{}};
+    return matches(parser, game_data, stats);
+}
+
+auto GameFilter::matches(PGNParser &parser, std::string_view game_data, FilterStats &stats) const -> bool {
+    ++stats.games;
+    parser.set_input(game_data);
+    std::optional<GameHeader> header;
+    try {
+        // The movetext is not scanned, unless the tags match.
+        header = parser.read_header(false);
+    } catch (const PGNError &) {
+        ++stats.errors;
+        return false;
+    }
+    if (!header.has_value()) {
+        return false;
+    }
+    const auto matches_tags = std::ranges::all_of(m_tag_predicates, [&header](const TagPredicate &predicate) { return predicate(header->metadata); });
+    if (!matches_tags || !needs_movetext()) {
+        if (matches_tags) {
+            ++stats.matches;
+        }
+        return matches_tags;
+    }
+    if (is_chess960(header->metadata)) {
+        ++stats.skipped;
+        return false;
+    }
+    auto board = start_board(header->metadata);
+    if (!board.has_value()) {
+        ++stats.errors;
+        return false;
+    }
+
+    ++stats.movetext_games;
+    const auto plies = stats.plies;
+    auto result = matches_movetext(game_data.substr(std::min(header->movetext_offset, game_data.size())), *board, stats);
+    if (!result.has_value()) {
+        // The movetext needs the fallbacks of the parser, e.g. for moves without piece type.
+        // The moves are played again, so they are counted only once.
+        stats.plies = plies;
+        parser.set_input(game_data);
+        auto game = parser.try_read_game();
+        if (!game.has_value() || !game->has_value()) {
+            ++stats.errors;
+            return false;
+        }
+        result = matches_game(**game, *board, stats);
+    }
+    if (*result) {
+        ++stats.matches;
+    }
+    return *result;
+}
+
+auto GameFilter::matches_movetext(std::string_view movetext, Board board, FilterStats &stats) const -> std::optional<bool> {
+    Satisfaction satisfaction{m_position_predicates.size(), m_move_predicates.size()};
+    satisfaction.check_positions(m_position_predicates, board);
+    if (satisfaction.done()) {
+        return true;
+    }
+
+    PGNLexer lexer{movetext};
+    size_t depth{0};
+    size_t ply{0};
+    while (!m_max_ply.has_value() || ply < *m_max_ply) {
+        const auto token = lexer.next_token();
+        switch (token.type) {
+        case PGNLexer::TokenType::OpenParen:
+            ++depth;
+            break;
+        case PGNLexer::TokenType::CloseParen:
+            if (depth == 0) {
+                return std::nullopt;
+            }
+            --depth;
+            break;
+        case PGNLexer::TokenType::Symbol: {
+            if (depth > 0) {
+                break;
+            }
+            const auto san_move = parse_san(token.value, board.side_to_move());
+            if (!san_move.has_value()) {
+                return std::nullopt;
+            }
+            const auto move = resolve_san_move(san_move.value(), board);
+            if (!move.has_value()) {
+                return std::nullopt;
+            }
+            satisfaction.check_moves(m_move_predicates, board, *move);
+            board.make_move(*move);
+            ++ply;
+            ++stats.plies;
+            satisfaction.check_positions(m_position_predicates, board);
+            if (satisfaction.done()) {
+                return true;
+            }
+            break;
+        }
+        case PGNLexer::TokenType::GameResult:
+        case PGNLexer::TokenType::EndOfInput:
+        case PGNLexer::TokenType::OpenBracket:
+            return false;
+        case PGNLexer::TokenType::Invalid:
+            if (token.value != "," && token.value != "}") {
+                return std::nullopt;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+auto GameFilter::matches_game(const Game &game, Board board, FilterStats &stats) const -> bool {
+    Satisfaction satisfaction{m_position_predicates.size(), m_move_predicates.size()};
+    satisfaction.check_positions(m_position_predicates, board);
+    size_t ply{0};
+    for (const auto node : game.view().mainline()) {
+        if (satisfaction.done() || (m_max_ply.has_value() && ply == *m_max_ply)) {
+            break;
+        }
+        satisfaction.check_moves(m_move_predicates, board, node.move());
+        board.make_move(node.move());
+        ++ply;
+        ++stats.plies;
+        satisfaction.check_positions(m_position_predicates, board);
+    }
+    return satisfaction.done();
+}
+
+auto filter_games(std::string_view data, const std::vector<size_t> &offsets, const GameFilter &filter, std::ostream &out_stream) -> FilterStats {
+    FilterStats stats{};
+    PGNParser parser{std::string_view{}};
+    for (size_t index = 0; index < offsets.size(); ++index) {
+        const auto end = index + 1 < offsets.size() ? offsets[index + 1] : data.size();
+        const auto game_data = data.substr(offsets[index], end - offsets[index]);
+        if (filter.matches(parser, game_data, stats)) {
+            out_stream.write(game_data.data(), static_cast<std::streamsize>(game_data.size()));
+        }
+    }
+    return stats;
+}
+
+auto filter_games(std::string_view data, const GameFilter &filter, std::ostream &out_stream) -> FilterStats {
+    return filter_games(data, scan_game_offsets(data), filter, out_stream);
+}
+
+auto filter_games(const PGNDatabase &database, const GameFilter &filter, std::ostream &out_stream) -> FilterStats {
+    return filter_games(database.data(), database.offsets(), filter, out_stream);
+}
+
+} // namespace chessgame
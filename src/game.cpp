@@ -5,24 +5,229 @@
 
 #include "chessgame/game.h"
 
+#include "chessgame/pgn.h"
+
+#include <memory>
+#include <ranges>
+#include <utility>
+#include <vector>
+
 namespace chessgame {
 
-Game::Game(const GameMetadata &metadata) : m_metadata{metadata} {
-    m_root = std::make_shared<GameNode>(NodeId{1});
-    const auto fen_tag = std::ranges::find_if(metadata, [](const auto &tag) { return tag.name == "FEN"; });
-    const auto initial_fen = fen_tag == metadata.end() ? chesscore::FenString::starting_position() : chesscore::FenString{fen_tag->value};
-    m_root->set_position(chesscore::Position{initial_fen});
+namespace {
+
+/// Number of plies between the nodes, that store their boards.
+constexpr size_t board_checkpoint_interval{16};
+
+auto initial_position(const GameMetadata &metadata) -> chesscore::Position {
+    static const chesscore::Position starting_position{chesscore::FenString::starting_position()};
+    const auto fen_tag = metadata.get("FEN");
+    return fen_tag.has_value() ? chesscore::Position{chesscore::FenString{std::string{fen_tag.value()}}} : starting_position;
+}
+
+} // namespace
+
+auto start_board(const GameMetadata &metadata) -> std::optional<Board> {
+    const auto fen_tag = metadata.get("FEN");
+    return fen_tag.has_value() ? Board::from_fen(fen_tag.value()) : Board::starting_position();
+}
+
+Game::Game(const GameMetadata &metadata) : Game{metadata, std::pmr::get_default_resource()} {}
+
+Game::Game(const GameMetadata &metadata, std::pmr::memory_resource *resource)
+    : m_resource{resource}, m_metadata{metadata, resource}, m_tree{std::make_unique<GameTree>(initial_position(metadata), resource)},
+      m_root_board{start_board(metadata)} {
+    if (m_root_board.has_value()) {
+        m_tree->set_position_key(GameTree::root_id, m_root_board->key());
+    }
 }
 
 Game::Game() : Game{GameMetadata{}} {}
 
-auto Game::add_node(const std::shared_ptr<GameNode> &parent, const chesscore::Move &move) -> std::shared_ptr<GameNode> {
-    auto child = std::make_shared<GameNode>(m_next_id++, move, parent);
-    auto added_child = parent->append_child(child);
-    if (added_child != child) {
-        ++m_next_id;
+Game::Game(const Game &other)
+    : m_resource{std::pmr::get_default_resource()}, m_metadata{other.m_metadata}, m_root_board{other.m_root_board},
+      m_position_cache_policy{other.m_position_cache_policy} {
+    // The tree of the other game may be built concurrently, so it is only
+    // copied, once it is complete.
+    if (other.has_pending_movetext()) {
+        m_tree = std::make_unique<GameTree>(initial_position(m_metadata));
+        if (m_root_board.has_value()) {
+            m_tree->set_position_key(GameTree::root_id, m_root_board->key());
+        }
+        set_pending_movetext(other.m_pending_movetext->movetext, other.m_pending_movetext->first_line);
+        m_pending_movetext->position_cache_policy = other.m_pending_movetext->position_cache_policy;
+    } else {
+        m_tree = std::make_unique<GameTree>(other.tree(), m_resource);
+    }
+}
+
+// The moved-from game keeps a null tree, that is replaced on the first
+// modifying access, see tree() and empty_tree().
+Game::Game(Game &&other) noexcept
+    : m_resource{other.m_resource}, m_metadata{std::move(other.m_metadata)}, m_tree{std::move(other.m_tree)},
+      m_root_board{std::exchange(other.m_root_board, Board::starting_position())},
+      m_position_cache_policy{std::exchange(other.m_position_cache_policy, PositionCachePolicy{})}, m_pending_movetext{std::move(other.m_pending_movetext)} {}
+
+// The game takes over the tree and with it the memory resource of the other
+// game. The metadata is only moved, if both use the same resource, otherwise
+// it is copied into the previous resource of the game.
+auto Game::operator=(Game &&other) -> Game & {
+    if (this == &other) {
+        return *this;
+    }
+    m_metadata = std::move(other.m_metadata);
+    m_tree = std::move(other.m_tree);
+    m_root_board = std::exchange(other.m_root_board, Board::starting_position());
+    m_position_cache_policy = std::exchange(other.m_position_cache_policy, PositionCachePolicy{});
+    m_pending_movetext = std::move(other.m_pending_movetext);
+    m_resource = other.m_resource;
+    return *this;
+}
+
+auto Game::empty_tree() -> const GameTree & {
+    static const GameTree tree = [] {
+        GameTree starting_tree{chesscore::Position{chesscore::FenString::starting_position()}};
+        starting_tree.set_position_key(GameTree::root_id, Board::starting_position().key());
+        return starting_tree;
+    }();
+    return tree;
+}
+
+auto Game::tree() -> GameTree & {
+    materialize_movetext();
+    m_pending_movetext.reset();
+    if (m_tree == nullptr) {
+        reset(GameMetadata{});
+    }
+    return *m_tree;
+}
+
+auto Game::reset(const GameMetadata &metadata) -> void {
+    // Throws for an invalid FEN tag before the game is changed.
+    const auto root_position = initial_position(metadata);
+    m_metadata = metadata;
+    m_pending_movetext.reset();
+    m_position_cache_policy = PositionCachePolicy{};
+    if (m_tree != nullptr) {
+        m_tree->clear(root_position);
+    } else {
+        m_tree = std::make_unique<GameTree>(root_position, m_resource);
+    }
+    m_root_board = start_board(metadata);
+    if (m_root_board.has_value()) {
+        m_tree->set_position_key(GameTree::root_id, m_root_board->key());
+    }
+}
+
+auto Game::memory_usage() const -> MemoryUsage {
+    auto usage = m_metadata.memory_usage();
+    std::unique_lock<std::mutex> lock;
+    if (m_pending_movetext != nullptr) {
+        lock = std::unique_lock{m_pending_movetext->tree_mutex};
+        if (!m_pending_movetext->parsed.load(std::memory_order_relaxed)) {
+            usage.movetext_bytes = heap_bytes(m_pending_movetext->movetext);
+        }
+    }
+    if (m_tree != nullptr) {
+        usage += m_tree->memory_usage();
+    }
+    return usage;
+}
+
+auto Game::set_pending_movetext(std::string movetext, int first_line) -> void {
+    m_pending_movetext = std::make_unique<PendingMovetext>();
+    m_pending_movetext->movetext = std::move(movetext);
+    m_pending_movetext->first_line = first_line;
+    m_pending_movetext->position_cache_policy = m_position_cache_policy;
+    // The policy has to stay unchanged while the tree is built, so it is
+    // already set to the policy, that the parser leaves behind.
+    if (m_position_cache_policy.mode == PositionCachePolicy::Mode::WhileParsing) {
+        m_position_cache_policy = PositionCachePolicy::root_only();
+    }
+}
+
+auto Game::build_pending_tree() const -> void {
+    // If parsing throws, the flag stays unset and the next access parses again.
+    std::call_once(m_pending_movetext->parse_once, [this] {
+        PGNParser parser{std::string_view{m_pending_movetext->movetext}, m_resource};
+        parser.set_position_cache_policy(m_pending_movetext->position_cache_policy);
+        std::unique_ptr<GameTree> tree;
+        try {
+            tree = std::move(parser.read_game_movetext(m_metadata).m_tree);
+        } catch (const PGNError &error) {
+            throw PGNError{error.type(), error.line() + m_pending_movetext->first_line - 1, error.what()};
+        }
+        const std::scoped_lock lock{m_pending_movetext->tree_mutex};
+        m_tree = std::move(tree);
+        m_pending_movetext->parsed.store(true, std::memory_order_release);
+    });
+}
+
+auto Game::add_node(NodeId parent, const chesscore::Move &move, const std::optional<chesscore::Position> &position, const std::optional<Board> &board)
+    -> NodeId {
+    auto &game_tree = tree();
+    const auto [child, added] = game_tree.add_child(parent, move);
+    if (!added) {
+        return child;
+    }
+    if (m_position_cache_policy.caches(game_tree.node(child).ply())) {
+        game_tree.set_position(child, position.has_value() ? *position : game_tree.calculate_position(child));
+    }
+    auto child_board = board;
+    if (!child_board.has_value()) {
+        child_board = this->board(parent);
+        if (child_board.has_value()) {
+            child_board->make_move(move);
+        }
+    }
+    if (child_board.has_value()) {
+        game_tree.set_position_key(child, child_board->key());
+        if (game_tree.node(child).ply() % board_checkpoint_interval == 0) {
+            game_tree.set_board(child, *child_board);
+        }
+    }
+    return child;
+}
+
+auto Game::board(NodeId node_id) const -> std::optional<Board> {
+    const auto &game_tree = tree();
+    if (!m_root_board.has_value()) {
+        return std::nullopt;
+    }
+    std::vector<NodeId> path;
+    const Board *ancestor_board{nullptr};
+    for (auto ancestor = node_id; ancestor != GameTree::root_id; ancestor = game_tree.node(ancestor).parent()) {
+        ancestor_board = game_tree.board(ancestor);
+        if (ancestor_board != nullptr) {
+            break;
+        }
+        path.push_back(ancestor);
     }
-    return added_child;
+    auto result = ancestor_board != nullptr ? *ancestor_board : *m_root_board;
+    for (const auto &path_node : std::views::reverse(path)) {
+        result.make_move(game_tree.node(path_node).move());
+    }
+    return result;
+}
+
+auto Game::find_position(uint64_t key) -> std::optional<Cursor> {
+    const auto node_id = tree().find_position(key);
+    return node_id == NodeId::Invalid ? std::nullopt : std::optional<Cursor>{Cursor{this, node_id}};
+}
+
+auto Game::find_position(uint64_t key) const -> std::optional<ConstCursor> {
+    const auto node_id = tree().find_position(key);
+    return node_id == NodeId::Invalid ? std::nullopt : std::optional<ConstCursor>{ConstCursor{this, node_id}};
+}
+
+auto Game::set_position_cache_policy(const PositionCachePolicy &policy) -> void {
+    auto &game_tree = tree();
+    m_position_cache_policy = policy;
+    game_tree.prune_positions([&](size_t ply) { return m_position_cache_policy.caches(ply); });
+}
+
+auto Game::drop_cached_positions() -> void {
+    tree().prune_positions([](size_t) { return false; });
 }
 
 } // namespace chessgame
@@ -0,0 +1,326 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "chessgame/import.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace chessgame {
+
+namespace {
+
+auto worker_count(const ImportOptions &options, size_t batch_count) -> size_t {
+    const size_t requested = options.thread_count != 0 ? options.thread_count : std::max(std::thread::hardware_concurrency(), 1U);
+    return std::min(requested, batch_count);
+}
+
+auto worker_tag_pool(const ImportOptions &options) -> std::shared_ptr<TagPool> {
+    return options.intern_tags ? std::make_shared<TagPool>(options.tag_pool_limit) : nullptr;
+}
+
+/**
+ * \brief Import a single game.
+ *
+ * Any exception while reading the game is recorded in the result, so that a
+ * single broken game does not abort the whole import.
+ */
+auto import_game(PGNParser &parser, std::string_view game_data, ImportedGame &result) -> void {
+    try {
+        parser.set_input(game_data);
+        auto game = parser.try_read_game();
+        if (game.has_value()) {
+            result.game = std::move(game).value();
+        } else {
+            result.error = std::move(game.error().error);
+            result.error_offset = result.offset + game.error().offset;
+        }
+        result.warnings = parser.warnings();
+    } catch (const PGNError &error) {
+        result.game.reset();
+        result.error = error;
+        result.error_offset = result.offset;
+    } catch (const std::exception &error) {
+        result.game.reset();
+        result.error = PGNError{PGNErrorType::InvalidGame, 0, error.what()};
+        result.error_offset = result.offset;
+    }
+}
+
+/**
+ * \brief A queue between two stages of a pipeline.
+ *
+ * Pushing blocks while the queue is full, popping blocks while it is empty.
+ * After closing the queue, pushing fails and popping returns the remaining
+ * values.
+ */
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity{std::max<size_t>(capacity, 1)} {}
+
+    auto push(T value) -> bool {
+        std::unique_lock lock{m_mutex};
+        m_not_full.wait(lock, [this] { return m_closed || m_values.size() < m_capacity; });
+        if (m_closed) {
+            return false;
+        }
+        m_values.push_back(std::move(value));
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    auto pop() -> std::optional<T> {
+        std::unique_lock lock{m_mutex};
+        m_not_empty.wait(lock, [this] { return m_closed || !m_values.empty(); });
+        if (m_values.empty()) {
+            return std::nullopt;
+        }
+        auto value = std::move(m_values.front());
+        m_values.pop_front();
+        m_not_full.notify_one();
+        return value;
+    }
+
+    auto close() -> void {
+        const std::lock_guard lock{m_mutex};
+        m_closed = true;
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+private:
+    size_t m_capacity;
+    std::mutex m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+    std::deque<T> m_values;
+    bool m_closed{false};
+};
+
+/**
+ * \brief Consecutive complete games cut from the input stream.
+ */
+struct GameBatch {
+    size_t offset{0};                               ///< Byte offset of the data in the input.
+    std::string data;                               ///< The PGN data of the games.
+    std::vector<size_t> offsets;                    ///< Start offsets of the games in the data.
+    std::promise<std::vector<ImportedGame>> result; ///< Receives the parsed games.
+};
+
+/**
+ * \brief The stages of a streaming import.
+ *
+ * The batches travel from the splitter to the workers through the work
+ * queue. Their results are handed to the consumer through the pending
+ * queue, in the order in which the splitter created the batches. As every
+ * batch waits in the pending queue until it is consumed, its capacity limits
+ * the number of batches in the pipeline.
+ */
+class ImportPipeline {
+public:
+    ImportPipeline(InputSource &input, const ImportOptions &options)
+        : m_input{&input}, m_options{options}, m_blocks{2}, m_work{options.max_pending_batches}, m_pending{options.max_pending_batches} {}
+
+    ImportPipeline(const ImportPipeline &) = delete;
+    ImportPipeline(ImportPipeline &&) = delete;
+    auto operator=(const ImportPipeline &) -> ImportPipeline & = delete;
+    auto operator=(ImportPipeline &&) -> ImportPipeline & = delete;
+
+    ~ImportPipeline() {
+        m_blocks.close();
+        m_work.close();
+        m_pending.close();
+    }
+
+    auto run(const ImportConsumer &consumer) -> size_t {
+        const auto workers = m_options.thread_count != 0 ? m_options.thread_count : std::max(std::thread::hardware_concurrency(), 1U);
+        m_threads.emplace_back([this] { read_blocks(); });
+        m_threads.emplace_back([this] { split_games(); });
+        for (unsigned int index = 0; index < workers; ++index) {
+            m_threads.emplace_back([this] { parse_batches(); });
+        }
+
+        size_t count{0};
+        while (auto games = m_pending.pop()) {
+            for (auto &game : games->get()) {
+                consumer(std::move(game));
+                ++count;
+            }
+        }
+        return count;
+    }
+private:
+    InputSource *m_input;
+    ImportOptions m_options;
+    BoundedQueue<std::string> m_blocks;
+    BoundedQueue<std::shared_ptr<GameBatch>> m_work;
+    BoundedQueue<std::future<std::vector<ImportedGame>>> m_pending;
+    std::exception_ptr m_read_error;
+    std::vector<std::jthread> m_threads; ///< Declared last, so that the threads are joined before the queues are destroyed.
+
+    auto read_blocks() -> void {
+        const auto block_size = std::max<size_t>(m_options.block_size, 1);
+        try {
+            while (true) {
+                std::string block(block_size, '\0');
+                const auto read = m_input->read(block.data(), block_size);
+                if (!read.has_value()) {
+                    throw PGNError{PGNErrorType::InputError, 0};
+                }
+                block.resize(*read);
+                if (block.empty() || !m_blocks.push(std::move(block))) {
+                    break;
+                }
+            }
+        } catch (...) {
+            m_read_error = std::current_exception();
+        }
+        m_blocks.close();
+    }
+
+    auto split_games() -> void {
+        const auto batch_size = std::max<size_t>(m_options.batch_size, 1);
+        std::string buffer;
+        size_t buffer_offset{0};
+        auto batch = std::make_shared<GameBatch>();
+        const auto add_game = [&](size_t begin, size_t end) {
+            if (batch->offsets.empty()) {
+                batch->offset = buffer_offset + begin;
+            }
+            batch->offsets.push_back(batch->data.size());
+            batch->data.append(buffer, begin, end - begin);
+            return batch->offsets.size() < batch_size || submit(std::exchange(batch, std::make_shared<GameBatch>()));
+        };
+
+        bool running{true};
+        size_t scanned{0};
+        while (auto block = m_blocks.pop()) {
+            buffer += *block;
+            // The scan cannot resume within a game, so the buffer is only scanned
+            // again, once it has doubled. This keeps the scanning of games, that
+            // span many blocks, linear.
+            if (buffer.size() < 2 * scanned) {
+                continue;
+            }
+            // All games but the last one are complete, the last one may continue in the next block.
+            const auto offsets = scan_game_offsets(buffer);
+            for (size_t index = 0; running && index + 1 < offsets.size(); ++index) {
+                running = add_game(offsets[index], offsets[index + 1]);
+            }
+            if (!running) {
+                return;
+            }
+            if (!offsets.empty()) {
+                buffer.erase(0, offsets.back());
+                buffer_offset += offsets.back();
+            }
+            scanned = buffer.size();
+        }
+        if (m_read_error) {
+            std::promise<std::vector<ImportedGame>> failure;
+            failure.set_exception(m_read_error);
+            m_pending.push(failure.get_future());
+        } else {
+            const auto offsets = scan_game_offsets(buffer);
+            for (size_t index = 0; running && index < offsets.size(); ++index) {
+                running = add_game(offsets[index], index + 1 < offsets.size() ? offsets[index + 1] : buffer.size());
+            }
+            if (running && !batch->offsets.empty()) {
+                submit(std::move(batch));
+            }
+        }
+        m_work.close();
+        m_pending.close();
+    }
+
+    auto submit(std::shared_ptr<GameBatch> batch) -> bool { return m_pending.push(batch->result.get_future()) && m_work.push(std::move(batch)); }
+
+    auto parse_batches() -> void {
+        PGNParser parser{std::string_view{}};
+        parser.set_position_cache_policy(m_options.position_cache_policy);
+        parser.set_tag_pool(worker_tag_pool(m_options));
+        while (auto batch = m_work.pop()) {
+            // The consumer waits for every batch, so the promise is fulfilled, even if the batch fails.
+            try {
+                const auto &offsets = (*batch)->offsets;
+                const std::string_view data{(*batch)->data};
+                std::vector<ImportedGame> results(offsets.size());
+                for (size_t index = 0; index < offsets.size(); ++index) {
+                    const auto end = index + 1 < offsets.size() ? offsets[index + 1] : data.size();
+                    results[index].offset = (*batch)->offset + offsets[index];
+                    import_game(parser, data.substr(offsets[index], end - offsets[index]), results[index]);
+                }
+                (*batch)->result.set_value(std::move(results));
+            } catch (...) {
+                (*batch)->result.set_exception(std::current_exception());
+            }
+        }
+    }
+};
+
+} // namespace
+
+auto import_games(std::string_view data, const std::vector<size_t> &offsets, const ImportOptions &options) -> std::vector<ImportedGame> {
+    std::vector<ImportedGame> results(offsets.size());
+    const auto batch_size = std::max<size_t>(options.batch_size, 1);
+    const auto batch_count = (offsets.size() + batch_size - 1) / batch_size;
+    std::atomic<size_t> next_batch{0};
+
+    const auto work = [&]() {
+        PGNParser parser{std::string_view{}};
+        parser.set_position_cache_policy(options.position_cache_policy);
+        parser.set_tag_pool(worker_tag_pool(options));
+        for (auto batch = next_batch.fetch_add(1); batch < batch_count; batch = next_batch.fetch_add(1)) {
+            const auto last = std::min((batch + 1) * batch_size, offsets.size());
+            for (auto index = batch * batch_size; index < last; ++index) {
+                const auto end = index + 1 < offsets.size() ? offsets[index + 1] : data.size();
+                results[index].offset = offsets[index];
+                import_game(parser, data.substr(offsets[index], end - offsets[index]), results[index]);
+            }
+        }
+    };
+
+    const auto workers = worker_count(options, batch_count);
+    if (workers <= 1) {
+        work();
+        return results;
+    }
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(workers);
+        for (size_t index = 0; index < workers; ++index) {
+            threads.emplace_back(work);
+        }
+    }
+    return results;
+}
+
+auto import_games(std::string_view data, const ImportOptions &options) -> std::vector<ImportedGame> {
+    return import_games(data, scan_game_offsets(data), options);
+}
+
+auto import_games(const PGNDatabase &database, const ImportOptions &options) -> std::vector<ImportedGame> {
+    return import_games(database.data(), database.offsets(), options);
+}
+
+auto import_games(InputSource &input, const ImportConsumer &consumer, const ImportOptions &options) -> size_t {
+    ImportPipeline pipeline{input, options};
+    return pipeline.run(consumer);
+}
+
+auto import_games(std::istream &in_stream, const ImportConsumer &consumer, const ImportOptions &options) -> size_t {
+    StreamInput input{in_stream};
+    return import_games(input, consumer, options);
+}
+
+} // namespace chessgame
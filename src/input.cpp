@@ -0,0 +1,304 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "chessgame/input.h"
+#include "chessgame/types.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#ifdef CHESSGAME_HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CHESSGAME_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace chessgame {
+
+namespace {
+
+constexpr size_t compressed_block_size{64UL * 1024UL};
+constexpr size_t detection_prefix_size{4};
+
+/**
+ * \brief Buffer for the compressed data read from a source.
+ */
+class CompressedBuffer {
+public:
+    explicit CompressedBuffer(std::unique_ptr<InputSource> compressed) : m_compressed{std::move(compressed)}, m_buffer(compressed_block_size) {}
+
+    /**
+     * \brief Make sure, that compressed data is available.
+     *
+     * \return If data is available, nullopt if the source cannot be read.
+     */
+    auto fill() -> std::optional<bool> {
+        if (m_pos < m_size) {
+            return true;
+        }
+        if (m_end_of_input) {
+            return false;
+        }
+        const auto read = m_compressed->read(m_buffer.data(), m_buffer.size());
+        if (!read.has_value()) {
+            return std::nullopt;
+        }
+        m_pos = 0;
+        m_size = *read;
+        m_end_of_input = m_size == 0;
+        return !m_end_of_input;
+    }
+
+    [[nodiscard]] auto data() const -> const char * { return m_buffer.data() + m_pos; }
+    [[nodiscard]] auto available() const -> size_t { return m_size - m_pos; }
+    auto consume(size_t count) -> void { m_pos += count; }
+private:
+    std::unique_ptr<InputSource> m_compressed;
+    std::vector<char> m_buffer;
+    size_t m_pos{0};
+    size_t m_size{0};
+    bool m_end_of_input{false};
+};
+
+} // namespace
+
+auto StreamInput::read(char *buffer, size_t size) -> std::optional<size_t> {
+    const auto prefix_count = std::min(size, m_prefix.size() - m_prefix_pos);
+    std::memcpy(buffer, m_prefix.data() + m_prefix_pos, prefix_count);
+    m_prefix_pos += prefix_count;
+    if (prefix_count == size) {
+        return size;
+    }
+    m_in_stream->read(buffer + prefix_count, static_cast<std::streamsize>(size - prefix_count));
+    if (m_in_stream->bad()) {
+        return std::nullopt;
+    }
+    return prefix_count + static_cast<size_t>(m_in_stream->gcount());
+}
+
+auto MemoryInput::read(char *buffer, size_t size) -> std::optional<size_t> {
+    const auto count = std::min(size, m_data.size());
+    std::memcpy(buffer, m_data.data(), count);
+    m_data.remove_prefix(count);
+    return count;
+}
+
+auto compression_supported(Compression compression) -> bool {
+    switch (compression) {
+    case Compression::None:
+        return true;
+    case Compression::Gzip:
+#ifdef CHESSGAME_HAS_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    case Compression::Zstd:
+#ifdef CHESSGAME_HAS_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+auto detect_compression(std::string_view prefix) -> Compression {
+    if (prefix.starts_with("\x1f\x8b")) {
+        return Compression::Gzip;
+    }
+    if (prefix.starts_with("\x28\xb5\x2f\xfd")) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+#ifdef CHESSGAME_HAS_ZLIB
+
+struct GzipInput::State {
+    explicit State(std::unique_ptr<InputSource> compressed) : input{std::move(compressed)} {
+        // Window size 15, +32 detects the gzip or zlib header automatically.
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+            throw ChessGameError{"Cannot initialize the gzip decompression"};
+        }
+    }
+    State(const State &) = delete;
+    State(State &&) = delete;
+    auto operator=(const State &) -> State & = delete;
+    auto operator=(State &&) -> State & = delete;
+    ~State() { inflateEnd(&stream); }
+
+    CompressedBuffer input;
+    z_stream stream{};
+    bool in_member{false}; ///< If a member has been started, but not finished.
+};
+
+GzipInput::GzipInput(std::unique_ptr<InputSource> compressed) : m_state{std::make_unique<State>(std::move(compressed))} {}
+
+auto GzipInput::read(char *buffer, size_t size) -> std::optional<size_t> {
+    auto &stream = m_state->stream;
+    const auto out_size = static_cast<uInt>(std::min<size_t>(size, std::numeric_limits<uInt>::max()));
+    stream.next_out = reinterpret_cast<Bytef *>(buffer);
+    stream.avail_out = out_size;
+    while (stream.avail_out > 0) {
+        const auto available = m_state->input.fill();
+        if (!available.has_value()) {
+            return std::nullopt;
+        }
+        if (!*available) {
+            if (!m_state->in_member) {
+                break;
+            }
+            // The decompression may still hold output of the consumed data.
+            const auto out_before = stream.avail_out;
+            stream.avail_in = 0;
+            const auto status = inflate(&stream, Z_NO_FLUSH);
+            if (status == Z_STREAM_END) {
+                m_state->in_member = false;
+            } else if ((status != Z_OK && status != Z_BUF_ERROR) || stream.avail_out == out_before) {
+                return std::nullopt; // Truncated data.
+            }
+            continue;
+        }
+        if (!m_state->in_member) {
+            inflateReset(&stream);
+            m_state->in_member = true;
+        }
+        const auto in_size = static_cast<uInt>(std::min<size_t>(m_state->input.available(), std::numeric_limits<uInt>::max()));
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(m_state->input.data()));
+        stream.avail_in = in_size;
+        const auto status = inflate(&stream, Z_NO_FLUSH);
+        m_state->input.consume(in_size - stream.avail_in);
+        if (status == Z_STREAM_END) {
+            m_state->in_member = false;
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            return std::nullopt;
+        }
+    }
+    return out_size - stream.avail_out;
+}
+
+#else
+
+struct GzipInput::State {};
+
+GzipInput::GzipInput(std::unique_ptr<InputSource> /*compressed*/) {
+    throw ChessGameError{"gzip compressed input is not supported"};
+}
+
+auto GzipInput::read(char * /*buffer*/, size_t /*size*/) -> std::optional<size_t> {
+    return std::nullopt;
+}
+
+#endif
+
+GzipInput::~GzipInput() = default;
+
+#ifdef CHESSGAME_HAS_ZSTD
+
+struct ZstdInput::State {
+    explicit State(std::unique_ptr<InputSource> compressed) : input{std::move(compressed)}, stream{ZSTD_createDStream()} {
+        if (stream == nullptr || ZSTD_isError(ZSTD_initDStream(stream)) != 0) {
+            ZSTD_freeDStream(stream);
+            throw ChessGameError{"Cannot initialize the Zstandard decompression"};
+        }
+    }
+    State(const State &) = delete;
+    State(State &&) = delete;
+    auto operator=(const State &) -> State & = delete;
+    auto operator=(State &&) -> State & = delete;
+    ~State() { ZSTD_freeDStream(stream); }
+
+    CompressedBuffer input;
+    ZSTD_DStream *stream;
+    bool in_frame{false}; ///< If a frame has been started, but not finished.
+};
+
+ZstdInput::ZstdInput(std::unique_ptr<InputSource> compressed) : m_state{std::make_unique<State>(std::move(compressed))} {}
+
+auto ZstdInput::read(char *buffer, size_t size) -> std::optional<size_t> {
+    ZSTD_outBuffer out{.dst = buffer, .size = size, .pos = 0};
+    while (out.pos < out.size) {
+        const auto available = m_state->input.fill();
+        if (!available.has_value()) {
+            return std::nullopt;
+        }
+        if (!*available) {
+            if (!m_state->in_frame) {
+                break;
+            }
+            // The decoder may still hold output of the consumed data.
+            const auto out_before = out.pos;
+            ZSTD_inBuffer in{.src = nullptr, .size = 0, .pos = 0};
+            const auto status = ZSTD_decompressStream(m_state->stream, &out, &in);
+            if (ZSTD_isError(status) != 0) {
+                return std::nullopt;
+            }
+            m_state->in_frame = status != 0;
+            if (m_state->in_frame && out.pos == out_before) {
+                return std::nullopt; // Truncated data.
+            }
+            continue;
+        }
+        ZSTD_inBuffer in{.src = m_state->input.data(), .size = m_state->input.available(), .pos = 0};
+        const auto status = ZSTD_decompressStream(m_state->stream, &out, &in);
+        m_state->input.consume(in.pos);
+        if (ZSTD_isError(status) != 0) {
+            return std::nullopt;
+        }
+        m_state->in_frame = status != 0;
+    }
+    return out.pos;
+}
+
+#else
+
+struct ZstdInput::State {};
+
+ZstdInput::ZstdInput(std::unique_ptr<InputSource> /*compressed*/) {
+    throw ChessGameError{"Zstandard compressed input is not supported"};
+}
+
+auto ZstdInput::read(char * /*buffer*/, size_t /*size*/) -> std::optional<size_t> {
+    return std::nullopt;
+}
+
+#endif
+
+ZstdInput::~ZstdInput() = default;
+
+namespace {
+
+auto decompressing_input(Compression compression, std::unique_ptr<InputSource> input) -> std::unique_ptr<InputSource> {
+    switch (compression) {
+    case Compression::Gzip:
+        return std::make_unique<GzipInput>(std::move(input));
+    case Compression::Zstd:
+        return std::make_unique<ZstdInput>(std::move(input));
+    case Compression::None:
+        break;
+    }
+    return input;
+}
+
+} // namespace
+
+auto open_input(std::istream &in_stream) -> std::unique_ptr<InputSource> {
+    std::string prefix(detection_prefix_size, '\0');
+    in_stream.read(prefix.data(), static_cast<std::streamsize>(prefix.size()));
+    prefix.resize(static_cast<size_t>(in_stream.gcount()));
+    const auto compression = detect_compression(prefix);
+    return decompressing_input(compression, std::make_unique<StreamInput>(in_stream, std::move(prefix)));
+}
+
+auto open_input(std::string_view data) -> std::unique_ptr<InputSource> {
+    return decompressing_input(detect_compression(data), std::make_unique<MemoryInput>(data));
+}
+
+} // namespace chessgame
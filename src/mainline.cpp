@@ -0,0 +1,99 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "chessgame/mainline.h"
+
+#include <array>
+
+namespace chessgame {
+
+namespace {
+
+constexpr uint16_t square_mask{0x3FU};
+constexpr unsigned int to_shift{6};
+constexpr unsigned int promoted_shift{12};
+constexpr std::array promotion_types{chesscore::PieceType::Knight, chesscore::PieceType::Bishop, chesscore::PieceType::Rook, chesscore::PieceType::Queen};
+
+auto promotion_code(chesscore::PieceType type) -> uint16_t {
+    for (size_t index = 0; index < promotion_types.size(); ++index) {
+        if (promotion_types[index] == type) {
+            return static_cast<uint16_t>(index + 1);
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+auto encode_compact_move(const chesscore::Move &move) -> uint16_t {
+    auto code = static_cast<unsigned int>(square_index(move.from)) | (static_cast<unsigned int>(square_index(move.to)) << to_shift);
+    if (move.promoted.has_value()) {
+        code |= static_cast<unsigned int>(promotion_code(move.promoted->type)) << promoted_shift;
+    }
+    return static_cast<uint16_t>(code);
+}
+
+auto decode_compact_move(uint16_t code, const Board &board) -> std::optional<chesscore::Move> {
+    const auto from = static_cast<int>(code & square_mask);
+    const auto to = static_cast<int>((code >> to_shift) & square_mask);
+    const auto piece = board.piece_at(from);
+    if (!piece.has_value() || piece->color != board.side_to_move()) {
+        return std::nullopt;
+    }
+    chesscore::Move move{.from = index_square(from), .to = index_square(to), .piece = *piece};
+    move.captured = board.piece_at(to);
+    if (piece->type == chesscore::PieceType::Pawn && to == board.en_passant_index() && from % 8 != to % 8) {
+        move.captured = chesscore::Piece{.type = chesscore::PieceType::Pawn, .color = chesscore::other_color(piece->color)};
+        move.capturing_en_passant = true;
+    }
+    if (const auto promoted = static_cast<size_t>(code >> promoted_shift); promoted != 0) {
+        if (promoted > promotion_types.size()) {
+            return std::nullopt;
+        }
+        move.promoted = chesscore::Piece{.type = promotion_types[promoted - 1], .color = piece->color};
+    }
+    return move;
+}
+
+auto MainlineGame::from_game(const Game &game) -> MainlineGame {
+    MainlineGame result{game.metadata()};
+    for (const auto node : game.view().mainline()) {
+        result.append_move(node.move());
+    }
+    return result;
+}
+
+auto MainlineGame::to_game() const -> Game {
+    Game game{m_metadata};
+    auto cursor = game.edit();
+    for (const auto &move : moves()) {
+        cursor = cursor.play_move(move);
+    }
+    return game;
+}
+
+auto MainlineGame::start_board() const -> std::optional<Board> {
+    return chessgame::start_board(m_metadata);
+}
+
+auto MainlineGame::moves() const -> std::vector<chesscore::Move> {
+    auto board = start_board();
+    if (!board.has_value()) {
+        throw ChessGameError{"Invalid start position of main line game"};
+    }
+    std::vector<chesscore::Move> result;
+    result.reserve(m_moves.size());
+    for (const auto code : m_moves) {
+        const auto move = decode_compact_move(code, *board);
+        if (!move.has_value()) {
+            throw ChessGameError{"Invalid move in main line game"};
+        }
+        board->make_move(*move);
+        result.push_back(*move);
+    }
+    return result;
+}
+
+} // namespace chessgame
@@ -9,22 +9,186 @@
 
 namespace chessgame {
 
-const std::array<std::string, 7> GameMetadata::str_tags{"Event", "Site", "Date", "Round", "White", "Black", "Result"};
+namespace {
 
-auto GameMetadata::is_str_tag(const std::string &name) -> bool {
-    return std::find(std::begin(str_tags), std::end(str_tags), name) != str_tags.end();
+constexpr size_t buffer_size{256};
+
+} // namespace
+
+auto TagPool::intern(std::string_view str) -> std::optional<std::string_view> {
+    const auto hash = string_hash{}(str);
+    auto &shard = m_shards[hash % shard_count];
+    const std::scoped_lock lock{shard.mutex};
+    const auto entry = shard.strings.find(str);
+    if (entry != shard.strings.end()) {
+        return *entry;
+    }
+    if (m_bytes.fetch_add(str.size()) + str.size() > m_max_bytes) {
+        m_bytes.fetch_sub(str.size());
+        return std::nullopt;
+    }
+    return *shard.strings.emplace(str).first;
+}
+
+auto TagPool::size() const -> size_t {
+    size_t count{0};
+    for (const auto &shard : m_shards) {
+        const std::scoped_lock lock{shard.mutex};
+        count += shard.strings.size();
+    }
+    return count;
+}
+
+auto TagPool::memory_usage() const -> size_t {
+    size_t bytes{0};
+    for (const auto &shard : m_shards) {
+        const std::scoped_lock lock{shard.mutex};
+        bytes += table_bytes(shard.strings);
+        for (const auto &str : shard.strings) {
+            bytes += heap_bytes(str);
+        }
+    }
+    return bytes;
 }
 
-auto GameMetadata::is_str_tag(const metadata_tag &tag) -> bool {
-    return is_str_tag(tag.name);
+GameMetadata::GameMetadata(const GameMetadata &other, std::pmr::memory_resource *resource) : m_tags{resource}, m_buffers{resource} {
+    *this = other;
 }
 
-auto GameMetadata::get(const std::string &name) const -> std::optional<std::string> {
-    const auto tag = std::find_if(std::begin(*this), std::end(*this), [&name](const metadata_tag &search_tag) { return search_tag.name == name; });
-    if (tag == end()) {
+// The moved-from metadata is empty, so that no STR slot refers to a moved tag.
+GameMetadata::GameMetadata(GameMetadata &&other) noexcept
+    : m_pool{std::move(other.m_pool)}, m_tags{std::move(other.m_tags)}, m_buffers{std::move(other.m_buffers)},
+      m_buffer_index{std::exchange(other.m_buffer_index, 0)}, m_str_slots{std::exchange(other.m_str_slots, {})} {}
+
+auto GameMetadata::operator=(const GameMetadata &other) -> GameMetadata & {
+    if (this == &other) {
+        return *this;
+    }
+    reset(other.m_pool);
+    m_tags.reserve(other.m_tags.size());
+    for (const auto &tag : other.m_tags) {
+        add(tag.name, tag.value);
+    }
+    return *this;
+}
+
+auto GameMetadata::operator=(GameMetadata &&other) -> GameMetadata & {
+    if (memory_resource() != other.memory_resource()) {
+        // The buffers would be copied into the own memory resource, invalidating the views of the tags.
+        return *this = std::as_const(other);
+    }
+    m_pool = std::move(other.m_pool);
+    m_tags = std::move(other.m_tags);
+    m_buffers = std::move(other.m_buffers);
+    m_buffer_index = std::exchange(other.m_buffer_index, 0);
+    m_str_slots = std::exchange(other.m_str_slots, {});
+    return *this;
+}
+
+auto GameMetadata::str_tag_index(std::string_view name) -> std::optional<size_t> {
+    size_t index{0};
+    switch (name.empty() ? '\0' : name.front()) {
+    case 'E':
+        index = 0;
+        break;
+    case 'S':
+        index = 1;
+        break;
+    case 'D':
+        index = 2;
+        break;
+    case 'R':
+        index = name.size() == str_tags[3].size() ? 3 : 6;
+        break;
+    case 'W':
+        index = 4;
+        break;
+    case 'B':
+        index = 5;
+        break;
+    default:
+        return std::nullopt;
+    }
+    if (name != str_tags[index]) {
+        return std::nullopt;
+    }
+    return index;
+}
+
+auto GameMetadata::reset(std::shared_ptr<TagPool> pool) -> void {
+    m_pool = std::move(pool);
+    m_tags.clear();
+    for (auto &buffer : m_buffers) {
+        buffer.clear();
+    }
+    m_buffer_index = 0;
+    m_str_slots = {};
+}
+
+auto GameMetadata::memory_usage() const -> MemoryUsage {
+    MemoryUsage usage{};
+    usage.metadata_bytes = heap_bytes(m_tags) + heap_bytes(m_buffers);
+    for (const auto &buffer : m_buffers) {
+        usage.metadata_bytes += heap_bytes(buffer);
+    }
+    usage.tag_pool_bytes = m_pool ? m_pool->memory_usage() : 0;
+    return usage;
+}
+
+auto GameMetadata::get(std::string_view name) const -> std::optional<std::string_view> {
+    if (const auto str_index = str_tag_index(name); str_index.has_value()) {
+        const auto slot = m_str_slots[str_index.value()];
+        if (slot == 0) {
+            return std::nullopt;
+        }
+        return m_tags[slot - 1].value;
+    }
+    const auto tag = std::ranges::find_if(m_tags, [&name](const metadata_tag &search_tag) { return search_tag.name == name; });
+    if (tag == m_tags.end()) {
         return std::nullopt;
     }
     return tag->value;
 }
 
+auto GameMetadata::add(std::string_view name, std::string_view value) -> void {
+    const auto stored_name = store(name);
+    m_tags.emplace_back(stored_name, store(value));
+    if (const auto str_index = str_tag_index(name); str_index.has_value() && m_str_slots[str_index.value()] == 0) {
+        m_str_slots[str_index.value()] = static_cast<uint32_t>(m_tags.size());
+    }
+}
+
+auto GameMetadata::set(std::string_view name, std::string_view value) -> void {
+    const auto tag = std::ranges::find_if(m_tags, [&name](const metadata_tag &search_tag) { return search_tag.name == name; });
+    if (tag == m_tags.end()) {
+        add(name, value);
+    } else {
+        tag->value = store(value);
+    }
+}
+
+auto GameMetadata::store(std::string_view str) -> std::string_view {
+    if (str.empty()) {
+        return {};
+    }
+    if (m_pool) {
+        if (const auto interned = m_pool->intern(str); interned.has_value()) {
+            return interned.value();
+        }
+    }
+    // Strings are only appended within the capacity of a buffer, so that views to them stay valid.
+    for (; m_buffer_index < m_buffers.size(); ++m_buffer_index) {
+        auto &buffer = m_buffers[m_buffer_index];
+        if (buffer.capacity() - buffer.size() >= str.size()) {
+            const auto offset = buffer.size();
+            buffer.append(str);
+            return std::string_view{buffer}.substr(offset);
+        }
+    }
+    auto &buffer = m_buffers.emplace_back();
+    buffer.reserve(std::max(str.size(), buffer_size));
+    buffer.append(str);
+    return buffer;
+}
+
 } // namespace chessgame
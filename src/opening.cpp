@@ -0,0 +1,313 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "chessgame/opening.h"
+
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include "chessgame/binary.h"
+#include "chessgame/types.h"
+#include "serialization.h"
+
+namespace chessgame {
+
+using serialization::append_u32;
+using serialization::append_u64;
+using serialization::append_varint;
+
+namespace {
+
+constexpr std::string_view opening_magic{"CGOT"};
+
+constexpr std::string_view corrupted_message{"Corrupted opening tree snapshot"};
+
+[[noreturn]] auto corrupted_snapshot() -> void {
+    throw ChessGameError{std::string{corrupted_message}};
+}
+
+auto parse_rating(std::optional<std::string_view> value) -> std::optional<uint64_t> {
+    if (!value.has_value()) {
+        return std::nullopt;
+    }
+    uint64_t rating{0};
+    const auto *end = value->data() + value->size();
+    const auto [ptr, ec] = std::from_chars(value->data(), end, rating);
+    if (ec != std::errc{} || ptr != end || rating == 0) {
+        return std::nullopt;
+    }
+    return rating;
+}
+
+auto game_stats(const GameMetadata &metadata, std::string_view rating_tag) -> OpeningStats {
+    OpeningStats stats{.games = 1};
+    const auto result = metadata.get("Result");
+    if (result == "1-0") {
+        stats.white_wins = 1;
+    } else if (result == "0-1") {
+        stats.black_wins = 1;
+    } else if (result == "1/2-1/2") {
+        stats.draws = 1;
+    }
+    if (const auto rating = parse_rating(metadata.get(rating_tag)); rating.has_value()) {
+        stats.rating_sum = *rating;
+        stats.rated_games = 1;
+    }
+    return stats;
+}
+
+struct VisitedPosition {
+    uint64_t key;
+    chesscore::Color side_to_move;
+};
+
+struct PlayedMove {
+    uint64_t from;
+    uint64_t to;
+    chesscore::Move move;
+};
+
+auto append_stats(std::string &out, const OpeningStats &stats) -> void {
+    for (const auto value : {stats.games, stats.white_wins, stats.draws, stats.black_wins, stats.rating_sum, stats.rated_games}) {
+        append_varint(out, value);
+    }
+}
+
+/**
+ * \brief Decoder for opening tree snapshots.
+ */
+class SnapshotDecoder : public serialization::ByteDecoder {
+public:
+    explicit SnapshotDecoder(std::string_view data) : ByteDecoder{data, corrupted_message} {}
+
+    auto read_stats() -> OpeningStats {
+        OpeningStats stats;
+        for (auto *value : {&stats.games, &stats.white_wins, &stats.draws, &stats.black_wins, &stats.rating_sum, &stats.rated_games}) {
+            *value = read_varint();
+        }
+        return stats;
+    }
+};
+
+} // namespace
+
+auto OpeningStats::white_score() const -> std::optional<double> {
+    const auto decided = white_wins + draws + black_wins;
+    if (decided == 0) {
+        return std::nullopt;
+    }
+    return (static_cast<double>(white_wins) + 0.5 * static_cast<double>(draws)) / static_cast<double>(decided);
+}
+
+auto OpeningStats::average_rating() const -> std::optional<double> {
+    if (rated_games == 0) {
+        return std::nullopt;
+    }
+    return static_cast<double>(rating_sum) / static_cast<double>(rated_games);
+}
+
+auto OpeningStats::operator+=(const OpeningStats &other) -> OpeningStats & {
+    games += other.games;
+    white_wins += other.white_wins;
+    draws += other.draws;
+    black_wins += other.black_wins;
+    rating_sum += other.rating_sum;
+    rated_games += other.rated_games;
+    return *this;
+}
+
+OpeningTree::OpeningTree(const OpeningTreeOptions &options) : m_options{options} {}
+
+auto OpeningTree::shard(uint64_t key) const -> Shard & {
+    // The high bits of the key select the shard, the hash table of the shard
+    // uses the low bits for its buckets.
+    return m_storage->shards[static_cast<size_t>(key >> 58U) % shard_count];
+}
+
+auto OpeningTree::add_game(const Game &game) -> void {
+    const auto &tree = game.tree();
+    const auto root_board = game.board(GameTree::root_id);
+    if (!root_board.has_value() || tree.node(GameTree::root_id).key() == 0) {
+        return;
+    }
+
+    std::vector<VisitedPosition> positions;
+    std::vector<PlayedMove> moves;
+    std::vector<NodeId> pending{GameTree::root_id};
+    while (!pending.empty()) {
+        const auto node_id = pending.back();
+        pending.pop_back();
+        const auto &node = tree.node(node_id);
+        const auto side_to_move = node.ply() % 2 == 0 ? root_board->side_to_move() : chesscore::other_color(root_board->side_to_move());
+        positions.push_back(VisitedPosition{.key = node.key(), .side_to_move = side_to_move});
+        if (m_options.max_ply != 0 && node.ply() >= m_options.max_ply) {
+            continue;
+        }
+        for (auto child = node.first_child(); child != NodeId::Invalid; child = tree.node(child).next_sibling()) {
+            const auto &child_node = tree.node(child);
+            moves.push_back(PlayedMove{.from = node.key(), .to = child_node.key(), .move = child_node.move()});
+            pending.push_back(child);
+            if (!m_options.include_variations) {
+                break;
+            }
+        }
+    }
+
+    // A game counts only once for every position and move, even if it
+    // reaches them repeatedly or in several variations.
+    std::ranges::sort(positions, {}, &VisitedPosition::key);
+    const auto [positions_end, positions_last] = std::ranges::unique(positions, {}, &VisitedPosition::key);
+    positions.erase(positions_end, positions_last);
+    const auto move_order = [](const PlayedMove &move) { return std::tie(move.from, move.to); };
+    std::ranges::sort(moves, {}, move_order);
+    const auto [moves_end, moves_last] = std::ranges::unique(moves, {}, move_order);
+    moves.erase(moves_end, moves_last);
+
+    const auto &metadata = game.metadata();
+    const auto white_stats = game_stats(metadata, "WhiteElo");
+    const auto black_stats = game_stats(metadata, "BlackElo");
+    const auto stats_for = [&](chesscore::Color color) -> const OpeningStats & { return color == chesscore::Color::White ? white_stats : black_stats; };
+
+    for (const auto &position : positions) {
+        auto &position_shard = shard(position.key);
+        const std::scoped_lock lock{position_shard.mutex};
+        position_shard.positions[position.key].stats += stats_for(position.side_to_move);
+    }
+    for (const auto &played : moves) {
+        auto &position_shard = shard(played.from);
+        const std::scoped_lock lock{position_shard.mutex};
+        auto &edges = position_shard.positions[played.from].moves;
+        auto edge = std::ranges::find(edges, played.to, &OpeningMove::key);
+        if (edge == edges.end()) {
+            edge = edges.insert(edges.end(), OpeningMove{.move = played.move, .key = played.to, .stats = {}});
+        }
+        edge->stats += stats_for(played.move.piece.color);
+    }
+    ++m_storage->game_count;
+}
+
+auto OpeningTree::add_games(const std::vector<ImportedGame> &games) -> void {
+    for (const auto &imported : games) {
+        if (imported.game.has_value()) {
+            add_game(*imported.game);
+        }
+    }
+}
+
+auto OpeningTree::position_count() const -> size_t {
+    size_t count{0};
+    for (const auto &position_shard : m_storage->shards) {
+        const std::scoped_lock lock{position_shard.mutex};
+        count += position_shard.positions.size();
+    }
+    return count;
+}
+
+auto OpeningTree::stats(uint64_t key) const -> std::optional<OpeningStats> {
+    const auto &position_shard = shard(key);
+    const std::scoped_lock lock{position_shard.mutex};
+    const auto entry = position_shard.positions.find(key);
+    if (entry == position_shard.positions.end()) {
+        return std::nullopt;
+    }
+    return entry->second.stats;
+}
+
+auto OpeningTree::moves(uint64_t key) const -> std::vector<OpeningMove> {
+    std::vector<OpeningMove> result;
+    {
+        const auto &position_shard = shard(key);
+        const std::scoped_lock lock{position_shard.mutex};
+        const auto entry = position_shard.positions.find(key);
+        if (entry == position_shard.positions.end()) {
+            return result;
+        }
+        result = entry->second.moves;
+    }
+    std::ranges::sort(result, [](const OpeningMove &lhs, const OpeningMove &rhs) { return lhs.stats.games != rhs.stats.games ? lhs.stats.games > rhs.stats.games : lhs.key < rhs.key; });
+    return result;
+}
+
+auto OpeningTree::write(std::ostream &out_stream) const -> void {
+    std::vector<std::pair<uint64_t, const Position *>> positions;
+    for (const auto &position_shard : m_storage->shards) {
+        const std::scoped_lock lock{position_shard.mutex};
+        for (const auto &[key, position] : position_shard.positions) {
+            positions.emplace_back(key, &position);
+        }
+    }
+    std::ranges::sort(positions, {}, &std::pair<uint64_t, const Position *>::first);
+
+    std::string data{opening_magic};
+    append_u32(data, opening_tree_format_version);
+    append_varint(data, m_storage->game_count.load());
+    append_varint(data, positions.size());
+    std::vector<const OpeningMove *> edges;
+    for (const auto &[key, position] : positions) {
+        append_u64(data, key);
+        append_stats(data, position->stats);
+        edges.clear();
+        for (const auto &edge : position->moves) {
+            edges.push_back(&edge);
+        }
+        std::ranges::sort(edges, {}, &OpeningMove::key);
+        append_varint(data, edges.size());
+        for (const auto *edge : edges) {
+            append_varint(data, encode_move(edge->move));
+            append_u64(data, edge->key);
+            append_stats(data, edge->stats);
+        }
+    }
+    out_stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+auto OpeningTree::read(std::istream &in_stream, const OpeningTreeOptions &options) -> OpeningTree {
+    const std::string data{std::istreambuf_iterator<char>{in_stream}, std::istreambuf_iterator<char>{}};
+    if (!data.starts_with(opening_magic) || data.size() < opening_magic.size() + 4) {
+        throw ChessGameError{"Not an opening tree snapshot"};
+    }
+    SnapshotDecoder decoder{std::string_view{data}.substr(opening_magic.size())};
+    const auto version = decoder.read_u32();
+    if (version == 0 || version > opening_tree_format_version) {
+        throw ChessGameError{"Unsupported opening tree format version " + std::to_string(version)};
+    }
+
+    OpeningTree tree{options};
+    tree.m_storage->game_count = decoder.read_varint();
+    const auto position_count = decoder.read_size();
+    for (size_t index = 0; index < position_count; ++index) {
+        const auto key = decoder.read_u64();
+        const auto [entry, inserted] = tree.shard(key).positions.try_emplace(key);
+        if (!inserted) {
+            corrupted_snapshot();
+        }
+        auto &position = entry->second;
+        position.stats = decoder.read_stats();
+        position.moves.resize(decoder.read_size());
+        for (auto &edge : position.moves) {
+            const auto code = decoder.read_varint();
+            if (code > 0xFFFFFFFFU) {
+                corrupted_snapshot();
+            }
+            edge.move = decode_move(static_cast<uint32_t>(code));
+            edge.key = decoder.read_u64();
+            edge.stats = decoder.read_stats();
+        }
+        // The moves are written in ascending order of their keys, so a move is never repeated.
+        if (std::ranges::adjacent_find(position.moves, std::ranges::greater_equal{}, &OpeningMove::key) != position.moves.end()) {
+            corrupted_snapshot();
+        }
+    }
+    if (!decoder.at_end()) {
+        corrupted_snapshot();
+    }
+    return tree;
+}
+
+} // namespace chessgame
@@ -7,38 +7,168 @@
 #include "chessgame/san.h"
 
 #include <algorithm>
+#include <bit>
 #include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 #include <istream>
 #include <ranges>
-#include <set>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHESSGAME_PGN_SCAN_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CHESSGAME_PGN_SCAN_NEON
+#endif
 
 namespace chessgame {
 
 namespace {
 
-auto split_into_words(std::string string, std::string delimiter) -> std::vector<std::string> {
-    std::size_t pos_start{0};
-    std::size_t pos_end{};
-    std::size_t delim_len{delimiter.length()};
-    std::string word;
-    std::vector<std::string> words;
+constexpr uint8_t symbol_class{1U << 0U};
+constexpr uint8_t digit_class{1U << 1U};
+constexpr uint8_t letter_class{1U << 2U};
+constexpr uint8_t whitespace_class{1U << 3U};
 
-    while ((pos_end = string.find(delimiter, pos_start)) != std::string::npos) {
-        word = string.substr(pos_start, pos_end - pos_start);
-        pos_start = pos_end + delim_len;
-        words.push_back(word);
+constexpr auto make_char_classes() -> std::array<uint8_t, 256> {
+    std::array<uint8_t, 256> classes{};
+    for (char c = 'a'; c <= 'z'; ++c) {
+        classes[static_cast<unsigned char>(c)] = symbol_class | letter_class;
+    }
+    for (char c = 'A'; c <= 'Z'; ++c) {
+        classes[static_cast<unsigned char>(c)] = symbol_class | letter_class;
+    }
+    for (char c = '0'; c <= '9'; ++c) {
+        classes[static_cast<unsigned char>(c)] = symbol_class | digit_class;
     }
+    for (const char c : std::string_view{"-/+#=?!"}) {
+        classes[static_cast<unsigned char>(c)] = symbol_class;
+    }
+    for (const char c : std::string_view{" \t\n\r"}) {
+        classes[static_cast<unsigned char>(c)] = whitespace_class;
+    }
+    return classes;
+}
+
+constexpr std::array<uint8_t, 256> char_classes = make_char_classes();
+
+/// Check the class of a character; end_of_input does not belong to any class.
+auto has_class(int character, uint8_t char_class) -> bool {
+    return character >= 0 && (char_classes[static_cast<size_t>(character)] & char_class) != 0;
+}
+
+/// Result of scanning a range of characters.
+struct ScanResult {
+    const char *stop;          ///< The first character, that stopped the scan, or the end of the range.
+    int newlines;              ///< Number of newlines before the stop character.
+    bool irregular_whitespace; ///< If there are whitespace characters other than spaces before the stop character.
+};
+
+#if defined(CHESSGAME_PGN_SCAN_SSE2)
+
+using Block = __m128i;
+constexpr ptrdiff_t block_size{16};
+constexpr int mask_bits_per_byte{1};
+constexpr uint64_t full_block_mask{0xFFFFU};
+
+auto load_block(const char *data) -> Block {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+}
+
+auto byte_mask(Block block, char character) -> uint64_t {
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(character))));
+}
+
+#elif defined(CHESSGAME_PGN_SCAN_NEON)
+
+using Block = uint8x16_t;
+constexpr ptrdiff_t block_size{16};
+constexpr int mask_bits_per_byte{4};
+constexpr uint64_t full_block_mask{~uint64_t{0}};
+
+auto load_block(const char *data) -> Block {
+    return vld1q_u8(reinterpret_cast<const uint8_t *>(data));
+}
 
-    words.push_back(string.substr(pos_start));
-    return words;
+auto byte_mask(Block block, char character) -> uint64_t {
+    const auto equal = vceqq_u8(block, vdupq_n_u8(static_cast<uint8_t>(character)));
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal), 4)), 0);
 }
 
-auto lower_case(const std::string &str) -> std::string {
+#endif
+
+/// What stops scanning a range of characters.
+enum class ScanStop {
+    NonWhitespace, ///< Any character, that is not whitespace.
+    Delimiter,     ///< A given delimiter character.
+};
+
+/**
+ * Scan characters until a stop character is found.
+ *
+ * With SIMD support, the characters are classified a block at a time and only
+ * the tail of the range is scanned character by character.
+ */
+template<ScanStop Stop>
+auto scan(const char *pos, const char *end, [[maybe_unused]] char delimiter = '\0') -> ScanResult {
+    ScanResult result{.stop = pos, .newlines = 0, .irregular_whitespace = false};
+#if defined(CHESSGAME_PGN_SCAN_SSE2) || defined(CHESSGAME_PGN_SCAN_NEON)
+    while (end - pos >= block_size) {
+        const auto block = load_block(pos);
+        auto newlines = byte_mask(block, '\n');
+        auto irregular = newlines | byte_mask(block, '\t') | byte_mask(block, '\r');
+        uint64_t stops{0};
+        if constexpr (Stop == ScanStop::NonWhitespace) {
+            stops = ~(irregular | byte_mask(block, ' ')) & full_block_mask;
+        } else {
+            stops = byte_mask(block, delimiter);
+        }
+        if (stops != 0) {
+            const auto before_stop = (uint64_t{1} << std::countr_zero(stops)) - 1;
+            result.newlines += std::popcount(newlines & before_stop) / mask_bits_per_byte;
+            result.irregular_whitespace = result.irregular_whitespace || (irregular & before_stop) != 0;
+            result.stop = pos + std::countr_zero(stops) / mask_bits_per_byte;
+            return result;
+        }
+        result.newlines += std::popcount(newlines) / mask_bits_per_byte;
+        result.irregular_whitespace = result.irregular_whitespace || irregular != 0;
+        pos += block_size;
+    }
+#endif
+    for (; pos != end; ++pos) {
+        const auto character = static_cast<unsigned char>(*pos);
+        const bool whitespace = has_class(character, whitespace_class);
+        if constexpr (Stop == ScanStop::NonWhitespace) {
+            if (!whitespace) {
+                break;
+            }
+        } else {
+            if (*pos == delimiter) {
+                break;
+            }
+        }
+        if (character == '\n') {
+            ++result.newlines;
+        }
+        result.irregular_whitespace = result.irregular_whitespace || (whitespace && character != ' ');
+    }
+    result.stop = pos;
+    return result;
+}
+
+auto lower_case(std::string_view str) -> std::string {
     std::string result{str};
     std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return std::tolower(c); });
     return result;
 }
 
+auto fullmove_number(const GameMetadata &metadata) -> int {
+    const auto fen_tag = metadata.get("FEN");
+    return fen_tag.has_value() ? chesscore::Position{chesscore::FenString{std::string{fen_tag.value()}}}.fullmove_number() : 1;
+}
+
 } // namespace
 
 auto to_string(PGNLexer::TokenType type) -> std::string {
@@ -95,6 +225,10 @@ auto to_string(PGNErrorType type) -> std::string {
         return "cannot start RAV";
     case PGNErrorType::NoPenRav:
         return "no pending RAV";
+    case PGNErrorType::InvalidGame:
+        return "invalid game";
+    case PGNErrorType::InvalidFen:
+        return "invalid FEN";
     }
     return "UNKNOWN ERROR!";
 }
@@ -111,224 +245,580 @@ auto to_string(PGNWarningType type) -> std::string {
     return "UNKNOWN WARNING!";
 }
 
+auto to_string(PGNStage stage) -> std::string {
+    switch (stage) {
+    case PGNStage::Lexing:
+        return "lexing";
+    case PGNStage::SANParsing:
+        return "SAN parsing";
+    case PGNStage::MoveResolution:
+        return "move resolution";
+    case PGNStage::TreeBuilding:
+        return "tree building";
+    case PGNStage::PositionReplay:
+        return "position replay";
+    case PGNStage::SANGeneration:
+        return "SAN generation";
+    }
+    return "UNKNOWN STAGE!";
+}
+
+PGNLexer::PGNLexer(std::istream *in_stream, size_t block_size) : PGNLexer{std::make_unique<StreamInput>(*in_stream), block_size} {}
+
+PGNLexer::PGNLexer(std::unique_ptr<InputSource> source, size_t block_size) : m_source{std::move(source)}, m_buffer(std::max<size_t>(block_size, 1)) {
+    m_begin = m_buffer.data();
+    m_pos = m_begin;
+    m_end = m_begin;
+    m_token_start = m_begin;
+}
+
+PGNLexer::PGNLexer(std::string_view input) : m_begin{input.data()}, m_pos{input.data()}, m_end{input.data() + input.size()}, m_token_start{input.data()} {}
+
+auto PGNLexer::fill_buffer() -> bool {
+    if (m_source == nullptr) {
+        return false;
+    }
+    if (m_capture != nullptr) {
+        m_capture->append(m_capture_start, m_token_start);
+    }
+    const auto kept_offset = static_cast<size_t>(m_token_start - m_begin);
+    const auto kept = static_cast<size_t>(m_end - m_token_start);
+    const auto token_position = static_cast<size_t>(m_pos - m_token_start);
+    if (kept == m_buffer.size()) {
+        m_buffer.resize(m_buffer.size() * 2);
+    }
+    if (kept_offset > 0) {
+        std::memmove(m_buffer.data(), m_buffer.data() + kept_offset, kept);
+    }
+    const auto read_result = m_source->read(m_buffer.data() + kept, m_buffer.size() - kept);
+    if (!read_result.has_value()) {
+        throw PGNError{PGNErrorType::InputError, m_line_number};
+    }
+    const auto read = *read_result;
+    m_begin_offset += kept_offset;
+    m_begin = m_buffer.data();
+    m_token_start = m_begin;
+    m_pos = m_token_start + token_position;
+    m_end = m_token_start + kept + read;
+    m_capture_start = m_token_start;
+    return read > 0;
+}
+
+auto PGNLexer::make_token(TokenType type, std::string_view value) const -> Token {
+    return Token{.type = type, .line = m_line_number, .value = value, .offset = m_begin_offset + static_cast<size_t>(m_token_start - m_begin)};
+}
+
+auto PGNLexer::token_value(size_t prefix_length, size_t suffix_length) const -> std::string_view {
+    const auto *begin = m_token_start + prefix_length;
+    return {begin, static_cast<size_t>(m_pos - begin) - suffix_length};
+}
+
 auto PGNLexer::next_token() -> Token {
-    int character = m_in_stream->get();
-    if (is_whitespace(static_cast<char>(character))) {
-        skip_whitespace(character);
-        character = m_in_stream->get();
+    skip_whitespace();
+    const int character = get();
+    if (character == end_of_input) {
+        return make_token(TokenType::EndOfInput, {});
     }
-    while (!m_in_stream->bad()) {
-        if (character == std::istream::traits_type::eof()) {
-            return Token{.type = TokenType::EndOfInput, .line = m_line_number, .value = ""};
-        }
-        if (std::isdigit(character) != 0) {
-            return read_token_starting_with_number(static_cast<char>(character));
-        }
-        if (std::isalpha(character) != 0) {
-            return read_symbol(static_cast<char>(character));
-        }
-        switch (character) {
-        case '[':
-            return Token{.type = TokenType::OpenBracket, .line = m_line_number, .value = ""};
-        case ']':
-            return Token{.type = TokenType::CloseBracket, .line = m_line_number, .value = ""};
-        case '$':
-            return read_nag();
-        case '.':
-            return Token{.type = TokenType::Dot, .line = m_line_number, .value = ""};
-        case '"':
-            return read_string();
-        case '(':
-            return Token{.type = TokenType::OpenParen, .line = m_line_number, .value = ""};
-        case ')':
-            return Token{.type = TokenType::CloseParen, .line = m_line_number, .value = ""};
-        case '{':
-            return read_comment();
-        case '*':
-            return Token{.type = TokenType::GameResult, .line = m_line_number, .value = "*"};
-        default:
-            return Token{.type = TokenType::Invalid, .line = m_line_number, .value = std::string{static_cast<char>(character)}};
-        }
+    if (has_class(character, digit_class)) {
+        return read_token_starting_with_number();
+    }
+    if (has_class(character, letter_class)) {
+        return read_symbol();
+    }
+    switch (character) {
+    case '[':
+        return make_token(TokenType::OpenBracket, {});
+    case ']':
+        return make_token(TokenType::CloseBracket, {});
+    case '$':
+        return read_nag();
+    case '.':
+        return make_token(TokenType::Dot, {});
+    case '"':
+        return read_string();
+    case '(':
+        return make_token(TokenType::OpenParen, {});
+    case ')':
+        return make_token(TokenType::CloseParen, {});
+    case '{':
+        return read_comment();
+    case '*':
+        return make_token(TokenType::GameResult, token_value(0));
+    default:
+        return make_token(TokenType::Invalid, token_value(0));
     }
-    throw PGNError{PGNErrorType::InputError, m_line_number};
 }
 
 auto PGNLexer::is_whitespace(char character) -> bool {
-    return character == ' ' || character == '\t' || character == '\n' || character == '\r';
+    return has_class(static_cast<unsigned char>(character), whitespace_class);
 }
 
-auto PGNLexer::skip_whitespace(int character) -> void {
-    while (!m_in_stream->bad() && (character == ' ' || character == '\t' || character == '\n' || character == '\r')) {
-        if (character == '\n') {
-            m_line_number++;
+auto PGNLexer::skip_whitespace() -> void {
+    while (true) {
+        const auto result = scan<ScanStop::NonWhitespace>(m_pos, m_end);
+        m_line_number += result.newlines;
+        m_pos = result.stop;
+        m_token_start = m_pos;
+        if (m_pos != m_end || !fill_buffer()) {
+            return;
         }
-        character = m_in_stream->get();
     }
-    if (!m_in_stream->bad()) {
-        m_in_stream->unget();
-    } else {
-        throw PGNError{PGNErrorType::InputError, m_line_number};
+}
+
+auto PGNLexer::scan_to_delimiter(char delimiter, bool &irregular_whitespace) -> bool {
+    while (true) {
+        const auto result = scan<ScanStop::Delimiter>(m_pos, m_end, delimiter);
+        m_line_number += result.newlines;
+        irregular_whitespace = irregular_whitespace || result.irregular_whitespace;
+        m_pos = result.stop;
+        if (m_pos != m_end) {
+            ++m_pos;
+            return true;
+        }
+        if (!fill_buffer()) {
+            return false;
+        }
     }
 }
 
 auto PGNLexer::read_string() -> Token {
-    std::string result{};
-    int character = m_in_stream->get();
-    while (!m_in_stream->bad() && character != '"') {
-        result += static_cast<char>(character);
-        character = m_in_stream->get();
-    }
-    if (m_in_stream->bad()) {
-        throw PGNError{PGNErrorType::InputError, m_line_number};
-    }
-    return Token{.type = TokenType::String, .line = m_line_number, .value = result};
+    bool irregular_whitespace{false};
+    const bool closed = scan_to_delimiter('"', irregular_whitespace);
+    return make_token(TokenType::String, token_value(1, closed ? 1 : 0));
 }
 
-auto PGNLexer::read_token_starting_with_number(char first_c) -> Token {
-    std::string result{first_c};
-    int character = m_in_stream->get();
+auto PGNLexer::read_token_starting_with_number() -> Token {
     bool only_numbers = true;
-    while (!m_in_stream->bad()) {
-        while (!m_in_stream->bad() && (std::isdigit(character) != 0)) {
-            result += static_cast<char>(character);
-            character = m_in_stream->get();
-        }
-        if (m_in_stream->bad()) {
-            if (m_in_stream->eof()) {
-                break;
-            }
-            throw PGNError{PGNErrorType::InputError, m_line_number};
+    while (true) {
+        while (has_class(peek(), digit_class)) {
+            ++m_pos;
         }
+        const auto character = peek();
         if (character == '/' || character == '-') {
             only_numbers = false;
-            result += static_cast<char>(character);
-            character = m_in_stream->get();
+            ++m_pos;
         } else {
             break;
         }
     }
-    m_in_stream->unget();
+    const auto result = token_value(0);
     if (only_numbers) {
-        return Token{.type = TokenType::Number, .line = m_line_number, .value = result};
+        return make_token(TokenType::Number, result);
     }
     if (result == "1-0" || result == "0-1" || result == "1/2-1/2") {
-        return Token{.type = TokenType::GameResult, .line = m_line_number, .value = result};
+        return make_token(TokenType::GameResult, result);
     }
-    return Token{.type = TokenType::Invalid, .line = m_line_number, .value = result};
+    return make_token(TokenType::Invalid, result);
 }
 
-auto PGNLexer::is_symbol_character(char character) -> bool {
-    static std::set<char> symbol_characters = {'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w',
-                                               'x', 'y', 'z', 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T',
-                                               'U', 'V', 'W', 'X', 'Y', 'Z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '-', '/', '+', '#', '=', '?', '!'};
-    return symbol_characters.contains(character);
+auto PGNLexer::read_symbol() -> Token {
+    while (has_class(peek(), symbol_class)) {
+        ++m_pos;
+    }
+    return make_token(TokenType::Symbol, token_value(0));
 }
 
-auto PGNLexer::read_symbol(char first_c) -> Token {
-    std::string result{first_c};
-    int character = m_in_stream->get();
-    while (!m_in_stream->bad() && is_symbol_character(static_cast<char>(character))) {
-        result += static_cast<char>(character);
-        character = m_in_stream->get();
+auto PGNLexer::read_comment() -> Token {
+    bool normalize{false};
+    const bool closed = scan_to_delimiter('}', normalize);
+    const auto comment = token_value(1, closed ? 1 : 0);
+    if (!normalize) {
+        return make_token(TokenType::Comment, comment);
     }
-    if (m_in_stream->bad()) {
-        throw PGNError{PGNErrorType::InputError, m_line_number};
+    m_comment.assign(comment);
+    std::ranges::replace_if(m_comment, [](char c) { return is_whitespace(c); }, ' ');
+    return make_token(TokenType::Comment, m_comment);
+}
+
+auto PGNLexer::read_nag() -> Token {
+    while (has_class(peek(), digit_class)) {
+        ++m_pos;
     }
-    m_in_stream->unget();
-    return Token{.type = TokenType::Symbol, .line = m_line_number, .value = result};
+    return make_token(TokenType::NAG, token_value(1));
 }
 
-auto PGNLexer::read_comment() -> Token {
-    std::string result{};
-    int character = m_in_stream->get();
-    while (!m_in_stream->bad() && character != '}') {
-        if (character == '\n') {
+auto PGNLexer::skip_back() -> void {
+    --m_pos;
+}
+
+auto PGNLexer::skip_to_tag_section() -> void {
+    while (true) {
+        m_token_start = m_pos;
+        switch (peek()) {
+        case end_of_input:
+        case '[':
+            return;
+        case '{':
+            ++m_pos;
+            skip_until('}');
+            break;
+        case '"':
+            ++m_pos;
+            skip_until('"');
+            break;
+        case '\n':
             m_line_number++;
+            ++m_pos;
+            break;
+        default:
+            ++m_pos;
         }
-        if (is_whitespace(static_cast<char>(character))) {
-            character = ' ';
-        }
-        result += static_cast<char>(character);
-        character = m_in_stream->get();
     }
-    if (m_in_stream->bad()) {
-        throw PGNError{PGNErrorType::InputError, m_line_number};
-    }
-    return Token{.type = TokenType::Comment, .line = m_line_number, .value = result};
 }
 
-auto PGNLexer::read_nag() -> Token {
-    std::string result{};
-    int character = m_in_stream->get();
-    while (!m_in_stream->bad() && (std::isdigit(character) != 0)) {
-        result += static_cast<char>(character);
-        character = m_in_stream->get();
-    }
-    if (m_in_stream->bad()) {
-        throw PGNError{PGNErrorType::InputError, m_line_number};
+auto PGNLexer::copy_to_tag_section(std::string &out) -> void {
+    m_capture = &out;
+    m_capture_start = m_token_start;
+    skip_to_tag_section();
+    out.append(m_capture_start, m_pos);
+    m_capture = nullptr;
+}
+
+auto PGNLexer::skip_until(char delimiter) -> void {
+    while (true) {
+        const auto result = scan<ScanStop::Delimiter>(m_pos, m_end, delimiter);
+        m_line_number += result.newlines;
+        m_pos = result.stop;
+        m_token_start = m_pos;
+        if (m_pos != m_end) {
+            ++m_pos;
+            return;
+        }
+        if (!fill_buffer()) {
+            return;
+        }
     }
-    m_in_stream->unget();
-    return Token{.type = TokenType::NAG, .line = m_line_number, .value = result};
 }
 
-auto PGNLexer::skip_back() -> void {
-    m_in_stream->unget();
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::set_input(std::string_view input) -> void {
+    m_lexer = PGNLexer{input};
+    m_token = PGNLexer::Token{};
+    clear_cursor_stack();
+    if constexpr (Instrumentation::enabled) {
+        m_instrumentation.new_input();
+    }
 }
 
-auto PGNParser::reset() -> void {
-    m_metadata = GameMetadata{};
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::reset() -> void {
+    m_metadata.reset(m_tag_pool);
+    m_overall_game_comment.clear();
+    while (!m_rav_stack.empty()) {
+        m_rav_stack.pop();
+    }
     m_warnings.clear();
 }
 
-auto PGNParser::setup_game() -> void {
-    m_game = Game{m_metadata};
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::reset_game(Game &game) -> Status {
+    try {
+        game.reset(m_metadata);
+    } catch (const std::exception &error) {
+        return std::unexpected{PGNError{PGNErrorType::InvalidFen, m_token.line, std::string{"Invalid FEN tag: "} + error.what()}};
+    }
+    game.set_position_cache_policy(m_position_cache_policy);
+    return {};
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::setup_game(Game &game) -> Status {
+    m_current_game = &game;
+    if (auto status = reset_game(game); !status.has_value()) {
+        return status;
+    }
     if (!m_overall_game_comment.empty()) {
-        m_game.edit().set_comment(m_overall_game_comment);
+        game.edit().set_comment(m_overall_game_comment);
     }
     clear_cursor_stack();
-    m_cursors.push(m_game.edit());
+    m_cursors.push(game_line{.cursor = game.edit(), .parent = std::nullopt});
+    return {};
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_game() -> std::optional<Game> {
+    if (!read_game_into(m_game)) {
+        return std::nullopt;
+    }
+    return std::move(m_game);
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_game_into(Game &game) -> bool {
+    auto has_game = parse_game(game);
+    if (!has_game.has_value()) {
+        throw std::move(has_game).error();
+    }
+    return has_game.value();
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::try_read_game() -> std::expected<std::optional<Game>, PGNGameError> {
+    auto has_game = try_read_game_into(m_game);
+    if (!has_game.has_value()) {
+        return std::unexpected{std::move(has_game).error()};
+    }
+    if (!has_game.value()) {
+        return std::nullopt;
+    }
+    return std::move(m_game);
 }
 
-auto PGNParser::read_game() -> std::optional<Game> {
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::try_read_game_into(Game &game) -> std::expected<bool, PGNGameError> {
+    auto has_game = parse_game(game);
+    if (has_game.has_value()) {
+        return has_game.value();
+    }
+    PGNGameError error{.error = std::move(has_game).error(), .game_offset = m_game_offset, .offset = m_token.offset};
+    skip_to_next_game();
+    return std::unexpected{std::move(error)};
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::parse_game(Game &game) -> std::expected<bool, PGNError> {
     while (true) {
         reset();
         next_token();
         if (m_token.type == PGNLexer::TokenType::EndOfInput) {
-            return std::nullopt;
+            return false;
+        }
+        m_game_offset = m_token.offset;
+        if (auto status = check_token_type(PGNLexer::TokenType::OpenBracket, "Metadata tags expected"); !status.has_value()) {
+            return std::unexpected{std::move(status).error()};
+        }
+        if (auto status = read_metadata(); !status.has_value()) {
+            return std::unexpected{std::move(status).error()};
         }
-        check_token_type(PGNLexer::TokenType::OpenBracket, "Metadata tags expected");
-        read_metadata();
         if (lower_case(m_metadata.get("Variant").value_or("")) == "chess960") {
             skip_to_next_game();
             continue;
         }
-        setup_game();
-        read_movetext();
-        return m_game;
+        if constexpr (Instrumentation::enabled) {
+            ++m_instrumentation.counters().games;
+        }
+        if (m_lazy_movetext) {
+            std::string movetext;
+            {
+                [[maybe_unused]] const auto timer = m_instrumentation.time(PGNStage::Lexing);
+                m_lexer.copy_to_tag_section(movetext);
+            }
+            if (auto status = reset_game(game); !status.has_value()) {
+                return std::unexpected{std::move(status).error()};
+            }
+            game.set_pending_movetext(std::move(movetext), m_token.line);
+            return true;
+        }
+        read_game_comment();
+        if (auto status = setup_game(game); !status.has_value()) {
+            return std::unexpected{std::move(status).error()};
+        }
+        if (auto status = read_movetext(); !status.has_value()) {
+            return std::unexpected{std::move(status).error()};
+        }
+        finish_game();
+        return true;
+    }
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_game_movetext(const GameMetadata &metadata) -> Game {
+    reset();
+    m_metadata = metadata;
+    next_token();
+    read_game_comment();
+    if (auto status = setup_game(m_game); !status.has_value()) {
+        throw std::move(status).error();
+    }
+    if (auto status = read_movetext(); !status.has_value()) {
+        throw std::move(status).error();
     }
+    finish_game();
+    return std::move(m_game);
 }
 
-auto PGNParser::skip_to_next_game() -> void {
-    while (m_token.type != PGNLexer::TokenType::EndOfInput && m_token.type != PGNLexer::TokenType::OpenBracket) {
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_mainline_game() -> std::optional<MainlineGame> {
+    while (true) {
+        reset();
         next_token();
+        if (m_token.type == PGNLexer::TokenType::EndOfInput) {
+            return std::nullopt;
+        }
+        m_game_offset = m_token.offset;
+        if (auto status = check_token_type(PGNLexer::TokenType::OpenBracket, "Metadata tags expected"); !status.has_value()) {
+            throw std::move(status).error();
+        }
+        if (auto status = read_metadata(); !status.has_value()) {
+            throw std::move(status).error();
+        }
+        if (lower_case(m_metadata.get("Variant").value_or("")) == "chess960") {
+            skip_to_next_game();
+            continue;
+        }
+        if constexpr (Instrumentation::enabled) {
+            ++m_instrumentation.counters().games;
+        }
+        MainlineGame game{std::move(m_metadata)};
+        auto board = game.start_board();
+        if (!board.has_value()) {
+            throw PGNError{PGNErrorType::InvalidFen, m_token.line, "Invalid FEN tag"};
+        }
+        if (auto status = read_mainline_movetext(game, board.value()); !status.has_value()) {
+            throw std::move(status).error();
+        }
+        game.shrink_to_fit();
+        return game;
+    }
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_mainline_movetext(MainlineGame &game, Board &board) -> Status {
+    while (m_token.type != PGNLexer::TokenType::GameResult) {
+        Status status{};
+        switch (m_token.type) {
+        case PGNLexer::TokenType::Number:
+            read_move_number_indication();
+            break;
+        case PGNLexer::TokenType::Dot:
+            if constexpr (!Policy::lenient) {
+                return std::unexpected{PGNError(PGNErrorType::UnexpectedToken, m_token.line, "Unexpected char in movetext: .")};
+            }
+            add_warning(PGNWarningType::UnexpectedChar, m_token.line, "Unexpected char in movetext: .");
+            next_token();
+            break;
+        case PGNLexer::TokenType::Symbol:
+            status = read_mainline_move(game, board);
+            break;
+        case PGNLexer::TokenType::NAG:
+        case PGNLexer::TokenType::Comment:
+            next_token();
+            break;
+        case PGNLexer::TokenType::OpenParen:
+            status = skip_rav();
+            break;
+        case PGNLexer::TokenType::CloseParen:
+            return std::unexpected{PGNError(PGNErrorType::NoPenRav, m_token.line, "No RAV to close")};
+        case PGNLexer::TokenType::Invalid:
+            if constexpr (Policy::lenient) {
+                if (m_token.value == "," || m_token.value == "}") {
+                    add_warning(PGNWarningType::UnexpectedChar, m_token.line, std::string{"Unexpected char in movetext: "} + std::string{m_token.value});
+                    next_token();
+                    break;
+                }
+            }
+            return std::unexpected{PGNError(PGNErrorType::UnexpectedToken, m_token.line, std::string{"Invalid token in movetext '"} + std::string{m_token.value} + std::string{"'"})};
+        default:
+            return std::unexpected{PGNError(
+                PGNErrorType::UnexpectedToken, m_token.line,
+                std::string{"Unexpected token of type "} + to_string(m_token.type) + std::string{" in movetext '"} + std::string{m_token.value} + std::string{"'"}
+            )};
+        }
+        if (!status.has_value()) {
+            return status;
+        }
+    }
+    return {};
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_mainline_move(MainlineGame &game, Board &board) -> Status {
+    const auto san_move = parse_san_move(m_token.value, board.side_to_move());
+    if (!san_move.has_value()) {
+        return std::unexpected{san_move.error()};
     }
+    const auto move = [&]() -> std::expected<chesscore::Move, PGNError> {
+        [[maybe_unused]] const auto timer = m_instrumentation.time(PGNStage::MoveResolution);
+        if (const auto resolved = resolve_san_move(san_move.value(), board); resolved.has_value()) {
+            return resolved.value();
+        }
+        // The fallbacks need the legal moves, so the position is built from the board.
+        return match_legal_move(san_move.value(), chesscore::Position{chesscore::FenString{board.fen()}});
+    }();
+    if (!move.has_value()) {
+        return std::unexpected{move.error()};
+    }
+    game.append_move(move.value());
+    board.make_move(move.value());
+    next_token();
+    return {};
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::finish_game() -> void {
+    if (m_position_cache_policy.mode == PositionCachePolicy::Mode::WhileParsing) {
+        m_current_game->set_position_cache_policy(PositionCachePolicy::root_only());
+    }
+    clear_cursor_stack();
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::skip_to_next_game() -> void {
     if (m_token.type == PGNLexer::TokenType::OpenBracket) {
         m_lexer.skip_back();
+    } else if (m_token.type != PGNLexer::TokenType::EndOfInput) {
+        m_lexer.skip_to_tag_section();
+    }
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::skip_game() -> std::optional<size_t> {
+    next_token();
+    if (m_token.type == PGNLexer::TokenType::EndOfInput) {
+        return std::nullopt;
     }
+    const auto game_offset = m_token.offset;
+    while (m_token.type == PGNLexer::TokenType::OpenBracket) {
+        while (m_token.type != PGNLexer::TokenType::CloseBracket && m_token.type != PGNLexer::TokenType::EndOfInput) {
+            next_token();
+        }
+        next_token();
+    }
+    skip_to_next_game();
+    return game_offset;
 }
 
-auto PGNParser::read_movetext() -> void {
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_header(bool skip_movetext) -> std::optional<GameHeader> {
+    reset();
+    next_token();
+    if (m_token.type == PGNLexer::TokenType::EndOfInput) {
+        return std::nullopt;
+    }
+    const auto game_offset = m_token.offset;
+    if (auto status = check_token_type(PGNLexer::TokenType::OpenBracket, "Metadata tags expected"); !status.has_value()) {
+        throw std::move(status).error();
+    }
+    if (auto status = read_metadata(); !status.has_value()) {
+        throw std::move(status).error();
+    }
+    const auto movetext_offset = m_token.offset;
+    if (skip_movetext) {
+        skip_to_next_game();
+    }
+    if constexpr (Instrumentation::enabled) {
+        ++m_instrumentation.counters().games;
+    }
+    return GameHeader{.offset = game_offset, .movetext_offset = movetext_offset, .metadata = std::move(m_metadata)};
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_movetext() -> Status {
     while (m_token.type != PGNLexer::TokenType::GameResult) {
+        Status status{};
         switch (m_token.type) {
         case PGNLexer::TokenType::Number:
             read_move_number_indication();
             break;
         case PGNLexer::TokenType::Dot:
-            m_warnings.emplace_back(PGNWarningType::UnexpectedChar, m_token.line, "Unexpected char in movetext: .");
+            if constexpr (!Policy::lenient) {
+                return std::unexpected{PGNError(PGNErrorType::UnexpectedToken, m_token.line, "Unexpected char in movetext: .")};
+            }
+            add_warning(PGNWarningType::UnexpectedChar, m_token.line, "Unexpected char in movetext: .");
             next_token();
             break;
         case PGNLexer::TokenType::Symbol:
-            read_move();
+            status = read_move();
             break;
         case PGNLexer::TokenType::NAG:
             annotate_move();
@@ -337,125 +827,214 @@ auto PGNParser::read_movetext() -> void {
             process_move_comment();
             break;
         case PGNLexer::TokenType::OpenParen:
-            start_rav();
+            if constexpr (Policy::keep_variations) {
+                status = start_rav();
+            } else {
+                status = skip_rav();
+            }
             break;
         case PGNLexer::TokenType::CloseParen:
-            finish_rav();
+            status = finish_rav();
             break;
         case PGNLexer::TokenType::Invalid:
-            if (m_token.value == "," || m_token.value == "}") {
-                m_warnings.emplace_back(PGNWarningType::UnexpectedChar, m_token.line, std::string{"Unexpected char in movetext: "} + m_token.value);
-                next_token();
-                break;
+            if constexpr (Policy::lenient) {
+                if (m_token.value == "," || m_token.value == "}") {
+                    add_warning(PGNWarningType::UnexpectedChar, m_token.line, std::string{"Unexpected char in movetext: "} + std::string{m_token.value});
+                    next_token();
+                    break;
+                }
             }
-            throw PGNError(PGNErrorType::UnexpectedToken, m_token.line, std::string{"Invalid token in movetext '"} + m_token.value + std::string{"'"});
+            return std::unexpected{PGNError(PGNErrorType::UnexpectedToken, m_token.line, std::string{"Invalid token in movetext '"} + std::string{m_token.value} + std::string{"'"})};
         default:
-            throw PGNError(
+            return std::unexpected{PGNError(
                 PGNErrorType::UnexpectedToken, m_token.line,
-                std::string{"Unexpected token of type "} + to_string(m_token.type) + std::string{" in movetext '"} + m_token.value + std::string{"'"}
-            );
+                std::string{"Unexpected token of type "} + to_string(m_token.type) + std::string{" in movetext '"} + std::string{m_token.value} + std::string{"'"}
+            )};
+        }
+        if (!status.has_value()) {
+            return status;
         }
     }
     process_game_result();
+    return {};
 }
 
-auto PGNParser::read_move() -> void {
-    check_token_type(PGNLexer::TokenType::Symbol, "Move expected");
-    process_move();
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_move() -> Status {
+    if (auto status = check_token_type(PGNLexer::TokenType::Symbol, "Move expected"); !status.has_value()) {
+        return status;
+    }
+    return process_move();
 }
 
-auto PGNParser::read_metadata() -> void {
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_metadata() -> Status {
     while (m_token.type == PGNLexer::TokenType::OpenBracket) {
-        read_tag();
+        if (auto status = read_tag(); !status.has_value()) {
+            return status;
+        }
         next_token();
     }
+    return {};
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_game_comment() -> void {
     if (m_token.type == PGNLexer::TokenType::Comment) {
-        m_overall_game_comment = m_token.value;
+        if constexpr (Policy::keep_comments) {
+            m_overall_game_comment = m_token.value;
+        }
         next_token();
     }
 }
 
-auto PGNParser::read_tag() -> void {
-    expect_token(PGNLexer::TokenType::Symbol, "Name expected");
-    const auto tag_name = m_token.value;
-    expect_token(PGNLexer::TokenType::String, "String expected");
-    const auto tag_value = m_token.value;
-    m_metadata.add(tag_name, tag_value);
-    expect_token(PGNLexer::TokenType::CloseBracket, "Close bracket expected");
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_tag() -> Status {
+    if (auto status = expect_token(PGNLexer::TokenType::Symbol, "Name expected"); !status.has_value()) {
+        return status;
+    }
+    std::string tag_name{m_token.value};
+    if (auto status = expect_token(PGNLexer::TokenType::String, "String expected"); !status.has_value()) {
+        return status;
+    }
+    m_metadata.add(tag_name, m_token.value);
+    return expect_token(PGNLexer::TokenType::CloseBracket, "Close bracket expected");
 }
 
-auto PGNParser::annotate_move() -> void {
-    current_game_line().node()->nags().emplace_back(stoi(m_token.value));
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::annotate_move() -> void {
+    if constexpr (Policy::keep_nags) {
+        int nag{0};
+        std::from_chars(m_token.value.data(), m_token.value.data() + m_token.value.size(), nag);
+        current_game_line().add_nag(nag);
+    }
     next_token();
 }
 
-auto PGNParser::process_game_result() -> void {}
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::process_game_result() -> void {}
 
-auto PGNParser::process_move_comment() -> void {
-    if (!m_rav_stack.empty() && !m_rav_stack.top().has_moves) {
-        m_rav_stack.top().comment = m_token.value;
-    } else {
-        current_game_line().append_comment(m_token.value);
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::process_move_comment() -> void {
+    if constexpr (Policy::keep_comments) {
+        if (!m_rav_stack.empty() && !m_rav_stack.top().has_moves) {
+            m_rav_stack.top().comment = m_token.value;
+        } else {
+            current_game_line().append_comment(m_token.value);
+        }
     }
     next_token();
 }
 
-auto PGNParser::start_rav() -> void {
-    auto opt_parent = current_game_line().parent();
-    if (opt_parent.has_value()) {
-        m_cursors.push(opt_parent.value());
-        m_rav_stack.emplace(false, std::string{});
-        next_token();
-    } else {
-        throw PGNError(PGNErrorType::CannotStartRav, m_token.line, "No parent in curent position");
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::start_rav() -> Status {
+    auto opt_parent = m_cursors.top().parent.has_value() ? m_cursors.top().parent : current_game_line().parent();
+    if (!opt_parent.has_value()) {
+        return std::unexpected{PGNError(PGNErrorType::CannotStartRav, m_token.line, "No parent in curent position")};
     }
+    m_cursors.push(game_line{.cursor = opt_parent.value(), .parent = std::nullopt});
+    m_rav_stack.emplace(false, std::string{});
+    next_token();
+    return {};
 }
 
-auto PGNParser::finish_rav() -> void {
-    if (m_cursors.size() > 1) {
-        m_cursors.pop();
-        next_token();
-    } else {
-        throw PGNError(PGNErrorType::NoPenRav, m_token.line, "No RAV to close");
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::finish_rav() -> Status {
+    if (m_cursors.size() <= 1) {
+        return std::unexpected{PGNError(PGNErrorType::NoPenRav, m_token.line, "No RAV to close")};
     }
+    m_cursors.pop();
+    next_token();
     if (!m_rav_stack.empty()) {
         m_rav_stack.pop();
     }
+    return {};
 }
 
-auto PGNParser::read_move_number_indication() -> void {
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::skip_rav() -> Status {
+    size_t depth{1};
+    while (depth > 0) {
+        next_token();
+        if (m_token.type == PGNLexer::TokenType::OpenParen) {
+            ++depth;
+        } else if (m_token.type == PGNLexer::TokenType::CloseParen) {
+            --depth;
+        } else if (m_token.type == PGNLexer::TokenType::EndOfInput) {
+            return std::unexpected{PGNError(PGNErrorType::EndOfInput, m_token.line, "Unterminated RAV")};
+        }
+    }
+    next_token();
+    return {};
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::read_move_number_indication() -> void {
     next_token();
     while (m_token.type == PGNLexer::TokenType::Dot) {
         next_token();
     }
 }
 
-auto PGNParser::parse_san_move(const std::string &san_str) const -> SANMove {
-    const auto san_exp = parse_san(san_str, current_game_line().position().side_to_move());
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::parse_san_move(std::string_view san_str, chesscore::Color side_to_move) const -> std::expected<SANMove, PGNError> {
+    [[maybe_unused]] const auto timer = m_instrumentation.time(PGNStage::SANParsing);
+    if constexpr (Instrumentation::enabled) {
+        ++m_instrumentation.counters().san_parses;
+    }
+    const auto san_exp = parse_san(san_str, side_to_move);
     if (san_exp.has_value()) {
         return san_exp.value();
     }
-    throw PGNError{PGNErrorType::InvalidMove, m_token.line, san_exp.error().san};
+    return std::unexpected{PGNError{PGNErrorType::InvalidMove, m_token.line, san_exp.error().san}};
 }
 
-auto PGNParser::find_legal_move(const SANMove &san_move) const -> chesscore::Move {
-    const auto legal_moves = current_game_line().position().all_legal_moves();
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::find_legal_move(const SANMove &san_move) -> std::expected<chesscore::Move, PGNError> {
+    [[maybe_unused]] const auto timer = m_instrumentation.time(PGNStage::MoveResolution);
+    m_san.clear();
+    const auto *board = current_game_line().board();
+    if (board != nullptr) {
+        const auto resolved = resolve_san_move(san_move, *board, m_san);
+        if (resolved.has_value()) {
+            return resolved.value();
+        }
+    }
+
+    // No unique move found on the board, match against all legal moves for the fallbacks and error reporting.
+    if (board != nullptr) {
+        return match_legal_move(san_move, chesscore::Position{chesscore::FenString{board->fen()}});
+    }
+    return match_legal_move(san_move, current_game_line().position());
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::match_legal_move(const SANMove &san_move, const chesscore::Position &position) -> std::expected<chesscore::Move, PGNError> {
+    const auto legal_moves = position.all_legal_moves();
+    if constexpr (Instrumentation::enabled) {
+        ++m_instrumentation.counters().legal_move_generations;
+    }
     if (legal_moves.empty()) {
-        throw PGNError{PGNErrorType::IllegalMove, m_token.line, san_move.san_string};
+        return std::unexpected{PGNError{PGNErrorType::IllegalMove, m_token.line, san_move.san_string}};
     }
     const auto matched_moves = match_move(san_move, legal_moves);
     if (matched_moves.size() == 1) {
+        append_san_move(m_san, matched_moves[0], legal_moves);
         return matched_moves[0];
     }
     if (matched_moves.size() > 1) {
-        throw PGNError{PGNErrorType::AmbiguousMove, m_token.line, san_move.san_string};
+        return std::unexpected{PGNError{PGNErrorType::AmbiguousMove, m_token.line, san_move.san_string}};
+    }
+    if constexpr (!Policy::lenient) {
+        return std::unexpected{PGNError{PGNErrorType::IllegalMove, m_token.line, san_move.san_string}};
     }
 
     // Could not match the SAN move against the legal moves, try some modifications...
 
     const auto matched_without_piece_type = match_san_move_wildcard_piece_type(san_move, legal_moves);
     if (matched_without_piece_type.size() == 1) {
-        m_warnings.emplace_back(PGNWarningType::MoveMissingPieceType, m_token.line, san_move.san_string);
+        add_warning(PGNWarningType::MoveMissingPieceType, m_token.line, san_move.san_string);
+        append_san_move(m_san, matched_without_piece_type[0], legal_moves);
         return matched_without_piece_type[0];
     }
     if (!san_move.capturing) {
@@ -463,196 +1042,372 @@ auto PGNParser::find_legal_move(const SANMove &san_move) const -> chesscore::Mov
         try_move.capturing = true;
         const auto matched_captures = match_move(try_move, legal_moves);
         if (matched_captures.size() == 1) {
-            m_warnings.emplace_back(PGNWarningType::MoveMissingCapture, m_token.line, san_move.san_string);
+            add_warning(PGNWarningType::MoveMissingCapture, m_token.line, san_move.san_string);
+            append_san_move(m_san, matched_captures[0], legal_moves);
             return matched_captures[0];
         }
     }
 
-    throw PGNError{PGNErrorType::IllegalMove, m_token.line, san_move.san_string};
+    return std::unexpected{PGNError{PGNErrorType::IllegalMove, m_token.line, san_move.san_string}};
 }
 
-auto PGNParser::process_move() -> void {
-    const auto san_move = parse_san_move(m_token.value);
-    const auto move = find_legal_move(san_move);
-    Cursor &cursor = current_game_line();
-    auto new_cursor = cursor.play_move(move);
-    current_game_line() = new_cursor;
-    if (san_move.suffix_annotation.has_value()) {
-        new_cursor.node()->add_nag(convert_to_nag(san_move.suffix_annotation.value()));
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::process_move() -> Status {
+    const auto *board = current_game_line().board();
+    const auto san_move = parse_san_move(m_token.value, board != nullptr ? board->side_to_move() : current_game_line().position().side_to_move());
+    if (!san_move.has_value()) {
+        return std::unexpected{san_move.error()};
     }
-    if (!m_rav_stack.empty()) {
-        m_rav_stack.top().has_moves = true;
-        if (!m_rav_stack.top().comment.empty()) {
-            current_game_line().append_premove_comment(m_rav_stack.top().comment);
-            m_rav_stack.top().comment.clear();
+    const auto move = find_legal_move(san_move.value());
+    if (!move.has_value()) {
+        return std::unexpected{move.error()};
+    }
+    auto &line = m_cursors.top();
+    auto new_cursor = [&] {
+        [[maybe_unused]] const auto timer = m_instrumentation.time(PGNStage::TreeBuilding);
+        if constexpr (Instrumentation::enabled) {
+            const auto node_count = m_current_game->tree().size();
+            auto cursor = line.cursor.play_move(move.value(), m_san);
+            auto &counters = m_instrumentation.counters();
+            ++counters.positions_replayed;
+            counters.nodes_allocated += m_current_game->tree().size() - node_count;
+            return cursor;
+        } else {
+            return line.cursor.play_move(move.value(), m_san);
+        }
+    }();
+    line.parent = std::move(line.cursor);
+    line.cursor = new_cursor;
+    if constexpr (Policy::keep_nags) {
+        if (san_move->suffix_annotation.has_value()) {
+            new_cursor.add_nag(convert_to_nag(san_move->suffix_annotation.value()));
+        }
+    }
+    if constexpr (Policy::keep_variations) {
+        if (!m_rav_stack.empty()) {
+            m_rav_stack.top().has_moves = true;
+            if (!m_rav_stack.top().comment.empty()) {
+                current_game_line().append_premove_comment(m_rav_stack.top().comment);
+                m_rav_stack.top().comment.clear();
+            }
         }
     }
     next_token();
+    return {};
 }
 
-auto PGNParser::next_token() -> void {
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::next_token() -> void {
+    [[maybe_unused]] const auto timer = m_instrumentation.time(PGNStage::Lexing);
     m_token = m_lexer.next_token();
+    if constexpr (Instrumentation::enabled) {
+        ++m_instrumentation.counters().tokens;
+        m_instrumentation.consumed_input(m_lexer.offset());
+    }
 }
 
-auto PGNParser::check_token_type(PGNLexer::TokenType expected_type, const std::string &error_message) const -> void {
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::check_token_type(PGNLexer::TokenType expected_type, std::string_view error_message) const -> Status {
     if (m_token.type != expected_type) {
-        throw PGNError{PGNErrorType::UnexpectedToken, m_token.line, error_message};
+        return std::unexpected{PGNError{PGNErrorType::UnexpectedToken, m_token.line, std::string{error_message}}};
     }
+    return {};
 }
 
-auto PGNParser::expect_token(PGNLexer::TokenType expected_type, const std::string &error_message) -> void {
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::expect_token(PGNLexer::TokenType expected_type, std::string_view error_message) -> Status {
     next_token();
-    check_token_type(expected_type, error_message);
+    return check_token_type(expected_type, error_message);
 }
 
-auto PGNParser::skip_tokens(PGNLexer::TokenType type) -> void {
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::skip_tokens(PGNLexer::TokenType type) -> void {
     next_token();
     while (m_token.type == type) {
         next_token();
     }
 }
 
-auto PGNParser::clear_cursor_stack() -> void {
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::add_warning(PGNWarningType type, int line, std::string description) const -> void {
+    if constexpr (Instrumentation::enabled) {
+        ++m_instrumentation.counters().warnings[static_cast<size_t>(type)];
+    }
+    if constexpr (Policy::collect_warnings) {
+        m_warnings.emplace_back(type, line, std::move(description));
+    }
+}
+
+template<typename Instrumentation, typename Policy>
+auto BasicPGNParser<Instrumentation, Policy>::clear_cursor_stack() -> void {
     while (!m_cursors.empty()) {
         m_cursors.pop();
     }
 }
 
-auto PGNWriter::write_game(const Game &game) -> void {
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_game(const Game &game) -> void {
+    std::streampos start{-1};
+    if constexpr (Instrumentation::enabled) {
+        start = m_output.stream()->tellp();
+    }
     write_metadata(game.metadata());
     if (has_overall_game_comment(game)) {
         write_overall_game_comment(game);
     }
-    write_game_lines(game.const_cursor());
+    write_game_lines(game.view(), game.const_cursor().position());
     write_game_termination(game);
-}
-
-auto PGNWriter::write_game_lines(const ConstCursor &node) -> void {
-    ConstCursor cursor = node;
-    while (cursor.child_count() > 0) {
-        const auto mainline_child = cursor.child(0);
-        if (mainline_child) {
-            write_move(*(mainline_child.value().node()));
-        } else {
-            break;
+    if constexpr (Instrumentation::enabled) {
+        auto &counters = m_instrumentation.counters();
+        ++counters.games;
+        const auto end = m_output.stream()->tellp();
+        if (start != std::streampos{-1} && end != std::streampos{-1}) {
+            counters.bytes += static_cast<uint64_t>(end - start);
         }
-        for (size_t child_index = 1; child_index < cursor.child_count(); ++child_index) {
-            const auto variant_cursor = cursor.child(child_index);
-            if (variant_cursor) {
-                write_rav(variant_cursor.value());
-            }
-        }
-        cursor = mainline_child.value();
     }
 }
 
-auto PGNWriter::write_move(const GameNode &node) -> void {
-    const auto &move = node.move();
-    const auto &parent = node.parent();
-    if (!parent) {
-        throw PGNError{PGNErrorType::CannotStartRav, -1, to_string(move)};
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_game(const MainlineGame &game) -> void {
+    std::streampos start{-1};
+    if constexpr (Instrumentation::enabled) {
+        start = m_output.stream()->tellp();
     }
-    const auto position = parent->calculate_position();
-    const auto legal_moves = position.all_legal_moves();
-    const auto possible_san_move = generate_san_move(move, legal_moves);
-    if (possible_san_move.has_value()) {
-        if (!node.premove_comment().empty()) {
-            m_output.write_comment(node.premove_comment());
+    // The start position is checked first, so that an invalid game leaves no partial header in the output.
+    auto board = game.start_board();
+    if (!board.has_value()) {
+        throw PGNError{PGNErrorType::InvalidFen, -1, "Invalid FEN tag"};
+    }
+    write_metadata(game.metadata());
+    auto move_number = fullmove_number(game.metadata());
+    for (const auto code : game.move_codes()) {
+        const auto move = decode_compact_move(code, board.value());
+        m_san.clear();
+        if (!move.has_value() || !append_san_move(m_san, move.value(), board.value())) {
+            throw PGNError{PGNErrorType::InvalidMove, -1, "Invalid move in main line game"};
         }
-
-        if (position.side_to_move() == chesscore::Color::White) {
-            m_output.write(PGNTokenOutput::OutToken::MoveNumber, position.fullmove_number(), ".");
+        const auto side_to_move = board->side_to_move();
+        board->make_move(move.value());
+        if (board->in_check(board->side_to_move())) {
+            m_san.push_back(is_checkmate(board.value()) ? '#' : '+');
         }
-        if (position.side_to_move() == chesscore::Color::Black && m_write_black_move_number) {
-            m_output.write(PGNTokenOutput::OutToken::MoveNumber, position.fullmove_number(), "...");
+        if (side_to_move == chesscore::Color::White) {
+            m_output.write(PGNTokenOutput::OutToken::MoveNumber, move_number, ".");
+        } else if (m_write_black_move_number) {
+            m_output.write(PGNTokenOutput::OutToken::MoveNumber, move_number, "...");
         }
         m_write_black_move_number = false;
-        const auto achieved_position = node.calculate_position();
-        const auto check_state = achieved_position.check_state();
-        std::string check_state_indicator;
-        if (check_state == chesscore::CheckState::Check) {
-            check_state_indicator = "+";
-        } else if (check_state == chesscore::CheckState::Checkmate) {
-            check_state_indicator = "#";
-        }
-        m_output.write(PGNTokenOutput::OutToken::Move, possible_san_move.value().san_string, check_state_indicator);
-        std::ranges::for_each(node.nags(), [&](int n) { m_output.write(PGNTokenOutput::OutToken::Nag, std::string{"$"} + std::to_string(n)); });
-        if (!node.comment().empty()) {
-            m_output.write_comment(node.comment());
+        m_output.write(PGNTokenOutput::OutToken::Move, m_san);
+        if (side_to_move == chesscore::Color::Black) {
+            ++move_number;
+        }
+    }
+    write_game_termination(game.metadata());
+    if constexpr (Instrumentation::enabled) {
+        auto &counters = m_instrumentation.counters();
+        ++counters.games;
+        const auto end = m_output.stream()->tellp();
+        if (start != std::streampos{-1} && end != std::streampos{-1}) {
+            counters.bytes += static_cast<uint64_t>(end - start);
         }
+    }
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_game_lines(const ConstCursor &node) -> void {
+    write_game_lines(node, node.position());
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_game_lines(const ConstCursor &node, chesscore::Position position) -> void {
+    write_game_lines(node.view(), std::move(position));
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_game_lines(NodeView node, chesscore::Position position) -> void {
+    for (const auto mainline_child : node.mainline()) {
+        auto next_position = position;
+        replay_move(next_position, mainline_child.move());
+        write_move(mainline_child, position, next_position);
+        for (auto variation = mainline_child.next_sibling(); variation.valid(); variation = variation.next_sibling()) {
+            write_rav(variation, position);
+        }
+        position = std::move(next_position);
+    }
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_move(const ConstCursor &node) -> void {
+    const auto parent = node.parent();
+    if (!parent) {
+        throw PGNError{PGNErrorType::CannotStartRav, -1, to_string(node.move())};
+    }
+    write_move(node, parent->position(), node.position());
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_move(const ConstCursor &node, const chesscore::Position &position, const chesscore::Position &next_position) -> void {
+    write_move(node.view(), position, next_position);
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_move(NodeView node, const chesscore::Position &position, const chesscore::Position &next_position) -> void {
+    m_san.clear();
+    if (const auto cached_san = node.san(); !cached_san.empty()) {
+        m_san.append(cached_san);
     } else {
+        generate_san(node.move(), position, next_position);
+    }
+    if (!node.premove_comment().empty()) {
+        m_output.write_comment(node.premove_comment());
+    }
+
+    if (position.side_to_move() == chesscore::Color::White) {
+        m_output.write(PGNTokenOutput::OutToken::MoveNumber, position.fullmove_number(), ".");
+    }
+    if (position.side_to_move() == chesscore::Color::Black && m_write_black_move_number) {
+        m_output.write(PGNTokenOutput::OutToken::MoveNumber, position.fullmove_number(), "...");
+    }
+    m_write_black_move_number = false;
+    m_output.write(PGNTokenOutput::OutToken::Move, m_san);
+    std::ranges::for_each(node.nags(), [&](int n) { m_output.write(PGNTokenOutput::OutToken::Nag, '$', n); });
+    if (!node.comment().empty()) {
+        m_output.write_comment(node.comment());
+    }
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::generate_san(const chesscore::Move &move, const chesscore::Position &position, const chesscore::Position &next_position) -> void {
+    [[maybe_unused]] const auto timer = m_instrumentation.time(PGNStage::SANGeneration);
+    const auto legal_moves = position.all_legal_moves();
+    if constexpr (Instrumentation::enabled) {
+        auto &counters = m_instrumentation.counters();
+        ++counters.legal_move_generations;
+        ++counters.san_generations;
+    }
+    if (!append_san_move(m_san, move, legal_moves)) {
         throw PGNError{PGNErrorType::InvalidMove, -1, to_string(move)};
     }
+    const auto check_state = next_position.check_state();
+    if (check_state == chesscore::CheckState::Check) {
+        m_san.push_back('+');
+    } else if (check_state == chesscore::CheckState::Checkmate) {
+        m_san.push_back('#');
+    }
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::replay_move(chesscore::Position &position, const chesscore::Move &move) -> void {
+    [[maybe_unused]] const auto timer = m_instrumentation.time(PGNStage::PositionReplay);
+    position.make_move(move);
+    if constexpr (Instrumentation::enabled) {
+        ++m_instrumentation.counters().positions_replayed;
+    }
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_game_termination(const Game &game) -> void {
+    write_game_termination(game.metadata());
 }
 
-auto PGNWriter::write_game_termination(const Game &game) -> void {
-    const auto value = game.metadata().get("Result").value_or("?");
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_game_termination(const GameMetadata &metadata) -> void {
+    const auto value = metadata.get("Result").value_or("?");
     m_output.write(PGNTokenOutput::OutToken::GameTermination, value);
     m_output.newline();
     m_output.newline();
 }
 
-auto PGNWriter::write_rav(const ConstCursor &node) -> void {
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_rav(const ConstCursor &node) -> void {
+    const auto parent = node.parent();
+    if (!parent) {
+        throw PGNError{PGNErrorType::CannotStartRav, -1, to_string(node.move())};
+    }
+    write_rav(node, parent->position());
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_rav(const ConstCursor &node, const chesscore::Position &position) -> void {
+    write_rav(node.view(), position);
+}
+
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_rav(NodeView node, const chesscore::Position &position) -> void {
     m_output.write(PGNTokenOutput::OutToken::RavStart, '(');
     m_write_black_move_number = true;
-    write_move(*(node.node()));
-    write_game_lines(node);
+    auto next_position = position;
+    replay_move(next_position, node.move());
+    write_move(node, position, next_position);
+    write_game_lines(node, std::move(next_position));
     m_output.write(PGNTokenOutput::OutToken::RavEnd, ')');
     m_write_black_move_number = true;
 }
 
-auto PGNWriter::write_metadata(const GameMetadata &metadata) -> void {
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_metadata(const GameMetadata &metadata) -> void {
     write_str_tags(metadata);
     write_non_str_tags(metadata);
     m_output.end_metadata_section();
 }
 
-auto PGNWriter::write_str_tags(const GameMetadata &metadata) -> void {
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_str_tags(const GameMetadata &metadata) -> void {
     for (const auto &tag_name : GameMetadata::str_tags) {
         const auto value = metadata.get(tag_name).value_or("?");
         write_tag_pair(tag_name, value);
     }
 }
 
-auto PGNWriter::write_non_str_tags(const GameMetadata &metadata) -> void {
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_non_str_tags(const GameMetadata &metadata) -> void {
     std::vector<metadata_tag> non_str_tags;
     std::ranges::copy_if(metadata, std::back_inserter(non_str_tags), [](const metadata_tag &tag) { return !GameMetadata::is_str_tag(tag); });
     std::ranges::sort(non_str_tags, [](const metadata_tag &tag1, const metadata_tag &tag2) { return tag1.name < tag2.name; });
     std::ranges::for_each(non_str_tags, [this](const metadata_tag &tag) { write_tag_pair(tag); });
 }
 
-auto PGNWriter::write_tag_pair(const std::string &name, const std::string &value) -> void {
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_tag_pair(std::string_view name, std::string_view value) -> void {
     m_output.write(PGNTokenOutput::OutToken::Tag, '[', name, " \"", value, "\"]");
     m_output.newline();
 }
 
-auto PGNWriter::write_tag_pair(const metadata_tag &tag) -> void {
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_tag_pair(const metadata_tag &tag) -> void {
     write_tag_pair(tag.name, tag.value);
 }
 
-auto PGNWriter::has_overall_game_comment(const Game &game) -> bool {
-    return !game.const_cursor().node()->comment().empty();
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::has_overall_game_comment(const Game &game) -> bool {
+    return !game.tree().comment(GameTree::root_id).empty();
 }
 
-auto PGNWriter::write_overall_game_comment(const Game &game) -> void {
-    m_output.write_comment(game.const_cursor().node()->comment());
+template<typename Instrumentation>
+auto BasicPGNWriter<Instrumentation>::write_overall_game_comment(const Game &game) -> void {
+    m_output.write_comment(game.tree().comment(GameTree::root_id));
     m_output.newline();
     m_output.newline();
 }
 
-auto PGNTokenOutput::write_comment(const std::string &comment) -> void {
-    const auto words = split_into_words(comment, " ");
-    auto word = std::begin(words);
-    while (word != std::end(words)) {
-        if (word == std::begin(words)) {
-            write(PGNTokenOutput::OutToken::Comment, std::string{"{"} + *word);
-        } else if (std::next(word) == std::end(words)) {
-            write(PGNTokenOutput::OutToken::Comment, *word + std::string{"}"});
-        } else {
-            write(PGNTokenOutput::OutToken::Comment, *word);
+auto PGNTokenOutput::write_comment(std::string_view comment) -> void {
+    size_t word_start{0};
+    while (true) {
+        const auto word_end = comment.find(' ', word_start);
+        const auto last_word = word_end == std::string_view::npos;
+        m_token.clear();
+        if (word_start == 0) {
+            m_token.push_back('{');
         }
-
-        ++word;
+        m_token.append(comment.substr(word_start, last_word ? std::string_view::npos : word_end - word_start));
+        if (last_word) {
+            m_token.push_back('}');
+        }
+        write_token(PGNTokenOutput::OutToken::Comment, m_token);
+        if (last_word) {
+            return;
+        }
+        word_start = word_end + 1;
     }
 }
 
@@ -662,7 +1417,7 @@ auto PGNTokenOutput::newline() -> void {
     m_last_out_token = OutToken::None;
 };
 
-auto PGNTokenOutput::write_token(OutToken type, const std::string &token) -> void {
+auto PGNTokenOutput::write_token(OutToken type, std::string_view token) -> void {
     auto need_ws = needs_whitespace(type);
     const auto token_length = token.size();
     const auto effective_token_length = token_length + (need_ws ? 1 : 0);
@@ -673,11 +1428,11 @@ auto PGNTokenOutput::write_token(OutToken type, const std::string &token) -> voi
     }
 
     if (need_ws) {
-        (*m_ostream) << ' ';
+        m_ostream->put(' ');
         ++m_current_line_length;
     }
 
-    (*m_ostream) << token;
+    m_ostream->write(token.data(), static_cast<std::streamsize>(token_length));
     m_current_line_length += token_length;
     m_last_out_token = type;
 }
@@ -701,4 +1456,11 @@ auto PGNTokenOutput::needs_whitespace(OutToken type) const -> bool {
     return false;
 }
 
+template class BasicPGNParser<NoInstrumentation>;
+template class BasicPGNParser<PGNInstrumentation>;
+template class BasicPGNParser<NoInstrumentation, StrictMainlinePGNPolicy>;
+template class BasicPGNParser<PGNInstrumentation, StrictMainlinePGNPolicy>;
+template class BasicPGNWriter<NoInstrumentation>;
+template class BasicPGNWriter<PGNInstrumentation>;
+
 } // namespace chessgame
@@ -0,0 +1,416 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "chessgame/position_index.h"
+
+#include "chessgame/pgn.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHESSGAME_INDEX_SCAN_SSE2
+#endif
+
+namespace chessgame {
+
+namespace {
+
+constexpr std::array<char, 4> index_magic{'C', 'G', 'P', 'X'};
+constexpr uint32_t index_version{3};
+
+struct IndexHeader {
+    std::array<char, 4> magic{index_magic};
+    uint32_t version{index_version};
+    uint64_t data_size{0}; ///< Size of the indexed PGN data.
+    uint64_t data_hash{0}; ///< Hash of the indexed PGN data, see serialization::hash_all_data().
+    uint64_t game_count{0};
+    uint64_t position_count{0};
+};
+
+template<typename T>
+auto write_values(std::ostream &out, const T *values, size_t count) -> void {
+    out.write(reinterpret_cast<const char *>(values), static_cast<std::streamsize>(count * sizeof(T))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+template<typename T>
+auto read_values(std::istream &in, T *values, size_t count) -> bool {
+    in.read(reinterpret_cast<char *>(values), static_cast<std::streamsize>(count * sizeof(T))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    return static_cast<bool>(in);
+}
+
+auto write_offsets(std::ostream &out, const std::vector<size_t> &offsets) -> void {
+    for (const auto offset : offsets) {
+        const auto value = static_cast<uint64_t>(offset);
+        write_values(out, &value, 1);
+    }
+}
+
+auto read_offsets(std::istream &in, std::vector<size_t> &offsets) -> bool {
+    for (auto &offset : offsets) {
+        uint64_t value{};
+        if (!read_values(in, &value, 1)) {
+            return false;
+        }
+        offset = static_cast<size_t>(value);
+    }
+    return true;
+}
+
+constexpr unsigned int black_shift{16};
+
+auto material_shift(chesscore::PieceType type) -> unsigned int {
+    switch (type) {
+    case chesscore::PieceType::Pawn:
+        return 0;
+    case chesscore::PieceType::Knight:
+        return 4;
+    case chesscore::PieceType::Bishop:
+        return 7;
+    case chesscore::PieceType::Rook:
+        return 10;
+    default:
+        return 13;
+    }
+}
+
+auto square_bit(const chesscore::Square &square) -> uint64_t {
+    return uint64_t{1} << static_cast<unsigned int>(square_index(square));
+}
+
+/**
+ * \brief The material and the pawn squares of a position.
+ *
+ * The board is scanned once for the start position, the moves then only
+ * update the pieces they move, capture or promote.
+ */
+class PositionSignature {
+public:
+    explicit PositionSignature(const Board &board) {
+        for (int index = 0; index < 64; ++index) {
+            if (const auto piece = board.piece_at(index); piece.has_value()) {
+                add(*piece, uint64_t{1} << static_cast<unsigned int>(index));
+            }
+        }
+    }
+
+    auto make_move(const chesscore::Move &move) -> void {
+        remove(move.piece, square_bit(move.from));
+        if (move.captured.has_value()) {
+            const auto captured_square = move.capturing_en_passant ? chesscore::Square{move.to.file(), move.from.rank()} : move.to;
+            remove(*move.captured, square_bit(captured_square));
+        }
+        add(move.promoted.value_or(move.piece), square_bit(move.to));
+    }
+
+    [[nodiscard]] auto material() const -> uint32_t {
+        uint32_t signature{0};
+        for (const auto type : {chesscore::PieceType::Pawn, chesscore::PieceType::Knight, chesscore::PieceType::Bishop, chesscore::PieceType::Rook, chesscore::PieceType::Queen}) {
+            const auto limit = type == chesscore::PieceType::Pawn ? 15U : 7U;
+            for (const auto shift : {material_shift(type), material_shift(type) + black_shift}) {
+                signature |= std::min(m_counts[shift], limit) << shift;
+            }
+        }
+        return signature;
+    }
+
+    [[nodiscard]] auto pawns(chesscore::Color color) const -> uint64_t { return m_pawns[color == chesscore::Color::White ? 0 : 1]; }
+private:
+    std::array<uint32_t, 2 * black_shift> m_counts{}; ///< Number of pieces, indexed by their shift in the material signature.
+    std::array<uint64_t, 2> m_pawns{};                ///< Pawn squares of white and black.
+
+    auto add(const chesscore::Piece &piece, uint64_t square) -> void { update(piece, square, 1); }
+    auto remove(const chesscore::Piece &piece, uint64_t square) -> void { update(piece, square, -1); }
+
+    auto update(const chesscore::Piece &piece, uint64_t square, int change) -> void {
+        if (piece.type == chesscore::PieceType::King) {
+            return;
+        }
+        const auto black = piece.color == chesscore::Color::Black;
+        auto &count = m_counts[material_shift(piece.type) + (black ? black_shift : 0U)];
+        count = static_cast<uint32_t>(static_cast<int>(count) + change);
+        if (piece.type == chesscore::PieceType::Pawn) {
+            m_pawns[black ? 1 : 0] ^= square;
+        }
+    }
+};
+
+/**
+ * \brief The conditions of a query, prepared for the scan.
+ */
+struct ScanConditions {
+    explicit ScanConditions(const PositionQuery &query)
+        : key{query.key.value_or(0)}, material{query.material.value_or(0)}, white_required{query.white_pawns}, black_required{query.black_pawns},
+          white_mask{query.white_pawns | query.no_white_pawns}, black_mask{query.black_pawns | query.no_black_pawns}, check_key{query.key.has_value()},
+          check_material{query.material.has_value()}, check_pawns{white_mask != 0 || black_mask != 0} {}
+
+    uint64_t key;
+    uint32_t material;
+    uint64_t white_required;
+    uint64_t black_required;
+    uint64_t white_mask;
+    uint64_t black_mask;
+    bool check_key;
+    bool check_material;
+    bool check_pawns;
+
+    [[nodiscard]] auto matches(uint64_t position_key, uint32_t position_material, uint64_t white_pawns, uint64_t black_pawns) const -> bool {
+        return (!check_key || position_key == key) && (!check_material || position_material == material) &&
+               (!check_pawns || ((white_pawns & white_mask) == white_required && (black_pawns & black_mask) == black_required));
+    }
+};
+
+#ifdef CHESSGAME_INDEX_SCAN_SSE2
+
+/**
+ * \brief Compare two 64-bit lanes for equality.
+ *
+ * SSE2 only compares 32-bit lanes, a 64-bit lane is equal, if both halves are.
+ */
+auto equal_64(__m128i lhs, __m128i rhs) -> __m128i {
+    const auto equal = _mm_cmpeq_epi32(lhs, rhs);
+    return _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+auto load_lanes(const uint64_t *values) -> __m128i {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(values)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+auto splat(uint64_t value) -> __m128i {
+    return _mm_set1_epi64x(static_cast<long long>(value));
+}
+
+#endif
+
+} // namespace
+
+auto material_signature(const Board &board) -> uint32_t {
+    return PositionSignature{board}.material();
+}
+
+auto pawn_squares(const Board &board, chesscore::Color color) -> uint64_t {
+    return PositionSignature{board}.pawns(color);
+}
+
+template<typename NextMove>
+auto PositionIndex::add_positions(Board board, NextMove next_move) -> void {
+    PositionSignature signature{board};
+    while (true) {
+        m_keys.push_back(board.key());
+        m_material.push_back(signature.material());
+        m_white_pawns.push_back(signature.pawns(chesscore::Color::White));
+        m_black_pawns.push_back(signature.pawns(chesscore::Color::Black));
+        const auto move = next_move(std::as_const(board));
+        if (!move.has_value()) {
+            return;
+        }
+        board.make_move(*move);
+        signature.make_move(*move);
+    }
+}
+
+auto PositionIndex::add_game(size_t game_offset, const MainlineGame &game) -> void {
+    m_game_offsets.push_back(game_offset);
+    m_game_positions.push_back(m_keys.size());
+    auto board = game.start_board();
+    if (!board.has_value()) {
+        return;
+    }
+    const auto codes = game.move_codes();
+    add_positions(*board, [&, ply = size_t{0}](const Board &current) mutable -> std::optional<chesscore::Move> {
+        return ply < codes.size() ? decode_compact_move(codes[ply++], current) : std::nullopt;
+    });
+}
+
+auto PositionIndex::add_game(size_t game_offset, const Game &game) -> void {
+    m_game_offsets.push_back(game_offset);
+    m_game_positions.push_back(m_keys.size());
+    const auto board = game.board(GameTree::root_id);
+    if (!board.has_value()) {
+        return;
+    }
+    const auto mainline = game.view().mainline();
+    add_positions(*board, [node = mainline.begin()](const Board &) mutable -> std::optional<chesscore::Move> {
+        if (node == std::default_sentinel) {
+            return std::nullopt;
+        }
+        return (*node++).move();
+    });
+}
+
+template<typename Visitor>
+auto PositionIndex::scan(const PositionQuery &query, Visitor visitor) const -> void {
+    const ScanConditions conditions{query};
+    const auto count = m_keys.size();
+    size_t position{0};
+#ifdef CHESSGAME_INDEX_SCAN_SSE2
+    const auto key = splat(conditions.key);
+    const auto material = _mm_set1_epi32(static_cast<int>(conditions.material));
+    const auto white_required = splat(conditions.white_required);
+    const auto black_required = splat(conditions.black_required);
+    const auto white_mask = splat(conditions.white_mask);
+    const auto black_mask = splat(conditions.black_mask);
+    for (; position + 2 <= count; position += 2) {
+        auto matches = _mm_set1_epi32(-1);
+        if (conditions.check_key) {
+            matches = _mm_and_si128(matches, equal_64(load_lanes(&m_keys[position]), key));
+        }
+        if (conditions.check_material) {
+            // Duplicate the two 32-bit signatures, so that they fill the 64-bit lanes.
+            const auto signatures = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(&m_material[position])); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            matches = _mm_and_si128(matches, _mm_cmpeq_epi32(_mm_unpacklo_epi32(signatures, signatures), material));
+        }
+        if (conditions.check_pawns) {
+            matches = _mm_and_si128(matches, equal_64(_mm_and_si128(load_lanes(&m_white_pawns[position]), white_mask), white_required));
+            matches = _mm_and_si128(matches, equal_64(_mm_and_si128(load_lanes(&m_black_pawns[position]), black_mask), black_required));
+        }
+        const auto lanes = _mm_movemask_pd(_mm_castsi128_pd(matches));
+        if (lanes == 0) {
+            continue;
+        }
+        if ((lanes & 1) != 0 && !visitor(position)) {
+            return;
+        }
+        if ((lanes & 2) != 0 && !visitor(position + 1)) {
+            return;
+        }
+    }
+#endif
+    for (; position < count; ++position) {
+        if (conditions.matches(m_keys[position], m_material[position], m_white_pawns[position], m_black_pawns[position]) && !visitor(position)) {
+            return;
+        }
+    }
+}
+
+auto PositionIndex::find(const PositionQuery &query, size_t max_matches) const -> std::vector<PositionMatch> {
+    std::vector<PositionMatch> matches;
+    if (max_matches == 0) {
+        return matches;
+    }
+    size_t game{0};
+    scan(query, [&](size_t position) {
+        // Matches are found in ascending order, so the game only moves forward.
+        while (game + 1 < m_game_positions.size() && m_game_positions[game + 1] <= position) {
+            ++game;
+        }
+        matches.push_back(PositionMatch{.game_offset = m_game_offsets[game], .ply = position - m_game_positions[game]});
+        return matches.size() < max_matches;
+    });
+    return matches;
+}
+
+auto PositionIndex::find_games(const PositionQuery &query) const -> std::vector<PositionMatch> {
+    std::vector<PositionMatch> matches;
+    size_t game{0};
+    bool matched_game{false};
+    scan(query, [&](size_t position) {
+        while (game + 1 < m_game_positions.size() && m_game_positions[game + 1] <= position) {
+            ++game;
+            matched_game = false;
+        }
+        if (!matched_game) {
+            matches.push_back(PositionMatch{.game_offset = m_game_offsets[game], .ply = position - m_game_positions[game]});
+            matched_game = true;
+        }
+        return true;
+    });
+    return matches;
+}
+
+auto PositionIndex::save(const std::filesystem::path &path, std::string_view data) const -> bool {
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    if (!out) {
+        return false;
+    }
+    const IndexHeader header{
+        .data_size = data.size(),
+        .data_hash = serialization::hash_all_data(data),
+        .game_count = m_game_offsets.size(),
+        .position_count = m_keys.size(),
+    };
+    write_values(out, &header, 1);
+    write_offsets(out, m_game_offsets);
+    write_offsets(out, m_game_positions);
+    write_values(out, m_keys.data(), m_keys.size());
+    write_values(out, m_material.data(), m_material.size());
+    write_values(out, m_white_pawns.data(), m_white_pawns.size());
+    write_values(out, m_black_pawns.data(), m_black_pawns.size());
+    return static_cast<bool>(out);
+}
+
+auto PositionIndex::load(const std::filesystem::path &path, std::string_view data) -> std::optional<PositionIndex> {
+    std::ifstream in{path, std::ios::binary};
+    if (!in) {
+        return std::nullopt;
+    }
+    IndexHeader header{};
+    if (!read_values(in, &header, 1) || header.magic != index_magic || header.version != index_version) {
+        return std::nullopt;
+    }
+    if (header.data_size != data.size() || header.data_hash != serialization::hash_all_data(data)) {
+        return std::nullopt;
+    }
+    // Check the sizes against the file, before allocating the columns.
+    constexpr auto game_bytes = 2 * sizeof(uint64_t);
+    constexpr auto position_bytes = 3 * sizeof(uint64_t) + sizeof(uint32_t);
+    std::error_code error;
+    const auto file_size = std::filesystem::file_size(path, error);
+    if (error || header.game_count > file_size / game_bytes || header.position_count > file_size / position_bytes ||
+        sizeof(IndexHeader) + header.game_count * game_bytes + header.position_count * position_bytes != file_size) {
+        return std::nullopt;
+    }
+    PositionIndex index;
+    index.m_game_offsets.resize(static_cast<size_t>(header.game_count));
+    index.m_game_positions.resize(static_cast<size_t>(header.game_count));
+    const auto position_count = static_cast<size_t>(header.position_count);
+    index.m_keys.resize(position_count);
+    index.m_material.resize(position_count);
+    index.m_white_pawns.resize(position_count);
+    index.m_black_pawns.resize(position_count);
+    if (!read_offsets(in, index.m_game_offsets) || !read_offsets(in, index.m_game_positions) || !read_values(in, index.m_keys.data(), position_count) ||
+        !read_values(in, index.m_material.data(), position_count) || !read_values(in, index.m_white_pawns.data(), position_count) ||
+        !read_values(in, index.m_black_pawns.data(), position_count)) {
+        return std::nullopt;
+    }
+    if (!index.m_game_positions.empty() && (index.m_game_positions.front() != 0 || index.m_game_positions.back() > position_count)) {
+        return std::nullopt;
+    }
+    if (!std::ranges::is_sorted(index.m_game_positions)) {
+        return std::nullopt;
+    }
+    return index;
+}
+
+auto build_position_index(std::string_view data, const std::vector<size_t> &offsets) -> PositionIndex {
+    PositionIndex index;
+    PGNParser parser{std::string_view{}};
+    for (size_t game = 0; game < offsets.size(); ++game) {
+        const auto end = game + 1 < offsets.size() ? offsets[game + 1] : data.size();
+        parser.set_input(data.substr(offsets[game], end - offsets[game]));
+        try {
+            if (const auto mainline = parser.read_mainline_game(); mainline.has_value()) {
+                index.add_game(offsets[game], *mainline);
+            }
+        } catch (const ChessGameError &) {
+            // Games, that cannot be parsed or have an invalid start position, are not indexed.
+        }
+    }
+    return index;
+}
+
+auto build_position_index(std::string_view data) -> PositionIndex {
+    return build_position_index(data, scan_game_offsets(data));
+}
+
+auto build_position_index(const PGNDatabase &database) -> PositionIndex {
+    return build_position_index(database.data(), database.offsets());
+}
+
+} // namespace chessgame
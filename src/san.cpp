@@ -7,8 +7,6 @@
 
 #include "chesscore/piece.h"
 #include <ranges>
-#include <set>
-#include <sstream>
 #include <string_view>
 
 namespace chessgame {
@@ -112,7 +110,7 @@ auto get_suffix_annotation(std::string_view str) -> std::expected<SuffixAnnotati
     return std::unexpected(SANParserError{.error_type = SANParserErrorType::InvalidSuffixAnnotation, .san = std::string{str}});
 }
 
-auto parse_suffixes(const std::string &san, SANMove &move, std::string_view &san_str, SANToken &token) -> std::optional<SANParserError> {
+auto parse_suffixes(std::string_view san, SANMove &move, std::string_view &san_str, SANToken &token) -> std::optional<SANParserError> {
     if (token.type == TokenType::Check) {
         move.check_state = chesscore::CheckState::Check;
         san_str = san_str.substr(1);
@@ -120,7 +118,7 @@ auto parse_suffixes(const std::string &san, SANMove &move, std::string_view &san
     }
     if (token.type == TokenType::Checkmate) {
         if (move.check_state != chesscore::CheckState::None) {
-            return SANParserError{.error_type = SANParserErrorType::CheckAndCheckmate, .san = san};
+            return SANParserError{.error_type = SANParserErrorType::CheckAndCheckmate, .san = std::string{san}};
         }
         move.check_state = chesscore::CheckState::Checkmate;
         san_str = san_str.substr(1);
@@ -128,7 +126,7 @@ auto parse_suffixes(const std::string &san, SANMove &move, std::string_view &san
     }
     if (token.type == TokenType::Check) {
         if (move.check_state != chesscore::CheckState::None) {
-            return SANParserError{.error_type = SANParserErrorType::CheckAndCheckmate, .san = san};
+            return SANParserError{.error_type = SANParserErrorType::CheckAndCheckmate, .san = std::string{san}};
         }
         move.check_state = chesscore::CheckState::Check;
         san_str = san_str.substr(1);
@@ -145,12 +143,12 @@ auto parse_suffixes(const std::string &san, SANMove &move, std::string_view &san
     return std::nullopt;
 }
 
-auto parse_promotions(const std::string &san, chesscore::Color &side_to_move, SANMove &move, std::string_view &san_str, SANToken &token) -> std::optional<SANParserError> {
+auto parse_promotions(std::string_view san, chesscore::Color &side_to_move, SANMove &move, std::string_view &san_str, SANToken &token) -> std::optional<SANParserError> {
     if (token.type == TokenType::Promotion) {
         san_str = san_str.substr(1);
         token = get_token(san_str);
         if (token.type != TokenType::PieceType) {
-            return SANParserError{.error_type = SANParserErrorType::MissingPieceType, .san = san};
+            return SANParserError{.error_type = SANParserErrorType::MissingPieceType, .san = std::string{san}};
         }
         move.promotion = chesscore::Piece{.type = chesscore::piece_type_from_char(token.value[0]), .color = side_to_move};
         san_str = san_str.substr(1);
@@ -203,7 +201,7 @@ auto parse_capture(SANMove &move, std::string_view &san_str, SANToken &token) ->
     }
 }
 
-auto parse_target_square(const std::string &san, SANMove &move, std::string_view &san_str, SANToken &token) -> std::optional<SANParserError> {
+auto parse_target_square(std::string_view san, SANMove &move, std::string_view &san_str, SANToken &token) -> std::optional<SANParserError> {
     if (token.type == TokenType::File) {
         chesscore::File to_file{token.value[0]};
         const auto rank_token = get_token(san_str.substr(1));
@@ -217,14 +215,14 @@ auto parse_target_square(const std::string &san, SANMove &move, std::string_view
             san_str = san_str.substr(2);
             token = get_token(san_str);
         } else {
-            return SANParserError{.error_type = SANParserErrorType::MissingRank, .san = san};
+            return SANParserError{.error_type = SANParserErrorType::MissingRank, .san = std::string{san}};
         }
     } else {
         if (move.possible_disambiguation) {
             move.target_square = chesscore::Square{move.target_file, move.target_rank};
             move.possible_disambiguation = false;
         } else {
-            return SANParserError{.error_type = SANParserErrorType::MissingFile, .san = san};
+            return SANParserError{.error_type = SANParserErrorType::MissingFile, .san = std::string{san}};
         }
     }
     return std::nullopt;
@@ -233,7 +231,7 @@ auto parse_target_square(const std::string &san, SANMove &move, std::string_view
 const std::string long_castling{"O-O-O"};
 const std::string short_castling{"O-O"};
 
-auto parse_castling_move(const std::string &san, chesscore::Color side_to_move, SANMove &move, std::string_view san_str) -> std::optional<SANParserError> {
+auto parse_castling_move(std::string_view san, chesscore::Color side_to_move, SANMove &move, std::string_view san_str) -> std::optional<SANParserError> {
     move.moving_piece = chesscore::Piece{.type = chesscore::PieceType::King, .color = side_to_move};
     chesscore::Square target_square;
     SANToken token;
@@ -270,25 +268,21 @@ auto san_move_matches_any_piece_type(const SANMove &san_move, const chesscore::M
     return true;
 }
 
-auto find_piece_moves_to_target(chesscore::Piece piece, chesscore::Square target, const chesscore::MoveList &moves) -> chesscore::MoveList {
-    return moves | std::views::filter([&piece, &target](const chesscore::Move &move) { return move.piece == piece && move.to == target; }) | std::ranges::to<chesscore::MoveList>();
+auto is_disambiguation_candidate(const chesscore::Move &move, const chesscore::Move &other_move) -> bool {
+    return other_move.piece == move.piece && other_move.to == move.to;
 }
 
 using Disambiguation = std::pair<std::optional<chesscore::File>, std::optional<chesscore::Rank>>;
 
-auto determine_disambiguation(const chesscore::Move &move, const chesscore::MoveList &moves) -> Disambiguation {
-    std::set<chesscore::File> files{};
-    std::set<chesscore::Rank> ranks{};
-
-    for (const auto &other_move : moves) {
-        files.insert(other_move.from.file());
-        ranks.insert(other_move.from.rank());
+auto select_disambiguation(const chesscore::Move &move, size_t candidates, bool distinct_files, bool distinct_ranks) -> Disambiguation {
+    if (move.piece.type == chesscore::PieceType::Pawn || candidates < 2) {
+        return {};
     }
-    if (files.size() == moves.size()) {
+    if (distinct_files) {
         // all files are different
         return std::make_pair(move.from.file(), std::nullopt);
     }
-    if (ranks.size() == moves.size()) {
+    if (distinct_ranks) {
         // all ranks are different
         return std::make_pair(std::nullopt, move.from.rank());
     }
@@ -296,6 +290,68 @@ auto determine_disambiguation(const chesscore::Move &move, const chesscore::Move
     return std::make_pair(move.from.file(), move.from.rank());
 }
 
+auto determine_disambiguation(const chesscore::Move &move, const chesscore::MoveList &moves) -> Disambiguation {
+    size_t candidates{0};
+    bool distinct_files{true};
+    bool distinct_ranks{true};
+    for (auto first = moves.begin(); first != moves.end(); ++first) {
+        if (!is_disambiguation_candidate(move, *first)) {
+            continue;
+        }
+        ++candidates;
+        for (auto second = std::next(first); second != moves.end(); ++second) {
+            if (is_disambiguation_candidate(move, *second)) {
+                distinct_files = distinct_files && first->from.file() != second->from.file();
+                distinct_ranks = distinct_ranks && first->from.rank() != second->from.rank();
+            }
+        }
+    }
+    return select_disambiguation(move, candidates, distinct_files, distinct_ranks);
+}
+
+auto determine_disambiguation(const chesscore::Move &move, std::span<const chesscore::Square> origins) -> Disambiguation {
+    bool distinct_files{true};
+    bool distinct_ranks{true};
+    for (auto first = origins.begin(); first != origins.end(); ++first) {
+        for (auto second = std::next(first); second != origins.end(); ++second) {
+            distinct_files = distinct_files && first->file() != second->file();
+            distinct_ranks = distinct_ranks && first->rank() != second->rank();
+        }
+    }
+    return select_disambiguation(move, origins.size(), distinct_files, distinct_ranks);
+}
+
+auto append_rank(std::string &out, chesscore::Rank rank) -> void {
+    out.push_back(static_cast<char>('0' + rank.rank));
+}
+
+auto append_san_string(std::string &out, const chesscore::Move &move, const Disambiguation &disambiguation) -> void {
+    if (move.is_castling()) {
+        out.append((move.to.file() == chesscore::File{'c'}) ? "O-O-O" : "O-O");
+        return;
+    }
+    if (move.piece.type != chesscore::PieceType::Pawn) {
+        out.push_back(move.piece.piece_char_colorless());
+    } else if (move.captured.has_value()) {
+        out.push_back(move.from.file().name());
+    }
+    if (disambiguation.first.has_value()) {
+        out.push_back(disambiguation.first.value().name());
+    }
+    if (disambiguation.second.has_value()) {
+        append_rank(out, disambiguation.second.value());
+    }
+    if (move.captured.has_value()) {
+        out.push_back('x');
+    }
+    out.push_back(move.to.file().name());
+    append_rank(out, move.to.rank());
+    if (move.promoted.has_value()) {
+        out.push_back('=');
+        out.push_back(move.promoted.value().piece_char_colorless());
+    }
+}
+
 } // namespace
 
 auto convert_to_nag(SuffixAnnotation annotation) -> int {
@@ -336,7 +392,7 @@ auto to_string(SANParserErrorType type) -> std::string {
     return "UNKNOWN ERROR TYPE";
 }
 
-auto parse_san(const std::string &san, chesscore::Color side_to_move) -> std::expected<SANMove, SANParserError> {
+auto parse_san(std::string_view san, chesscore::Color side_to_move) -> std::expected<SANMove, SANParserError> {
     SANMove move;
     move.san_string = san;
     std::string_view san_str{san};
@@ -350,7 +406,7 @@ auto parse_san(const std::string &san, chesscore::Color side_to_move) -> std::ex
 
     auto token = get_token(san_str);
     if (token.type == TokenType::Invalid) {
-        return std::unexpected(SANParserError{.error_type = SANParserErrorType::UnexpectedToken, .san = san});
+        return std::unexpected(SANParserError{.error_type = SANParserErrorType::UnexpectedToken, .san = std::string{san}});
     }
 
     parse_piece_type(side_to_move, move, san_str, token);
@@ -370,7 +426,7 @@ auto parse_san(const std::string &san, chesscore::Color side_to_move) -> std::ex
     }
 
     if (!san_str.empty()) {
-        return std::unexpected(SANParserError{.error_type = SANParserErrorType::UnexpectedCharsAtEnd, .san = san});
+        return std::unexpected(SANParserError{.error_type = SANParserErrorType::UnexpectedCharsAtEnd, .san = std::string{san}});
     }
 
     return move;
@@ -393,44 +449,17 @@ auto match_san_move_wildcard_piece_type(const SANMove &san_move, const chesscore
 }
 
 auto generate_san_move(const chesscore::Move &move, const chesscore::MoveList &moves) -> std::optional<SANMove> {
-    std::stringstream san_string;
     if (!chesscore::move_list_contains(moves, move, chesscore::FullMoveCompare{})) {
         return std::nullopt;
     }
     if (move.is_castling()) {
         return SANMove{.san_string = (move.to.file() == chesscore::File{'c'}) ? "O-O-O" : "O-O", .moving_piece = move.piece, .target_square = move.to};
     }
-    const auto matching_moves = find_piece_moves_to_target(move.piece, move.to, moves);
-    if (matching_moves.empty()) {
-        return std::nullopt;
-    }
-    Disambiguation disambiguation{};
-
-    if (move.piece.type != chesscore::PieceType::Pawn) {
-        san_string << move.piece.piece_char_colorless();
-    }
-    if (move.piece.type == chesscore::PieceType::Pawn) {
-        if (move.captured.has_value()) {
-            san_string << move.from.file().name();
-        }
-    } else if (matching_moves.size() > 1) {
-        disambiguation = determine_disambiguation(move, matching_moves);
-        if (disambiguation.first.has_value()) {
-            san_string << disambiguation.first.value().name();
-        }
-        if (disambiguation.second.has_value()) {
-            san_string << std::to_string(disambiguation.second.value().rank);
-        }
-    }
-    if (move.captured.has_value()) {
-        san_string << 'x';
-    }
-    san_string << to_string(move.to);
-    if (move.promoted.has_value()) {
-        san_string << '=' << move.promoted.value().piece_char_colorless();
-    }
+    const auto disambiguation = determine_disambiguation(move, moves);
+    std::string san_string;
+    append_san_string(san_string, move, disambiguation);
     return SANMove{
-        .san_string = san_string.str(),
+        .san_string = std::move(san_string),
         .moving_piece = move.piece,
         .target_square = move.to,
         .capturing = move.captured.has_value(),
@@ -440,4 +469,16 @@ auto generate_san_move(const chesscore::Move &move, const chesscore::MoveList &m
     };
 }
 
+auto append_san_move(std::string &out, const chesscore::Move &move, const chesscore::MoveList &moves) -> bool {
+    if (!chesscore::move_list_contains(moves, move, chesscore::FullMoveCompare{})) {
+        return false;
+    }
+    append_san_string(out, move, move.is_castling() ? Disambiguation{} : determine_disambiguation(move, moves));
+    return true;
+}
+
+auto append_san_move(std::string &out, const chesscore::Move &move, std::span<const chesscore::Square> origins) -> void {
+    append_san_string(out, move, move.is_castling() ? Disambiguation{} : determine_disambiguation(move, origins));
+}
+
 } // namespace chessgame
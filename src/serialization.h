@@ -0,0 +1,194 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_SERIALIZATION_H
+#define CHESSGAME_SERIALIZATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "chessgame/types.h"
+
+/**
+ * \brief Helpers for the binary formats of the library.
+ *
+ * Fixed-size integers are stored in little endian byte order, variable-size
+ * integers as LEB128 varints with 7 bits per byte.
+ */
+namespace chessgame::serialization {
+
+/**
+ * \brief Append a fixed-size integer.
+ *
+ * \param out The output.
+ * \param value The value.
+ * \param byte_count Number of bytes of the value.
+ */
+inline auto append_fixed(std::string &out, uint64_t value, size_t byte_count) -> void {
+    for (size_t byte = 0; byte < byte_count; ++byte) {
+        out.push_back(static_cast<char>(value & 0xFFU));
+        value >>= 8U;
+    }
+}
+
+inline auto append_u32(std::string &out, uint32_t value) -> void {
+    append_fixed(out, value, 4);
+}
+
+inline auto append_u64(std::string &out, uint64_t value) -> void {
+    append_fixed(out, value, 8);
+}
+
+inline auto append_varint(std::string &out, uint64_t value) -> void {
+    while (value >= 0x80U) {
+        out.push_back(static_cast<char>((value & 0x7FU) | 0x80U));
+        value >>= 7U;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * \brief Append a string, prefixed by its size.
+ *
+ * \param out The output.
+ * \param value The string.
+ */
+inline auto append_string(std::string &out, std::string_view value) -> void {
+    append_varint(out, value.size());
+    out.append(value);
+}
+
+/// Number of bytes at the start and at the end of the data, that are hashed by hash_data().
+constexpr size_t hashed_block_size{64UL * 1024UL};
+
+/**
+ * \brief Continue an FNV-1a hash with a block of data.
+ *
+ * \param hash The hash of the preceding data.
+ * \param block The data.
+ * \return The hash.
+ */
+inline auto hash_block(uint64_t hash, std::string_view block) -> uint64_t {
+    for (const char character : block) {
+        hash = (hash ^ static_cast<unsigned char>(character)) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/// Initial value of an FNV-1a hash.
+constexpr uint64_t hash_offset_basis{0xCBF29CE484222325ULL};
+
+/**
+ * \brief FNV-1a hash of the first and the last block of the data.
+ *
+ * Identifies the PGN data, that an index file belongs to, without reading
+ * all of it.
+ * \param data The data.
+ * \return The hash.
+ */
+inline auto hash_data(std::string_view data) -> uint64_t {
+    auto hash = hash_block(hash_offset_basis, data.substr(0, hashed_block_size));
+    if (data.size() > hashed_block_size) {
+        hash = hash_block(hash, data.substr(std::max(data.size() - hashed_block_size, hashed_block_size)));
+    }
+    return hash;
+}
+
+/**
+ * \brief FNV-1a hash of all of the data.
+ *
+ * Detects any change of the data, for files that are not identified by
+ * their path and modification time.
+ * \param data The data.
+ * \return The hash.
+ */
+inline auto hash_all_data(std::string_view data) -> uint64_t {
+    return hash_block(hash_offset_basis, data);
+}
+
+/**
+ * \brief Reads the values written by the append functions.
+ *
+ * Reading beyond the end of the data or reading malformed values throws a
+ * ChessGameError with the message given to the constructor.
+ */
+class ByteDecoder {
+public:
+    /**
+     * \brief Create a decoder.
+     *
+     * \param data The data.
+     * \param error_message Message of the errors about corrupted data. Has to outlive the decoder.
+     */
+    ByteDecoder(std::string_view data, std::string_view error_message) : m_data{data}, m_error_message{error_message} {}
+
+    [[nodiscard]] auto at_end() const -> bool { return m_pos == m_data.size(); }
+
+    [[noreturn]] auto corrupted() const -> void { throw ChessGameError{std::string{m_error_message}}; }
+
+    auto read_fixed(size_t byte_count) -> uint64_t {
+        const auto bytes = read_bytes(byte_count);
+        uint64_t value{0};
+        for (size_t byte = byte_count; byte > 0; --byte) {
+            value = (value << 8U) | static_cast<unsigned char>(bytes[byte - 1]);
+        }
+        return value;
+    }
+
+    auto read_u8() -> uint8_t { return static_cast<uint8_t>(read_fixed(1)); }
+
+    auto read_u32() -> uint32_t { return static_cast<uint32_t>(read_fixed(4)); }
+
+    auto read_u64() -> uint64_t { return read_fixed(8); }
+
+    auto read_varint() -> uint64_t {
+        uint64_t value{0};
+        for (uint32_t shift = 0; shift < 64; shift += 7) {
+            const auto byte = static_cast<unsigned char>(read_bytes(1)[0]);
+            value |= static_cast<uint64_t>(byte & 0x7FU) << shift;
+            if ((byte & 0x80U) == 0) {
+                return value;
+            }
+        }
+        corrupted();
+    }
+
+    /**
+     * \brief Read the number of bytes or items that follow.
+     *
+     * Every item takes at least one byte, so the size can never exceed the
+     * remaining data.
+     */
+    auto read_size() -> size_t {
+        const auto value = read_varint();
+        if (value > m_data.size() - m_pos) {
+            corrupted();
+        }
+        return static_cast<size_t>(value);
+    }
+
+    auto read_string() -> std::string_view { return read_bytes(read_size()); }
+
+    auto read_bytes(size_t count) -> std::string_view {
+        if (count > m_data.size() - m_pos) {
+            corrupted();
+        }
+        const auto bytes = m_data.substr(m_pos, count);
+        m_pos += count;
+        return bytes;
+    }
+private:
+    std::string_view m_data;          ///< The data.
+    std::string_view m_error_message; ///< Message of the errors about corrupted data.
+    size_t m_pos{0};                  ///< Position of the next byte to read.
+};
+
+} // namespace chessgame::serialization
+
+#endif
@@ -6,38 +6,217 @@
 #include "chessgame/tree.h"
 #include "chessgame/types.h"
 
+#include <algorithm>
+#include <ranges>
+
 namespace chessgame {
 
 const NodeId NodeId::Invalid{0};
 
-auto GameNode::append_child(const std::shared_ptr<GameNode> &child) -> std::shared_ptr<GameNode> {
-    const auto iterator = std::ranges::find_if(m_children, [&](const auto &node) { return node->move() == child->move(); });
-    if (iterator == m_children.end()) {
-        m_children.push_back(child);
-        return child;
+GameTree::GameTree(const chesscore::Position &root_position, std::pmr::memory_resource *resource)
+    : m_nodes{resource}, m_comments{resource}, m_premove_comments{resource}, m_nags{resource}, m_positions{resource}, m_boards{resource}, m_key_index{resource} {
+    m_nodes.emplace_back();
+    m_positions.emplace(root_id.value, root_position);
+}
+
+GameTree::GameTree(const GameTree &other, std::pmr::memory_resource *resource)
+    : m_nodes{other.m_nodes, resource}, m_comments{other.m_comments, resource}, m_premove_comments{other.m_premove_comments, resource},
+      m_nags{other.m_nags, resource}, m_positions{other.m_positions, resource}, m_boards{other.m_boards, resource}, m_key_index{other.m_key_index, resource} {}
+
+auto GameTree::clear(const chesscore::Position &root_position) -> void {
+    m_nodes.clear();
+    m_nodes.emplace_back();
+    m_comments.clear();
+    m_premove_comments.clear();
+    m_nags.clear();
+    // The entry of the root position is kept, so that reusing a tree for the
+    // next game does not allocate it again.
+    std::erase_if(m_positions, [](const auto &entry) { return entry.first != root_id.value; });
+    m_positions.insert_or_assign(root_id.value, root_position);
+    m_boards.clear();
+    m_key_index.invalidate();
+}
+
+auto GameTree::memory_usage() const -> MemoryUsage {
+    MemoryUsage usage{};
+    usage.nodes = m_nodes.size();
+    usage.positions = m_positions.size();
+    usage.node_bytes = sizeof(GameTree) + heap_bytes(m_nodes);
+    usage.comment_bytes = table_bytes(m_comments) + table_bytes(m_premove_comments);
+    for (const auto &[id, comment] : m_comments) {
+        usage.comment_bytes += heap_bytes(comment);
+    }
+    for (const auto &[id, comment] : m_premove_comments) {
+        usage.comment_bytes += heap_bytes(comment);
     }
-    return *iterator;
+    usage.nag_bytes = table_bytes(m_nags);
+    for (const auto &[id, nags] : m_nags) {
+        usage.nag_bytes += heap_bytes(nags);
+    }
+    usage.position_bytes = table_bytes(m_positions) + table_bytes(m_boards);
+    usage.index_bytes = m_key_index.memory_usage();
+    return usage;
 }
 
-auto GameNode::calculate_position() const -> chesscore::Position {
-    if (m_position.has_value()) {
-        return *m_position;
+auto GameTree::memory_usage(NodeId node_id) const -> MemoryUsage {
+    MemoryUsage usage{};
+    usage.nodes = 1;
+    usage.node_bytes = sizeof(GameNode);
+    if (const auto entry = m_comments.find(node_id.value); entry != m_comments.end()) {
+        usage.comment_bytes += table_entry_bytes<decltype(m_comments)>() + heap_bytes(entry->second);
+    }
+    if (const auto entry = m_premove_comments.find(node_id.value); entry != m_premove_comments.end()) {
+        usage.comment_bytes += table_entry_bytes<decltype(m_premove_comments)>() + heap_bytes(entry->second);
+    }
+    if (const auto entry = m_nags.find(node_id.value); entry != m_nags.end()) {
+        usage.nag_bytes = table_entry_bytes<decltype(m_nags)>() + heap_bytes(entry->second);
+    }
+    if (m_positions.contains(node_id.value)) {
+        usage.positions = 1;
+        usage.position_bytes = table_entry_bytes<decltype(m_positions)>();
+    }
+    if (m_boards.contains(node_id.value)) {
+        usage.position_bytes += table_entry_bytes<decltype(m_boards)>();
+    }
+    if (node(node_id).m_key != 0) {
+        usage.index_bytes = sizeof(KeyIndex::Entry);
     }
+    return usage;
+}
+
+auto GameTree::child_count(NodeId node_id) const -> size_t {
+    size_t count{0};
+    for (auto child_id = node(node_id).m_first_child; child_id != NodeId::Invalid; child_id = node(child_id).m_next_sibling) {
+        ++count;
+    }
+    return count;
+}
+
+auto GameTree::child(NodeId node_id, size_t index) const -> NodeId {
+    auto child_id = node(node_id).m_first_child;
+    for (; child_id != NodeId::Invalid && index > 0; --index) {
+        child_id = node(child_id).m_next_sibling;
+    }
+    return child_id;
+}
+
+auto GameTree::child_number(NodeId node_id) const -> int {
+    const auto parent_id = node(node_id).m_parent;
+    if (parent_id == NodeId::Invalid) {
+        return 0;
+    }
+    int number{0};
+    for (auto child_id = node(parent_id).m_first_child; child_id != node_id; child_id = node(child_id).m_next_sibling) {
+        ++number;
+    }
+    return number;
+}
 
-    if (const auto parent = m_parent.lock(); parent) {
-        auto position = parent->calculate_position();
-        position.make_move(m_move);
-        return position;
+auto GameTree::add_child(NodeId parent, const chesscore::Move &move) -> std::pair<NodeId, bool> {
+    auto *link = &mutable_node(parent).m_first_child;
+    while (*link != NodeId::Invalid) {
+        if (node(*link).m_move == move) {
+            return {*link, false};
+        }
+        link = &mutable_node(*link).m_next_sibling;
     }
-    throw ChessGameError{"No ancestor with position information found"};
+    const NodeId child_id{static_cast<uint32_t>(m_nodes.size() + 1)};
+    // The link points into m_nodes, so it has to be set before the vector grows.
+    *link = child_id;
+    m_nodes.emplace_back(move, parent, node(parent).m_ply + 1);
+    return {child_id, true};
 }
 
-auto GameNode::get_child_number(const std::shared_ptr<GameNode> &child) const -> int {
-    const auto iterator = std::ranges::find(m_children, child);
-    if (iterator != m_children.end()) {
-        return static_cast<int>(std::distance(m_children.begin(), iterator));
+auto GameTree::set_san(NodeId node_id, std::string_view san) -> void {
+    auto &san_node = mutable_node(node_id);
+    if (san.size() > GameNode::max_san_length) {
+        san_node.m_san_length = 0;
+        return;
+    }
+    std::ranges::copy(san, san_node.m_san.begin());
+    san_node.m_san_length = static_cast<uint8_t>(san.size());
+}
+
+auto GameTree::set_position_key(NodeId node_id, uint64_t key) -> void {
+    auto &key_node = mutable_node(node_id);
+    if (key_node.m_key != key) {
+        key_node.m_key = key;
+        m_key_index.invalidate();
+    }
+}
+
+auto GameTree::find_position(uint64_t key) const -> NodeId {
+    const auto entries = m_key_index.find(m_nodes, key);
+    return entries.empty() ? NodeId::Invalid : NodeId{entries.front().node};
+}
+
+auto GameTree::find_positions(uint64_t key) const -> std::vector<NodeId> {
+    const auto entries = m_key_index.find(m_nodes, key);
+    std::vector<NodeId> found;
+    found.reserve(entries.size());
+    for (const auto &entry : entries) {
+        found.push_back(NodeId{entry.node});
+    }
+    return found;
+}
+
+auto GameTree::board(NodeId node_id) const -> const Board * {
+    const auto entry = m_boards.find(node_id.value);
+    return entry == m_boards.end() ? nullptr : &entry->second;
+}
+
+auto GameTree::KeyIndex::build(const std::pmr::vector<GameNode> &nodes) const -> void {
+    if (m_valid) {
+        return;
+    }
+    m_entries.clear();
+    for (size_t index = 0; index < nodes.size(); ++index) {
+        if (nodes[index].key() != 0) {
+            m_entries.push_back({.key = nodes[index].key(), .node = static_cast<uint32_t>(index + 1)});
+        }
+    }
+    // The nodes are visited in ascending order of their ids, so a stable sort keeps the ids sorted per key.
+    std::ranges::stable_sort(m_entries, {}, &Entry::key);
+    m_valid = true;
+}
+
+auto GameTree::KeyIndex::find(const std::pmr::vector<GameNode> &nodes, uint64_t key) const -> std::span<const Entry> {
+    if (key == 0) {
+        return {};
+    }
+    const std::scoped_lock lock{m_mutex};
+    build(nodes);
+    const auto [first, last] = std::ranges::equal_range(m_entries, key, {}, &Entry::key);
+    return {first, last};
+}
+
+auto GameTree::KeyIndex::memory_usage() const -> size_t {
+    const std::scoped_lock lock{m_mutex};
+    return heap_bytes(m_entries);
+}
+
+auto GameTree::position(NodeId node_id) const -> const chesscore::Position * {
+    const auto entry = m_positions.find(node_id.value);
+    return entry == m_positions.end() ? nullptr : &entry->second;
+}
+
+auto GameTree::calculate_position(NodeId node_id) const -> chesscore::Position {
+    std::vector<NodeId> path;
+    auto ancestor = node_id;
+    const chesscore::Position *ancestor_position = position(ancestor);
+    while (ancestor_position == nullptr) {
+        path.push_back(ancestor);
+        ancestor = node(ancestor).m_parent;
+        if (ancestor == NodeId::Invalid) {
+            throw ChessGameError{"No ancestor with position information found"};
+        }
+        ancestor_position = position(ancestor);
+    }
+    auto result = *ancestor_position;
+    for (const auto &path_node : std::views::reverse(path)) {
+        result.make_move(node(path_node).m_move);
     }
-    return -1;
+    return result;
 }
 
 } // namespace chessgame
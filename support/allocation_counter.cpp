@@ -0,0 +1,52 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+
+auto allocate(std::size_t size) -> void * {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto *memory = std::malloc(size == 0 ? 1 : size); memory != nullptr) {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+} // namespace
+
+auto chessgame::support::allocation_count() -> uint64_t {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+auto operator new(std::size_t size) -> void * {
+    return allocate(size);
+}
+
+auto operator new[](std::size_t size) -> void * {
+    return allocate(size);
+}
+
+auto operator delete(void *memory) noexcept -> void {
+    std::free(memory);
+}
+
+auto operator delete[](void *memory) noexcept -> void {
+    std::free(memory);
+}
+
+auto operator delete(void *memory, std::size_t /*size*/) noexcept -> void {
+    std::free(memory);
+}
+
+auto operator delete[](void *memory, std::size_t /*size*/) noexcept -> void {
+    std::free(memory);
+}
@@ -0,0 +1,25 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+/** \file */
+
+#ifndef CHESSGAME_SUPPORT_ALLOCATION_COUNTER_H
+#define CHESSGAME_SUPPORT_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+namespace chessgame::support {
+
+/**
+ * \brief Number of memory allocations since the start of the program.
+ *
+ * Counted by the replaced global operator new, that every program linking
+ * the allocation counter uses.
+ * \return Number of allocations.
+ */
+auto allocation_count() -> uint64_t;
+
+} // namespace chessgame::support
+
+#endif
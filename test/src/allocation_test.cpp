@@ -0,0 +1,71 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "allocation_counter.h"
+#include "chessgame/metadata.h"
+#include "chessgame/pgn.h"
+
+#include <cstdint>
+#include <string_view>
+
+using namespace chessgame;
+
+namespace {
+
+const std::string_view plain_game = R"([Event "Allocations"]
+[Site "Somewhere"]
+[Date "2024.01.01"]
+[Round "1"]
+[White "A player with a name, that does not fit into a small string"]
+[Black "Another player with a name, that does not fit into a small string"]
+[Result "1-0"]
+
+1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4. Ba4 Nf6 5. O-O Be7 6. Re1 b5 7. Bb3 d6 8. c3 O-O 9. h3 Nb8 10. d4 Nbd7 1-0
+)";
+
+auto add_tags(GameMetadata &metadata) -> void {
+    metadata.add("Event", "Allocations");
+    metadata.add("White", "A player with a name, that does not fit into a small string");
+    metadata.add("Black", "Another player with a name, that does not fit into a small string");
+    metadata.add("Result", "1-0");
+}
+
+} // namespace
+
+TEST_CASE("Allocation.Metadata Reuse", "[allocation]") {
+    GameMetadata metadata;
+    add_tags(metadata);
+    metadata.reset(nullptr);
+    add_tags(metadata);
+
+    const auto before = support::allocation_count();
+    for (int game = 0; game < 10; ++game) {
+        metadata.reset(nullptr);
+        add_tags(metadata);
+    }
+    CHECK(support::allocation_count() == before);
+    CHECK(metadata.get("Black") == "Another player with a name, that does not fit into a small string");
+}
+
+TEST_CASE("Allocation.Read Game Into", "[allocation]") {
+    PGNParser parser{plain_game};
+    const auto count_allocations = [&parser](const auto &read) -> uint64_t {
+        parser.set_input(plain_game);
+        const auto before = support::allocation_count();
+        read();
+        return support::allocation_count() - before;
+    };
+
+    const auto fresh = count_allocations([&parser] { REQUIRE(parser.read_game().has_value()); });
+    Game game{};
+    count_allocations([&parser, &game] { REQUIRE(parser.read_game_into(game)); });
+    const auto reused = count_allocations([&parser, &game] { REQUIRE(parser.read_game_into(game)); });
+    CHECK(reused < fresh);
+    CHECK(count_allocations([&parser, &game] { REQUIRE(parser.read_game_into(game)); }) == reused);
+    CHECK(game.metadata().get("White") == "A player with a name, that does not fit into a small string");
+    CHECK(game.current_mainline().ply() == 20);
+}
@@ -0,0 +1,180 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chessgame/binary.h"
+#include "chessgame/pgn.h"
+
+#include "chesscore/position.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace chessgame;
+
+namespace {
+
+const std::string pgn_data = R"([Event "Binary Test"]
+[Site "Test Site"]
+[Result "*"]
+
+{Game comment} 1. e4 $1 e5 2. Nf3 ({Alternative} 2. f4 exf4 $2 {Gambit}) (2. d4)
+(2. c3) (2. Bc4) 2... Nc6 3. d4 exd4 4. c3 dxc3 5. Nxc3 *
+
+[Event "Setup"]
+[Result "*"]
+[SetUp "1"]
+[FEN "4k3/1P6/8/3pP3/8/8/8/4K3 w - d6 0 1"]
+
+1. exd6 Kd7 2. b8=Q Ke6 *
+)";
+
+auto parse_games(const std::string &data) -> std::vector<Game> {
+    auto parser = PGNParser{std::string_view{data}};
+    std::vector<Game> games;
+    for (auto game = parser.read_game(); game.has_value(); game = parser.read_game()) {
+        games.push_back(std::move(game).value());
+    }
+    return games;
+}
+
+auto to_pgn(const Game &game) -> std::string {
+    std::ostringstream out;
+    PGNWriter writer{out};
+    writer.write_game(game);
+    return out.str();
+}
+
+} // namespace
+
+TEST_CASE("Binary.Round Trip", "[binary]") {
+    const auto games = parse_games(pgn_data);
+    REQUIRE(games.size() == 2);
+
+    std::ostringstream out;
+    BinaryGameWriter writer{out};
+    for (const auto &game : games) {
+        writer.write_game(game);
+    }
+    const auto binary_data = out.str();
+
+    std::istringstream in{binary_data};
+    BinaryGameReader reader{in};
+    CHECK(reader.version() == binary_format_version);
+    for (const auto &game : games) {
+        const auto loaded = reader.read_game();
+        REQUIRE(loaded.has_value());
+        CHECK(loaded->tree().size() == game.tree().size());
+        CHECK(to_pgn(loaded.value()) == to_pgn(game));
+    }
+    CHECK_FALSE(reader.read_game().has_value());
+
+    BinaryGameReader memory_reader{std::string_view{binary_data}};
+    const auto first = memory_reader.read_game();
+    REQUIRE(first.has_value());
+    CHECK(first->const_cursor().comment() == "Game comment");
+    CHECK(first->const_cursor().child(0)->nags() == std::pmr::vector<int>{1});
+    CHECK(first->const_cursor().child(0)->child(0)->child_count() == 5);
+    const auto second = memory_reader.read_game();
+    REQUIRE(second.has_value());
+    CHECK(second->metadata().get("FEN") == "4k3/1P6/8/3pP3/8/8/8/4K3 w - d6 0 1");
+    CHECK(second->const_cursor().child(0)->move().capturing_en_passant);
+    CHECK_FALSE(memory_reader.read_game().has_value());
+}
+
+TEST_CASE("Binary.Move Indices", "[binary]") {
+    const chesscore::Position position{chesscore::FenString{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"}};
+    const auto legal_moves = position.all_legal_moves();
+    for (const auto &move : legal_moves) {
+        const auto index = encode_move_index(move, legal_moves);
+        REQUIRE(index.has_value());
+        CHECK(decode_move_index(index.value(), legal_moves) == move);
+    }
+    CHECK_FALSE(encode_move_index(chesscore::Move{.from = chesscore::Square::A1, .to = chesscore::Square::A8, .piece = chesscore::Piece::WhiteRook}, legal_moves).has_value());
+    CHECK_FALSE(decode_move_index(static_cast<uint8_t>(legal_moves.size()), legal_moves).has_value());
+
+    // The canonical order does not depend on the order of the move generator.
+    auto canonical = legal_moves;
+    sort_legal_moves(canonical);
+    auto reversed = legal_moves;
+    std::ranges::reverse(reversed);
+    sort_legal_moves(reversed);
+    CHECK(std::ranges::equal(reversed, canonical));
+    CHECK(std::ranges::is_sorted(canonical, {}, [](const chesscore::Move &move) { return encode_move(move); }));
+
+    const auto games = parse_games(pgn_data);
+    std::ostringstream full_out;
+    BinaryGameWriter full_writer{full_out};
+    std::ostringstream indexed_out;
+    BinaryGameWriter indexed_writer{indexed_out, {.move_indices = true}};
+    for (const auto &game : games) {
+        full_writer.write_game(game);
+        indexed_writer.write_game(game);
+    }
+    const auto indexed_data = indexed_out.str();
+    CHECK(indexed_data.size() < full_out.str().size());
+
+    BinaryGameReader reader{std::string_view{indexed_data}};
+    CHECK(reader.options().move_indices);
+    for (const auto &game : games) {
+        const auto loaded = reader.read_game();
+        REQUIRE(loaded.has_value());
+        CHECK(loaded->tree().size() == game.tree().size());
+        CHECK(loaded->const_cursor().child(0)->san() == game.const_cursor().child(0)->san());
+        CHECK(to_pgn(loaded.value()) == to_pgn(game));
+    }
+    CHECK_FALSE(reader.read_game().has_value());
+}
+
+TEST_CASE("Binary.Version 1", "[binary]") {
+    std::ostringstream out;
+    BinaryGameWriter writer{out};
+    const auto game = parse_games(pgn_data).front().clone();
+    writer.write_game(game);
+    // Version 1 streams have no options in the header.
+    auto binary_data = out.str().erase(8, 4);
+    binary_data[4] = '\x01';
+    BinaryGameReader reader{std::string_view{binary_data}};
+    CHECK(reader.version() == 1);
+    CHECK_FALSE(reader.options().move_indices);
+    const auto loaded = reader.read_game();
+    REQUIRE(loaded.has_value());
+    CHECK(to_pgn(loaded.value()) == to_pgn(game));
+}
+
+TEST_CASE("Binary.Invalid Data", "[binary]") {
+    CHECK_THROWS_AS(BinaryGameReader{std::string_view{"PGN!"}}, ChessGameError);
+    const std::string future_version{"CGBG\x63\x00\x00\x00", 8};
+    CHECK_THROWS_AS(BinaryGameReader{std::string_view{future_version}}, ChessGameError);
+
+    std::ostringstream out;
+    BinaryGameWriter writer{out};
+    writer.write_game(parse_games(pgn_data).front());
+    const auto binary_data = out.str();
+    BinaryGameReader truncated{std::string_view{binary_data}.substr(0, binary_data.size() - 3)};
+    CHECK_THROWS_AS(truncated.read_game(), ChessGameError);
+
+    const auto header = binary_data.substr(0, 12);
+    SECTION("Huge record size") {
+        std::istringstream in_stream{header + std::string{"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x7F", 8} + "data"};
+        BinaryGameReader reader{in_stream};
+        CHECK_THROWS_AS(reader.read_game(), ChessGameError);
+    }
+    SECTION("Record size beyond the stream") {
+        std::istringstream in_stream{header + std::string{"\x80\x80\x80\x10", 4} + "data"};
+        BinaryGameReader reader{in_stream};
+        CHECK_THROWS_AS(reader.read_game(), ChessGameError);
+    }
+    SECTION("Too many NAGs") {
+        // No tags, no moves, a root node with NAGs, but only one of 127 NAGs.
+        const std::string record{"\x00\x00\x00\x00\x00\x02\x7F\x01", 8};
+        std::istringstream in_stream{header + static_cast<char>(record.size()) + record};
+        BinaryGameReader reader{in_stream};
+        CHECK_THROWS_AS(reader.read_game(), ChessGameError);
+    }
+}
@@ -0,0 +1,253 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chesscore_io/chesscore_io.h"
+#include "chessgame/board.h"
+#include "chessgame/san.h"
+
+#include "chesscore/fen.h"
+#include "chesscore/position.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace chessgame;
+using namespace chesscore;
+
+namespace {
+
+auto same_moves(const MoveList &moves, const MoveList &expected) -> bool {
+    return moves.size() == expected.size() && std::ranges::all_of(expected, [&moves](const Move &move) {
+               return std::ranges::count_if(moves, [&move](const Move &candidate) { return FullMoveCompare{}(candidate, move); }) == 1;
+           });
+}
+
+/**
+ * \brief Compare the legal moves of the board with the ones of chesscore, perft-style.
+ *
+ * \return The number of compared positions.
+ */
+auto cross_check(const Board &board, const Position &position, int depth) -> size_t {
+    const auto expected = position.all_legal_moves();
+    const auto moves = legal_moves(board);
+    INFO(board.fen());
+    REQUIRE(same_moves(moves, expected));
+    size_t positions{1};
+    if (depth > 1) {
+        for (const auto &move : expected) {
+            auto next_board = board;
+            next_board.make_move(move);
+            auto next_position = position;
+            next_position.make_move(move);
+            positions += cross_check(next_board, next_position, depth - 1);
+        }
+    }
+    return positions;
+}
+
+auto resolve(const std::string &fen, const std::string &san) -> std::optional<Move> {
+    const auto board = Board::from_fen(fen).value();
+    const auto san_move = parse_san(san, board.side_to_move()).value();
+    return resolve_san_move(san_move, board);
+}
+
+} // namespace
+
+TEST_CASE("Game.Board.From FEN", "[board]") {
+    const auto board = Board::starting_position();
+    CHECK(board.piece_at(Square::E1) == Piece::WhiteKing);
+    CHECK(board.piece_at(Square::D8) == Piece::BlackQueen);
+    CHECK(board.piece_at(Square::B7) == Piece::BlackPawn);
+    CHECK_FALSE(board.piece_at(Square::E4).has_value());
+    CHECK(board.side_to_move() == Color::White);
+    CHECK(board.castling_rights() == (Board::white_kingside | Board::white_queenside | Board::black_kingside | Board::black_queenside));
+    CHECK(board.en_passant_index() == -1);
+
+    const auto en_passant = Board::from_fen("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w Kq f6 0 3");
+    REQUIRE(en_passant.has_value());
+    CHECK(en_passant->en_passant_index() == square_index(Square::F6));
+    CHECK(en_passant->castling_rights() == (Board::white_kingside | Board::black_queenside));
+
+    CHECK_FALSE(Board::from_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1").has_value());
+    CHECK_FALSE(Board::from_fen("rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1").has_value());
+    CHECK_FALSE(Board::from_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1").has_value());
+}
+
+TEST_CASE("Game.Board.Make Move", "[board]") {
+    auto board = Board::from_fen("r3k2r/8/8/3pP3/8/8/1p6/R3K2R w KQkq d6 0 1").value();
+    board.make_move(Move{.from = Square::E5, .to = Square::D6, .piece = Piece::WhitePawn, .captured = Piece::BlackPawn, .capturing_en_passant = true});
+    CHECK(board.piece_at(Square::D6) == Piece::WhitePawn);
+    CHECK_FALSE(board.piece_at(Square::D5).has_value());
+    CHECK(board.side_to_move() == Color::Black);
+
+    board.make_move(Move{.from = Square::B2, .to = Square::A1, .piece = Piece::BlackPawn, .captured = Piece::WhiteRook, .promoted = Piece::BlackQueen});
+    CHECK(board.piece_at(Square::A1) == Piece::BlackQueen);
+    CHECK(board.castling_rights() == (Board::white_kingside | Board::black_kingside | Board::black_queenside));
+
+    board.make_move(Move{.from = Square::E1, .to = Square::G1, .piece = Piece::WhiteKing});
+    CHECK(board.piece_at(Square::G1) == Piece::WhiteKing);
+    CHECK(board.piece_at(Square::F1) == Piece::WhiteRook);
+    CHECK_FALSE(board.piece_at(Square::H1).has_value());
+    CHECK(board.castling_rights() == (Board::black_kingside | Board::black_queenside));
+
+    board.make_move(Move{.from = Square::E8, .to = Square::C8, .piece = Piece::BlackKing});
+    CHECK(board.piece_at(Square::C8) == Piece::BlackKing);
+    CHECK(board.piece_at(Square::D8) == Piece::BlackRook);
+    CHECK_FALSE(board.piece_at(Square::A8).has_value());
+    CHECK(board.castling_rights() == 0);
+
+    board.make_move(Move{.from = Square::D6, .to = Square::D7, .piece = Piece::WhitePawn});
+    CHECK(board.in_check(Color::Black));
+    CHECK_FALSE(board.in_check(Color::White));
+}
+
+TEST_CASE("Game.Board.Position Keys", "[board]") {
+    const Move e4{.from = Square::E2, .to = Square::E4, .piece = Piece::WhitePawn};
+    const Move d4{.from = Square::D2, .to = Square::D4, .piece = Piece::WhitePawn};
+    const Move e6{.from = Square::E7, .to = Square::E6, .piece = Piece::BlackPawn};
+    auto first = Board::starting_position();
+    auto second = Board::starting_position();
+    for (const auto &move : {e4, e6, d4}) {
+        first.make_move(move);
+    }
+    for (const auto &move : {d4, e6, e4}) {
+        second.make_move(move);
+    }
+    CHECK(first.key() == second.key());
+    CHECK(first.key() == Board::from_fen("rnbqkbnr/pppp1ppp/4p3/8/3PP3/8/PPP2PPP/RNBQKBNR b KQkq - 0 2")->key());
+    CHECK(first.key() != Board::from_fen("rnbqkbnr/pppp1ppp/4p3/8/3PP3/8/PPP2PPP/RNBQKBNR w KQkq - 0 2")->key());
+    CHECK(first.key() != Board::from_fen("rnbqkbnr/pppp1ppp/4p3/8/3PP3/8/PPP2PPP/RNBQKBNR b Kkq - 0 2")->key());
+
+    const auto capturable = Board::from_fen("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3").value();
+    CHECK(capturable.key() != Board::from_fen("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq - 0 3")->key());
+    const auto not_capturable = Board::from_fen("rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2").value();
+    CHECK(not_capturable.key() == Board::from_fen("rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2")->key());
+
+    auto castled = Board::from_fen("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1").value();
+    castled.make_move(Move{.from = Square::E1, .to = Square::G1, .piece = Piece::WhiteKing});
+    CHECK(castled.key() == Board::from_fen("r3k2r/8/8/8/8/8/8/R4RK1 b kq - 1 1")->key());
+}
+
+TEST_CASE("Game.Board.Resolve SAN Move", "[board]") {
+    SECTION("Simple moves") {
+        const std::string start{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"};
+        CHECK(resolve(start, "e4") == Move{.from = Square::E2, .to = Square::E4, .piece = Piece::WhitePawn});
+        CHECK(resolve(start, "Nf3") == Move{.from = Square::G1, .to = Square::F3, .piece = Piece::WhiteKnight});
+        CHECK_FALSE(resolve(start, "e5").has_value());
+        CHECK_FALSE(resolve(start, "Bc4").has_value());
+    }
+    SECTION("Pinned piece") {
+        // The knight on d2 is pinned, so only the knight on b1 can go to c3.
+        const std::string fen{"4k3/8/8/b7/8/8/3N4/1N2K3 w - - 0 1"};
+        CHECK(resolve(fen, "Nc3") == Move{.from = Square::B1, .to = Square::C3, .piece = Piece::WhiteKnight});
+        CHECK_FALSE(resolve(fen, "Nf3").has_value());
+    }
+    SECTION("Ambiguity and disambiguation") {
+        const std::string fen{"4k3/8/8/8/8/8/8/R4RK1 w - - 0 1"};
+        CHECK_FALSE(resolve(fen, "Rd1").has_value());
+        CHECK(resolve(fen, "Rad1") == Move{.from = Square::A1, .to = Square::D1, .piece = Piece::WhiteRook});
+        CHECK_FALSE(resolve(fen, "Rbd1").has_value());
+    }
+    SECTION("Captures") {
+        const std::string fen{"4k3/8/8/3pPp2/8/8/8/4K3 w - f6 0 1"};
+        CHECK(resolve(fen, "exf6") == Move{.from = Square::E5, .to = Square::F6, .piece = Piece::WhitePawn, .captured = Piece::BlackPawn, .capturing_en_passant = true});
+        CHECK_FALSE(resolve(fen, "exd6").has_value());
+        CHECK_FALSE(resolve(fen, "f6").has_value());
+    }
+    SECTION("Promotions") {
+        const std::string fen{"1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1"};
+        CHECK(resolve(fen, "a8=Q") == Move{.from = Square::A7, .to = Square::A8, .piece = Piece::WhitePawn, .promoted = Piece::WhiteQueen});
+        CHECK(resolve(fen, "axb8=N") == Move{.from = Square::A7, .to = Square::B8, .piece = Piece::WhitePawn, .captured = Piece::BlackRook, .promoted = Piece::WhiteKnight});
+        CHECK_FALSE(resolve(fen, "a8").has_value());
+    }
+    SECTION("Castling") {
+        CHECK(resolve("r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1", "O-O-O") == Move{.from = Square::E8, .to = Square::C8, .piece = Piece::BlackKing});
+        CHECK(resolve("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "O-O") == Move{.from = Square::E1, .to = Square::G1, .piece = Piece::WhiteKing});
+        CHECK_FALSE(resolve("r3k2r/8/8/8/8/8/8/R3K2R w Qkq - 0 1", "O-O").has_value());
+        CHECK_FALSE(resolve("r3k2r/8/8/8/8/8/5r2/R3K2R w KQkq - 0 1", "O-O").has_value());
+        CHECK_FALSE(resolve("r3k2r/8/8/8/8/8/8/R2QK2R w KQkq - 0 1", "O-O-O").has_value());
+        CHECK_FALSE(resolve("r3k2r/8/8/8/8/8/4r3/R3K2R w KQkq - 0 1", "O-O").has_value());
+    }
+}
+
+TEST_CASE("Game.Board.Resolve All Legal Moves", "[board]") {
+    const auto fen = GENERATE(as<std::string>{}, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                              "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/Pp2P3/2N2Q1p/1PPBBPPP/R3K2R b KQkq a3 0 1",
+                              "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+    const Position position{FenString{fen}};
+    const auto board = Board::from_fen(fen).value();
+    const auto legal_moves = position.all_legal_moves();
+    for (const auto &move : legal_moves) {
+        const auto san_move = generate_san_move(move, legal_moves).value();
+        const auto parsed = parse_san(san_move.san_string, board.side_to_move()).value();
+        const auto resolved = resolve_san_move(parsed, board);
+        INFO(san_move.san_string);
+        REQUIRE(resolved.has_value());
+        CHECK(FullMoveCompare{}(resolved.value(), move));
+    }
+}
+
+TEST_CASE("Game.Board.Legal Moves", "[board]") {
+    const auto fen = GENERATE(as<std::string>{}, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                              "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                              "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                              "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+    const auto board = Board::from_fen(fen).value();
+    CHECK(cross_check(board, Position{FenString{fen}}, 3) > 1);
+}
+
+TEST_CASE("Game.Board.FEN", "[board]") {
+    CHECK(Board::starting_position().fen() == "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    const std::string fen{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/Pp2P3/2N2Q1p/1PPBBPPP/R3K2R b Kq a3 0 1"};
+    CHECK(Board::from_fen(fen)->fen() == fen);
+    CHECK(Board::from_fen("8/8/8/8/8/8/8/K6k w - - 5 40")->fen() == "8/8/8/8/8/8/8/K6k w - - 0 1");
+}
+
+TEST_CASE("Game.Board.Checkmate", "[board]") {
+    CHECK_FALSE(is_checkmate(Board::starting_position()));
+    CHECK(is_checkmate(Board::from_fen("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3").value()));
+    CHECK(is_checkmate(Board::from_fen("R5k1/5ppp/8/8/8/8/5PPP/6K1 b - - 0 1").value()));
+    CHECK(is_checkmate(Board::from_fen("6rk/5Npp/8/8/8/8/8/6K1 b - - 0 1").value()));
+    // The check can be blocked or the checking piece can be captured.
+    CHECK_FALSE(is_checkmate(Board::from_fen("R5k1/5ppp/8/8/8/8/1r3PPP/6K1 b - - 0 1").value()));
+    CHECK_FALSE(is_checkmate(Board::from_fen("R5k1/5ppp/8/8/8/8/r4PPP/6K1 b - - 0 1").value()));
+    CHECK_FALSE(is_checkmate(Board::from_fen("R5k1/5pp1/8/8/8/8/5PPP/6K1 b - - 0 1").value()));
+}
+
+TEST_CASE("Game.Board.Resolve SAN Move With SAN String", "[board]") {
+    const auto board = Board::from_fen("3k4/8/8/1Q1Q1Q2/8/1Q3Q2/8/3K4 w - - 0 1").value();
+    std::string san;
+    CHECK(resolve_san_move(parse_san("Qb3c4", Color::White).value(), board, san) == Move{.from = Square::B3, .to = Square::C4, .piece = Piece::WhiteQueen});
+    CHECK(san == "Qb3c4");
+    san.clear();
+    CHECK(resolve_san_move(parse_san("Qd5e5", Color::White).value(), board, san).has_value());
+    CHECK(san == "Qde5");
+    san.clear();
+    CHECK_FALSE(resolve_san_move(parse_san("Qc4", Color::White).value(), board, san).has_value());
+    CHECK(san.empty());
+}
+
+TEST_CASE("Game.Board.Append SAN Move", "[board]") {
+    const auto fen = GENERATE(as<std::string>{}, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                              "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/Pp2P3/2N2Q1p/1PPBBPPP/R3K2R b KQkq a3 0 1",
+                              "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1", "3k4/8/8/1Q1Q1Q2/8/1Q3Q2/8/3K4 w - - 0 1", "4k3/8/8/b7/8/8/3N4/1N2K3 w - - 0 1");
+    const Position position{FenString{fen}};
+    const auto board = Board::from_fen(fen).value();
+    const auto legal_moves = position.all_legal_moves();
+    for (const auto &move : legal_moves) {
+        std::string expected;
+        REQUIRE(append_san_move(expected, move, legal_moves));
+        std::string san;
+        CHECK(append_san_move(san, move, board));
+        CHECK(san == expected);
+    }
+
+    std::string san{"unchanged"};
+    CHECK_FALSE(append_san_move(san, Move{.from = Square::D2, .to = Square::F3, .piece = Piece::WhiteKnight}, Board::from_fen("4k3/8/8/b7/8/8/3N4/1N2K3 w - - 0 1").value()));
+    CHECK_FALSE(append_san_move(san, Move{.from = Square::E7, .to = Square::E5, .piece = Piece::BlackPawn}, Board::starting_position()));
+    CHECK(san == "unchanged");
+}
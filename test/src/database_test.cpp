@@ -0,0 +1,148 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chessgame/database.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace chessgame;
+
+namespace {
+
+const std::string pgn_data = R"([Event "Game 1"]
+[Result "1-0"]
+
+1. e4 e5 2. Nf3 {A comment with [brackets]} Nc6 1-0
+
+[Event "Game 2"]
+[Result "*"]
+
+1. d4 (1. c4 e5) 1... d5 *
+
+[Event "Game 3"]
+[Result "0-1"]
+{Game comment}
+1. f3 e5 2. g4 Qh4# 0-1
+)";
+
+class TemporaryFile {
+public:
+    explicit TemporaryFile(const std::string &name, const std::string &contents) : m_path{std::filesystem::temp_directory_path() / name} {
+        std::ofstream out{m_path, std::ios::binary};
+        out << contents;
+    }
+    TemporaryFile(const TemporaryFile &) = delete;
+    auto operator=(const TemporaryFile &) -> TemporaryFile & = delete;
+    ~TemporaryFile() {
+        std::filesystem::remove(m_path);
+        std::filesystem::remove(PGNDatabase::default_index_path(m_path));
+    }
+
+    [[nodiscard]] auto path() const -> const std::filesystem::path & { return m_path; }
+private:
+    std::filesystem::path m_path;
+};
+
+} // namespace
+
+TEST_CASE("PGN.Database.Scan Game Offsets", "[pgn][database]") {
+    const auto offsets = scan_game_offsets(pgn_data);
+    REQUIRE(offsets.size() == 3);
+    CHECK(offsets[0] == 0);
+    CHECK(pgn_data.substr(offsets[1]).starts_with("[Event \"Game 2\"]"));
+    CHECK(pgn_data.substr(offsets[2]).starts_with("[Event \"Game 3\"]"));
+    CHECK(scan_game_offsets("").empty());
+}
+
+TEST_CASE("PGN.Database.Random Access", "[pgn][database]") {
+    const TemporaryFile file{"chessgame_database_test.pgn", pgn_data};
+    const PGNDatabase database{file.path()};
+    REQUIRE(database.size() == 3);
+    CHECK_FALSE(std::filesystem::exists(PGNDatabase::default_index_path(file.path())));
+
+    const auto game3 = database.read_game(2);
+    REQUIRE(game3.has_value());
+    CHECK(game3->metadata().get("Event") == "Game 3");
+    CHECK(game3->const_cursor().comment() == "Game comment");
+
+    const auto game2 = database.read_game(1);
+    REQUIRE(game2.has_value());
+    CHECK(game2->metadata().get("Event") == "Game 2");
+    CHECK(game2->const_cursor().child_count() == 2);
+    CHECK(database.game_data(0).ends_with("1-0\n\n"));
+}
+
+TEST_CASE("PGN.Database.Persisted Index", "[pgn][database]") {
+    const TemporaryFile file{"chessgame_database_index_test.pgn", pgn_data};
+    const auto offsets = PGNDatabase{file.path(), IndexFileMode::ReadWrite}.offsets();
+    CHECK(std::filesystem::exists(PGNDatabase::default_index_path(file.path())));
+    const PGNDatabase reopened{file.path()};
+    CHECK(reopened.offsets() == offsets);
+
+    {
+        std::ofstream out{file.path(), std::ios::binary | std::ios::app};
+        out << "\n[Event \"Game 4\"]\n\n1. e4 *\n";
+    }
+    const PGNDatabase extended{file.path()};
+    REQUIRE(extended.size() == 4);
+    CHECK(extended.read_game(3)->metadata().get("Event") == "Game 4");
+}
+
+TEST_CASE("PGN.Database.Stale Index", "[pgn][database]") {
+    const TemporaryFile file{"chessgame_database_stale_test.pgn", pgn_data};
+    const auto index_path = PGNDatabase::default_index_path(file.path());
+    const PGNDatabase original{file.path(), IndexFileMode::ReadWrite};
+    REQUIRE(original.size() == 3);
+
+    SECTION("Same size edit") {
+        auto edited = pgn_data;
+        // Move the start of the second game, keeping the size of the file.
+        edited.replace(edited.find("A comment"), 9, "Acomment");
+        edited.replace(edited.find("Game 2"), 6, "Game 22");
+        REQUIRE(edited.size() == pgn_data.size());
+        REQUIRE(scan_game_offsets(edited) != original.offsets());
+        const auto last_write = std::filesystem::last_write_time(file.path());
+        {
+            std::ofstream out{file.path(), std::ios::binary | std::ios::trunc};
+            out << edited;
+        }
+        std::filesystem::last_write_time(file.path(), last_write);
+        const PGNDatabase reopened{file.path()};
+        CHECK(reopened.offsets() == scan_game_offsets(edited));
+    }
+
+    SECTION("Offsets not increasing") {
+        const auto index_size = std::filesystem::file_size(index_path);
+        {
+            // Swap the offsets of the last two games.
+            std::fstream index{index_path, std::ios::binary | std::ios::in | std::ios::out};
+            std::array<char, 16> offsets{};
+            index.seekg(static_cast<std::streamoff>(index_size - offsets.size()));
+            index.read(offsets.data(), static_cast<std::streamsize>(offsets.size()));
+            std::rotate(offsets.begin(), offsets.begin() + 8, offsets.end());
+            index.seekp(static_cast<std::streamoff>(index_size - offsets.size()));
+            index.write(offsets.data(), static_cast<std::streamsize>(offsets.size()));
+        }
+        const PGNDatabase reopened{file.path()};
+        CHECK(reopened.offsets() == original.offsets());
+    }
+}
+
+TEST_CASE("PGN.Database.Read Header", "[pgn][database]") {
+    const TemporaryFile file{"chessgame_database_header_test.pgn", pgn_data};
+    const PGNDatabase database{file.path()};
+    const auto header = database.read_header(1);
+    CHECK(header.offset == database.offsets()[1]);
+    CHECK(header.metadata.get("Event") == "Game 2");
+    CHECK(header.metadata.get("Result") == "*");
+    CHECK(header.metadata.pool() == database.tag_pool());
+    CHECK(database.read_game(2)->metadata().pool() == database.tag_pool());
+}
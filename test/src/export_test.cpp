@@ -0,0 +1,101 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chessgame/export.h"
+#include "chessgame/pgn.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace chessgame;
+using namespace chesscore;
+
+namespace {
+
+auto many_games(size_t count) -> std::string {
+    std::string data;
+    for (size_t index = 0; index < count; ++index) {
+        data += "[Event \"Game " + std::to_string(index) + "\"]\n\n{Start} 1. e4 e5 2. Nf3 $1 (2. d4 exd4 {A long comment, that does not fit into the line}) 2... Nc6 *\n\n";
+    }
+    return data;
+}
+
+auto sequential_output(std::span<const Game> games) -> std::string {
+    std::ostringstream out_stream;
+    PGNWriter writer{out_stream};
+    for (const auto &game : games) {
+        writer.write_game(game);
+    }
+    return out_stream.str();
+}
+
+auto illegal_game() -> Game {
+    Game game{};
+    auto cursor = game.cursor();
+    cursor = cursor.play_move(Move{.from = Square::E2, .to = Square::E5, .piece = Piece::WhitePawn});
+    return game;
+}
+
+} // namespace
+
+TEST_CASE("PGN.Export.Ordered Output", "[pgn][export]") {
+    const auto imported = import_games(many_games(50));
+    std::vector<Game> games;
+    for (const auto &game : imported) {
+        games.push_back(game.game->clone());
+    }
+    const auto expected = sequential_output(games);
+
+    for (const auto &options : {ExportOptions{.thread_count = 1}, ExportOptions{.thread_count = 4, .batch_size = 3, .max_pending_batches = 2}, ExportOptions{.thread_count = 3, .batch_size = 1}}) {
+        std::ostringstream out_stream;
+        export_games(games, out_stream, options);
+        CHECK(out_stream.str() == expected);
+    }
+
+    std::ostringstream from_import;
+    export_games(imported, from_import, ExportOptions{.thread_count = 2, .batch_size = 4});
+    CHECK(from_import.str() == expected);
+
+    std::ostringstream empty;
+    export_games(std::span<const Game>{}, empty);
+    CHECK(empty.str().empty());
+}
+
+TEST_CASE("PGN.Export.Errors", "[pgn][export]") {
+    const auto imported = import_games(many_games(20));
+    std::vector<Game> games;
+    for (const auto &game : imported) {
+        games.push_back(game.game->clone());
+    }
+    games.insert(games.begin() + 9, illegal_game());
+
+    std::ostringstream out_stream;
+    CHECK_THROWS_AS(export_games(games, out_stream, ExportOptions{.thread_count = 4, .batch_size = 2}), PGNError);
+    // The batches before the failing one are written.
+    CHECK(out_stream.str() == sequential_output(std::span<const Game>{games}.first(8)));
+}
+
+TEST_CASE("PGN.Export.File", "[pgn][export]") {
+    const auto imported = import_games(many_games(10));
+    std::vector<Game> games;
+    for (const auto &game : imported) {
+        games.push_back(game.game->clone());
+    }
+    const auto path = std::filesystem::temp_directory_path() / "chessgame_export_test.pgn";
+    export_games(games, path, ExportOptions{.thread_count = 2, .batch_size = 3});
+    {
+        std::ifstream in_stream{path, std::ios::binary};
+        const std::string contents{std::istreambuf_iterator<char>{in_stream}, std::istreambuf_iterator<char>{}};
+        CHECK(contents == sequential_output(games));
+    }
+    std::filesystem::remove(path);
+    CHECK_THROWS_AS(export_games(games, std::filesystem::temp_directory_path() / "missing_directory" / "games.pgn"), ChessGameError);
+}
@@ -0,0 +1,137 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chesscore_io/chesscore_io.h"
+#include "chessgame/filter.h"
+
+#include <sstream>
+#include <string>
+
+using namespace chessgame;
+using namespace chesscore;
+
+namespace {
+
+const Move e4{.from = Square::E2, .to = Square::E4, .piece = Piece::WhitePawn};
+const Move e6{.from = Square::E7, .to = Square::E6, .piece = Piece::BlackPawn};
+const Move d4{.from = Square::D2, .to = Square::D4, .piece = Piece::WhitePawn};
+const Move d5{.from = Square::D7, .to = Square::D5, .piece = Piece::BlackPawn};
+
+auto key_after(std::initializer_list<Move> moves) -> uint64_t {
+    auto board = Board::starting_position();
+    for (const auto &move : moves) {
+        board.make_move(move);
+    }
+    return board.key();
+}
+
+const std::string game_1 = R"([Event "Game 1"]
+[White "Alice"]
+[Result "1-0"]
+
+1. e4 e6 2. d4 d5 3. Nc3 Nf6 1-0
+
+)";
+const std::string game_2 = R"([Event "Game 2"]
+[White "Bob"]
+[Result "1/2-1/2"]
+
+1. d4 (1. e4 e6 2. d4 d5) 1... e6 2. e4 d5 1/2-1/2
+
+)";
+const std::string game_3 = R"([Event "Game 3"]
+[White "Alice"]
+[Result "0-1"]
+
+1. e4 c5 2. Nf3 {Sicilian} d6 0-1
+)";
+const std::string games_data = game_1 + game_2 + game_3;
+
+auto filter(const GameFilter &game_filter, FilterStats &stats) -> std::string {
+    std::ostringstream out_stream;
+    stats = filter_games(games_data, game_filter, out_stream);
+    return out_stream.str();
+}
+
+} // namespace
+
+TEST_CASE("Filter.Tags", "[filter]") {
+    FilterStats stats{};
+    GameFilter game_filter{};
+    game_filter.require_tag("White", "Alice");
+    CHECK_FALSE(game_filter.needs_movetext());
+    CHECK(filter(game_filter, stats) == game_1 + game_3);
+    CHECK(stats.games == 3);
+    CHECK(stats.matches == 2);
+    CHECK(stats.movetext_games == 0);
+    CHECK(stats.plies == 0);
+    CHECK(stats.errors == 0);
+    CHECK(stats.skipped == 0);
+
+    game_filter.add_tag_predicate([](const GameMetadata &metadata) { return metadata.get("Result") == "0-1"; });
+    CHECK(filter(game_filter, stats) == game_3);
+    CHECK(filter(GameFilter{}, stats) == games_data);
+}
+
+TEST_CASE("Filter.Positions", "[filter]") {
+    FilterStats stats{};
+    GameFilter game_filter{};
+    game_filter.require_position(key_after({e4, e6, d4, d5}));
+    CHECK(game_filter.needs_movetext());
+    // Both move orders reach the position, the variation of game 2 is not checked.
+    CHECK(filter(game_filter, stats) == game_1 + game_2);
+    CHECK(stats.matches == 2);
+    CHECK(stats.movetext_games == 3);
+    // Reading stops as soon as the position is reached.
+    CHECK(stats.plies == 4 + 4 + 4);
+
+    SECTION("Tags are checked first") {
+        game_filter.require_tag("White", "Bob");
+        CHECK(filter(game_filter, stats) == game_2);
+        CHECK(stats.movetext_games == 1);
+    }
+    SECTION("Maximum ply") {
+        game_filter.set_max_ply(3);
+        CHECK(filter(game_filter, stats).empty());
+        CHECK(stats.plies == 3 + 3 + 3);
+    }
+    SECTION("Start position") {
+        CHECK(GameFilter{}.require_position(Board::starting_position().key()).set_max_ply(0).matches(game_3));
+    }
+}
+
+TEST_CASE("Filter.Moves", "[filter]") {
+    FilterStats stats{};
+    GameFilter game_filter{};
+    game_filter.add_move_predicate([](const Board &board, const Move &move) {
+        return move.piece.type == PieceType::Knight && board.side_to_move() == Color::White;
+    });
+    CHECK(filter(game_filter, stats) == game_1 + game_3);
+
+    game_filter.add_move_predicate([](const Board &, const Move &move) { return move == d4; });
+    CHECK(filter(game_filter, stats) == game_1);
+    CHECK(stats.plies == 5 + 4 + 4);
+}
+
+TEST_CASE("Filter.Parser Fallbacks", "[filter]") {
+    GameFilter game_filter{};
+    game_filter.require_position(key_after({e4, e6, d4}));
+    FilterStats stats{};
+    // The missing piece type of the second move is only accepted by the parser.
+    CHECK(game_filter.matches("[Event \"Fallback\"]\n\n1. e4 e6 2. Pd4 d5 *\n", stats));
+    CHECK(stats.errors == 0);
+    // The moves before the fallback are only counted once.
+    CHECK(stats.plies == 3);
+    CHECK_FALSE(game_filter.matches("[Event \"Illegal\"]\n\n1. e4 e6 2. Ke3 d5 *\n", stats));
+    CHECK_FALSE(game_filter.matches("[Event \"Broken\"\n\n1. e4 *\n", stats));
+    CHECK(stats.errors == 2);
+    CHECK_FALSE(game_filter.matches("[Variant \"Chess960\"]\n\n1. e4 e6 2. d4 *\n", stats));
+    CHECK(stats.errors == 2);
+    CHECK(stats.skipped == 1);
+    CHECK(stats.games == 4);
+    CHECK(stats.matches == 1);
+}
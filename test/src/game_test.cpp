@@ -0,0 +1,271 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chesscore_io/chesscore_io.h"
+#include "chessgame/pgn.h"
+
+#include <array>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+using namespace chessgame;
+using namespace chesscore;
+
+namespace {
+
+const std::string game_data = R"([Event "Test Event"]
+[Site "Test Site"]
+[White "Player W"]
+[Black "Player B"]
+[Result "1-0"]
+
+1. e4 e5 2. Nf3 Nc6 (2... d6 3. d4 exd4 4. Nxd4) 3. Bb5 a6 4. Ba4 Nf6 5. O-O Be7 1-0)";
+
+auto parse_game(const PositionCachePolicy &policy) -> Game {
+    std::istringstream pgn_data{game_data};
+    auto parser = PGNParser{pgn_data};
+    parser.set_position_cache_policy(policy);
+    auto opt_game = parser.read_game();
+    REQUIRE(opt_game.has_value());
+    return std::move(opt_game).value();
+}
+
+auto for_each_node(const Game &game, const std::function<void(const ConstCursor &)> &func) -> void {
+    std::vector<ConstCursor> pending{game.const_cursor()};
+    while (!pending.empty()) {
+        const auto cursor = pending.back();
+        pending.pop_back();
+        func(cursor);
+        for (size_t index = 0; index < cursor.child_count(); ++index) {
+            pending.push_back(cursor.child(index).value());
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("Game.Position Cache.While Parsing", "[game]") {
+    const auto game = parse_game(PositionCachePolicy::while_parsing());
+    CHECK(game.position_cache_policy().mode == PositionCachePolicy::Mode::RootOnly);
+    for_each_node(game, [](const ConstCursor &cursor) {
+        CAPTURE(cursor.node()->ply());
+        CHECK(cursor.has_stored_position() == (cursor.node()->ply() == 0));
+    });
+}
+
+TEST_CASE("Game.Position Cache.Always", "[game]") {
+    const auto game = parse_game(PositionCachePolicy::always());
+    for_each_node(game, [](const ConstCursor &cursor) { CHECK(cursor.has_stored_position()); });
+}
+
+TEST_CASE("Game.Position Cache.Every N Plies", "[game]") {
+    const auto game = parse_game(PositionCachePolicy::every_n_plies(3));
+    for_each_node(game, [](const ConstCursor &cursor) {
+        CAPTURE(cursor.node()->ply());
+        CHECK(cursor.has_stored_position() == (cursor.node()->ply() % 3 == 0));
+    });
+}
+
+TEST_CASE("Game.Position Cache.Change Policy", "[game]") {
+    auto game = parse_game(PositionCachePolicy::always());
+    game.set_position_cache_policy(PositionCachePolicy::every_n_plies(2));
+    for_each_node(game, [](const ConstCursor &cursor) { CHECK(cursor.has_stored_position() == (cursor.node()->ply() % 2 == 0)); });
+    game.drop_cached_positions();
+    for_each_node(game, [](const ConstCursor &cursor) { CHECK(cursor.has_stored_position() == (cursor.node()->ply() == 0)); });
+}
+
+TEST_CASE("Game.Position Cache.Cursor Positions", "[game]") {
+    const auto game = parse_game(PositionCachePolicy::root_only());
+    auto cursor = game.cursor();
+    CHECK(cursor.position().side_to_move() == Color::White);
+    while (cursor.child_count() > 0) {
+        cursor = cursor.child(0).value();
+        CAPTURE(cursor.node()->ply());
+        const auto expected = game.tree().calculate_position(cursor.node_id());
+        CHECK(cursor.position().side_to_move() == expected.side_to_move());
+        CHECK(cursor.position().fullmove_number() == expected.fullmove_number());
+        CHECK(cursor.position().all_legal_moves() == expected.all_legal_moves());
+    }
+    CHECK(cursor.node()->ply() == 10);
+}
+
+TEST_CASE("Game.Position Cache.Play Move", "[game]") {
+    Game game{};
+    game.set_position_cache_policy(PositionCachePolicy::every_n_plies(2));
+    auto cursor = game.edit();
+    cursor = cursor.play_move(Move{.from = Square::E2, .to = Square::E4, .piece = Piece::WhitePawn});
+    CHECK_FALSE(cursor.has_stored_position());
+    cursor = cursor.play_move(Move{.from = Square::E7, .to = Square::E5, .piece = Piece::BlackPawn});
+    CHECK(cursor.has_stored_position());
+    CHECK(cursor.position().side_to_move() == Color::White);
+    CHECK(cursor.position().fullmove_number() == 2);
+}
+
+TEST_CASE("Game.SAN Cache", "[game]") {
+    Game game{};
+    auto cursor = game.edit();
+    cursor = cursor.play_move(Move{.from = Square::F2, .to = Square::F3, .piece = Piece::WhitePawn});
+    CHECK(cursor.san() == "f3");
+    cursor = cursor.play_move(Move{.from = Square::E7, .to = Square::E5, .piece = Piece::BlackPawn});
+    cursor = cursor.play_move(Move{.from = Square::G2, .to = Square::G4, .piece = Piece::WhitePawn});
+    cursor = cursor.play_move(Move{.from = Square::D8, .to = Square::H4, .piece = Piece::BlackQueen});
+    CHECK(cursor.san() == "Qh4#");
+    CHECK(game.tree().node(GameTree::root_id).san().empty());
+
+    const auto parsed = PGNParser{std::string_view{R"([Event "SAN Cache"]
+
+1. e4 e5 2. Nf3 Nc6 3. Bb5 Nf6 4. Nc3 Nd4 5. Bc4 Nxe4 6. Nxe4 d5 7. Nxd4 dxc4 8. Nf3 Bf5 9. Qe2 Qd5 10. Nc3 Qd6 11. Nb5 Qd7 12. Qxe5+ Be7 13. Nfd4 *)"}}.read_game().value();
+    std::vector<std::string_view> sans;
+    for (auto node = parsed.cursor().child(0); node.has_value(); node = node->child(0)) {
+        sans.push_back(node->san());
+    }
+    CHECK(sans.size() == 25);
+    CHECK(sans[22] == "Qxe5+");
+    CHECK(sans[24] == "Nfd4");
+}
+
+TEST_CASE("Game.Position Keys.Transpositions", "[game]") {
+    std::istringstream pgn_data{R"([Event "Transpositions"]
+
+1. e4 (1. d4 e6 2. e4 d5) 1... e6 2. d4 d5 *)"};
+    auto parser = PGNParser{pgn_data};
+    const auto game = parser.read_game().value();
+    for_each_node(game, [&game](const ConstCursor &cursor) {
+        CAPTURE(cursor.node()->ply());
+        REQUIRE(cursor.board() != nullptr);
+        CHECK(cursor.position_key() == cursor.board()->key());
+        CHECK(cursor.position_key() == game.board(cursor.node_id())->key());
+    });
+
+    const auto french = Board::from_fen("rnbqkbnr/ppp2ppp/4p3/3p4/3PP3/8/PPP2PPP/RNBQKBNR w KQkq d6 0 3").value();
+    const auto nodes = game.tree().find_positions(french.key());
+    REQUIRE(nodes.size() == 2);
+    CHECK(game.tree().node(nodes[0]).ply() == 4);
+    CHECK(game.tree().node(nodes[1]).ply() == 4);
+    const auto last_white_move = [&game](NodeId node_id) { return game.tree().node(game.tree().node(node_id).parent()).move(); };
+    CHECK(last_white_move(nodes[0]).to == Square::E4);
+    CHECK(last_white_move(nodes[1]).to == Square::D4);
+
+    const auto found = game.find_position(french.key());
+    REQUIRE(found.has_value());
+    CHECK(found->node_id() == nodes[0]);
+    CHECK(game.find_position(Board::starting_position().key())->node_id() == GameTree::root_id);
+    CHECK_FALSE(game.find_position(Board::from_fen("4k3/8/8/8/8/8/8/4K3 w - - 0 1")->key()).has_value());
+}
+
+TEST_CASE("Game.Position Keys.Play Move", "[game]") {
+    Game game{};
+    auto cursor = game.edit();
+    cursor = cursor.play_move(Move{.from = Square::G1, .to = Square::F3, .piece = Piece::WhiteKnight});
+    cursor = cursor.play_move(Move{.from = Square::G8, .to = Square::F6, .piece = Piece::BlackKnight});
+    cursor = cursor.play_move(Move{.from = Square::F3, .to = Square::G1, .piece = Piece::WhiteKnight});
+    cursor = cursor.play_move(Move{.from = Square::F6, .to = Square::G8, .piece = Piece::BlackKnight});
+    CHECK(cursor.position_key() == Board::starting_position().key());
+    CHECK(game.tree().find_positions(cursor.position_key()) == std::vector<NodeId>{GameTree::root_id, cursor.node_id()});
+}
+
+TEST_CASE("Game.Position Keys.Long Game", "[game]") {
+    const std::array<Move, 4> shuffle{
+        Move{.from = Square::G1, .to = Square::F3, .piece = Piece::WhiteKnight},
+        Move{.from = Square::G8, .to = Square::F6, .piece = Piece::BlackKnight},
+        Move{.from = Square::F3, .to = Square::G1, .piece = Piece::WhiteKnight},
+        Move{.from = Square::F6, .to = Square::G8, .piece = Piece::BlackKnight},
+    };
+    Game game{};
+    auto replayed = Board::starting_position();
+    auto node_id = GameTree::root_id;
+    for (size_t ply = 1; ply <= 80; ++ply) {
+        const auto &move = shuffle[(ply - 1) % shuffle.size()];
+        node_id = game.add_node(node_id, move);
+        replayed.make_move(move);
+        CAPTURE(ply);
+        CHECK(game.tree().node(node_id).key() == replayed.key());
+        CHECK(game.board(node_id)->key() == replayed.key());
+        CHECK((game.tree().board(node_id) != nullptr) == (ply % 16 == 0));
+    }
+    CHECK(game.tree().find_positions(Board::starting_position().key()).size() == 21);
+    CHECK(game.tree().memory_usage(game.tree().node(node_id).parent()).position_bytes == 0);
+    CHECK(game.tree().memory_usage(node_id).position_bytes > 0);
+}
+
+TEST_CASE("Game.Reset", "[game]") {
+    auto game = parse_game(PositionCachePolicy::always());
+    game.edit().set_comment("Old comment");
+    const auto *tree = &game.tree();
+    GameMetadata metadata{};
+    metadata.add("Event", "New Event");
+    metadata.add("FEN", "4k3/8/8/8/8/8/8/4K3 w - - 0 1");
+
+    game.reset(metadata);
+    CHECK(&game.tree() == tree);
+    CHECK(game.tree().size() == 1);
+    CHECK(game.metadata().get("Event") == "New Event");
+    CHECK_FALSE(game.metadata().get("White").has_value());
+    CHECK(game.const_cursor().comment().empty());
+    CHECK_FALSE(game.const_cursor().child(0).has_value());
+    CHECK(game.position_cache_policy().mode == PositionCachePolicy::Mode::RootOnly);
+    CHECK(game.const_cursor().position_key() == Board::from_fen("4k3/8/8/8/8/8/8/4K3 w - - 0 1")->key());
+    CHECK(game.find_position(Board::starting_position().key()) == std::nullopt);
+
+    const auto copy = game.clone();
+    game.reset(GameMetadata{});
+    CHECK(&game.tree() != &copy.tree());
+    CHECK(copy.metadata().get("Event") == "New Event");
+    CHECK(copy.const_cursor().position_key() != game.const_cursor().position_key());
+}
+
+TEST_CASE("Game.Clone", "[game]") {
+    static_assert(!std::is_copy_constructible_v<Game>);
+    static_assert(std::is_nothrow_move_constructible_v<Game>);
+    auto game = parse_game(PositionCachePolicy::root_only());
+    auto clone = game.clone();
+    CHECK(&clone.tree() != &game.tree());
+    CHECK(clone.tree().size() == game.tree().size());
+    CHECK(clone.metadata().get("White") == "Player W");
+
+    auto cursor = clone.edit().child(0).value();
+    cursor.set_comment("Clone comment");
+    cursor.append_comment(std::string_view{" appended"});
+    cursor.set_premove_comment(std::string{"Premove"});
+    cursor.set_nags(std::vector<int>{1, 3});
+    CHECK(cursor.play_move(Move{.from = Square::D7, .to = Square::D5, .piece = Piece::BlackPawn}).node_id() != NodeId::Invalid);
+    CHECK(cursor.comment() == "Clone comment appended");
+    CHECK(cursor.premove_comment() == "Premove");
+    CHECK(cursor.nags() == std::pmr::vector<int>{1, 3});
+    CHECK(game.const_cursor().child(0)->comment().empty());
+    CHECK(game.const_cursor().child(0)->nags().empty());
+    CHECK(game.const_cursor().child(0)->child_count() == 1);
+    CHECK(clone.const_cursor().child(0)->child_count() == 2);
+
+    cursor.set_nags({});
+    CHECK(cursor.nags().empty());
+
+    const auto size = game.tree().size();
+    auto moved = std::move(game);
+    CHECK(moved.tree().size() == size);
+
+    SECTION("Moved-from game") {
+        // NOLINTBEGIN(bugprone-use-after-move)
+        const auto &moved_from = game;
+        CHECK(moved_from.tree().size() == 1);
+        CHECK(moved_from.metadata().get("White") == std::nullopt);
+        CHECK(moved_from.metadata().begin() == moved_from.metadata().end());
+        CHECK(moved_from.const_cursor().position_key() == Board::starting_position().key());
+        CHECK(moved_from.board(GameTree::root_id)->key() == Board::starting_position().key());
+        CHECK_FALSE(moved_from.const_cursor().child(0).has_value());
+        CHECK(game.edit().play_move(Move{.from = Square::E2, .to = Square::E4, .piece = Piece::WhitePawn}).ply() == 1);
+        CHECK(game.tree().size() == 2);
+        game.metadata().add("White", "New player");
+        CHECK(game.metadata().get("White") == "New player");
+        game = std::move(moved);
+        CHECK(game.tree().size() == size);
+        CHECK(moved.tree().size() == 1);
+        // NOLINTEND(bugprone-use-after-move)
+    }
+}
@@ -0,0 +1,201 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chessgame/import.h"
+
+#include <istream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace chessgame;
+
+namespace {
+
+const std::string pgn_data = R"([Event "Game 1"]
+[Result "1-0"]
+
+{Comment of game 1} 1. e4 e5 2. Nf3 Nc6 1-0
+
+[Event "Game 2"]
+[Result "*"]
+
+1. e4 d5 2. Nc3 e6 3. Nd5 *
+
+[Event "Game 3"]
+[Result "*"]
+
+1. e4 e5 2. Ke3 *
+
+[Event "Game 4"]
+[Result "0-1"]
+
+1. f3 e5 2. g4 Qh4# 0-1
+)";
+
+auto many_games(size_t count) -> std::string {
+    std::string data;
+    for (size_t index = 0; index < count; ++index) {
+        data += "[Event \"Game " + std::to_string(index) + "\"]\n\n1. e4 e5 2. Nf3 (2. d4 exd4) 2... Nc6 *\n\n";
+    }
+    return data;
+}
+
+/**
+ * \brief Stream buffer, that fails after the given data.
+ */
+class FailingBuffer : public std::streambuf {
+public:
+    explicit FailingBuffer(std::string data) : m_data{std::move(data)} { setg(m_data.data(), m_data.data(), m_data.data() + m_data.size()); }
+protected:
+    auto underflow() -> int_type override { throw std::runtime_error{"read error"}; }
+private:
+    std::string m_data;
+};
+
+} // namespace
+
+TEST_CASE("PGN.Import.Single Thread", "[pgn][import]") {
+    const auto games = import_games(pgn_data, ImportOptions{.thread_count = 1});
+    REQUIRE(games.size() == 4);
+    CHECK(games[0].offset == 0);
+    REQUIRE(games[0].game.has_value());
+    CHECK(games[0].game->metadata().get("Event") == "Game 1");
+    CHECK(games[0].game->const_cursor().comment() == "Comment of game 1");
+    CHECK_FALSE(games[0].error.has_value());
+
+    REQUIRE(games[1].game.has_value());
+    CHECK(games[1].game->const_cursor().comment().empty());
+    CHECK(games[1].warnings.size() == 1);
+
+    CHECK_FALSE(games[2].game.has_value());
+    REQUIRE(games[2].error.has_value());
+    CHECK(games[2].error->type() == PGNErrorType::IllegalMove);
+    CHECK(std::string_view{pgn_data}.substr(games[2].error_offset).starts_with("Ke3 *"));
+    CHECK(games[2].warnings.empty());
+
+    REQUIRE(games[3].game.has_value());
+    CHECK(games[3].game->metadata().get("Event") == "Game 4");
+    CHECK(games[3].warnings.empty());
+}
+
+TEST_CASE("PGN.Import.Invalid Game", "[pgn][import]") {
+    const std::string data = R"([Event "Game 1"]
+
+1. e4 e5 *
+
+[Event "Game 2"]
+[SetUp "1"]
+[FEN "not a fen string"]
+
+1. e4 e5 *
+
+[Event "Game 3"]
+
+1. d4 d5 *
+)";
+    for (const unsigned int thread_count : {1U, 2U}) {
+        const auto games = import_games(data, ImportOptions{.thread_count = thread_count, .batch_size = 1});
+        REQUIRE(games.size() == 3);
+        CHECK(games[0].game.has_value());
+        CHECK_FALSE(games[1].game.has_value());
+        REQUIRE(games[1].error.has_value());
+        CHECK(games[1].error->type() == PGNErrorType::InvalidFen);
+        REQUIRE(games[2].game.has_value());
+        CHECK(games[2].game->metadata().get("Event") == "Game 3");
+    }
+}
+
+TEST_CASE("PGN.Import.Multiple Threads", "[pgn][import]") {
+    const auto data = many_games(100);
+    const auto games = import_games(data, ImportOptions{.thread_count = 4, .batch_size = 3});
+    REQUIRE(games.size() == 100);
+    for (size_t index = 0; index < games.size(); ++index) {
+        REQUIRE(games[index].game.has_value());
+        CHECK(games[index].game->metadata().get("Event") == "Game " + std::to_string(index));
+        CHECK(games[index].game->const_cursor().child(0)->child(0)->child_count() == 2);
+    }
+}
+
+TEST_CASE("PGN.Import.Interned Tags", "[pgn][import]") {
+    const auto data = many_games(20);
+    const auto games = import_games(data, ImportOptions{.thread_count = 2, .batch_size = 5, .intern_tags = true});
+    REQUIRE(games.size() == 20);
+    std::set<const TagPool *> pools;
+    for (size_t index = 0; index < games.size(); ++index) {
+        REQUIRE(games[index].game.has_value());
+        CHECK(games[index].game->metadata().get("Event") == "Game " + std::to_string(index));
+        REQUIRE(games[index].game->metadata().pool() != nullptr);
+        pools.insert(games[index].game->metadata().pool().get());
+    }
+    CHECK(pools.size() <= 2);
+
+    const auto own_tags = import_games(data, ImportOptions{.thread_count = 1});
+    CHECK(own_tags.front().game->metadata().pool() == nullptr);
+}
+
+TEST_CASE("PGN.Import.Empty Input", "[pgn][import]") {
+    CHECK(import_games("").empty());
+}
+
+TEST_CASE("PGN.Import.Stream", "[pgn][import]") {
+    const auto data = many_games(100) + pgn_data;
+    std::vector<ImportedGame> games;
+    const auto consume = [&games](ImportedGame &&game) { games.push_back(std::move(game)); };
+
+    SECTION("Small blocks") {
+        std::istringstream in_stream{data};
+        CHECK(import_games(in_stream, consume, ImportOptions{.thread_count = 3, .batch_size = 7, .block_size = 50, .max_pending_batches = 2}) == 104);
+    }
+    SECTION("Single block") {
+        std::istringstream in_stream{data};
+        CHECK(import_games(in_stream, consume, ImportOptions{.thread_count = 1, .block_size = data.size() * 2}) == 104);
+    }
+
+    const auto expected = import_games(data, ImportOptions{.thread_count = 1});
+    REQUIRE(games.size() == expected.size());
+    for (size_t index = 0; index < games.size(); ++index) {
+        CHECK(games[index].offset == expected[index].offset);
+        CHECK(games[index].game.has_value() == expected[index].game.has_value());
+        CHECK(games[index].error.has_value() == expected[index].error.has_value());
+        CHECK(games[index].error_offset == expected[index].error_offset);
+        CHECK(games[index].warnings.size() == expected[index].warnings.size());
+    }
+    REQUIRE(games[100].game.has_value());
+    CHECK(games[100].game->metadata().get("Event") == "Game 1");
+    CHECK(games[102].error->type() == PGNErrorType::IllegalMove);
+}
+
+TEST_CASE("PGN.Import.Stream Errors", "[pgn][import]") {
+    const auto data = many_games(100);
+    SECTION("Empty input") {
+        std::istringstream in_stream{""};
+        CHECK(import_games(in_stream, [](ImportedGame &&) { FAIL(); }) == 0);
+    }
+    SECTION("Consumer stops the import") {
+        std::istringstream in_stream{data};
+        size_t consumed{0};
+        const auto consume = [&consumed](ImportedGame &&) {
+            if (++consumed == 10) {
+                throw std::runtime_error{"stop"};
+            }
+        };
+        CHECK_THROWS_AS(import_games(in_stream, consume, ImportOptions{.batch_size = 2, .block_size = 64, .max_pending_batches = 1}), std::runtime_error);
+        CHECK(consumed == 10);
+    }
+    SECTION("Stream error") {
+        FailingBuffer buffer{data.substr(0, 1000)};
+        std::istream in_stream{&buffer};
+        in_stream.exceptions(std::ios::badbit);
+        size_t consumed{0};
+        CHECK_THROWS_AS(import_games(in_stream, [&consumed](ImportedGame &&) { ++consumed; }), std::runtime_error);
+        CHECK(consumed < 100);
+    }
+}
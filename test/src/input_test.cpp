@@ -0,0 +1,208 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chessgame/import.h"
+#include "chessgame/input.h"
+#include "chessgame/pgn.h"
+
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using namespace chessgame;
+using namespace std::literals;
+
+namespace {
+
+const std::string pgn_data = "[Event \"Compressed\"]\n[Result \"1-0\"]\n\n1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 1-0\n\n";
+
+// pgn_data compressed with gzip.
+const auto gzip_data = "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\x8b\x76\x2d\x4b\xcd\x2b"
+                       "\x51\x50\x72\xce\xcf\x2d\x28\x4a\x2d\x2e\x4e\x4d\x51\x8a\xe5\x8a"
+                       "\x0e\x4a\x2d\x2e\xcd\x01\x8a\x1a\xea\x1a\x00\xb9\x5c\x86\x7a\x0a"
+                       "\xa9\x26\x0a\xa9\xa6\x0a\x46\x7a\x0a\x7e\x69\xc6\x0a\x7e\xc9\x66"
+                       "\x0a\xc6\x7a\x0a\x4e\x49\xa6\x0a\x89\x66\x0a\x40\x45\x5c\x5c\x00"
+                       "\x71\x90\x56\x3b\x48\x00\x00\x00"sv;
+
+// pgn_data compressed with zstd.
+const auto zstd_data = "\x28\xb5\x2f\xfd\x24\x48\x41\x02\x00\x5b\x45\x76\x65\x6e\x74\x20"
+                       "\x22\x43\x6f\x6d\x70\x72\x65\x73\x73\x65\x64\x22\x5d\x0a\x5b\x52"
+                       "\x65\x73\x75\x6c\x74\x20\x22\x31\x2d\x30\x22\x5d\x0a\x0a\x31\x2e"
+                       "\x20\x65\x34\x20\x65\x35\x20\x32\x2e\x20\x4e\x66\x33\x20\x4e\x63"
+                       "\x36\x20\x33\x2e\x20\x42\x62\x35\x20\x61\x36\x20\x31\x2d\x30\x0a"
+                       "\x0a\xa7\x12\x55\x5d"sv;
+
+// 64 copies of pgn_data compressed with gzip. The compressed data is consumed
+// long before the last output is read.
+const auto gzip_repeated_data = "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\xed\xcc\x3b\x0e\x83\x30"
+                                "\x14\x44\xd1\xde\xab\x18\xd1\x63\x41\xf8\x2c\x00\x44\x4b\x91\xd6"
+                                "\xa2\x00\xf2\x52\xe5\x83\x30\xc9\xfa\xf1\x32\x28\x6e\x39\x57\xa3"
+                                "\x13\x86\xbf\x7d\x0e\x65\xfd\xf7\xbd\xed\x16\xa3\x3d\xb2\xc9\x85"
+                                "\xbb\xc5\xdf\x2b\xd5\x32\x2f\xd2\x74\xa5\x97\xd5\xb2\x46\x37\xaf"
+                                "\xf1\x59\x69\x5c\x5b\x55\x5e\xdd\xd2\x68\x6e\x95\x4e\xce\x05\x1c"
+                                "\x1c\x1c\x1c\x1c\x1c\x1c\x1c\x1c\x1c\x1c\x1c\x1c\x1c\x1c\x1c\x9c"
+                                "\x4b\x3a\x27\xf3\x62\xbd\x90\x00\x12\x00\x00"sv;
+
+// 64 copies of pgn_data compressed with zstd.
+const auto zstd_repeated_data = "\x28\xb5\x2f\xfd\x64\x00\x11\x7d\x02\x00\x82\x04\x11\x18\x70\xad"
+                                "\x0e\x40\x08\xc0\xe3\xcb\x59\x5a\x42\x1d\xd1\xe2\xc1\xd7\x12\x79"
+                                "\x83\x24\xfd\xf5\x61\x04\xaa\x4b\xb1\x3f\xe3\xee\x10\xce\xed\x0f"
+                                "\x81\x6f\x0a\x3c\x03\x77\xfd\xa0\xcf\x4c\x55\xee\x52\x6c\x1f\x2d"
+                                "\xd2\xec\x22\xaa\xdc\xa4\xe7\x6c\xe8\x61\x9c\x61\x1f\x35\x3d\x11"
+                                "\x31\x01\x00\x48\x6d\x2c\x7d\x88\x02\x6b\x95\x7c\x2d"sv;
+
+auto repeated_pgn_data() -> std::string {
+    std::string data;
+    for (int copy = 0; copy < 64; ++copy) {
+        data += pgn_data;
+    }
+    return data;
+}
+
+auto read_all(InputSource &input, size_t block_size) -> std::optional<std::string> {
+    std::string data;
+    std::string block(block_size, '\0');
+    while (true) {
+        const auto read = input.read(block.data(), block.size());
+        if (!read.has_value()) {
+            return std::nullopt;
+        }
+        if (*read == 0) {
+            return data;
+        }
+        data.append(block, 0, *read);
+    }
+}
+
+} // namespace
+
+TEST_CASE("Input.Detect Compression", "[input]") {
+    CHECK(detect_compression(pgn_data) == Compression::None);
+    CHECK(detect_compression("") == Compression::None);
+    CHECK(detect_compression(gzip_data) == Compression::Gzip);
+    CHECK(detect_compression("\x28\xb5\x2f\xfd\x04"sv) == Compression::Zstd);
+    CHECK(detect_compression(zstd_data) == Compression::Zstd);
+    CHECK(compression_supported(Compression::None));
+}
+
+TEST_CASE("Input.Uncompressed", "[input]") {
+    std::istringstream in_stream{pgn_data};
+    auto input = open_input(in_stream);
+    CHECK(read_all(*input, 5) == pgn_data);
+    MemoryInput memory{pgn_data};
+    CHECK(read_all(memory, 7) == pgn_data);
+    StreamInput prefixed{in_stream, "prefix"};
+    CHECK(read_all(prefixed, 4) == "prefix");
+}
+
+TEST_CASE("Input.Gzip", "[input]") {
+    if (!compression_supported(Compression::Gzip)) {
+        CHECK_THROWS_AS(GzipInput{std::make_unique<MemoryInput>(gzip_data)}, ChessGameError);
+        return;
+    }
+    SECTION("Blocks") {
+        for (const size_t block_size : {1UL, 3UL, 1024UL}) {
+            auto input = open_input(gzip_data);
+            CHECK(read_all(*input, block_size) == pgn_data);
+        }
+    }
+    SECTION("Buffered output") {
+        for (const size_t block_size : {1UL, 7UL, 100UL}) {
+            auto input = open_input(gzip_repeated_data);
+            CHECK(read_all(*input, block_size) == repeated_pgn_data());
+        }
+    }
+    SECTION("Concatenated members") {
+        const auto data = std::string{gzip_data} + std::string{gzip_data};
+        auto input = open_input(data);
+        CHECK(read_all(*input, 16) == pgn_data + pgn_data);
+    }
+    SECTION("Corrupted data") {
+        auto truncated = open_input(gzip_data.substr(0, 40));
+        CHECK_FALSE(read_all(*truncated, 16).has_value());
+        auto corrupted_data = std::string{gzip_data};
+        corrupted_data[20] = '\xff';
+        auto corrupted = open_input(corrupted_data);
+        CHECK_FALSE(read_all(*corrupted, 16).has_value());
+    }
+    SECTION("Parser") {
+        std::istringstream in_stream{std::string{gzip_data}};
+        PGNParser parser{open_input(in_stream)};
+        const auto game = parser.read_game();
+        REQUIRE(game.has_value());
+        CHECK(game->metadata().get("Event") == "Compressed");
+        CHECK(game->current_mainline().ply() == 6);
+        CHECK_FALSE(parser.read_game().has_value());
+
+        auto truncated = PGNParser{open_input(gzip_data.substr(0, 60))};
+        CHECK_THROWS_AS(truncated.read_game(), PGNError);
+    }
+    SECTION("Lexer blocks") {
+        PGNLexer lexer{open_input(gzip_data), 3};
+        PGNLexer expected{pgn_data};
+        for (auto token = expected.next_token(); token.type != PGNLexer::TokenType::EndOfInput; token = expected.next_token()) {
+            const auto compressed_token = lexer.next_token();
+            CHECK(compressed_token.type == token.type);
+            CHECK(compressed_token.value == token.value);
+            CHECK(compressed_token.offset == token.offset);
+        }
+        CHECK(lexer.next_token().type == PGNLexer::TokenType::EndOfInput);
+    }
+    SECTION("Streaming import") {
+        const auto data = std::string{gzip_data} + std::string{gzip_data} + std::string{gzip_data};
+        auto input = open_input(data);
+        size_t games{0};
+        const auto count_game = [&games](ImportedGame &&game) {
+            if (game.game.has_value()) {
+                ++games;
+            }
+        };
+        CHECK(import_games(*input, count_game, ImportOptions{.thread_count = 2, .block_size = 32}) == 3);
+        CHECK(games == 3);
+    }
+}
+
+TEST_CASE("Input.Zstd", "[input]") {
+    if (!compression_supported(Compression::Zstd)) {
+        CHECK_THROWS_AS(ZstdInput{std::make_unique<MemoryInput>(zstd_data)}, ChessGameError);
+        return;
+    }
+    SECTION("Blocks") {
+        for (const size_t block_size : {1UL, 3UL, 1024UL}) {
+            auto input = open_input(zstd_data);
+            CHECK(read_all(*input, block_size) == pgn_data);
+        }
+    }
+    SECTION("Buffered output") {
+        for (const size_t block_size : {1UL, 7UL, 100UL}) {
+            auto input = open_input(zstd_repeated_data);
+            CHECK(read_all(*input, block_size) == repeated_pgn_data());
+        }
+    }
+    SECTION("Concatenated frames") {
+        const auto data = std::string{zstd_data} + std::string{zstd_data};
+        auto input = open_input(data);
+        CHECK(read_all(*input, 16) == pgn_data + pgn_data);
+    }
+    SECTION("Corrupted data") {
+        for (const size_t size : {10UL, 40UL, zstd_data.size() - 1}) {
+            auto truncated = open_input(zstd_data.substr(0, size));
+            CHECK_FALSE(read_all(*truncated, 16).has_value());
+        }
+        auto truncated_repeated = open_input(zstd_repeated_data.substr(0, zstd_repeated_data.size() - 4));
+        CHECK_FALSE(read_all(*truncated_repeated, 16).has_value());
+    }
+    SECTION("Parser") {
+        std::istringstream in_stream{std::string{zstd_data}};
+        PGNParser parser{open_input(in_stream)};
+        const auto game = parser.read_game();
+        REQUIRE(game.has_value());
+        CHECK(game->metadata().get("Event") == "Compressed");
+        CHECK(game->current_mainline().ply() == 6);
+        CHECK_FALSE(parser.read_game().has_value());
+    }
+}
@@ -0,0 +1,165 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chessgame/mainline.h"
+#include "chessgame/pgn.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace chessgame;
+
+namespace {
+
+const std::string pgn_data = R"([Event "Mainline Test"]
+[Site "Test Site"]
+[Result "1-0"]
+
+{Game comment} 1. e4 $1 e5 2. Nf3 ({Alternative} 2. f4 exf4 $2 {Gambit}) (2. d4)
+2... Nc6 3. Bc4 Nf6 4. O-O Bc5 5. Pd4 Bxd4 6. Nxd4 Nxd4 7. Qxd4 d6 8. Bg5 h6
+9. Bxf6 Qxf6 10. Bxf7+ Kxf7 1-0
+
+[Event "Setup"]
+[Result "*"]
+[SetUp "1"]
+[FEN "4k3/1P6/8/3pP3/8/8/8/4K3 w - d6 0 12"]
+
+12. exd6 Kd7 13. b8=N+ Kxd6 *
+
+[Event "Black to move"]
+[Result "0-1"]
+[SetUp "1"]
+[FEN "7k/8/8/8/8/8/5q2/7K b - - 0 40"]
+
+40... Qf1+ 41. Kh2 Qg2# 0-1
+)";
+
+auto parse_games(const std::string &data) -> std::vector<Game> {
+    auto parser = PGNParser{std::string_view{data}};
+    std::vector<Game> games;
+    for (auto game = parser.read_game(); game.has_value(); game = parser.read_game()) {
+        games.push_back(std::move(game).value());
+    }
+    return games;
+}
+
+template<typename GameType>
+auto to_pgn(const GameType &game) -> std::string {
+    std::ostringstream out;
+    PGNWriter writer{out};
+    writer.write_game(game);
+    return out.str();
+}
+
+} // namespace
+
+TEST_CASE("Mainline.Move Encoding", "[mainline]") {
+    auto board = Board::from_fen("r3k2r/1P6/8/3pP3/8/8/8/R3K2R w KQkq d6 0 1").value();
+    const auto en_passant = chesscore::Move{
+        .from = chesscore::Square::E5,
+        .to = chesscore::Square::D6,
+        .piece = chesscore::Piece::WhitePawn,
+        .captured = chesscore::Piece::BlackPawn,
+        .capturing_en_passant = true
+    };
+    const auto promotion = chesscore::Move{
+        .from = chesscore::Square::B7,
+        .to = chesscore::Square::B8,
+        .piece = chesscore::Piece::WhitePawn,
+        .promoted = chesscore::Piece::WhiteBishop
+    };
+    const auto castling = chesscore::Move{.from = chesscore::Square::E1, .to = chesscore::Square::C1, .piece = chesscore::Piece::WhiteKing};
+    for (const auto &move : {en_passant, promotion, castling}) {
+        CHECK(decode_compact_move(encode_compact_move(move), board) == move);
+    }
+    const auto rook_capture = chesscore::Move{.from = chesscore::Square::A1, .to = chesscore::Square::A8, .piece = chesscore::Piece::WhiteRook, .captured = chesscore::Piece::BlackRook};
+    CHECK(decode_compact_move(encode_compact_move(rook_capture), board) == rook_capture);
+    // No piece of the side to move on the from square.
+    CHECK_FALSE(decode_compact_move(encode_compact_move(chesscore::Move{.from = chesscore::Square::E8, .to = chesscore::Square::E7, .piece = chesscore::Piece::BlackKing}), board).has_value());
+    CHECK_FALSE(decode_compact_move(encode_compact_move(chesscore::Move{.from = chesscore::Square::C3, .to = chesscore::Square::C4, .piece = chesscore::Piece::WhitePawn}), board).has_value());
+}
+
+TEST_CASE("Mainline.Game Conversion", "[mainline]") {
+    const auto games = parse_games(pgn_data);
+    REQUIRE(games.size() == 3);
+
+    const auto mainline = MainlineGame::from_game(games[0]);
+    CHECK(mainline.metadata().get("Event") == "Mainline Test");
+    CHECK(mainline.ply_count() == 20);
+    CHECK(mainline.move_codes().size_bytes() == 2 * mainline.ply_count());
+    const auto moves = mainline.moves();
+    REQUIRE(moves.size() == 20);
+    CHECK(moves[6].is_castling());
+
+    const auto game = mainline.to_game();
+    CHECK(game.tree().size() == 21);
+    CHECK(game.const_cursor().child(0)->child(0)->child_count() == 1);
+    CHECK(game.const_cursor().child(0)->nags().empty());
+    CHECK(game.const_cursor().child(0)->san() == "e4");
+
+    for (const auto &original : games) {
+        CHECK(to_pgn(MainlineGame::from_game(original).to_game()) == to_pgn(MainlineGame::from_game(original)));
+    }
+    CHECK(to_pgn(MainlineGame::from_game(games[1])) == to_pgn(games[1]));
+    CHECK(to_pgn(MainlineGame::from_game(games[2])) == to_pgn(games[2]));
+
+    MainlineGame invalid{MainlineGame::from_game(games[1]).metadata()};
+    invalid.metadata().add("Annotator", "Test");
+    invalid.append_move(chesscore::Move{.from = chesscore::Square::A1, .to = chesscore::Square::A2, .piece = chesscore::Piece::WhiteRook});
+    CHECK_THROWS_AS(invalid.moves(), ChessGameError);
+    CHECK_THROWS_AS(to_pgn(invalid), PGNError);
+
+    MainlineGame invalid_fen{MainlineGame::from_game(games[1]).metadata()};
+    invalid_fen.metadata().set("FEN", "not a position");
+    std::ostringstream out;
+    PGNWriter writer{out};
+    try {
+        writer.write_game(invalid_fen);
+        FAIL("Invalid FEN not detected");
+    } catch (const PGNError &error) {
+        CHECK(error.type() == PGNErrorType::InvalidFen);
+    }
+    // Nothing of the game is written.
+    CHECK(out.str().empty());
+}
+
+TEST_CASE("Mainline.Parser", "[mainline]") {
+    const auto games = parse_games(pgn_data);
+    auto parser = PGNParser{std::string_view{pgn_data}};
+    for (const auto &game : games) {
+        const auto mainline = parser.read_mainline_game();
+        REQUIRE(mainline.has_value());
+        CHECK(mainline->metadata().get("Event") == game.metadata().get("Event"));
+        CHECK(std::ranges::equal(mainline->move_codes(), MainlineGame::from_game(game).move_codes()));
+    }
+    CHECK(parser.warnings().empty());
+    CHECK_FALSE(parser.read_mainline_game().has_value());
+
+    SECTION("Warnings of the fallbacks") {
+        parser.set_input("[Event \"Fallback\"]\n\n1. e4 d5 2. ed5 Qxd5 *\n");
+        const auto mainline = parser.read_mainline_game();
+        REQUIRE(mainline.has_value());
+        CHECK(mainline->ply_count() == 4);
+        REQUIRE(parser.warnings().size() == 1);
+        CHECK(parser.warnings()[0].type == PGNWarningType::MoveMissingCapture);
+    }
+    SECTION("Errors") {
+        parser.set_input("[Event \"Illegal\"]\n\n1. e4 e6 2. Ke3 d5 *\n");
+        CHECK_THROWS_AS(parser.read_mainline_game(), PGNError);
+        parser.set_input("[Event \"Unbalanced\"]\n\n1. e4 e6 ) *\n");
+        CHECK_THROWS_AS(parser.read_mainline_game(), PGNError);
+        StrictMainlinePGNParser strict_parser{std::string_view{"[Event \"Strict\"]\n\n1. e4 d5 2. ed5 Qxd5 *\n"}};
+        CHECK_THROWS_AS(strict_parser.read_mainline_game(), PGNError);
+    }
+    SECTION("Chess960 games are skipped") {
+        parser.set_input("[Variant \"Chess960\"]\n\n1. e4 *\n\n[Event \"Standard\"]\n\n1. d4 *\n");
+        const auto mainline = parser.read_mainline_game();
+        REQUIRE(mainline.has_value());
+        CHECK(mainline->metadata().get("Event") == "Standard");
+    }
+}
@@ -0,0 +1,223 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chessgame/game.h"
+#include "chessgame/memory.h"
+#include "chessgame/pgn.h"
+
+#include "chesscore/fen.h"
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace chessgame;
+using namespace chesscore;
+
+namespace {
+
+const Move e4{.from = Square::E2, .to = Square::E4, .piece = Piece::WhitePawn};
+const Move d4{.from = Square::D2, .to = Square::D4, .piece = Piece::WhitePawn};
+const Move e5{.from = Square::E7, .to = Square::E5, .piece = Piece::BlackPawn};
+
+/**
+ * \brief Memory resource, that counts the bytes currently allocated.
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+    [[nodiscard]] auto allocated() const -> size_t { return m_allocated; }
+private:
+    size_t m_allocated{0};
+
+    auto do_allocate(size_t bytes, size_t alignment) -> void * override {
+        m_allocated += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    auto do_deallocate(void *pointer, size_t bytes, size_t alignment) -> void override {
+        m_allocated -= bytes;
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+
+    [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override { return this == &other; }
+};
+
+const std::string_view annotated_game = R"([Event "Memory"]
+[White "Alice"]
+[Black "Bob"]
+[Result "*"]
+
+1. e4 {A comment, that is too long for the small string buffer} 1... e5 $1 $14 (1... c5 2. Nf3) 2. Nf3 *
+)";
+
+} // namespace
+
+TEST_CASE("Memory.Heap Bytes", "[memory]") {
+    CHECK(heap_bytes(std::string{"short"}) == 0);
+    const std::string long_string(100, 'x');
+    CHECK(heap_bytes(long_string) == long_string.capacity() + 1);
+    std::vector<int> numbers;
+    CHECK(heap_bytes(numbers) == 0);
+    numbers.reserve(10);
+    CHECK(heap_bytes(numbers) == numbers.capacity() * sizeof(int));
+}
+
+TEST_CASE("Memory.Tree Usage", "[memory]") {
+    GameTree tree{Position{FenString::starting_position()}};
+    auto usage = tree.memory_usage();
+    CHECK(usage.nodes == 1);
+    CHECK(usage.positions == 1);
+    CHECK(usage.node_bytes >= sizeof(GameTree) + sizeof(GameNode));
+    CHECK(usage.metadata_bytes == 0);
+    CHECK(usage.movetext_bytes == 0);
+
+    const auto e4_node = tree.add_child(GameTree::root_id, e4).first;
+    const auto e5_node = tree.add_child(e4_node, e5).first;
+    tree.add_child(GameTree::root_id, d4);
+    tree.set_comment(e5_node, std::string(100, 'x'));
+    tree.add_nag(e5_node, 1);
+    tree.set_position_key(e5_node, 42);
+    // Reporting the memory does not build the index, the first search does.
+    CHECK(tree.memory_usage().index_bytes == usage.index_bytes);
+    CHECK(tree.find_position(42) == e5_node);
+    const auto annotated = tree.memory_usage();
+    CHECK(annotated.nodes == 4);
+    CHECK(annotated.node_bytes >= sizeof(GameTree) + 4 * sizeof(GameNode));
+    CHECK(annotated.comment_bytes >= usage.comment_bytes + 101);
+    CHECK(annotated.nag_bytes > usage.nag_bytes);
+    CHECK(annotated.index_bytes > usage.index_bytes);
+    CHECK(annotated.total() > usage.total());
+
+    SECTION("Single nodes") {
+        const auto e4_usage = tree.memory_usage(e4_node);
+        CHECK(e4_usage == MemoryUsage{.nodes = 1, .node_bytes = sizeof(GameNode)});
+        const auto e5_usage = tree.memory_usage(e5_node);
+        CHECK(e5_usage.nodes == 1);
+        CHECK(e5_usage.comment_bytes >= 101);
+        CHECK(e5_usage.nag_bytes >= sizeof(int));
+        CHECK(e5_usage.index_bytes > 0);
+        CHECK(e5_usage.positions == 0);
+        CHECK(tree.memory_usage(GameTree::root_id).positions == 1);
+    }
+}
+
+TEST_CASE("Memory.Game Usage", "[memory]") {
+    PGNParser parser{annotated_game};
+    const auto game = parser.read_game();
+    REQUIRE(game.has_value());
+    const auto usage = game->memory_usage();
+    CHECK(usage.nodes == game->tree().size());
+    CHECK(usage.nodes == 6);
+    CHECK(usage.comment_bytes > 0);
+    CHECK(usage.nag_bytes > 0);
+    CHECK(usage.metadata_bytes >= 4 * sizeof(metadata_tag));
+    CHECK(usage.tag_pool_bytes == 0);
+    CHECK(usage.movetext_bytes == 0);
+
+    MemoryUsage sum{};
+    sum += game->metadata().memory_usage();
+    sum += game->tree().memory_usage();
+    CHECK(sum == usage);
+
+    SECTION("Pending movetext") {
+        parser.set_input(annotated_game);
+        parser.set_lazy_movetext(true);
+        const auto lazy_game = parser.read_game();
+        REQUIRE(lazy_game.has_value());
+        const auto lazy_usage = lazy_game->memory_usage();
+        CHECK(lazy_game->has_pending_movetext());
+        CHECK(lazy_usage.nodes == 1);
+        CHECK(lazy_usage.movetext_bytes > 0);
+    }
+}
+
+TEST_CASE("Memory.Memory Resource", "[memory]") {
+    CountingResource resource{};
+    {
+        Game game{GameMetadata{}, &resource};
+        CHECK(game.memory_resource() == &resource);
+        CHECK(game.tree().memory_resource() == &resource);
+        CHECK(game.metadata().memory_resource() == &resource);
+        const auto allocated = resource.allocated();
+        CHECK(allocated > 0);
+
+        const auto e4_node = game.add_node(GameTree::root_id, e4);
+        CHECK(resource.allocated() > allocated);
+
+        // Comments and NAGs are allocated from the resource, too.
+        const auto annotated = resource.allocated();
+        game.tree().set_comment(e4_node, std::string(100, 'x'));
+        game.tree().add_nag(e4_node, 1);
+        CHECK(resource.allocated() >= annotated + 101 + sizeof(int));
+        CHECK(game.tree().comment(e4_node).get_allocator().resource() == &resource);
+        CHECK(game.tree().nags(e4_node).get_allocator().resource() == &resource);
+
+        const auto copy = game.clone();
+        CHECK(copy.memory_resource() == std::pmr::get_default_resource());
+        CHECK(copy.tree().memory_resource() == std::pmr::get_default_resource());
+        CHECK(copy.tree().comment(e4_node).get_allocator().resource() == std::pmr::get_default_resource());
+        const GameTree tree_copy{copy.tree(), &resource};
+        CHECK(tree_copy.memory_resource() == &resource);
+        CHECK(tree_copy.comment(e4_node).get_allocator().resource() == &resource);
+        CHECK(tree_copy.find_position(tree_copy.node(e4_node).key()) == e4_node);
+    }
+    CHECK(resource.allocated() == 0);
+
+    SECTION("Move assignment") {
+        {
+            Game game{};
+            game.metadata().add("White", "A player with a name, that does not fit into a small string");
+            Game other{GameMetadata{}, &resource};
+            other.metadata().add("Black", "Another player with a name, that does not fit into a small string");
+            game = std::move(other);
+            // The tree moves with its memory resource, the metadata is copied into the previous resource.
+            CHECK(game.memory_resource() == &resource);
+            CHECK(game.metadata().memory_resource() == std::pmr::get_default_resource());
+            CHECK(game.tree().memory_resource() == &resource);
+            CHECK(game.metadata().get("Black") == "Another player with a name, that does not fit into a small string");
+            CHECK_FALSE(game.metadata().get("White").has_value());
+        }
+        CHECK(resource.allocated() == 0);
+    }
+
+    SECTION("Parsed games") {
+        {
+            PGNParser parser{annotated_game, &resource};
+            CHECK(parser.memory_resource() == &resource);
+            const auto game = parser.read_game();
+            REQUIRE(game.has_value());
+            CHECK(game->tree().memory_resource() == &resource);
+            CHECK(game->metadata().memory_resource() == &resource);
+            CHECK(game->metadata().get("White") == "Alice");
+
+            parser.set_input(annotated_game);
+            parser.set_lazy_movetext(true);
+            const auto lazy_game = parser.read_game();
+            REQUIRE(lazy_game.has_value());
+            CHECK(lazy_game->tree().size() == 6);
+            CHECK(lazy_game->tree().memory_resource() == &resource);
+        }
+        CHECK(resource.allocated() == 0);
+    }
+    SECTION("Batch in a monotonic buffer") {
+        std::pmr::monotonic_buffer_resource batch{&resource};
+        {
+            PGNParser parser{annotated_game, &batch};
+            for (int count = 0; count < 10; ++count) {
+                parser.set_input(annotated_game);
+                const auto game = parser.read_game();
+                REQUIRE(game.has_value());
+                CHECK(game->tree().size() == 6);
+            }
+        }
+        CHECK(resource.allocated() > 0);
+        batch.release();
+        CHECK(resource.allocated() == 0);
+    }
+}
@@ -0,0 +1,117 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chessgame/metadata.h"
+
+#include <iterator>
+#include <memory>
+#include <string>
+
+using namespace chessgame;
+
+TEST_CASE("Game.Metadata.Get Tags", "[metadata]") {
+    GameMetadata metadata;
+    CHECK(metadata.pool() == nullptr);
+    CHECK_FALSE(metadata.get("White").has_value());
+
+    metadata.add("White", "Player W");
+    metadata.add("Annotator", "Someone");
+    metadata.add("Round", "3");
+    metadata.add("Result", "1-0");
+    metadata.add("White", "Another Player");
+    CHECK(metadata.pool() == nullptr);
+
+    CHECK(metadata.get("White") == "Player W");
+    CHECK(metadata.get("Round") == "3");
+    CHECK(metadata.get("Result") == "1-0");
+    CHECK(metadata.get("Annotator") == "Someone");
+    CHECK_FALSE(metadata.get("Black").has_value());
+    CHECK_FALSE(metadata.get("Whites").has_value());
+    CHECK_FALSE(metadata.get("").has_value());
+    CHECK(std::distance(metadata.begin(), metadata.end()) == 5);
+    CHECK(metadata.begin()->name == "White");
+    CHECK(std::prev(metadata.end())->value == "Another Player");
+}
+
+TEST_CASE("Game.Metadata.STR Tags", "[metadata]") {
+    for (size_t index = 0; index < GameMetadata::str_tags.size(); ++index) {
+        CHECK(GameMetadata::str_tag_index(GameMetadata::str_tags[index]) == index);
+        CHECK(GameMetadata::is_str_tag(GameMetadata::str_tags[index]));
+    }
+    CHECK_FALSE(GameMetadata::is_str_tag("Annotator"));
+    CHECK_FALSE(GameMetadata::is_str_tag("Rounds"));
+    CHECK_FALSE(GameMetadata::is_str_tag("event"));
+    CHECK_FALSE(GameMetadata::is_str_tag(""));
+}
+
+TEST_CASE("Game.Metadata.Shared Pool", "[metadata]") {
+    const auto pool = std::make_shared<TagPool>();
+    GameMetadata first{pool};
+    first.add("Event", "Championship");
+    first.add("White", "Player A");
+    GameMetadata second{pool};
+    second.add("Event", "Championship");
+    second.add("White", "Player B");
+    CHECK(pool->size() == 5);
+    CHECK(first.get("Event")->data() == second.get("Event")->data());
+
+    auto copy = first;
+    copy.add("Black", "Player B");
+    CHECK(copy.pool() == pool);
+    CHECK(pool->size() == 6);
+    CHECK(copy.get("Black") == "Player B");
+    CHECK_FALSE(first.get("Black").has_value());
+}
+
+TEST_CASE("Game.Metadata.Set Tags", "[metadata]") {
+    GameMetadata metadata;
+    metadata.add("White", "Player W");
+    metadata.add("White", "Another Player");
+    metadata.set("White", "Renamed");
+    metadata.set("Black", "Player B");
+    CHECK(metadata.get("White") == "Renamed");
+    CHECK(metadata.get("Black") == "Player B");
+    CHECK(std::distance(metadata.begin(), metadata.end()) == 3);
+    CHECK(std::next(metadata.begin())->value == "Another Player");
+}
+
+TEST_CASE("Game.Metadata.Reuse", "[metadata]") {
+    GameMetadata metadata;
+    const std::string long_value(1000, 'x');
+    metadata.add("Event", "First");
+    metadata.add("Annotator", long_value);
+    const auto usage = metadata.memory_usage();
+    CHECK(usage.metadata_bytes > long_value.size());
+    CHECK(usage.tag_pool_bytes == 0);
+
+    metadata.reset(nullptr);
+    CHECK(metadata.begin() == metadata.end());
+    CHECK_FALSE(metadata.get("Event").has_value());
+    metadata.add("Event", "Second");
+    metadata.add("Annotator", long_value);
+    CHECK(metadata.get("Event") == "Second");
+    CHECK(metadata.get("Annotator") == long_value);
+    CHECK(metadata.memory_usage() == usage);
+
+    const auto copy = metadata;
+    metadata.reset(nullptr);
+    metadata.add("Event", "Third");
+    CHECK(copy.get("Event") == "Second");
+    CHECK(copy.get("Annotator") == long_value);
+}
+
+TEST_CASE("Game.Metadata.Pool Limit", "[metadata]") {
+    const auto pool = std::make_shared<TagPool>(12);
+    GameMetadata metadata{pool};
+    metadata.add("Event", "Championship");
+    metadata.add("Site", "Somewhere");
+    CHECK(pool->size() == 2);
+    CHECK(metadata.get("Event") == "Championship");
+    CHECK(metadata.get("Site") == "Somewhere");
+    CHECK(pool->intern("Event") == "Event");
+    CHECK_FALSE(pool->intern("Another String").has_value());
+}
@@ -0,0 +1,201 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chesscore_io/chesscore_io.h"
+#include "chessgame/opening.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chessgame;
+using namespace chesscore;
+
+namespace {
+
+const Move e4{.from = Square::E2, .to = Square::E4, .piece = Piece::WhitePawn};
+const Move d4{.from = Square::D2, .to = Square::D4, .piece = Piece::WhitePawn};
+const Move e6{.from = Square::E7, .to = Square::E6, .piece = Piece::BlackPawn};
+const Move d5{.from = Square::D7, .to = Square::D5, .piece = Piece::BlackPawn};
+
+auto key_after(std::initializer_list<Move> moves) -> uint64_t {
+    auto board = Board::starting_position();
+    for (const auto &move : moves) {
+        board.make_move(move);
+    }
+    return board.key();
+}
+
+auto build_tree(std::string_view pgn_data, const OpeningTreeOptions &options = {}) -> OpeningTree {
+    OpeningTree tree{options};
+    tree.add_games(import_games(pgn_data));
+    return tree;
+}
+
+const std::string games_data = R"([Event "Game 1"]
+[Result "1-0"]
+[WhiteElo "2400"]
+[BlackElo "2200"]
+
+1. e4 e6 2. d4 d5 1-0
+
+[Event "Game 2"]
+[Result "1/2-1/2"]
+[WhiteElo "2000"]
+
+1. e4 c5 1/2-1/2
+
+[Event "Game 3"]
+[Result "0-1"]
+[WhiteElo "unknown"]
+
+1. d4 e6 2. e4 d5 0-1
+)";
+
+} // namespace
+
+TEST_CASE("Game.Opening Tree.Merge Games", "[opening]") {
+    const auto tree = build_tree(games_data);
+    CHECK(tree.game_count() == 3);
+    CHECK(tree.position_count() == 8);
+
+    const auto start = tree.stats(Board::starting_position().key());
+    REQUIRE(start.has_value());
+    CHECK(*start == OpeningStats{.games = 3, .white_wins = 1, .draws = 1, .black_wins = 1, .rating_sum = 4400, .rated_games = 2});
+    CHECK(start->white_score() == 0.5);
+    CHECK(start->average_rating() == 2200.0);
+
+    const auto start_moves = tree.moves(Board::starting_position().key());
+    REQUIRE(start_moves.size() == 2);
+    CHECK(start_moves[0].move == e4);
+    CHECK(start_moves[0].key == key_after({e4}));
+    CHECK(start_moves[0].stats == OpeningStats{.games = 2, .white_wins = 1, .draws = 1, .rating_sum = 4400, .rated_games = 2});
+    CHECK(start_moves[1].move == d4);
+    CHECK(start_moves[1].stats == OpeningStats{.games = 1, .black_wins = 1});
+
+    const auto after_e4 = tree.moves(key_after({e4}));
+    REQUIRE(after_e4.size() == 2);
+    CHECK(after_e4[0].stats.average_rating() != after_e4[1].stats.average_rating());
+
+    // Both move orders reach the same position.
+    const auto french = tree.stats(key_after({e4, e6, d4, d5}));
+    REQUIRE(french.has_value());
+    CHECK(*french == OpeningStats{.games = 2, .white_wins = 1, .black_wins = 1, .rating_sum = 2400, .rated_games = 1});
+    CHECK(tree.moves(key_after({e4, e6, d4, d5})).empty());
+
+    CHECK_FALSE(tree.stats(key_after({d5})).has_value());
+    CHECK(tree.moves(key_after({d5})).empty());
+}
+
+TEST_CASE("Game.Opening Tree.Options", "[opening]") {
+    const std::string pgn_data = R"([Event "Variations"]
+[Result "*"]
+
+1. e4 (1. d4 d5) 1... e6 2. Nf3 *
+)";
+    const auto start_key = Board::starting_position().key();
+
+    SECTION("Main line only") {
+        const auto tree = build_tree(pgn_data);
+        CHECK(tree.moves(start_key).size() == 1);
+        CHECK_FALSE(tree.stats(key_after({d4})).has_value());
+        CHECK(tree.position_count() == 4);
+    }
+    SECTION("Variations") {
+        const auto tree = build_tree(pgn_data, {.include_variations = true});
+        CHECK(tree.moves(start_key).size() == 2);
+        CHECK(tree.stats(key_after({d4, d5}))->games == 1);
+        CHECK(tree.stats(start_key)->games == 1);
+        CHECK(tree.position_count() == 6);
+    }
+    SECTION("Maximum ply") {
+        const auto tree = build_tree(pgn_data, {.include_variations = true, .max_ply = 1});
+        CHECK(tree.moves(start_key).size() == 2);
+        CHECK(tree.stats(key_after({d4})).has_value());
+        CHECK(tree.moves(key_after({d4})).empty());
+        CHECK(tree.position_count() == 3);
+    }
+    SECTION("Repeated positions") {
+        const auto tree = build_tree(R"([Result "1/2-1/2"]
+
+1. Nf3 Nf6 2. Ng1 Ng8 3. Nf3 Nf6 1/2-1/2
+)");
+        CHECK(tree.stats(start_key)->games == 1);
+        REQUIRE(tree.moves(start_key).size() == 1);
+        CHECK(tree.moves(start_key)[0].stats.games == 1);
+        CHECK(tree.position_count() == 4);
+    }
+}
+
+TEST_CASE("Game.Opening Tree.Concurrent Insertion", "[opening]") {
+    std::vector<Game> games;
+    for (auto &imported : import_games(games_data)) {
+        games.push_back(std::move(imported.game.value()));
+    }
+    constexpr uint64_t thread_count{4};
+    constexpr uint64_t repetitions{50};
+    OpeningTree tree{};
+    {
+        std::vector<std::jthread> threads;
+        for (uint64_t thread = 0; thread < thread_count; ++thread) {
+            threads.emplace_back([&tree, &games] {
+                for (uint64_t repetition = 0; repetition < repetitions; ++repetition) {
+                    for (const auto &game : games) {
+                        tree.add_game(game);
+                    }
+                }
+            });
+        }
+    }
+    CHECK(tree.game_count() == thread_count * repetitions * 3);
+    CHECK(tree.position_count() == 8);
+    CHECK(tree.stats(Board::starting_position().key())->games == thread_count * repetitions * 3);
+    CHECK(tree.moves(Board::starting_position().key())[0].stats.games == thread_count * repetitions * 2);
+}
+
+TEST_CASE("Game.Opening Tree.Snapshot", "[opening]") {
+    const auto tree = build_tree(games_data);
+    std::ostringstream out_stream;
+    tree.write(out_stream);
+    const auto snapshot = out_stream.str();
+
+    std::istringstream in_stream{snapshot};
+    const auto restored = OpeningTree::read(in_stream);
+    CHECK(restored.game_count() == tree.game_count());
+    CHECK(restored.position_count() == tree.position_count());
+    for (const auto key : {Board::starting_position().key(), key_after({e4}), key_after({d4, e6})}) {
+        CHECK(restored.stats(key) == tree.stats(key));
+        const auto moves = tree.moves(key);
+        const auto restored_moves = restored.moves(key);
+        REQUIRE(restored_moves.size() == moves.size());
+        for (size_t index = 0; index < moves.size(); ++index) {
+            CHECK(FullMoveCompare{}(restored_moves[index].move, moves[index].move));
+            CHECK(restored_moves[index].key == moves[index].key);
+            CHECK(restored_moves[index].stats == moves[index].stats);
+        }
+    }
+
+    std::ostringstream rewritten;
+    restored.write(rewritten);
+    CHECK(rewritten.str() == snapshot);
+
+    std::istringstream not_a_snapshot{"CGBG\x01\x00\x00\x00"};
+    CHECK_THROWS_AS(OpeningTree::read(not_a_snapshot), ChessGameError);
+    std::istringstream truncated{snapshot.substr(0, snapshot.size() - 3)};
+    CHECK_THROWS_AS(OpeningTree::read(truncated), ChessGameError);
+
+    SECTION("Duplicate positions") {
+        // Header, 1 game and 2 positions with the same key, no stats and no moves.
+        const std::string duplicate{"CGOT\x01\x00\x00\x00\x01\x02", 10};
+        const std::string position{"\x2A\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00", 15};
+        std::istringstream single{duplicate.substr(0, 9) + "\x01" + position};
+        CHECK(OpeningTree::read(single).position_count() == 1);
+        std::istringstream repeated{duplicate + position + position};
+        CHECK_THROWS_AS(OpeningTree::read(repeated), ChessGameError);
+    }
+}
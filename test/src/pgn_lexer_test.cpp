@@ -276,3 +276,123 @@ TEST_CASE("PGN.Lexer.Invalid Result", "[pgn]") {
     check_token(lexer, PGNLexer::TokenType::Symbol, 3, "Ba4");
     check_token(lexer, PGNLexer::TokenType::Invalid, 3, "1/0");
 }
+
+TEST_CASE("PGN.Lexer.Memory input", "[pgn]") {
+    const std::string pgn_data{"[Event \"Test Event\"]\n"
+                               "[Site \"Test Site\"]\n\n"
+                               "1. e4 {A comment\nover two lines} e5 $1 (1... c5) 2. Nf3 *"};
+    auto lexer = PGNLexer{std::string_view{pgn_data}};
+    check_tag(lexer, "Event", "Test Event", 1);
+    check_tag(lexer, "Site", "Test Site", 2);
+    check_token(lexer, PGNLexer::TokenType::Number, 4, "1");
+    check_token(lexer, PGNLexer::TokenType::Dot, 4);
+    check_token(lexer, PGNLexer::TokenType::Symbol, 4, "e4");
+    check_token(lexer, PGNLexer::TokenType::Comment, 5, "A comment over two lines");
+    check_token(lexer, PGNLexer::TokenType::Symbol, 5, "e5");
+    check_token(lexer, PGNLexer::TokenType::NAG, 5, "1");
+    check_token(lexer, PGNLexer::TokenType::OpenParen, 5);
+    check_token(lexer, PGNLexer::TokenType::Number, 5, "1");
+    check_token(lexer, PGNLexer::TokenType::Dot, 5);
+    check_token(lexer, PGNLexer::TokenType::Dot, 5);
+    check_token(lexer, PGNLexer::TokenType::Dot, 5);
+    check_token(lexer, PGNLexer::TokenType::Symbol, 5, "c5");
+    check_token(lexer, PGNLexer::TokenType::CloseParen, 5);
+    check_token(lexer, PGNLexer::TokenType::Number, 5, "2");
+    check_token(lexer, PGNLexer::TokenType::Dot, 5);
+    check_token(lexer, PGNLexer::TokenType::Symbol, 5, "Nf3");
+    check_token(lexer, PGNLexer::TokenType::GameResult, 5, "*");
+    check_token(lexer, PGNLexer::TokenType::EndOfInput, 5);
+}
+
+TEST_CASE("PGN.Lexer.Memory input tokens refer to input", "[pgn]") {
+    const std::string pgn_data{"[Event \"Test Event\"]"};
+    auto lexer = PGNLexer{std::string_view{pgn_data}};
+    check_token(lexer, PGNLexer::TokenType::OpenBracket, 1);
+    const auto name = lexer.next_token();
+    const auto value = lexer.next_token();
+    CHECK(name.value.data() == pgn_data.data() + 1);
+    CHECK(value.value.data() == pgn_data.data() + 8);
+    CHECK(name.value == "Event");
+    CHECK(value.value == "Test Event");
+}
+
+TEST_CASE("PGN.Lexer.Small stream blocks", "[pgn]") {
+    const std::string pgn_data{"[Event \"A rather long event name\"]\n\n"
+                               "1. e4 {A long comment that does not fit into a single block} e5 2. Nf3 1/2-1/2"};
+    auto pgn_stream = std::istringstream{pgn_data};
+    auto lexer = PGNLexer{&pgn_stream, 3};
+    check_tag(lexer, "Event", "A rather long event name", 1);
+    check_token(lexer, PGNLexer::TokenType::Number, 3, "1");
+    check_token(lexer, PGNLexer::TokenType::Dot, 3);
+    check_token(lexer, PGNLexer::TokenType::Symbol, 3, "e4");
+    check_token(lexer, PGNLexer::TokenType::Comment, 3, "A long comment that does not fit into a single block");
+    check_token(lexer, PGNLexer::TokenType::Symbol, 3, "e5");
+    check_token(lexer, PGNLexer::TokenType::Number, 3, "2");
+    check_token(lexer, PGNLexer::TokenType::Dot, 3);
+    check_token(lexer, PGNLexer::TokenType::Symbol, 3, "Nf3");
+    check_token(lexer, PGNLexer::TokenType::GameResult, 3, "1/2-1/2");
+    check_token(lexer, PGNLexer::TokenType::EndOfInput, 3);
+}
+
+TEST_CASE("PGN.Lexer.Long comments and whitespace", "[pgn]") {
+    const std::string pgn_data{"[Annotator \"An annotator with a name that is longer than a block\"]\n"
+                               "                                  \n\n"
+                               "1. e4 {A comment that spans several lines,\n"
+                               "with a\ttab\tand enough text to fill a few blocks} e5\n"
+                               "{Another comment, long enough for more than one block, without any line break} *"};
+    const auto check_tokens = [](PGNLexer &lexer) {
+        check_tag(lexer, "Annotator", "An annotator with a name that is longer than a block", 1);
+        check_token(lexer, PGNLexer::TokenType::Number, 4, "1");
+        check_token(lexer, PGNLexer::TokenType::Dot, 4);
+        check_token(lexer, PGNLexer::TokenType::Symbol, 4, "e4");
+        check_token(lexer, PGNLexer::TokenType::Comment, 5, "A comment that spans several lines, with a tab and enough text to fill a few blocks");
+        check_token(lexer, PGNLexer::TokenType::Symbol, 5, "e5");
+        check_token(lexer, PGNLexer::TokenType::Comment, 6, "Another comment, long enough for more than one block, without any line break");
+        check_token(lexer, PGNLexer::TokenType::GameResult, 6, "*");
+        check_token(lexer, PGNLexer::TokenType::EndOfInput, 6);
+    };
+
+    auto memory_lexer = PGNLexer{pgn_data};
+    check_tokens(memory_lexer);
+    auto pgn_stream = std::istringstream{pgn_data};
+    auto stream_lexer = PGNLexer{&pgn_stream, 7};
+    check_tokens(stream_lexer);
+}
+
+TEST_CASE("PGN.Lexer.Skip to tag section", "[pgn]") {
+    const std::string pgn_data{"1. e4 {A [comment]\n} e5 \"a [string]\" 2. Nf3 *\n\n"
+                               "[Event \"Next\"]"};
+    auto in_memory = PGNLexer{std::string_view{pgn_data}};
+    in_memory.skip_to_tag_section();
+    check_tag(in_memory, "Event", "Next", 4);
+    check_token(in_memory, PGNLexer::TokenType::EndOfInput, 4);
+
+    auto pgn_stream = std::istringstream{pgn_data};
+    auto from_stream = PGNLexer{&pgn_stream, 3};
+    from_stream.skip_to_tag_section();
+    check_tag(from_stream, "Event", "Next", 4);
+
+    auto without_tags = PGNLexer{std::string_view{"1. e4 {Comment} *"}};
+    without_tags.skip_to_tag_section();
+    check_token(without_tags, PGNLexer::TokenType::EndOfInput, 1);
+}
+
+TEST_CASE("PGN.Lexer.Copy to tag section", "[pgn]") {
+    const std::string pgn_data{"[Event \"First\"]\n{Game comment} 1. e4 {A [comment]\n} e5 \"a [string]\" 2. Nf3 *\n\n"
+                               "[Event \"Next\"]"};
+    const std::string movetext{"{Game comment} 1. e4 {A [comment]\n} e5 \"a [string]\" 2. Nf3 *\n\n"};
+    const auto copy_movetext = [&movetext](PGNLexer &lexer) {
+        check_tag(lexer, "Event", "First", 1);
+        check_token(lexer, PGNLexer::TokenType::Comment, 2, "Game comment");
+        std::string copied;
+        lexer.copy_to_tag_section(copied);
+        CHECK(copied == movetext);
+        check_tag(lexer, "Event", "Next", 5);
+    };
+
+    auto in_memory = PGNLexer{std::string_view{pgn_data}};
+    copy_movetext(in_memory);
+    auto pgn_stream = std::istringstream{pgn_data};
+    auto from_stream = PGNLexer{&pgn_stream, 3};
+    copy_movetext(from_stream);
+}
@@ -9,8 +9,17 @@
 #include "chessgame/pgn.h"
 
 #include <algorithm>
+#include <array>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
+
+// The parser and the writer can be forward declared.
+namespace chessgame {
+class PGNParser;
+class PGNWriter;
+} // namespace chessgame
 
 using namespace chessgame;
 using namespace chesscore;
@@ -61,7 +70,7 @@ auto var(std::size_t index) -> GamePath {
     return GamePath{{index}};
 }
 
-auto get_node(const chessgame::Game &game, const GamePath &path) -> std::shared_ptr<const chessgame::GameNode> {
+auto get_node(const chessgame::Game &game, const GamePath &path) -> std::optional<chessgame::ConstCursor> {
     auto cursor = game.cursor();
     for (std::size_t index = 0U; index < path.size(); ++index) {
         const auto child_cursor = cursor.child(path[index]);
@@ -69,7 +78,7 @@ auto get_node(const chessgame::Game &game, const GamePath &path) -> std::shared_
         REQUIRE(child_cursor.has_value());
         cursor = child_cursor.value();
     }
-    return cursor.node();
+    return cursor;
 }
 
 auto get_move(const chessgame::Game &game, const GamePath &path) -> Move {
@@ -283,20 +292,20 @@ is in his favour (as he can immediately occupy it) - Alekhine} 1-0
 
     CHECK(count_ply_on_mainline(game) == 17);
 
-    CHECK(game.const_cursor().node()->comment() == "The active Bishop puts White in a position to start a Kingside attack");
+    CHECK(game.const_cursor().comment() == "The active Bishop puts White in a position to start a Kingside attack");
     const auto node1 = get_node(game, mainline(3));
-    REQUIRE(node1 != nullptr);
+    REQUIRE(node1.has_value());
     REQUIRE(node1->nags().size() == 1);
     CHECK(node1->nags()[0] == 1);
 
     const auto node2 = get_node(game, mainline(10));
-    REQUIRE(node2 != nullptr);
+    REQUIRE(node2.has_value());
     REQUIRE(node2->nags().size() == 2);
     CHECK(node2->nags()[0] == 1);
     CHECK(node2->nags()[1] == 32);
 
     const auto node3 = get_node(game, mainline(17));
-    REQUIRE(node3 != nullptr);
+    REQUIRE(node3.has_value());
     REQUIRE(node3->nags().size() == 1);
     CHECK(node3->nags()[0] == 1);
     CHECK(
@@ -342,3 +351,334 @@ Nf6xd5 {Comment 5} 9. Bxe7, Qxe7 10. Nxd5, e6xd5) 9. Bd3 {Comment 6} Bb7 1-0
     const auto node7 = get_node(game, mainline(17));
     CHECK(node7->comment() == "Comment 6");
 }
+
+TEST_CASE("PGN.Parser.Memory input", "[pgn]") {
+    const std::string game_data = R"([Event "Test Event"]
+[Site "Test Site"]
+[White "Player W"]
+[Black "Player B"]
+[Result "1-0"]
+
+1. e4 e5 {Comment} 2. Nf3 $1 Nc6 (2... d6) 3. Bb5 a6 4. Ba4 1-0
+
+[Event "Second Event"]
+[Result "*"]
+
+1. d4 *)";
+    auto parser = chessgame::PGNParser{std::string_view{game_data}};
+    auto opt_game = parser.read_game();
+    REQUIRE(opt_game.has_value());
+    const auto &game = opt_game.value();
+
+    CHECK(count_ply_on_mainline(game) == 7);
+    CHECK(game.metadata().get("White") == "Player W");
+    CHECK(get_node(game, mainline(2))->comment() == "Comment");
+    CHECK(get_node(game, mainline(3))->nags() == std::pmr::vector<int>{1});
+    check_move(game, mainline(3) + var(1), Move{.from = Square::D7, .to = Square::D6, .piece = Piece::BlackPawn});
+    check_move(game, mainline(7), Move{.from = Square::B5, .to = Square::A4, .piece = Piece::WhiteBishop});
+
+    auto opt_second = parser.read_game();
+    REQUIRE(opt_second.has_value());
+    CHECK(opt_second->metadata().get("Event") == "Second Event");
+    CHECK(count_ply_on_mainline(opt_second.value()) == 1);
+    CHECK_FALSE(parser.read_game().has_value());
+}
+
+TEST_CASE("PGN.Parser.Read header", "[pgn]") {
+    const std::string game_data = R"([Event "First Event"]
+[White "Player W"]
+{Game comment}
+1. e4 {Comment with [Brackets]} e5 2. Qh5 Ke7 3. Qxe5# 1-0
+
+[Event "Chess960 Event"]
+[Variant "Chess960"]
+
+1. g3 g6 *
+
+[Event "Third Event"]
+[Result "*"]
+
+1. d4 *)";
+    auto parser = chessgame::PGNParser{std::string_view{game_data}};
+    const auto first = parser.read_header();
+    REQUIRE(first.has_value());
+    CHECK(first->offset == 0);
+    CHECK(first->metadata.get("Event") == "First Event");
+    CHECK(first->metadata.get("White") == "Player W");
+
+    const auto second = parser.read_header();
+    REQUIRE(second.has_value());
+    CHECK(std::string_view{game_data}.substr(second->offset).starts_with("[Event \"Chess960 Event\"]"));
+    CHECK(second->metadata.get("Variant") == "Chess960");
+
+    const auto third = parser.read_game();
+    REQUIRE(third.has_value());
+    CHECK(third->metadata().get("Event") == "Third Event");
+    CHECK(count_ply_on_mainline(third.value()) == 1);
+    CHECK_FALSE(parser.read_header().has_value());
+}
+
+TEST_CASE("PGN.Parser.Lazy movetext", "[pgn]") {
+    const std::string game_data = R"([Event "First Event"]
+{Game comment}
+1. e4 {Comment with [Brackets]} e5 (1... c5 2. Nf3) 2. Qh5 Ke7 3. Qxe5# 1-0
+
+[Event "Chess960 Event"]
+[Variant "Chess960"]
+
+1. g3 g6 *
+
+[Event "Broken Event"]
+
+1. e4 e4 *
+
+[Event "Last Event"]
+
+1. d4 *)";
+    std::istringstream input{game_data};
+    auto parser = chessgame::PGNParser{input};
+    parser.set_lazy_movetext(true);
+    CHECK(parser.lazy_movetext());
+
+    auto first = parser.read_game();
+    REQUIRE(first.has_value());
+    CHECK(first->has_pending_movetext());
+    CHECK(first->metadata().get("Event") == "First Event");
+    auto copy = first->clone();
+    CHECK(count_ply_on_mainline(first.value()) == 5);
+    CHECK_FALSE(first->has_pending_movetext());
+    CHECK(first->cursor().comment() == "Game comment");
+    CHECK(first->cursor().child(0)->comment() == "Comment with [Brackets]");
+    CHECK(first->cursor().child(0)->child_count() == 2);
+    CHECK(first->position_cache_policy().mode == PositionCachePolicy::Mode::RootOnly);
+    CHECK(copy.has_pending_movetext());
+    CHECK(copy.current_mainline().ply() == 5);
+
+    auto broken = parser.read_game();
+    REQUIRE(broken.has_value());
+    CHECK(broken->metadata().get("Event") == "Broken Event");
+    CHECK_THROWS_AS(broken->edit(), PGNError);
+    CHECK(broken->has_pending_movetext());
+    const auto broken_line = std::ranges::count(game_data.substr(0, game_data.find("1. e4 e4")), '\n') + 1;
+    try {
+        static_cast<void>(broken->tree());
+        FAIL("Illegal move not detected");
+    } catch (const PGNError &error) {
+        CHECK(error.line() == broken_line);
+    }
+
+    auto last = parser.read_game();
+    REQUIRE(last.has_value());
+    CHECK(last->metadata().get("Event") == "Last Event");
+    const auto &shared = last.value();
+    std::array<size_t, 4> sizes{};
+    {
+        std::vector<std::jthread> readers;
+        for (auto &size : sizes) {
+            readers.emplace_back([&shared, &size] { size = shared.tree().size(); });
+        }
+    }
+    CHECK(std::ranges::all_of(sizes, [](size_t size) { return size == 2; }));
+    CHECK(count_ply_on_mainline(last.value()) == 1);
+    CHECK_FALSE(parser.read_game().has_value());
+}
+
+TEST_CASE("PGN.Parser.Instrumentation", "[pgn]") {
+    const std::string game_data = R"([Event "First Event"]
+
+1. e4 d5 2. ed5 , Qxd5 (2... Nf6) 3. Nc3 *
+
+[Event "Second Event"]
+
+1. d4 *
+)";
+    static_assert(sizeof(BasicPGNParser<NoInstrumentation>) < sizeof(BasicPGNParser<PGNInstrumentation>));
+    auto parser = BasicPGNParser<PGNInstrumentation>{std::string_view{game_data}};
+    CHECK(parser.instrumentation().counters().tokens == 0);
+
+    const auto first = parser.read_game();
+    REQUIRE(first.has_value());
+    CHECK(parser.warnings().size() == 2);
+    const auto second = parser.read_game();
+    REQUIRE(second.has_value());
+    CHECK_FALSE(parser.read_game().has_value());
+
+    const auto &counters = parser.instrumentation().counters();
+    CHECK(counters.games == 2);
+    CHECK(counters.tokens > 20);
+    CHECK(counters.bytes == game_data.size());
+    CHECK(counters.san_parses == 7);
+    CHECK(counters.positions_replayed == 7);
+    CHECK(counters.nodes_allocated == 7);
+    CHECK(counters.legal_move_generations >= 1);
+    CHECK(counters.warning_count(PGNWarningType::MoveMissingCapture) == 1);
+    CHECK(counters.warning_count(PGNWarningType::UnexpectedChar) == 1);
+    CHECK(counters.warning_count(PGNWarningType::MoveMissingPieceType) == 0);
+    CHECK(counters.stage_time(PGNStage::Lexing) > std::chrono::nanoseconds{0});
+    CHECK(counters.stage_time(PGNStage::SANGeneration) == std::chrono::nanoseconds{0});
+
+    parser.instrumentation().reset();
+    CHECK(parser.instrumentation().counters().games == 0);
+    parser.set_input(game_data);
+    CHECK(parser.read_header().has_value());
+    CHECK(parser.instrumentation().counters().games == 1);
+    CHECK(parser.instrumentation().counters().san_parses == 0);
+    CHECK(parser.instrumentation().counters().bytes < game_data.size());
+}
+
+TEST_CASE("PGN.Parser.Error recovery", "[pgn]") {
+    const std::string game_data = R"([Event "First Event"]
+
+1. e4 e5 *
+
+[Event "Illegal Move"]
+
+1. e4 e5 2. Ke3 Nc6 3. Nf3 *
+
+[Event "Broken Tag" Site "Somewhere"]
+
+1. d4 *
+
+[Event "Unclosed RAV"]
+
+1. d4 d5) 2. c4 *
+
+[Event "Invalid FEN"]
+[FEN "not a fen string"]
+
+1. e4 *
+
+[Event "Last Event"]
+
+1. c4 *
+)";
+    const auto offset_of = [&game_data](std::string_view text) { return game_data.find(text); };
+    auto parser = chessgame::PGNParser{std::string_view{game_data}};
+
+    const auto first = parser.try_read_game();
+    REQUIRE(first.has_value());
+    REQUIRE(first->has_value());
+    CHECK(first->value().metadata().get("Event") == "First Event");
+
+    const auto illegal_move = parser.try_read_game();
+    REQUIRE_FALSE(illegal_move.has_value());
+    CHECK(illegal_move.error().error.type() == PGNErrorType::IllegalMove);
+    CHECK(illegal_move.error().error.line() == 7);
+    CHECK(illegal_move.error().game_offset == offset_of("[Event \"Illegal Move\"]"));
+    CHECK(illegal_move.error().offset == offset_of("Ke3"));
+
+    const auto broken_tag = parser.try_read_game();
+    REQUIRE_FALSE(broken_tag.has_value());
+    CHECK(broken_tag.error().error.type() == PGNErrorType::UnexpectedToken);
+    CHECK(broken_tag.error().error.line() == 9);
+    CHECK(broken_tag.error().game_offset == offset_of("[Event \"Broken Tag\""));
+
+    const auto unclosed_rav = parser.try_read_game();
+    REQUIRE_FALSE(unclosed_rav.has_value());
+    CHECK(unclosed_rav.error().error.type() == PGNErrorType::NoPenRav);
+    CHECK(unclosed_rav.error().offset == offset_of(") 2. c4"));
+
+    const auto invalid_fen = parser.try_read_game();
+    REQUIRE_FALSE(invalid_fen.has_value());
+    CHECK(invalid_fen.error().error.type() == PGNErrorType::InvalidFen);
+    CHECK(invalid_fen.error().error.line() == 20);
+    CHECK(invalid_fen.error().game_offset == offset_of("[Event \"Invalid FEN\"]"));
+
+    const auto last = parser.try_read_game();
+    REQUIRE(last.has_value());
+    REQUIRE(last->has_value());
+    CHECK(last->value().metadata().get("Event") == "Last Event");
+    CHECK(count_ply_on_mainline(last->value()) == 1);
+
+    const auto end = parser.try_read_game();
+    REQUIRE(end.has_value());
+    CHECK_FALSE(end->has_value());
+
+    auto throwing_parser = chessgame::PGNParser{std::string_view{game_data}};
+    CHECK(throwing_parser.read_game().has_value());
+    CHECK_THROWS_AS(throwing_parser.read_game(), PGNError);
+}
+
+TEST_CASE("PGN.Parser.Read game into", "[pgn]") {
+    const std::string game_data = R"([Event "First Event"]
+{Game comment}
+1. e4 e5 (1... c5 2. Nf3) 2. Qh5 Ke7 3. Qxe5# 1-0
+
+[Event "Second Event"]
+[FEN "4k3/8/8/8/8/8/8/R3K3 w Q - 0 1"]
+
+1. O-O-O Kf7 *
+
+[Event "Broken Event"]
+
+1. e4 e4 *
+
+[Event "Last Event"]
+
+1. d4 *)";
+    auto parser = chessgame::PGNParser{std::string_view{game_data}};
+    Game game{};
+    REQUIRE(parser.read_game_into(game));
+    const auto *tree = &game.tree();
+    CHECK(game.metadata().get("Event") == "First Event");
+    CHECK(game.cursor().comment() == "Game comment");
+    CHECK(count_ply_on_mainline(game) == 5);
+    CHECK(game.tree().size() == 8);
+
+    REQUIRE(parser.read_game_into(game));
+    CHECK(&game.tree() == tree);
+    CHECK(game.metadata().get("Event") == "Second Event");
+    CHECK(game.cursor().comment().empty());
+    CHECK(count_ply_on_mainline(game) == 2);
+    CHECK(game.tree().size() == 3);
+    CHECK(game.cursor().child(0)->move().to == Square::C1);
+
+    const auto broken = parser.try_read_game_into(game);
+    REQUIRE_FALSE(broken.has_value());
+    CHECK(broken.error().error.type() == PGNErrorType::IllegalMove);
+
+    const auto copy = game.clone();
+    REQUIRE(parser.try_read_game_into(game).value());
+    CHECK(game.metadata().get("Event") == "Last Event");
+    CHECK(count_ply_on_mainline(game) == 1);
+    CHECK(copy.metadata().get("Event") == "Broken Event");
+    CHECK_FALSE(parser.read_game_into(game));
+}
+
+TEST_CASE("PGN.Parser.Strict mainline policy", "[pgn]") {
+    const std::string game_data = R"([Event "Annotated"]
+
+{Game comment} 1. e4 $1 {Best by test} e5! (1... c5 2. Nf3 (2. c3) d6) 2. Nf3 Nc6 (2... d6 {Philidor}) 3. Bb5 *
+)";
+    auto parser = StrictMainlinePGNParser{std::string_view{game_data}};
+    const auto game = parser.read_game();
+    REQUIRE(game.has_value());
+    CHECK(count_ply_on_mainline(*game) == 5);
+    CHECK(game->tree().size() == 6);
+    CHECK(game->cursor().comment().empty());
+    const auto first_move = game->cursor().child(0);
+    CHECK(first_move->comment().empty());
+    CHECK(first_move->nags().empty());
+    CHECK(first_move->child(0)->nags().empty());
+    CHECK_FALSE(parser.read_game().has_value());
+
+    auto lenient = chessgame::PGNParser{std::string_view{game_data}};
+    const auto annotated = lenient.read_game();
+    REQUIRE(annotated.has_value());
+    CHECK(annotated->tree().size() > game->tree().size());
+    CHECK(annotated->cursor().child(0)->nags().size() == 1);
+
+    const std::string lenient_data = R"([Event "Lenient"]
+
+1. e4 d5 2. ed5 *
+)";
+    auto strict = StrictMainlinePGNParser{std::string_view{lenient_data}};
+    const auto rejected = strict.try_read_game();
+    REQUIRE_FALSE(rejected.has_value());
+    CHECK(rejected.error().error.type() == PGNErrorType::IllegalMove);
+    CHECK(strict.warnings().empty());
+    CHECK(chessgame::PGNParser{std::string_view{lenient_data}}.read_game().has_value());
+
+    auto unterminated = StrictMainlinePGNParser{std::string_view{"[Event \"Unterminated\"]\n\n1. e4 (1. d4 *\n"}};
+    CHECK_THROWS_AS(unterminated.read_game(), PGNError);
+}
@@ -183,3 +183,61 @@ g6) 4... c6 5. Ba4 d6 *
 )"
     );
 }
+
+TEST_CASE("PGN.Writer.Lines From Node", "[pgn]") {
+    const std::string pgn_data = R"([Event "Test Event"]
+[Result "0-1"]
+
+1. f3 e5 (1... e6 2. g4 Qh4#) 2. g4 Qh4# 0-1
+)";
+    const auto opt_game = PGNParser{std::string_view{pgn_data}}.read_game();
+    REQUIRE(opt_game.has_value());
+    const auto first_move = opt_game->cursor().child(0).value();
+
+    std::ostringstream rav_stream;
+    PGNWriter rav_writer{rav_stream};
+    rav_writer.write_rav(first_move.child(1).value());
+    CHECK(rav_stream.str() == "(1... e6 2. g4 Qh4#)");
+
+    std::ostringstream lines_stream;
+    PGNWriter lines_writer{lines_stream};
+    lines_writer.write_game_lines(first_move);
+    CHECK(lines_stream.str() == "e5 (1... e6 2. g4 Qh4#) 2. g4 Qh4#");
+}
+
+TEST_CASE("PGN.Writer.Token Output", "[pgn]") {
+    std::ostringstream sstr;
+    PGNTokenOutput output{&sstr};
+    output.write(PGNTokenOutput::OutToken::MoveNumber, 12, "...");
+    output.write(PGNTokenOutput::OutToken::Move, std::string_view{"Nbd7"});
+    output.write(PGNTokenOutput::OutToken::Nag, '$', 146);
+    output.write_comment("Single");
+    output.write_comment("Two words");
+    CHECK(sstr.str() == "12... Nbd7 $146 {Single} {Two words}");
+}
+
+TEST_CASE("PGN.Writer.Instrumentation", "[pgn]") {
+    const auto game = PGNParser{std::string_view{"[Event \"Test Event\"]\n\n1. e4 e5 (1... c5 2. Nf3) 2. Nf3 *"}}.read_game().value();
+    std::ostringstream sstr;
+    BasicPGNWriter<PGNInstrumentation> writer{sstr};
+    writer.write_game(game);
+    writer.write_game(game);
+
+    const auto &counters = writer.instrumentation().counters();
+    CHECK(counters.games == 2);
+    CHECK(counters.bytes == sstr.str().size());
+    // The parser caches the SAN strings of all moves.
+    CHECK(counters.san_generations == 0);
+    CHECK(counters.legal_move_generations == 0);
+    CHECK(counters.positions_replayed == 10);
+    CHECK(counters.tokens == 0);
+
+    // Variations added without a board have no cached SAN string.
+    auto edited = game.clone();
+    REQUIRE(edited.edit().child(0)->add_variation(chesscore::Move{.from = chesscore::Square::D2, .to = chesscore::Square::D4, .piece = chesscore::Piece::WhitePawn}));
+    std::ostringstream edited_stream;
+    BasicPGNWriter<PGNInstrumentation> edited_writer{edited_stream};
+    edited_writer.write_game(edited);
+    CHECK(edited_writer.instrumentation().counters().san_generations == 1);
+    CHECK(edited_stream.str().find("(1. d4)") != std::string::npos);
+}
@@ -0,0 +1,201 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chessgame/pgn.h"
+#include "chessgame/position_index.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace chessgame;
+
+namespace {
+
+const std::string game_1 = R"([Event "Open"]
+[Result "1-0"]
+
+1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4. Bxc6 dxc6 5. d4 exd4 6. Qxd4 Qxd4 7. Nxd4 1-0
+
+)";
+const std::string game_2 = R"([Event "Transposition"]
+[Result "*"]
+
+1. Nf3 Nc6 2. e4 (2. d4 d5) 2... e5 3. Bb5 *
+
+)";
+const std::string game_3 = R"([Event "Broken"]
+[Result "*"]
+
+1. e4 Ke3 *
+
+)";
+const std::string game_4 = R"([Event "Setup"]
+[Result "*"]
+[SetUp "1"]
+[FEN "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1"]
+
+1. e4 Kd7 2. e5 *
+
+)";
+const std::string game_5 = R"([Event "Special moves"]
+[Result "*"]
+[SetUp "1"]
+[FEN "4k3/1P6/8/3pP3/8/8/8/4K3 w - d6 0 1"]
+
+1. exd6 Kd7 2. b8=N+ Kxd6 *
+)";
+const std::string pgn_data = game_1 + game_2 + game_3 + game_4 + game_5;
+
+auto board_after(std::string_view fen, std::initializer_list<std::string_view> moves) -> Board {
+    auto board = Board::from_fen(fen).value();
+    for (const auto san : moves) {
+        const auto san_move = parse_san(std::string{san}, board.side_to_move());
+        board.make_move(resolve_san_move(san_move.value(), board).value());
+    }
+    return board;
+}
+
+auto square_bit(chesscore::Square square) -> uint64_t {
+    return uint64_t{1} << static_cast<unsigned int>(square_index(square));
+}
+
+// Checks every position of the index against a direct evaluation of the query.
+auto brute_force(const std::vector<Game> &games, const std::vector<size_t> &offsets, const PositionQuery &query) -> std::vector<PositionMatch> {
+    std::vector<PositionMatch> matches;
+    for (size_t index = 0; index < games.size(); ++index) {
+        auto board = games[index].board(GameTree::root_id).value();
+        auto check = [&](size_t ply) {
+            const auto white = pawn_squares(board, chesscore::Color::White);
+            const auto black = pawn_squares(board, chesscore::Color::Black);
+            if ((!query.key.has_value() || board.key() == query.key) && (!query.material.has_value() || material_signature(board) == query.material) &&
+                (white & query.white_pawns) == query.white_pawns && (white & query.no_white_pawns) == 0 && (black & query.black_pawns) == query.black_pawns &&
+                (black & query.no_black_pawns) == 0) {
+                matches.push_back(PositionMatch{.game_offset = offsets[index], .ply = ply});
+            }
+        };
+        check(0);
+        size_t ply{0};
+        for (const auto node : games[index].view().mainline()) {
+            board.make_move(node.move());
+            check(++ply);
+        }
+    }
+    return matches;
+}
+
+} // namespace
+
+TEST_CASE("Position Index.Signatures", "[position_index]") {
+    const auto start = Board::starting_position();
+    CHECK(material_signature(start) == (8U | 2U << 4U | 2U << 7U | 2U << 10U | 1U << 13U) * 0x10001U);
+    CHECK(pawn_squares(start, chesscore::Color::White) == 0xFF00U);
+    CHECK(pawn_squares(start, chesscore::Color::Black) == 0x00FF000000000000U);
+
+    const auto endgame = Board::from_fen("4k3/8/8/8/8/8/4P3/4K3 w - - 0 1").value();
+    CHECK(material_signature(endgame) == 1U);
+    CHECK(pawn_squares(endgame, chesscore::Color::White) == square_bit(chesscore::Square::E2));
+    // Only the material counts, not the placement of the pieces.
+    CHECK(material_signature(Board::from_fen("3k4/8/8/8/8/8/P7/K7 b - - 0 1").value()) == 1U);
+}
+
+TEST_CASE("Position Index.Queries", "[position_index]") {
+    const auto offsets = scan_game_offsets(pgn_data);
+    REQUIRE(offsets.size() == 5);
+    const auto index = build_position_index(pgn_data);
+    CHECK(index.game_count() == 4);
+    CHECK(std::ranges::equal(index.game_offsets(), std::vector<size_t>{offsets[0], offsets[1], offsets[3], offsets[4]}));
+    CHECK(index.position_count() == 14 + 6 + 4 + 5);
+
+    const std::vector<size_t> game_offsets{offsets[0], offsets[1], offsets[3], offsets[4]};
+    std::vector<Game> games;
+    for (const auto offset : game_offsets) {
+        games.push_back(PGNParser{std::string_view{pgn_data}.substr(offset)}.read_game().value());
+    }
+    const auto start_fen = std::string_view{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"};
+    const auto ruy_lopez = board_after(start_fen, {"e4", "e5", "Nf3", "Nc6", "Bb5"});
+
+    SECTION("Position key") {
+        const PositionQuery query{.key = ruy_lopez.key()};
+        const auto matches = index.find(query);
+        CHECK(matches == std::vector{PositionMatch{.game_offset = offsets[0], .ply = 5}, PositionMatch{.game_offset = offsets[1], .ply = 5}});
+        CHECK(matches == brute_force(games, game_offsets, query));
+        CHECK(index.find(query, 1).size() == 1);
+        CHECK(index.find(query, 0).empty());
+    }
+    SECTION("Material") {
+        const PositionQuery query{.material = material_signature(board_after(start_fen, {"e4", "e5", "Nf3", "Nc6", "Bb5", "a6", "Bxc6", "dxc6"}))};
+        const auto matches = index.find(query);
+        CHECK(matches.size() == 2);
+        CHECK(matches == brute_force(games, game_offsets, query));
+        CHECK(index.find_games(query) == std::vector{PositionMatch{.game_offset = offsets[0], .ply = 8}});
+    }
+    SECTION("Pawn structure") {
+        const PositionQuery query{.white_pawns = square_bit(chesscore::Square::E4), .no_black_pawns = square_bit(chesscore::Square::E5)};
+        const auto matches = index.find(query);
+        CHECK(matches == brute_force(games, game_offsets, query));
+        CHECK(index.find_games(query) == std::vector{
+            PositionMatch{.game_offset = offsets[0], .ply = 1}, PositionMatch{.game_offset = offsets[1], .ply = 3}, PositionMatch{.game_offset = offsets[3], .ply = 1}
+        });
+    }
+    SECTION("Combined conditions") {
+        const PositionQuery query{.material = 1U, .black_pawns = 0, .no_white_pawns = square_bit(chesscore::Square::E2) | square_bit(chesscore::Square::E4)};
+        CHECK(index.find(query) == std::vector{PositionMatch{.game_offset = offsets[3], .ply = 3}});
+        CHECK(index.find(PositionQuery{}).size() == index.position_count());
+    }
+    SECTION("En passant and promotion") {
+        const PositionQuery query{.material = material_signature(Board::from_fen("8/8/3k4/8/8/8/8/1N2K3 w - - 0 3").value())};
+        CHECK(index.find(query) == std::vector{PositionMatch{.game_offset = offsets[4], .ply = 4}});
+        CHECK(index.find(PositionQuery{.white_pawns = square_bit(chesscore::Square::D6)}) == brute_force(games, game_offsets, PositionQuery{.white_pawns = square_bit(chesscore::Square::D6)}));
+        CHECK(index.find(PositionQuery{.black_pawns = square_bit(chesscore::Square::D5)}).size() == 1);
+    }
+}
+
+TEST_CASE("Position Index.Side File", "[position_index]") {
+    PositionIndex index;
+    const auto data = game_1 + game_2;
+    auto parser = PGNParser{std::string_view{data}};
+    // Index the games while they are imported.
+    size_t offset{0};
+    while (const auto game = parser.read_game()) {
+        index.add_game(offset++, *game);
+    }
+    CHECK(index.game_count() == 2);
+    CHECK(index.position_count() == 14 + 6);
+
+    const auto path = std::filesystem::temp_directory_path() / "chessgame_position_index_test.cgpx";
+    REQUIRE(index.save(path, data));
+    const auto loaded = PositionIndex::load(path, data);
+    REQUIRE(loaded.has_value());
+    CHECK(std::ranges::equal(loaded->game_offsets(), index.game_offsets()));
+    const PositionQuery query{.key = Board::starting_position().key()};
+    CHECK(loaded->find(query) == index.find(query));
+
+    // The index belongs to the data, it was saved for.
+    CHECK_FALSE(PositionIndex::load(path, game_1).has_value());
+    auto changed_data = data;
+    changed_data[1] = 'X';
+    CHECK_FALSE(PositionIndex::load(path, changed_data).has_value());
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    CHECK_FALSE(PositionIndex::load(path, data).has_value());
+
+    // The whole data is checked, not only its start and its end.
+    std::string large_data;
+    while (large_data.size() <= 3 * 64 * 1024) {
+        large_data += data;
+    }
+    REQUIRE(index.save(path, large_data));
+    CHECK(PositionIndex::load(path, large_data).has_value());
+    const auto middle = large_data.find("1. e4", large_data.size() / 2);
+    REQUIRE(middle != std::string::npos);
+    large_data[middle + 3] = 'd';
+    CHECK_FALSE(PositionIndex::load(path, large_data).has_value());
+    std::filesystem::remove(path);
+    CHECK_FALSE(PositionIndex::load(path, data).has_value());
+}
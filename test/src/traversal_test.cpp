@@ -0,0 +1,118 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chesscore_io/chesscore_io.h"
+#include "chessgame/game.h"
+#include "chessgame/pgn.h"
+#include "chessgame/traversal.h"
+
+#include "chesscore/fen.h"
+
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <string_view>
+#include <vector>
+
+using namespace chessgame;
+using namespace chesscore;
+
+namespace {
+
+const Move e4{.from = Square::E2, .to = Square::E4, .piece = Piece::WhitePawn};
+const Move d4{.from = Square::D2, .to = Square::D4, .piece = Piece::WhitePawn};
+const Move c4{.from = Square::C2, .to = Square::C4, .piece = Piece::WhitePawn};
+const Move e5{.from = Square::E7, .to = Square::E5, .piece = Piece::BlackPawn};
+const Move d5{.from = Square::D7, .to = Square::D5, .piece = Piece::BlackPawn};
+const Move nf3{.from = Square::G1, .to = Square::F3, .piece = Piece::WhiteKnight};
+
+template<typename Range>
+auto ids(const Range &range) -> std::vector<uint32_t> {
+    std::vector<uint32_t> result;
+    std::ranges::transform(range, std::back_inserter(result), [](NodeView node) { return node.id().value; });
+    return result;
+}
+
+} // namespace
+
+static_assert(std::forward_iterator<NodeIterator<TraversalOrder::DepthFirst>>);
+static_assert(std::sentinel_for<std::default_sentinel_t, NodeIterator<TraversalOrder::Mainline>>);
+
+TEST_CASE("Game.Traversal.Node View", "[traversal]") {
+    GameTree tree{Position{FenString::starting_position()}};
+    const auto e4_node = tree.add_child(GameTree::root_id, e4).first;
+    const auto d4_node = tree.add_child(GameTree::root_id, d4).first;
+    const auto e5_node = tree.add_child(e4_node, e5).first;
+    tree.set_comment(e5_node, "Open game");
+    tree.set_premove_comment(d4_node, "Closed");
+    tree.add_nag(e4_node, 1);
+
+    const NodeView root{&tree, GameTree::root_id};
+    CHECK(root.valid());
+    CHECK_FALSE(NodeView{}.valid());
+    CHECK_FALSE(root.parent().valid());
+    CHECK(root.child_count() == 2);
+    CHECK(root.has_variations());
+    CHECK(root.first_child().id() == e4_node);
+    CHECK(root.child(1).id() == d4_node);
+    CHECK_FALSE(root.child(2));
+    CHECK(root.child(1).starts_variation());
+    CHECK_FALSE(root.first_child().starts_variation());
+
+    const auto e5_view = root.first_child().first_child();
+    CHECK(e5_view.id() == e5_node);
+    CHECK(e5_view.move() == e5);
+    CHECK(e5_view.ply() == 2);
+    CHECK(e5_view.comment() == std::string_view{"Open game"});
+    CHECK(e5_view.parent() == root.first_child());
+    CHECK_FALSE(e5_view.has_children());
+    CHECK(root.child(1).premove_comment() == std::string_view{"Closed"});
+    CHECK(std::ranges::equal(root.first_child().nags(), std::vector<int>{1}));
+    CHECK(root.first_child().comment().empty());
+
+    // Views stay valid, when nodes are added.
+    const auto nf3_node = tree.add_child(e5_node, nf3).first;
+    CHECK(e5_view.first_child().id() == nf3_node);
+}
+
+TEST_CASE("Game.Traversal.Ranges", "[traversal]") {
+    GameTree tree{Position{FenString::starting_position()}};
+    const auto e4_node = tree.add_child(GameTree::root_id, e4).first;
+    const auto d4_node = tree.add_child(GameTree::root_id, d4).first;
+    const auto c4_node = tree.add_child(GameTree::root_id, c4).first;
+    const auto e5_node = tree.add_child(e4_node, e5).first;
+    const auto d5_node = tree.add_child(e4_node, d5).first;
+    const auto nf3_node = tree.add_child(e5_node, nf3).first;
+    const auto d4_d5_node = tree.add_child(d4_node, d5).first;
+    const NodeView root{&tree, GameTree::root_id};
+
+    CHECK(ids(root.mainline()) == std::vector{e4_node.value, e5_node.value, nf3_node.value});
+    CHECK(ids(root.child(1).mainline()) == std::vector{d4_d5_node.value});
+    CHECK(ids(root.children()) == std::vector{e4_node.value, d4_node.value, c4_node.value});
+    CHECK(ids(root.first_child().children()) == std::vector{e5_node.value, d5_node.value});
+    CHECK(std::ranges::distance(root.child(2).children()) == 0);
+
+    CHECK(ids(root.depth_first()) == std::vector{GameTree::root_id.value, e4_node.value, e5_node.value, nf3_node.value, d5_node.value, d4_node.value, d4_d5_node.value, c4_node.value});
+    // A subtree ends at its root, the siblings of the root are not visited.
+    CHECK(ids(root.first_child().depth_first()) == std::vector{e4_node.value, e5_node.value, nf3_node.value, d5_node.value});
+    CHECK(ids(NodeView{&tree, c4_node}.depth_first()) == std::vector{c4_node.value});
+    CHECK(std::ranges::count_if(root.depth_first(), [](NodeView node) { return node.has_variations(); }) == 2);
+}
+
+TEST_CASE("Game.Traversal.Games", "[traversal]") {
+    auto parser = PGNParser{std::string_view{"[Event \"Traversal\"]\n\n1. e4 {King pawn} e5 (1... c5) 2. Nf3 *\n"}};
+    const auto game = parser.read_game();
+    REQUIRE(game.has_value());
+    std::vector<std::string_view> sans;
+    for (const auto node : game->view().mainline()) {
+        sans.push_back(node.san());
+    }
+    CHECK(sans == std::vector<std::string_view>{"e4", "e5", "Nf3"});
+    CHECK(game->view().first_child().comment() == std::string_view{"King pawn"});
+    CHECK(game->const_cursor().child(0)->view() == game->view().first_child());
+    CHECK(std::ranges::distance(game->view().depth_first()) == 5);
+}
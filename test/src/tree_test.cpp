@@ -0,0 +1,121 @@
+/* ************************************************************************** *
+ * Chess Game                                                                 *
+ * Representation of a single game of chess                                   *
+ * ************************************************************************** */
+
+#include <catch2/catch_all.hpp>
+
+#include "chesscore_io/chesscore_io.h"
+#include "chessgame/tree.h"
+
+#include "chesscore/fen.h"
+
+using namespace chessgame;
+using namespace chesscore;
+
+namespace {
+
+const Move e4{.from = Square::E2, .to = Square::E4, .piece = Piece::WhitePawn};
+const Move d4{.from = Square::D2, .to = Square::D4, .piece = Piece::WhitePawn};
+const Move c4{.from = Square::C2, .to = Square::C4, .piece = Piece::WhitePawn};
+const Move e5{.from = Square::E7, .to = Square::E5, .piece = Piece::BlackPawn};
+
+} // namespace
+
+TEST_CASE("Game.Tree.Add Children", "[tree]") {
+    GameTree tree{Position{FenString::starting_position()}};
+    CHECK(tree.size() == 1);
+    CHECK(tree.child_count(GameTree::root_id) == 0);
+
+    const auto [e4_node, e4_added] = tree.add_child(GameTree::root_id, e4);
+    const auto [d4_node, d4_added] = tree.add_child(GameTree::root_id, d4);
+    const auto [c4_node, c4_added] = tree.add_child(GameTree::root_id, c4);
+    const auto [e5_node, e5_added] = tree.add_child(e4_node, e5);
+    CHECK(e4_added);
+    CHECK(d4_added);
+    CHECK(c4_added);
+    CHECK(e5_added);
+    CHECK(tree.size() == 5);
+
+    CHECK(tree.child_count(GameTree::root_id) == 3);
+    CHECK(tree.child(GameTree::root_id, 0) == e4_node);
+    CHECK(tree.child(GameTree::root_id, 1) == d4_node);
+    CHECK(tree.child(GameTree::root_id, 2) == c4_node);
+    CHECK(tree.child(GameTree::root_id, 3) == NodeId::Invalid);
+    CHECK(tree.child_number(GameTree::root_id) == 0);
+    CHECK(tree.child_number(c4_node) == 2);
+
+    CHECK(tree.node(e5_node).parent() == e4_node);
+    CHECK(tree.node(e5_node).ply() == 2);
+    CHECK(tree.node(e5_node).move() == e5);
+    CHECK(tree.node(e4_node).first_child() == e5_node);
+    CHECK(tree.node(e4_node).next_sibling() == d4_node);
+    CHECK_FALSE(tree.node(e5_node).has_children());
+
+    const auto [existing_node, existing_added] = tree.add_child(GameTree::root_id, d4);
+    CHECK_FALSE(existing_added);
+    CHECK(existing_node == d4_node);
+    CHECK(tree.size() == 5);
+}
+
+TEST_CASE("Game.Tree.Annotations", "[tree]") {
+    GameTree tree{Position{FenString::starting_position()}};
+    const auto node = tree.add_child(GameTree::root_id, e4).first;
+    CHECK(tree.comment(node).empty());
+    CHECK(tree.nags(node).empty());
+
+    tree.set_comment(node, "A");
+    tree.append_comment(node, "B");
+    tree.append_premove_comment(node, "C");
+    tree.add_nag(node, 1);
+    tree.add_nag(node, 14);
+    CHECK(tree.comment(node) == "AB");
+    CHECK(tree.premove_comment(node) == "C");
+    CHECK(tree.nags(node) == std::pmr::vector<int>{1, 14});
+    CHECK(tree.comment(GameTree::root_id).empty());
+
+    tree.set_comment(node, "");
+    CHECK(tree.comment(node).empty());
+}
+
+TEST_CASE("Game.Tree.Positions", "[tree]") {
+    GameTree tree{Position{FenString::starting_position()}};
+    const auto e4_node = tree.add_child(GameTree::root_id, e4).first;
+    const auto e5_node = tree.add_child(e4_node, e5).first;
+    CHECK(tree.position(GameTree::root_id) != nullptr);
+    CHECK(tree.position(e5_node) == nullptr);
+
+    const auto position = tree.calculate_position(e5_node);
+    CHECK(position.side_to_move() == Color::White);
+    CHECK(position.fullmove_number() == 2);
+
+    tree.set_position(e4_node, tree.calculate_position(e4_node));
+    tree.set_position(e5_node, position);
+    tree.prune_positions([](size_t ply) { return ply == 2; });
+    CHECK(tree.position(GameTree::root_id) != nullptr);
+    CHECK(tree.position(e4_node) == nullptr);
+    CHECK(tree.position(e5_node) != nullptr);
+    tree.clear_position(e5_node);
+    CHECK(tree.position(e5_node) == nullptr);
+}
+
+TEST_CASE("Game.Tree.Position Keys", "[tree]") {
+    GameTree tree{Position{FenString::starting_position()}};
+    const auto e4_node = tree.add_child(GameTree::root_id, e4).first;
+    const auto d4_node = tree.add_child(GameTree::root_id, d4).first;
+    const auto e5_node = tree.add_child(e4_node, e5).first;
+    CHECK(tree.node(e4_node).key() == 0);
+    CHECK(tree.find_position(42) == NodeId::Invalid);
+
+    tree.set_position_key(e5_node, 42);
+    tree.set_position_key(d4_node, 42);
+    tree.set_position_key(e4_node, 7);
+    CHECK(tree.node(e5_node).key() == 42);
+    CHECK(tree.find_position(42) == d4_node);
+    CHECK(tree.find_positions(42) == std::vector<NodeId>{d4_node, e5_node});
+    CHECK(tree.find_position(7) == e4_node);
+
+    tree.set_position_key(d4_node, 0);
+    CHECK(tree.find_positions(42) == std::vector<NodeId>{e5_node});
+    CHECK(tree.find_positions(0).empty());
+}